@@ -42,8 +42,7 @@ void PF_ActionDrawCircle::trigger()
     PF_Circle* circle = new PF_Circle(container,view,*data);
 
     container->addEntity(circle);
-    //view->redraw(PF::RedrawDrawing);
-    view->replot();
+    view->redraw((PF::RedrawMethod) (PF::RedrawDrawing | PF::RedrawOverlay));
     setStatus(SetCenter);
     reset();
 
@@ -47,8 +47,7 @@ void PF_ActionDrawLine::trigger()
 
     PF_Line::line_index++;
 
-    //view->redraw(PF::RedrawDrawing);
-    view->replot();
+    view->redraw((PF::RedrawMethod) (PF::RedrawDrawing | PF::RedrawOverlay));
 }
 
 void PF_ActionDrawLine::mouseMoveEvent(QMouseEvent *e)
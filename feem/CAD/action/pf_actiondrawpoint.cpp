@@ -67,8 +67,7 @@ void PF_ActionDrawPoint::trigger()
 
         PF_Point::point_index++;
 
-        //view->redraw((PF::RedrawMethod) (PF::RedrawDrawing | PF::RedrawOverlay));
-        view->replot();
+        view->redraw((PF::RedrawMethod) (PF::RedrawDrawing | PF::RedrawOverlay));
     }
 }
 
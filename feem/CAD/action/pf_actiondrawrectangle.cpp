@@ -50,7 +50,7 @@ void PF_ActionDrawRectangle::trigger()
     PF_Line::line_index++;
     container->addEntity(polyline);
 
-    view->replot();
+    view->redraw((PF::RedrawMethod) (PF::RedrawDrawing | PF::RedrawOverlay));
 }
 
 void PF_ActionDrawRectangle::mouseMoveEvent(QMouseEvent *e)
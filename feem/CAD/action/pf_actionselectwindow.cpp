@@ -0,0 +1,128 @@
+#include "pf_actionselectwindow.h"
+
+#include "pf_graphicview.h"
+#include "pf_line.h"
+#include "pf_selection.h"
+
+#include <QKeyEvent>
+#include <QMouseEvent>
+
+namespace {
+
+/** 拖动距离小于该像素数时按单击处理，套索的顶点也按该距离抽稀 **/
+const int DragDistance = 3;
+
+}
+
+PF_ActionSelectWindow::PF_ActionSelectWindow(PF_EntityContainer *container,
+                                             PF_GraphicView *graphicView,
+                                             bool lasso)
+    :PF_ActionPreviewInterface(lasso ? "Select Lasso" : "Select Window",container,graphicView)
+    ,lasso(lasso)
+    ,select(true)
+    ,cross(false)
+{
+    actionType = lasso ? PF::ActionSelectLasso : PF::ActionSelectWindow;
+}
+
+PF_ActionSelectWindow::~PF_ActionSelectWindow()
+{
+
+}
+
+void PF_ActionSelectWindow::trigger()
+{
+    PF_ActionPreviewInterface::trigger();
+
+    PF_Selection s(container, view);
+    if (lasso) {
+        s.selectLasso(polygon, select, cross);
+    } else {
+        s.selectWindow(corner1, corner2, select, cross);
+    }
+    view->redraw(PF::RedrawOverlay);
+}
+
+void PF_ActionSelectWindow::mousePressEvent(QMouseEvent *e)
+{
+    if (e->button()==Qt::LeftButton) {
+        pressPos = e->pos();
+        corner1 = view->toGraph(e->x(), e->y());
+        corner2 = corner1;
+        polygon.clear();
+        polygon.push_back(corner1);
+        setStatus(SetCorner2);
+    }
+}
+
+void PF_ActionSelectWindow::mouseMoveEvent(QMouseEvent *e)
+{
+    if (getStatus()!=SetCorner2) return;
+
+    const PF_Vector mouse = view->toGraph(e->x(), e->y());
+    deletePreview();
+    if (lasso) {
+        const PF_Vector last = view->toGui(polygon.back());
+        if (qAbs(e->x()-last.x) + qAbs(e->y()-last.y) >= DragDistance) {
+            polygon.push_back(mouse);
+        }
+        for (size_t i = 1; i < polygon.size(); i++) {
+            preview->addEntity(new PF_Line{preview, view, polygon[i-1], polygon[i]});
+        }
+        if (polygon.size() > 2) {
+            preview->addEntity(new PF_Line{preview, view, polygon.back(), polygon.front()});
+        }
+    } else {
+        corner2 = mouse;
+        preview->addRectangle(corner1, corner2);
+    }
+    drawPreview();
+}
+
+void PF_ActionSelectWindow::mouseReleaseEvent(QMouseEvent *e)
+{
+    if (e->button()==Qt::LeftButton) {
+        if (getStatus()!=SetCorner2) return;
+        setStatus(SetCorner1);
+
+        select = !(e->modifiers() & Qt::ControlModifier);
+        if ((e->pos()-pressPos).manhattanLength() < DragDistance) {
+            deletePreview();
+            drawPreview();
+            PF_Entity* en = catchEntity(e);
+            if (en) {
+                PF_Selection s(container, view);
+                s.selectSingle(en);
+            }
+            return;
+        }
+
+        corner2 = view->toGraph(e->x(), e->y());
+        if (lasso) {
+            polygon.push_back(corner2);
+            cross = e->modifiers() & Qt::ShiftModifier;
+        } else {
+            cross = e->x() < pressPos.x();
+        }
+        trigger();
+    } else if (e->button()==Qt::RightButton) {
+        finish();
+    }
+}
+
+void PF_ActionSelectWindow::keyPressEvent(QKeyEvent *e)
+{
+    if (e->key()==Qt::Key_Escape) {
+        finish();
+    }
+}
+
+void PF_ActionSelectWindow::updateMouseButtonHints()
+{
+
+}
+
+void PF_ActionSelectWindow::updateMouseCursor()
+{
+
+}
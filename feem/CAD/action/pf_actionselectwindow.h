@@ -0,0 +1,51 @@
+#ifndef PF_ACTIONSELECTWINDOW_H
+#define PF_ACTIONSELECTWINDOW_H
+
+#include "pf_actionpreviewinterface.h"
+
+#include <vector>
+
+
+/*!
+ \brief 框选和套索选择。
+
+ 按下左键拖动画出矩形或者任意多边形，松开时选择。矩形从左向右拖动为
+ 窗口选择，只选择完全在窗口内的实体；从右向左拖动为交叉选择，
+ 与窗口相交的实体也被选择。套索按住Shift松开时为交叉选择。
+ 按住Ctrl时取消选择，没有拖动时与PF_ActionSelectSingle相同。
+*/
+class PF_ActionSelectWindow : public PF_ActionPreviewInterface
+{
+    Q_OBJECT
+public:
+    enum Status {
+        SetCorner1,      /**< 等待按下鼠标 */
+        SetCorner2       /**< 拖动中 */
+    };
+
+public:
+    PF_ActionSelectWindow(PF_EntityContainer* container,
+                          PF_GraphicView* graphicView,
+                          bool lasso=false);
+    ~PF_ActionSelectWindow() override;
+
+    void trigger() override;
+    void mousePressEvent(QMouseEvent* e) override;
+    void mouseMoveEvent(QMouseEvent* e) override;
+    void mouseReleaseEvent(QMouseEvent* e) override;
+    void keyPressEvent(QKeyEvent* e) override;
+
+    void updateMouseButtonHints() override;
+    void updateMouseCursor() override;
+
+private:
+    bool lasso;
+    bool select;
+    bool cross;
+    QPoint pressPos;
+    PF_Vector corner1;
+    PF_Vector corner2;
+    std::vector<PF_Vector> polygon;
+};
+
+#endif // PF_ACTIONSELECTWINDOW_H
@@ -6,6 +6,168 @@
 //#include "PF_graphic.h"
 //#include "PF_layer.h"
 
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/** 多边形的顶点，最后一个顶点与第一个顶点相连 **/
+typedef std::vector<PF_Vector> Polygon;
+
+/** 实体与选择区域的关系 **/
+enum Relation {
+    Outside,
+    Crossing,
+    Inside
+};
+
+double cross(const PF_Vector& o, const PF_Vector& a, const PF_Vector& b)
+{
+    return (a.x-o.x)*(b.y-o.y) - (a.y-o.y)*(b.x-o.x);
+}
+
+bool onSegment(const PF_Vector& p, const PF_Vector& q1, const PF_Vector& q2)
+{
+    return std::min(q1.x,q2.x) <= p.x && p.x <= std::max(q1.x,q2.x)
+            && std::min(q1.y,q2.y) <= p.y && p.y <= std::max(q1.y,q2.y);
+}
+
+/*!
+ \brief 两条线段是否相交，包括端点接触和共线重叠。
+
+*/
+bool segmentsIntersect(const PF_Vector& p1, const PF_Vector& p2,
+                       const PF_Vector& q1, const PF_Vector& q2)
+{
+    const double d1 = cross(q1,q2,p1);
+    const double d2 = cross(q1,q2,p2);
+    const double d3 = cross(p1,p2,q1);
+    const double d4 = cross(p1,p2,q2);
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0))
+            && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+        return true;
+    }
+    return (d1 == 0 && onSegment(p1,q1,q2)) || (d2 == 0 && onSegment(p2,q1,q2))
+            || (d3 == 0 && onSegment(q1,p1,p2)) || (d4 == 0 && onSegment(q2,p1,p2));
+}
+
+/*!
+ \brief 奇偶规则判断点是否在多边形内。
+
+*/
+bool pointInPolygon(const PF_Vector& p, const Polygon& poly)
+{
+    bool inside = false;
+    for (size_t i = 0, j = poly.size()-1; i < poly.size(); j = i++) {
+        const PF_Vector& a = poly[i];
+        const PF_Vector& b = poly[j];
+        if ((a.y > p.y) != (b.y > p.y)
+                && p.x < (b.x-a.x)*(p.y-a.y)/(b.y-a.y) + a.x) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+bool segmentCrossesPolygon(const PF_Vector& p1, const PF_Vector& p2, const Polygon& poly)
+{
+    for (size_t i = 0, j = poly.size()-1; i < poly.size(); j = i++) {
+        if (segmentsIntersect(p1,p2,poly[j],poly[i]))
+            return true;
+    }
+    return false;
+}
+
+/*!
+ \brief 圆周与线段相交：圆心到线段的最近距离不大于半径，且最远的端点不在圆内。
+
+*/
+bool circleCrossesSegment(const PF_Vector& c, double r,
+                          const PF_Vector& q1, const PF_Vector& q2)
+{
+    const PF_Vector d = q2 - q1;
+    const double len2 = d.squared();
+    double t = len2 > 0. ? (c - q1).dotP(d)/len2 : 0.;
+    t = std::max(0.,std::min(1.,t));
+    const double dmin = (q1 + d*t).distanceTo(c);
+    const double dmax = std::max(q1.distanceTo(c),q2.distanceTo(c));
+    return dmin <= r && r <= dmax;
+}
+
+bool circleCrossesPolygon(const PF_Vector& c, double r, const Polygon& poly)
+{
+    for (size_t i = 0, j = poly.size()-1; i < poly.size(); j = i++) {
+        if (circleCrossesSegment(c,r,poly[j],poly[i]))
+            return true;
+    }
+    return false;
+}
+
+/*!
+ \brief 实体与多边形区域的关系。
+
+ 直线和圆周都是连通的曲线，与边界不相交时要么整体在内部，要么整体在外部，
+ 只需要再判断曲线上的一个点。容器由子实体的关系合并得到，其他实体按包围盒处理。
+*/
+Relation relation(PF_Entity* e, const Polygon& poly)
+{
+    if (e->isContainer()) {
+        bool inside = false, outside = false;
+        for (auto child : static_cast<PF_EntityContainer*>(e)->getEntityList()) {
+            switch (relation(child,poly)) {
+            case Crossing:
+                return Crossing;
+            case Inside:
+                inside = true;
+                break;
+            case Outside:
+                outside = true;
+                break;
+            }
+            if (inside && outside)
+                return Crossing;
+        }
+        return inside ? Inside : Outside;
+    }
+
+    switch (e->rtti()) {
+    case PF::EntityLine:
+        if (segmentCrossesPolygon(e->getStartpoint(),e->getEndpoint(),poly))
+            return Crossing;
+        return pointInPolygon(e->getStartpoint(),poly) ? Inside : Outside;
+    case PF::EntityCircle: {
+        const PF_Vector c = e->getCenter();
+        const double r = e->getRadius();
+        if (circleCrossesPolygon(c,r,poly))
+            return Crossing;
+        return pointInPolygon(c + PF_Vector(r,0.),poly) ? Inside : Outside;
+    }
+    case PF::EntityPoint:
+        return pointInPolygon(e->getMin(),poly) ? Inside : Outside;
+    default: {
+        const PF_Vector minV = e->getMin();
+        const PF_Vector maxV = e->getMax();
+        const PF_Vector corners[4] = {minV, {maxV.x,minV.y}, maxV, {minV.x,maxV.y}};
+        for (int i = 0; i < 4; i++) {
+            if (segmentCrossesPolygon(corners[i],corners[(i+1)%4],poly))
+                return Crossing;
+        }
+        return pointInPolygon(minV,poly) ? Inside : Outside;
+    }
+    }
+}
+
+bool boxInside(PF_Entity* e, const PF_Vector& minV, const PF_Vector& maxV)
+{
+    const PF_Vector eMin = e->getMin();
+    const PF_Vector eMax = e->getMax();
+    return eMin.x <= eMax.x && eMin.y <= eMax.y
+            && minV.x <= eMin.x && minV.y <= eMin.y
+            && eMax.x <= maxV.x && eMax.y <= maxV.y;
+}
+
+}
+
 
 
 /**
@@ -40,8 +202,8 @@ void PF_Selection::selectSingle(PF_Entity* e) {
 //            graphicView->drawEntity(e);
 //        }
         if (graphicView) {
-            //graphicView->drawEntity(container);
-            graphicView->replot();
+            graphicView->invalidateEntity(e);
+            graphicView->redraw(PF::RedrawDrawing);
         }
     }
 }
@@ -56,6 +218,20 @@ void PF_Selection::selectAll(bool select) {
         //graphicView->deleteEntity(container);
     }
 
+    /** 取消选择时只需要访问已经选中的实体 **/
+    if (!select) {
+        std::vector<PF_Entity*> selected;
+        container->getSelection().selected(selected);
+        for (auto e : selected) {
+            e->setSelected(false);
+        }
+        if (graphicView && !selected.empty()) {
+            graphicView->invalidateEntity(container);
+            graphicView->redraw(PF::RedrawDrawing);
+        }
+        return;
+    }
+
     //container->setSelected(select);
     for(auto e: *container){
     //for (unsigned i=0; i<container->count(); ++i) {
@@ -67,8 +243,8 @@ void PF_Selection::selectAll(bool select) {
     }
 
     if (graphicView) {
-        //graphicView->drawEntity(container);
-        graphicView->replot();
+        graphicView->invalidateEntity(container);
+        graphicView->redraw(PF::RedrawDrawing);
     }
 }
 
@@ -92,7 +268,97 @@ void PF_Selection::invertSelection() {
     }
 
     if (graphicView) {
-        //graphicView->drawEntity(container);
-        graphicView->replot();
+        graphicView->invalidateEntity(container);
+        graphicView->redraw(PF::RedrawDrawing);
+    }
+}
+
+
+
+/**
+ * Selects or deselects all entities within the given window.
+ *
+ * 通过空间索引只访问包围盒与窗口相交的实体。窗口选择（cross为false）
+ * 只选择完全在窗口内的实体，交叉选择还包括与窗口边界相交的实体。
+ *
+ * @return 选择状态发生变化的实体数目
+ */
+int PF_Selection::selectWindow(const PF_Vector& v1, const PF_Vector& v2,
+                               bool select, bool cross) {
+    const PF_Vector minV = PF_Vector::minimum(v1, v2);
+    const PF_Vector maxV = PF_Vector::maximum(v1, v2);
+    const Polygon rect{minV, {maxV.x, minV.y}, maxV, {minV.x, maxV.y}};
+
+    std::vector<PF_Entity*> candidates;
+    container->getIndex().query(minV, maxV, candidates);
+
+    std::vector<PF_Entity*> hits;
+    for (auto e : candidates) {
+        if (!e->isVisible()) continue;
+        if (boxInside(e, minV, maxV)
+                || (cross && relation(e, rect) != Outside)) {
+            hits.push_back(e);
+        }
+    }
+    return apply(hits, select);
+}
+
+
+
+/**
+ * Selects or deselects all entities within the given polygon.
+ *
+ * 先用多边形的包围盒查询空间索引，再对候选实体做精确判断，
+ * 代价为O(log n + k·m)，m为多边形的顶点数。
+ *
+ * @return 选择状态发生变化的实体数目
+ */
+int PF_Selection::selectLasso(const std::vector<PF_Vector>& polygon,
+                              bool select, bool cross) {
+    if (polygon.size() < 3) return 0;
+
+    PF_Vector minV = polygon.front();
+    PF_Vector maxV = polygon.front();
+    for (const auto& p : polygon) {
+        minV = PF_Vector::minimum(minV, p);
+        maxV = PF_Vector::maximum(maxV, p);
+    }
+
+    std::vector<PF_Entity*> candidates;
+    container->getIndex().query(minV, maxV, candidates);
+
+    std::vector<PF_Entity*> hits;
+    for (auto e : candidates) {
+        if (!e->isVisible()) continue;
+        if (!cross && !boxInside(e, minV, maxV)) continue;
+        const Relation r = relation(e, polygon);
+        if (r == Inside || (cross && r == Crossing)) {
+            hits.push_back(e);
+        }
+    }
+    return apply(hits, select);
+}
+
+
+
+/**
+ * 修改实体的选择状态，只重绘发生变化的实体所在的区域。
+ */
+int PF_Selection::apply(const std::vector<PF_Entity*>& entities, bool select) {
+    int changed = 0;
+    PF_Vector minV(PF_MAXDOUBLE, PF_MAXDOUBLE);
+    PF_Vector maxV(PF_MINDOUBLE, PF_MINDOUBLE);
+    for (auto e : entities) {
+        if (e->isSelected() == select) continue;
+        e->setSelected(select);
+        minV = PF_Vector::minimum(minV, e->getMin());
+        maxV = PF_Vector::maximum(maxV, e->getMax());
+        changed++;
+    }
+
+    if (graphicView && changed > 0) {
+        graphicView->invalidateRect(minV, maxV);
+        graphicView->redraw(PF::RedrawDrawing);
     }
+    return changed;
 }
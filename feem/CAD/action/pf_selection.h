@@ -4,6 +4,8 @@
 #include "pf_entitycontainer.h"
 #include "pf_graphicview.h"
 
+#include <vector>
+
 /**
  * API Class for selecting entities.
  * There's no interaction handled in this class.
@@ -23,11 +25,13 @@ public:
         selectAll(false);
     }
     void invertSelection();
-//    void selectWindow(const PF_Vector& v1, const PF_Vector& v2,
-//                      bool select=true, bool cross=false);
-//    void deselectWindow(const PF_Vector& v1, const PF_Vector& v2) {
-//        selectWindow(v1, v2, false);
-//    }
+    int selectWindow(const PF_Vector& v1, const PF_Vector& v2,
+                     bool select=true, bool cross=false);
+    int deselectWindow(const PF_Vector& v1, const PF_Vector& v2) {
+        return selectWindow(v1, v2, false);
+    }
+    int selectLasso(const std::vector<PF_Vector>& polygon,
+                    bool select=true, bool cross=false);
 //    void selectIntersected(const PF_Vector& v1, const PF_Vector& v2,
 //                      bool select=true);
 //    void deselectIntersected(const PF_Vector& v1, const PF_Vector& v2) {
@@ -41,6 +45,9 @@ public:
 //		selectLayer(layerName, false);
 //	}
 
+protected:
+    int apply(const std::vector<PF_Entity*>& entities, bool select);
+
 protected:
     PF_EntityContainer* container;
 //    PF_Graphic* graphic;
@@ -1,4 +1,8 @@
 #include "pf_document.h"
+#include "pf_gmshgeowriter.h"
+#include "pf_gmshmesher.h"
+
+#include <QDebug>
 
 PF_Document::PF_Document(PF_EntityContainer *parent)
     :PF_EntityContainer(parent)
@@ -10,8 +14,32 @@ PF_Document::PF_Document(PF_EntityContainer *parent)
  \brief 将列表当中的形状元素导出到.geo文件
 
  \param filename
+ \return 写入成功返回true
 */
-void PF_Document::exportGmshGeo(const QString &filename)
+bool PF_Document::exportGmshGeo(const QString &filename)
 {
+    PF_GmshGeoWriter writer(this);
+    if(!writer.write(filename)){
+        qDebug()<<Q_FUNC_INFO<<writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+/*!
+ \brief 调用Gmsh的API在进程内剖分，结果直接写入data和bound，
+ 不经过.geo文件和外部的gmsh程序。
 
+ \param meshSize 全局的网格尺寸，小于等于0时由Gmsh自动确定
+ \return 剖分成功返回true
+*/
+bool PF_Document::generateMesh(FemType *data, BoundaryType *bound, double meshSize)
+{
+    PF_GmshMesher mesher(this);
+    mesher.setMeshSize(meshSize);
+    if(!mesher.mesh(data,bound)){
+        qDebug()<<Q_FUNC_INFO<<mesher.errorString();
+        return false;
+    }
+    return true;
 }
@@ -1,6 +1,7 @@
 #ifndef PF_DOCUMENT_H
 #define PF_DOCUMENT_H
 #include "pf_entitycontainer.h"
+#include "pf_meshjob.h"
 
 class PF_Document : public PF_EntityContainer
 {
@@ -8,7 +9,16 @@ public:
     PF_Document(PF_EntityContainer* parent=nullptr);
     ~PF_Document()=default;
 
-    void exportGmshGeo(const QString& filename);
+    bool exportGmshGeo(const QString& filename);
+    bool generateMesh(FemType* data, BoundaryType* bound, double meshSize=0.);
+
+    /** 文档当前的网格，几何修改后不会自动清除 **/
+    void setMesh(PF_MeshResultPtr result){
+        mesh = result;
+    }
+    PF_MeshResultPtr getMesh() const{
+        return mesh;
+    }
 
     virtual bool isDocument() const{
         return true;
@@ -18,6 +28,7 @@ protected:
     QString fileName;
     QString autoSaveFileName;
     PF_GraphicView* gv;
+    PF_MeshResultPtr mesh;
 };
 
 #endif // PF_DOCUMENT_H
@@ -88,6 +88,10 @@ bool PF_Entity::setSelected(bool select)
     else
         delFlag(PF::FlagSelected);
 
+    /** 同步所在容器的选择集合 **/
+    if(parent)
+        parent->selectionChanged(this);
+
     return  true;
 }
 
@@ -24,6 +24,16 @@ public:
 
     void init();
 
+    /** @return 实体的类型 **/
+    virtual PF::EntityType rtti() const{
+        return PF::EntityUnknown;
+    }
+
+    /** @return 所属的容器 **/
+    PF_EntityContainer* getParent() const{
+        return parent;
+    }
+
     virtual bool isContainer() const = 0;/**纯虚函数**/
     virtual bool isAtomic() const = 0;
 
@@ -1,6 +1,7 @@
 #include "pf_entitycontainer.h"
 #include "pf_graphicview.h"
 #include "pf_line.h"
+#include "pf_renderbatch.h"
 
 #include <QDebug>
 
@@ -8,6 +9,9 @@ PF_EntityContainer::PF_EntityContainer(PF_EntityContainer *parent, PF_GraphicVie
     :PF_Entity(parent,view)
 {
     autoDelete = owner;
+    bordersDirty = false;
+    transforming = false;
+    resetBorders();
 }
 
 PF_EntityContainer::~PF_EntityContainer()
@@ -31,6 +35,14 @@ void PF_EntityContainer::clear()
     }else{
         entities.clear();
     }
+    spatialIndex.clear();
+    intersections.clear();
+    regions.clear();
+    selection.clear();
+    resetBorders();
+    if (parent) {
+        parent->updateEntity(this);
+    }
     //qDebug()<<"PF_EntityContainer::clear: OK.";
 }
 
@@ -68,6 +80,7 @@ void PF_EntityContainer::addEntity(PF_Entity *entity)
     }
 
     entities.append(entity);
+    indexEntity(entity);
     //qDebug()<<"PF_EntityContainer::addEntity:size:"<<entities.size();
 }
 
@@ -82,6 +95,7 @@ void PF_EntityContainer::appendEntity(PF_Entity *entity)
     if (!entity)
             return;
     entities.append(entity);
+    indexEntity(entity);
 }
 
 /**
@@ -93,6 +107,7 @@ void PF_EntityContainer::prependEntity(PF_Entity *entity)
 {
     if (!entity) return;
     entities.prepend(entity);
+    indexEntity(entity, 0);
 }
 
 void PF_EntityContainer::moveEntity(int index, QList<PF_Entity *> &entList)
@@ -125,6 +140,7 @@ void PF_EntityContainer::moveEntity(int index, QList<PF_Entity *> &entList)
     for(auto e: entList){
             entities.insert(ci++, e);
     }
+    renumberEntities();
 }
 
 
@@ -139,6 +155,7 @@ void PF_EntityContainer::insertEntity(int index, PF_Entity *entity)
     if (!entity) return;
 
     entities.insert(index, entity);
+    indexEntity(entity, qBound(0, index, entities.size() - 1));
 }
 
 
@@ -152,6 +169,19 @@ bool PF_EntityContainer::removeEntity(PF_Entity *entity)
 {
     bool ret;
     ret = entities.removeOne(entity);
+    if (ret) {
+        if (mParentPlot) {
+            mParentPlot->invalidateEntity(entity);
+        }
+        spatialIndex.remove(entity);
+        intersections.remove(entity);
+        regions.remove(entity);
+        selection.remove(entity);
+        refreshBorders();
+        if (parent) {
+            parent->updateEntity(this);
+        }
+    }
 
     if (autoDelete && ret) {
         delete entity;
@@ -160,6 +190,89 @@ bool PF_EntityContainer::removeEntity(PF_Entity *entity)
 }
 
 
+/*!
+ \brief 将新加入的实体放入空间索引，更新容器的包围盒并通知上一级容器。
+ 加在列表首尾时顺序号由相邻的实体延伸得到，插在中间时重新编号。
+
+ \param entity
+ \param index 实体在列表中的位置
+*/
+void PF_EntityContainer::indexEntity(PF_Entity *entity, int index)
+{
+    if (!entity->isContainer()) {
+        entity->calculateBorders();
+    }
+    const int last = entities.size() - 1;
+    qint64 order = 0;
+    if (index == last && last > 0) {
+        order = spatialIndex.order(entities.at(last - 1)) + 1;
+    } else if (index == 0 && last > 0) {
+        order = spatialIndex.order(entities.at(1)) - 1;
+    }
+    spatialIndex.insert(entity, entity->getMin(), entity->getMax(), order);
+    if (index > 0 && index < last) {
+        renumberEntities();
+    }
+    intersections.invalidate(entity);
+    regions.invalidate(entity);
+    selection.add(entity, entity->getFlag(PF::FlagSelected));
+    refreshBorders();
+    if (mParentPlot) {
+        mParentPlot->invalidateEntity(entity);
+    }
+    if (parent) {
+        parent->updateEntity(this);
+    }
+}
+
+
+/*!
+ \brief 列表顺序被整体改变后，按列表中的位置重新设置空间索引中的顺序号。
+
+*/
+void PF_EntityContainer::renumberEntities()
+{
+    qint64 order = 0;
+    for (PF_Entity* e: entities) {
+        spatialIndex.setOrder(e, order++);
+    }
+}
+
+
+/*!
+ \brief 实体的几何被单独修改后调用，更新它在空间索引中的包围盒，
+ 并逐级通知上一级容器，代价为O(depth·log n)。
+
+ \param entity
+*/
+void PF_EntityContainer::updateEntity(PF_Entity *entity)
+{
+    /** 整体变换时子容器的通知由本容器在变换结束后统一处理 **/
+    if (transforming || !entity || !spatialIndex.contains(entity)) return;
+
+    /** 原来的位置和新的位置都需要重绘 **/
+    if (mParentPlot) {
+        PF_Vector oldMin, oldMax;
+        spatialIndex.bounds(entity, oldMin, oldMax);
+        mParentPlot->invalidateRect(oldMin, oldMax);
+        mParentPlot->invalidateEntity(entity);
+    }
+    spatialIndex.update(entity, entity->getMin(), entity->getMax());
+    intersections.invalidate(entity);
+    regions.invalidate(entity);
+    refreshBorders();
+    if (parent) {
+        parent->updateEntity(this);
+    }
+}
+
+
+void PF_EntityContainer::selectionChanged(PF_Entity *entity)
+{
+    selection.set(entity, entity->getFlag(PF::FlagSelected));
+}
+
+
 /**
  * @brief 在实体当中添加一个矩形
  *
@@ -181,8 +294,65 @@ void PF_EntityContainer::draw(QCPPainter *painter)
         return;
     }
 
-    for(int i=0;i < entities.size();++i){
-        mParentPlot->drawEntity(painter,entities.at(i));
+    /** 实体很多时由视图合成后台绘制的瓦片 **/
+    if (!parent && mParentPlot->drawTiles(painter, this)) {
+        return;
+    }
+
+    /** 只绘制包围盒与可见范围相交的实体，局部重绘时只查询裁剪区域 **/
+    PF_Vector minV, maxV;
+    mParentPlot->getVisibleRange(minV, maxV);
+    if (painter->hasClipping()) {
+        const QRect clip = painter->clipBoundingRect().toAlignedRect();
+        const PF_Vector c1 = mParentPlot->toGraph(clip.left(), clip.bottom()+1);
+        const PF_Vector c2 = mParentPlot->toGraph(clip.right()+1, clip.top());
+        minV = PF_Vector::maximum(minV, PF_Vector::minimum(c1, c2));
+        maxV = PF_Vector::minimum(maxV, PF_Vector::maximum(c1, c2));
+        if (minV.x > maxV.x || minV.y > maxV.y) {
+            return;
+        }
+    }
+    std::vector<PF_Entity*> visible;
+    spatialIndex.query(minV, maxV, visible);
+
+    /** 可见的实体较少时，即放大到一定程度之后才绘制标注 **/
+    if (!parent) {
+        mParentPlot->setLabelsVisible(int(visible.size()) <= mParentPlot->labelEntityLimit());
+    }
+
+    /** 小于一个像素的实体不绘制，点的大小与缩放无关，选中的实体最后绘制 **/
+    const double pixelX = fabs(mParentPlot->toGraphDX(1));
+    const double pixelY = fabs(mParentPlot->toGraphDY(1));
+    std::vector<PF_Entity*> selected;
+    std::vector<PF_Entity*> others;
+
+    /** 不需要绘制标注时，未选中的直线和圆使用painter当前的样式批量绘制 **/
+    const bool batched = !mParentPlot->labelsVisible();
+    PF_RenderBatch batch(mParentPlot);
+    for(auto e : visible){
+        if (e->isSelected() || e->isHighlighted()) {
+            selected.push_back(e);
+            continue;
+        }
+        if (e->rtti() != PF::EntityPoint
+                && e->getMax().x - e->getMin().x < pixelX
+                && e->getMax().y - e->getMin().y < pixelY) {
+            continue;
+        }
+        if (batched && e->rtti() == PF::EntityLine) {
+            batch.addLine(e->getStartpoint(), e->getEndpoint(), painter->pen());
+        } else if (batched && e->rtti() == PF::EntityCircle) {
+            batch.addCircle(e->getCenter(), e->getRadius(), painter->pen(), painter->brush());
+        } else {
+            others.push_back(e);
+        }
+    }
+    batch.flush(painter);
+    for(auto e : others){
+        mParentPlot->drawEntity(painter,e);
+    }
+    for(auto e : selected){
+        mParentPlot->drawEntity(painter,e);
     }
 }
 
@@ -196,40 +366,78 @@ void PF_EntityContainer::adjustBorders(PF_Entity *entity)
             maxV = PF_Vector::maximum(entity->getMax(),maxV);
         }
 
-        // Notify parents. The border for the parent might
-        // also change TODO: Check for efficiency
-        //if(parent) {
-        //parent->adjustBorders(this);
-        //}
+        // 上一级容器由updateEntity()通知
+    }
+}
+
+
+/*!
+ \brief 容器的包围盒就是空间索引根节点的包围盒，插入、删除和更新实体时
+ 已经增量维护，这里只需要复制。
+
+*/
+void PF_EntityContainer::refreshBorders()
+{
+    if (!spatialIndex.getBounds(minV, maxV)) {
+        resetBorders();
     }
 }
 
 
 /**
  * Recalculates the borders of this entity container.
+ *
+ * 子实体的变化已经通过updateEntity()增量更新，只有容器整体变换之后
+ * （bordersDirty）才重新计算每个子实体，否则只需要O(1)。
  */
 void PF_EntityContainer::calculateBorders() {
 
-    resetBorders();
-    for (PF_Entity* e: entities){
-        if (e->isVisible() /*&& !(layer && layer->isFrozen())*/) {
+    if (bordersDirty) {
+        for (PF_Entity* e: entities){
             e->calculateBorders();
-            adjustBorders(e);
+            spatialIndex.update(e, e->getMin(), e->getMax());
         }
+        bordersDirty = false;
     }
+    refreshBorders();
+}
 
-    if (minV.x>maxV.x || minV.x>PF_MAXDOUBLE || maxV.x>PF_MAXDOUBLE
-            || minV.x<PF_MINDOUBLE || maxV.x<PF_MINDOUBLE) {
 
-        minV.x = 0.0;
-        maxV.x = 0.0;
+/*!
+ \brief 整体变换结束后调用：重绘变换前后的区域，并通知上一级容器更新
+ 本容器的包围盒。变换过程中子容器的通知被忽略，每次变换只向上传递一次，
+ 代价为O(depth·log n)。
+
+ \param oldMin 变换前的包围盒
+ \param oldMax
+*/
+void PF_EntityContainer::transformed(const PF_Vector &oldMin, const PF_Vector &oldMax)
+{
+    /** 上一级容器正在整体变换，由它重绘整个区域 **/
+    if (parent && parent->transforming) return;
+    if (mParentPlot) {
+        mParentPlot->invalidateRect(oldMin, oldMax);
+        mParentPlot->invalidateRect(minV, maxV);
     }
-    if (minV.y>maxV.y || minV.y>PF_MAXDOUBLE || maxV.y>PF_MAXDOUBLE
-            || minV.y<PF_MINDOUBLE || maxV.y<PF_MINDOUBLE) {
+    if (parent) {
+        parent->updateEntity(this);
+    }
+}
+
+
+/**
+ * @brief 不管是否有变化，重新计算所有层级的包围盒。用于没有通过
+ * updateEntity()通知容器而直接修改了实体几何的情况。
+ */
+void PF_EntityContainer::forcedCalculateBorders() {
 
-        minV.y = 0.0;
-        maxV.y = 0.0;
+    for (PF_Entity* e: entities){
+        if (e->isContainer()) {
+            static_cast<PF_EntityContainer*>(e)->forcedCalculateBorders();
+        }
     }
+    bordersDirty = true;
+    calculateBorders();
 }
 
 
@@ -246,8 +454,8 @@ PF_Vector PF_EntityContainer::getNearestEndpoint(const PF_Vector& coord,
     PF_Vector closestPoint(false);  // closest found endpoint
     PF_Vector point;                // endpoint found
 
-    for (PF_Entity* en: entities){
-
+    /** 端点都在包围盒内，按包围盒距离剪枝 **/
+    spatialIndex.nearest(coord, [&](PF_Entity* en){
         if (en->isVisible()
                 //&& !en->getParent()->ignoredOnModification()
                 ){//no end point for Insert, text, Dim
@@ -260,7 +468,8 @@ PF_Vector PF_EntityContainer::getNearestEndpoint(const PF_Vector& coord,
                 }
             }
         }
-    }
+        return minDist;
+    });
 
     return closestPoint;
 }
@@ -279,34 +488,21 @@ PF_Vector PF_EntityContainer::getNearestEndpoint(const PF_Vector& coord,
     PF_Vector closestPoint(false);  // closest found endpoint
     PF_Vector point;                // endpoint found
 
-    //QListIterator<PF_Entity> it = createIterator();
-    //PF_Entity* en;
-    //while ( (en = it.current())  ) {
-    //    ++it;
-
-    unsigned i0=0;
-    for(auto en: entities){
-        //if (!en->getParent()->ignoredOnModification() ){//no end point for Insert, text, Dim
-//            std::cout<<"find nearest for entity "<<i0<<std::endl;
-            point = en->getNearestEndpoint(coord, &curDist);
-            if (point.valid && curDist<minDist) {
-                closestPoint = point;
-                minDist = curDist;
-                if (dist) {
-                    *dist = minDist;
-                }
-                if(pEntity){
-                    *pEntity=en;
-                }
+    spatialIndex.nearest(coord, [&](PF_Entity* en){
+        point = en->getNearestEndpoint(coord, &curDist);
+        if (point.valid && curDist<minDist) {
+            closestPoint = point;
+            minDist = curDist;
+            if (dist) {
+                *dist = minDist;
             }
-        //}
-        i0++;
-    }
+            if(pEntity){
+                *pEntity=en;
+            }
+        }
+        return minDist;
+    });
 
-//    std::cout<<__FILE__<<" : "<<__func__<<" : line "<<__LINE__<<std::endl;
-//    std::cout<<"count()="<<const_cast<PF_EntityContainer*>(this)->count()<<"\tminDist= "<<minDist<<"\tclosestPoint="<<closestPoint;
-//    if(pEntity ) std::cout<<"\t*pEntity="<<*pEntity;
-//    std::cout<<std::endl;
     return closestPoint;
 }
 
@@ -337,8 +533,7 @@ PF_Vector PF_EntityContainer::getNearestCenter(const PF_Vector& coord,
     PF_Vector closestPoint(false);  // closest found endpoint
     PF_Vector point;                // endpoint found
 
-    for(auto en: entities){
-
+    spatialIndex.nearest(coord, [&](PF_Entity* en){
         if (en->isVisible()
                 //&& !en->getParent()->ignoredSnap()
                 ){//no center point for spline, text, Dim
@@ -348,7 +543,8 @@ PF_Vector PF_EntityContainer::getNearestCenter(const PF_Vector& coord,
                 minDist = curDist;
             }
         }
-    }
+        return minDist;
+    });
     if (dist) {
         *dist = minDist;
     }
@@ -367,8 +563,7 @@ PF_Vector PF_EntityContainer::getNearestMiddle(const PF_Vector& coord,
     PF_Vector closestPoint(false);  // closest found endpoint
     PF_Vector point;                // endpoint found
 
-    for(auto en: entities){
-
+    spatialIndex.nearest(coord, [&](PF_Entity* en){
         if (en->isVisible()
                 //&& !en->getParent()->ignoredSnap()
                 ){//no midle point for spline, text, Dim
@@ -378,7 +573,8 @@ PF_Vector PF_EntityContainer::getNearestMiddle(const PF_Vector& coord,
                 minDist = curDist;
             }
         }
-    }
+        return minDist;
+    });
     if (dist) {
         *dist = minDist;
     }
@@ -404,9 +600,46 @@ PF_Vector PF_EntityContainer::getNearestDist(double distance,
     return point;
 }
 
+/*!
+ \brief 查找距离coord最近的实体交点，交点在第一次查询时求出并缓存，
+ 之后只重新计算变化过的实体。
+
+ \param coord
+ \param dist
+ \return 没有交点时返回无效的点
+*/
 PF_Vector PF_EntityContainer::getNearestIntersection(const PF_Vector &coord, double *dist)
 {
-    return PF_Vector{};
+    intersections.update(entities, spatialIndex);
+    return intersections.getNearest(coord, dist);
+}
+
+/*!
+ \brief 容器中的直线、圆弧和圆围成的所有闭合区域，用于指定材料。
+ 第一次查询时求出，之后只重新计算变化过的实体附近的部分。
+
+*/
+const std::vector<PF_RegionIndex::Region> &PF_EntityContainer::getRegions()
+{
+    regions.update(entities, spatialIndex);
+    return regions.getRegions();
+}
+
+const std::vector<PF_RegionIndex::Edge> &PF_EntityContainer::getRegionEdges()
+{
+    regions.update(entities, spatialIndex);
+    return regions.getEdges();
+}
+
+/*!
+ \brief 查找包含coord的最内层的区域。
+
+ \return 区域在getRegions()中的下标，不在任何区域内时返回-1
+*/
+int PF_EntityContainer::getRegionAt(const PF_Vector &coord)
+{
+    regions.update(entities, spatialIndex);
+    return regions.regionAt(coord);
 }
 
 PF_Vector PF_EntityContainer::getNearestRef(const PF_Vector& coord,
@@ -417,8 +650,7 @@ PF_Vector PF_EntityContainer::getNearestRef(const PF_Vector& coord,
     PF_Vector closestPoint(false);  // closest found endpoint
     PF_Vector point;                // endpoint found
 
-    for(auto en: entities){
-
+    spatialIndex.nearest(coord, [&](PF_Entity* en){
         if (en->isVisible()) {
             point = en->getNearestRef(coord, &curDist);
             if (point.valid && curDist<minDist) {
@@ -429,7 +661,8 @@ PF_Vector PF_EntityContainer::getNearestRef(const PF_Vector& coord,
                 }
             }
         }
-    }
+        return minDist;
+    });
 
     return closestPoint;
 }
@@ -443,8 +676,7 @@ PF_Vector PF_EntityContainer::getNearestSelectedRef(const PF_Vector& coord,
     PF_Vector closestPoint(false);  // closest found endpoint
     PF_Vector point;                // endpoint found
 
-    for(auto en: entities){
-
+    spatialIndex.nearest(coord, [&](PF_Entity* en){
         if (en->isVisible() && en->isSelected() && !en->isParentSelected()) {
             point = en->getNearestSelectedRef(coord, &curDist);
             if (point.valid && curDist<minDist) {
@@ -455,7 +687,8 @@ PF_Vector PF_EntityContainer::getNearestSelectedRef(const PF_Vector& coord,
                 }
             }
         }
-    }
+        return minDist;
+    });
 
     return closestPoint;
 }
@@ -483,17 +716,20 @@ double PF_EntityContainer::getDistanceToPoint(const PF_Vector& coord,
     PF_Entity* closestEntity = nullptr;    // closest entity found
     PF_Entity* subEntity = nullptr;
 
-    for(auto e: entities){
+    // bug#426, need to ignore Images to find nearest intersections
+    if(level==PF::ResolveAllButTextImage /*&& e->rtti()==PF::EntityImage*/){
+        if (entity) {
+            *entity = nullptr;
+        }
+        return minDist;
+    }
 
+    PF_Entity* closestChild = nullptr;  // direct child holding closestEntity
+    /** 包围盒距离等于当前最小值的实体仍会被访问，所以相等时可以按索引中保存的列表顺序取舍 **/
+    spatialIndex.nearest(coord, [&](PF_Entity* e){
         if (e->isVisible()) {
-            // RS_DEBUG->print("entity: getDistanceToPoint");
-            // RS_DEBUG->print("entity: %d", e->rtti());
-            // bug#426, need to ignore Images to find nearest intersections
-            if(level==PF::ResolveAllButTextImage /*&& e->rtti()==PF::EntityImage*/) continue;
             curDist = e->getDistanceToPoint(coord, &subEntity, level, solidDist);
 
-            // RS_DEBUG->print("entity: getDistanceToPoint: OK");
-
             /*
              * By using '<=', we will prefer the *last* item in the container if there are multiple
              * entities that are *exactly* the same distance away, which should tend to be the one
@@ -503,7 +739,9 @@ double PF_EntityContainer::getDistanceToPoint(const PF_Vector& coord,
              * tend to want to reference entities that they see or have recently drawn as opposed
              * to deeper more forgotten and invisible ones...
              */
-            if (curDist<=minDist)
+            if (curDist<minDist
+                    || (curDist==minDist && closestChild
+                        && spatialIndex.order(e)>spatialIndex.order(closestChild)))
             {
                 switch(level){
                 case PF::ResolveAll:
@@ -513,10 +751,12 @@ double PF_EntityContainer::getDistanceToPoint(const PF_Vector& coord,
                 default:
                     closestEntity = e;
                 }
+                closestChild = e;
                 minDist = curDist;
             }
         }
-    }
+        return minDist;
+    });
 
     if (entity) {
         *entity = closestEntity;
@@ -560,63 +800,88 @@ PF_Entity* PF_EntityContainer::getNearestEntity(const PF_Vector& coord,
 
 
 void PF_EntityContainer::move(const PF_Vector& offset) {
+    const PF_Vector oldMin = minV, oldMax = maxV;
+    transforming = true;
     for(auto e: entities){
 
         e->move(offset);
-//        if (autoUpdateBorders) {
-//            e->moveBorders(offset);
-//        }
     }
-//    if (autoUpdateBorders) {
-//        moveBorders(offset);
-//    }
+    transforming = false;
+    /** 所有实体平移相同的距离，索引的结构不变 **/
+    spatialIndex.translate(offset);
+    intersections.translate(offset);
+    regions.translate(offset);
+    moveBorders(offset);
+    transformed(oldMin, oldMax);
 }
 
 
 
 void PF_EntityContainer::rotate(const PF_Vector& center, const double& angle) {
+    const PF_Vector oldMin = minV, oldMax = maxV;
     PF_Vector angleVector(angle);
 
+    transforming = true;
     for(auto e: entities){
         e->rotate(center, angleVector);
     }
-//    if (autoUpdateBorders) {
-//        calculateBorders();
-//    }
+    transforming = false;
+    intersections.invalidateAll();
+    regions.invalidateAll();
+    bordersDirty = true;
+    calculateBorders();
+    transformed(oldMin, oldMax);
 }
 
 
 void PF_EntityContainer::rotate(const PF_Vector& center, const PF_Vector& angleVector) {
-
+    const PF_Vector oldMin = minV, oldMax = maxV;
+    transforming = true;
     for(auto e: entities){
         e->rotate(center, angleVector);
     }
-//    if (autoUpdateBorders) {
-//        calculateBorders();
-//    }
+    transforming = false;
+    intersections.invalidateAll();
+    regions.invalidateAll();
+    bordersDirty = true;
+    calculateBorders();
+    transformed(oldMin, oldMax);
 }
 
 
 void PF_EntityContainer::scale(const PF_Vector& center, const PF_Vector& factor) {
+    const PF_Vector oldMin = minV, oldMax = maxV;
     if (fabs(factor.x)>PF_TOLERANCE && fabs(factor.y)>PF_TOLERANCE) {
 
+        transforming = true;
         for(auto e: entities){
             e->scale(center, factor);
         }
+        transforming = false;
     }
-//    if (autoUpdateBorders) {
-//        calculateBorders();
-//    }
+    intersections.invalidateAll();
+    regions.invalidateAll();
+    bordersDirty = true;
+    calculateBorders();
+    transformed(oldMin, oldMax);
 }
 
 
 
 void PF_EntityContainer::mirror(const PF_Vector& axisPoint1, const PF_Vector& axisPoint2) {
+    const PF_Vector oldMin = minV, oldMax = maxV;
     if (axisPoint1.distanceTo(axisPoint2)>PF_TOLERANCE) {
 
+        transforming = true;
         for(auto e: entities){
             e->mirror(axisPoint1, axisPoint2);
         }
+        transforming = false;
+        intersections.invalidateAll();
+        regions.invalidateAll();
+        bordersDirty = true;
+        calculateBorders();
+        transformed(oldMin, oldMax);
     }
 }
 
@@ -644,33 +909,40 @@ void PF_EntityContainer::mirror(const PF_Vector& axisPoint1, const PF_Vector& ax
 
 void PF_EntityContainer::moveRef(const PF_Vector& ref,
                                  const PF_Vector& offset) {
-
-
+    const PF_Vector oldMin = minV, oldMax = maxV;
+    transforming = true;
     for(auto e: entities){
         e->moveRef(ref, offset);
     }
-//    if (autoUpdateBorders) {
-//        calculateBorders();
-//    }
+    transforming = false;
+    intersections.invalidateAll();
+    regions.invalidateAll();
+    bordersDirty = true;
+    calculateBorders();
+    transformed(oldMin, oldMax);
 }
 
 
 void PF_EntityContainer::moveSelectedRef(const PF_Vector& ref,
                                          const PF_Vector& offset) {
-
-
+    const PF_Vector oldMin = minV, oldMax = maxV;
+    transforming = true;
     for(auto e: entities){
         e->moveSelectedRef(ref, offset);
     }
-//    if (autoUpdateBorders) {
-//        calculateBorders();
-//    }
+    transforming = false;
+    intersections.invalidateAll();
+    regions.invalidateAll();
+    bordersDirty = true;
+    calculateBorders();
+    transformed(oldMin, oldMax);
 }
 
 void PF_EntityContainer::revertDirection() {
     for(int k = 0; k < entities.size() / 2; ++k) {
         entities.swap(k, entities.size() - 1 - k);
     }
+    renumberEntities();
 
     for(PF_Entity*const entity: entities) {
         entity->revertDirection();
@@ -2,6 +2,10 @@
 #define PF_ENTITYCONTAINER_H
 
 #include "pf_entity.h"
+#include "pf_entityindex.h"
+#include "pf_intersectionindex.h"
+#include "pf_regionindex.h"
+#include "pf_selectionset.h"
 #include <QList>
 
 //2018-02-15
@@ -16,6 +20,10 @@ public:
 
     virtual void clear();
 
+    PF::EntityType rtti() const override{
+        return PF::EntityContainer;
+    }
+
     bool isAtomic() const override{
         return false;
     }
@@ -37,6 +45,21 @@ public:
     virtual void insertEntity(int index, PF_Entity* entity);
     virtual bool removeEntity(PF_Entity* entity);
 
+    /** 单独修改了某个实体的几何之后调用，更新空间索引 **/
+    void updateEntity(PF_Entity* entity);
+    const PF_EntityIndex& getIndex() const{
+        return spatialIndex;
+    }
+
+    /** 子实体的选择标志变化后由PF_Entity::setSelected()调用 **/
+    void selectionChanged(PF_Entity* entity);
+    const PF_SelectionSet& getSelection() const{
+        return selection;
+    }
+    unsigned countSelected() const{
+        return unsigned(selection.count());
+    }
+
     void addRectangle(PF_Vector const& v0, PF_Vector const& v1);
 
     /**一系列对Entity的操作**/
@@ -65,6 +88,15 @@ public:
                                      double* dist = nullptr) const override;
     PF_Vector getNearestIntersection(const PF_Vector& coord,
             double* dist = nullptr);
+
+    /** 实体围成的闭合区域，第一次查询时求出并缓存 **/
+    const std::vector<PF_RegionIndex::Region>& getRegions();
+    /** 区域边界在交点处打断后的边，Region中的边编号指向这里 **/
+    const std::vector<PF_RegionIndex::Edge>& getRegionEdges();
+    int getRegionAt(const PF_Vector& coord);
+    int regionRevision() const{
+        return regions.revision();
+    }
     PF_Vector getNearestRef(const PF_Vector& coord,
                                      double* dist = nullptr) const override;
     PF_Vector getNearestSelectedRef(const PF_Vector& coord,
@@ -96,6 +128,7 @@ public:
 
     virtual void adjustBorders(PF_Entity* entity);
     void calculateBorders() override;
+    void forcedCalculateBorders();
 
     /**
      * @brief begin/end to support range based loop
@@ -107,10 +140,22 @@ public:
     QList<PF_Entity *>::iterator end() ;
 
     const QList<PF_Entity*>& getEntityList();
+protected:
+    void indexEntity(PF_Entity* entity, int index);
+    void renumberEntities();
+    void refreshBorders();
+    void transformed(const PF_Vector& oldMin, const PF_Vector& oldMax);
+
 protected:
     QList<PF_Entity*> entities;/**保存所有实体**/
+    PF_EntityIndex spatialIndex;/**实体包围盒的空间索引**/
+    PF_IntersectionIndex intersections;/**实体之间交点的缓存**/
+    PF_RegionIndex regions;/**实体围成的闭合区域的缓存**/
+    PF_SelectionSet selection;/**直接子实体的选择状态**/
 private:
     bool autoDelete;
+    bool bordersDirty;/**整体变换之后需要重新计算子实体的包围盒**/
+    bool transforming;/**正在整体变换，忽略子容器的updateEntity()**/
 };
 
 #endif // PF_ENTITYCONTAINER_H
@@ -0,0 +1,463 @@
+#include "pf_entityindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+double PF_EntityIndex::Box::distanceTo(const PF_Vector &p) const
+{
+    double dx = std::max(0.,std::max(x0-p.x,p.x-x1));
+    double dy = std::max(0.,std::max(y0-p.y,p.y-y1));
+    return std::sqrt(dx*dx+dy*dy);
+}
+
+PF_EntityIndex::Box PF_EntityIndex::Box::merge(const Box &a, const Box &b)
+{
+    return Box{std::min(a.x0,b.x0),std::min(a.y0,b.y0),
+                std::max(a.x1,b.x1),std::max(a.y1,b.y1)};
+}
+
+PF_EntityIndex::PF_EntityIndex()
+    :root(-1)
+    ,freeList(-1)
+{
+
+}
+
+PF_EntityIndex::Box PF_EntityIndex::makeBox(const PF_Vector &minV, const PF_Vector &maxV)
+{
+    return Box{minV.x,minV.y,maxV.x,maxV.y};
+}
+
+/*!
+ \brief 空的容器的包围盒是反的，这样的实体只记录下来，不放入树中。
+
+*/
+bool PF_EntityIndex::isEmpty(const PF_Vector &minV, const PF_Vector &maxV)
+{
+    return minV.x > maxV.x || minV.y > maxV.y;
+}
+
+int PF_EntityIndex::allocateNode()
+{
+    int id;
+    if(freeList >= 0){
+        id = freeList;
+        freeList = nodes[id].parent;
+    }else{
+        id = int(nodes.size());
+        nodes.push_back(Node());
+    }
+    Node& n = nodes[id];
+    n.parent = n.child1 = n.child2 = -1;
+    n.height = 0;
+    n.entity = nullptr;
+    return id;
+}
+
+void PF_EntityIndex::freeNode(int id)
+{
+    nodes[id].parent = freeList;
+    nodes[id].height = -1;
+    freeList = id;
+}
+
+/*!
+ \brief 插入实体，已经存在的实体会更新其包围盒。
+
+*/
+void PF_EntityIndex::insert(PF_Entity *e, const PF_Vector &minV, const PF_Vector &maxV, qint64 order)
+{
+    if(!e) return;
+    if(leaves.contains(e)){
+        leaves[e].order = order;
+        update(e,minV,maxV);
+        return;
+    }
+    if(isEmpty(minV,maxV)){
+        leaves.insert(e,Leaf{-1,order});
+        return;
+    }
+    int leaf = allocateNode();
+    nodes[leaf].box = makeBox(minV,maxV);
+    nodes[leaf].entity = e;
+    leaves.insert(e,Leaf{leaf,order});
+    insertLeaf(leaf);
+}
+
+bool PF_EntityIndex::remove(PF_Entity *e)
+{
+    auto it = leaves.find(e);
+    if(it == leaves.end()) return false;
+    int leaf = it.value().node;
+    leaves.erase(it);
+    if(leaf >= 0){
+        removeLeaf(leaf);
+        freeNode(leaf);
+    }
+    return true;
+}
+
+/*!
+ \brief 实体的包围盒发生变化后调用，包围盒不变时不做任何操作。
+
+*/
+void PF_EntityIndex::update(PF_Entity *e, const PF_Vector &minV, const PF_Vector &maxV)
+{
+    auto it = leaves.find(e);
+    if(it == leaves.end()){
+        insert(e,minV,maxV);
+        return;
+    }
+    int leaf = it.value().node;
+    const bool empty = isEmpty(minV,maxV);
+    if(leaf < 0){
+        if(empty) return;
+        leaf = allocateNode();
+        nodes[leaf].box = makeBox(minV,maxV);
+        nodes[leaf].entity = e;
+        it.value().node = leaf;
+        insertLeaf(leaf);
+        return;
+    }
+    if(empty){
+        removeLeaf(leaf);
+        freeNode(leaf);
+        it.value().node = -1;
+        return;
+    }
+
+    Box box = makeBox(minV,maxV);
+    const Box& old = nodes[leaf].box;
+    if(old.x0 == box.x0 && old.y0 == box.y0 && old.x1 == box.x1 && old.y1 == box.y1){
+        return;
+    }
+    removeLeaf(leaf);
+    nodes[leaf].box = box;
+    insertLeaf(leaf);
+}
+
+/*!
+ \brief 索引中保存的实体包围盒，实体的几何修改之后仍然是修改之前的值。
+
+ \return 实体不在索引中或者包围盒为空时返回false
+*/
+bool PF_EntityIndex::bounds(PF_Entity *e, PF_Vector &minV, PF_Vector &maxV) const
+{
+    auto it = leaves.constFind(e);
+    if(it == leaves.constEnd() || it.value().node < 0) return false;
+    const Box& box = nodes[it.value().node].box;
+    minV = PF_Vector(box.x0,box.y0);
+    maxV = PF_Vector(box.x1,box.y1);
+    return true;
+}
+
+/*!
+ \brief 设置实体的顺序号，容器的列表顺序变化时调用。
+
+*/
+void PF_EntityIndex::setOrder(PF_Entity *e, qint64 order)
+{
+    auto it = leaves.find(e);
+    if(it != leaves.end())
+        it.value().order = order;
+}
+
+/*!
+ \brief 实体的顺序号，顺序号大的实体在容器列表中靠后，不在索引中时返回0。
+
+*/
+qint64 PF_EntityIndex::order(PF_Entity *e) const
+{
+    auto it = leaves.constFind(e);
+    return it == leaves.constEnd() ? 0 : it.value().order;
+}
+
+/*!
+ \brief 所有实体的包围盒，即根节点的包围盒，随插入和删除增量维护。
+
+ \return 没有非空的实体时返回false
+*/
+bool PF_EntityIndex::getBounds(PF_Vector &minV, PF_Vector &maxV) const
+{
+    if(root < 0) return false;
+    const Box& box = nodes[root].box;
+    minV = PF_Vector(box.x0,box.y0);
+    maxV = PF_Vector(box.x1,box.y1);
+    return true;
+}
+
+/*!
+ \brief 所有实体平移offset，树的结构不变。
+
+*/
+void PF_EntityIndex::translate(const PF_Vector &offset)
+{
+    for(auto& n : nodes){
+        if(n.height < 0) continue;
+        n.box.x0 += offset.x;
+        n.box.x1 += offset.x;
+        n.box.y0 += offset.y;
+        n.box.y1 += offset.y;
+    }
+}
+
+void PF_EntityIndex::clear()
+{
+    nodes.clear();
+    leaves.clear();
+    root = -1;
+    freeList = -1;
+}
+
+/*!
+ \brief 按照包围盒距离由近到远访问实体。
+
+ \param coord 查询点
+ \param visit 访问函数，返回当前的最小距离，包围盒距离大于该值的实体不再访问
+*/
+void PF_EntityIndex::nearest(const PF_Vector &coord, const NearestVisitor &visit) const
+{
+    if(root < 0) return;
+
+    typedef std::pair<double,int> Item;
+    std::priority_queue<Item,std::vector<Item>,std::greater<Item> > queue;
+    double best = PF_MAXDOUBLE;
+    queue.push(Item(nodes[root].box.distanceTo(coord),root));
+
+    while(!queue.empty()){
+        Item top = queue.top();
+        queue.pop();
+        if(top.first > best) break;
+
+        const Node& n = nodes[top.second];
+        if(n.isLeaf()){
+            best = std::min(best,visit(n.entity));
+        }else{
+            double d1 = nodes[n.child1].box.distanceTo(coord);
+            double d2 = nodes[n.child2].box.distanceTo(coord);
+            if(d1 <= best) queue.push(Item(d1,n.child1));
+            if(d2 <= best) queue.push(Item(d2,n.child2));
+        }
+    }
+}
+
+/*!
+ \brief 查找包围盒与给定矩形相交的实体。
+
+*/
+void PF_EntityIndex::query(const PF_Vector &minV, const PF_Vector &maxV,
+                           std::vector<PF_Entity *> &result) const
+{
+    if(root < 0) return;
+
+    const Box box{std::min(minV.x,maxV.x),std::min(minV.y,maxV.y),
+                std::max(minV.x,maxV.x),std::max(minV.y,maxV.y)};
+    std::vector<int> stack;
+    stack.push_back(root);
+    while(!stack.empty()){
+        const Node& n = nodes[stack.back()];
+        stack.pop_back();
+        if(!n.box.overlaps(box)) continue;
+        if(n.isLeaf()){
+            result.push_back(n.entity);
+        }else{
+            stack.push_back(n.child1);
+            stack.push_back(n.child2);
+        }
+    }
+}
+
+void PF_EntityIndex::refit(int id)
+{
+    Node& n = nodes[id];
+    n.box = Box::merge(nodes[n.child1].box,nodes[n.child2].box);
+    n.height = 1 + std::max(nodes[n.child1].height,nodes[n.child2].height);
+}
+
+/*!
+ \brief 选择使包围盒周长增加最少的位置插入叶子。
+
+*/
+void PF_EntityIndex::insertLeaf(int leaf)
+{
+    if(root < 0){
+        root = leaf;
+        nodes[leaf].parent = -1;
+        return;
+    }
+
+    const Box box = nodes[leaf].box;
+    int index = root;
+    while(!nodes[index].isLeaf()){
+        const Node& n = nodes[index];
+        double area = n.box.perimeter();
+        double combined = Box::merge(n.box,box).perimeter();
+        double cost = 2.*combined;
+        double inheritance = 2.*(combined-area);
+
+        double cost1 = Box::merge(box,nodes[n.child1].box).perimeter() + inheritance;
+        if(!nodes[n.child1].isLeaf()) cost1 -= nodes[n.child1].box.perimeter();
+        double cost2 = Box::merge(box,nodes[n.child2].box).perimeter() + inheritance;
+        if(!nodes[n.child2].isLeaf()) cost2 -= nodes[n.child2].box.perimeter();
+
+        if(cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? n.child1 : n.child2;
+    }
+
+    const int sibling = index;
+    const int oldParent = nodes[sibling].parent;
+    const int newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = Box::merge(box,nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if(oldParent >= 0){
+        if(nodes[oldParent].child1 == sibling){
+            nodes[oldParent].child1 = newParent;
+        }else{
+            nodes[oldParent].child2 = newParent;
+        }
+    }else{
+        root = newParent;
+    }
+
+    for(index = nodes[leaf].parent; index >= 0; index = nodes[index].parent){
+        index = balance(index);
+        refit(index);
+    }
+}
+
+void PF_EntityIndex::removeLeaf(int leaf)
+{
+    if(leaf == root){
+        root = -1;
+        return;
+    }
+
+    const int parent = nodes[leaf].parent;
+    const int grandParent = nodes[parent].parent;
+    const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if(grandParent >= 0){
+        if(nodes[grandParent].child1 == parent){
+            nodes[grandParent].child1 = sibling;
+        }else{
+            nodes[grandParent].child2 = sibling;
+        }
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        for(int index = grandParent; index >= 0; index = nodes[index].parent){
+            index = balance(index);
+            refit(index);
+        }
+    }else{
+        root = sibling;
+        nodes[sibling].parent = -1;
+        freeNode(parent);
+    }
+    nodes[leaf].parent = -1;
+}
+
+/*!
+ \brief 左右子树高度差大于1时进行旋转，返回旋转后该位置的节点。
+
+*/
+int PF_EntityIndex::balance(int iA)
+{
+    Node& A = nodes[iA];
+    if(A.isLeaf() || A.height < 2) return iA;
+
+    const int iB = A.child1;
+    const int iC = A.child2;
+    Node& B = nodes[iB];
+    Node& C = nodes[iC];
+    const int diff = C.height - B.height;
+
+    /** C上移 **/
+    if(diff > 1){
+        const int iF = C.child1;
+        const int iG = C.child2;
+        Node& F = nodes[iF];
+        Node& G = nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        if(C.parent >= 0){
+            if(nodes[C.parent].child1 == iA){
+                nodes[C.parent].child1 = iC;
+            }else{
+                nodes[C.parent].child2 = iC;
+            }
+        }else{
+            root = iC;
+        }
+
+        if(F.height > G.height){
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = Box::merge(B.box,G.box);
+            C.box = Box::merge(A.box,F.box);
+            A.height = 1 + std::max(B.height,G.height);
+            C.height = 1 + std::max(A.height,F.height);
+        }else{
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = Box::merge(B.box,F.box);
+            C.box = Box::merge(A.box,G.box);
+            A.height = 1 + std::max(B.height,F.height);
+            C.height = 1 + std::max(A.height,G.height);
+        }
+        return iC;
+    }
+
+    /** B上移 **/
+    if(diff < -1){
+        const int iD = B.child1;
+        const int iE = B.child2;
+        Node& D = nodes[iD];
+        Node& E = nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        if(B.parent >= 0){
+            if(nodes[B.parent].child1 == iA){
+                nodes[B.parent].child1 = iB;
+            }else{
+                nodes[B.parent].child2 = iB;
+            }
+        }else{
+            root = iB;
+        }
+
+        if(D.height > E.height){
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = Box::merge(C.box,E.box);
+            B.box = Box::merge(A.box,D.box);
+            A.height = 1 + std::max(C.height,E.height);
+            B.height = 1 + std::max(A.height,D.height);
+        }else{
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = Box::merge(C.box,D.box);
+            B.box = Box::merge(A.box,E.box);
+            A.height = 1 + std::max(C.height,D.height);
+            B.height = 1 + std::max(A.height,E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
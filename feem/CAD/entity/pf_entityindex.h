@@ -0,0 +1,107 @@
+#ifndef PF_ENTITYINDEX_H
+#define PF_ENTITYINDEX_H
+
+#include "pf_vector.h"
+
+#include <QHash>
+
+#include <functional>
+#include <vector>
+
+class PF_Entity;
+
+/*!
+ \brief 实体的空间索引，按照实体的包围盒（minV/maxV）组织成
+ 动态的二叉R树（AABB树）。
+
+ 插入时按包围盒周长增量最小的原则选择兄弟节点，插入和删除后
+ 通过旋转保持树的平衡，因此插入、删除和更新都是O(log n)。
+ 最近点查询按照到包围盒的距离从近到远访问实体，
+ 当包围盒的距离超过当前最优值时停止。
+
+ 每个实体还保存一个顺序号，与容器列表中的先后一致，
+ 用于距离相等时以O(1)比较实体的先后。
+*/
+class PF_EntityIndex
+{
+public:
+    PF_EntityIndex();
+    ~PF_EntityIndex()=default;
+
+    void insert(PF_Entity* e, const PF_Vector& minV, const PF_Vector& maxV, qint64 order=0);
+    bool remove(PF_Entity* e);
+    void update(PF_Entity* e, const PF_Vector& minV, const PF_Vector& maxV);
+    void translate(const PF_Vector& offset);
+    void clear();
+
+    bool contains(PF_Entity* e) const{
+        return leaves.contains(e);
+    }
+    int size() const{
+        return leaves.size();
+    }
+    void setOrder(PF_Entity* e, qint64 order);
+    qint64 order(PF_Entity* e) const;
+    bool bounds(PF_Entity* e, PF_Vector& minV, PF_Vector& maxV) const;
+    bool getBounds(PF_Vector& minV, PF_Vector& maxV) const;
+
+    /*!
+     \brief 访问函数，参数为实体，返回目前找到的最小距离。
+    */
+    typedef std::function<double(PF_Entity*)> NearestVisitor;
+    void nearest(const PF_Vector& coord, const NearestVisitor& visit) const;
+
+    void query(const PF_Vector& minV, const PF_Vector& maxV,
+               std::vector<PF_Entity*>& result) const;
+
+private:
+    struct Box{
+        double x0, y0, x1, y1;
+
+        double perimeter() const{
+            return 2.*((x1-x0)+(y1-y0));
+        }
+        bool contains(const Box& b) const{
+            return x0 <= b.x0 && y0 <= b.y0 && b.x1 <= x1 && b.y1 <= y1;
+        }
+        bool overlaps(const Box& b) const{
+            return !(b.x0 > x1 || b.x1 < x0 || b.y0 > y1 || b.y1 < y0);
+        }
+        double distanceTo(const PF_Vector& p) const;
+        static Box merge(const Box& a, const Box& b);
+    };
+
+    struct Node{
+        Box box;
+        int parent;
+        int child1;
+        int child2;
+        int height;     /**叶子为0，空闲节点为-1**/
+        PF_Entity* entity;
+
+        bool isLeaf() const{
+            return child1 < 0;
+        }
+    };
+
+    static Box makeBox(const PF_Vector& minV, const PF_Vector& maxV);
+    static bool isEmpty(const PF_Vector& minV, const PF_Vector& maxV);
+    int allocateNode();
+    void freeNode(int id);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int a);
+    void refit(int id);
+
+private:
+    std::vector<Node> nodes;
+    int root;
+    int freeList;
+    struct Leaf{
+        int node;       /**包围盒为空时为-1**/
+        qint64 order;   /**在容器列表中的顺序**/
+    };
+    QHash<PF_Entity*,Leaf> leaves;
+};
+
+#endif // PF_ENTITYINDEX_H
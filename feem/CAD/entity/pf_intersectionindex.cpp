@@ -0,0 +1,354 @@
+#include "pf_intersectionindex.h"
+#include "pf_entitycontainer.h"
+#include "pf_entityindex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/** 参数方向上的容差，端点处的交点也算作交点 **/
+const double ParamTolerance = 1.0e-9;
+
+bool boxesOverlap(const PF_Entity* e1, const PF_Entity* e2)
+{
+    const PF_Vector min1 = e1->getMin();
+    const PF_Vector max1 = e1->getMax();
+    const PF_Vector min2 = e2->getMin();
+    const PF_Vector max2 = e2->getMax();
+    return !(min2.x > max1.x + PF_TOLERANCE || max2.x < min1.x - PF_TOLERANCE
+             || min2.y > max1.y + PF_TOLERANCE || max2.y < min1.y - PF_TOLERANCE);
+}
+
+double cross(const PF_Vector& a, const PF_Vector& b)
+{
+    return a.x*b.y - a.y*b.x;
+}
+
+/*!
+ \brief 线段与线段求交，平行的线段只取重合的端点。
+
+*/
+void lineLine(const PF_Vector& p1, const PF_Vector& p2,
+              const PF_Vector& q1, const PF_Vector& q2,
+              std::vector<PF_Vector>& out)
+{
+    const PF_Vector d1 = p2 - p1;
+    const PF_Vector d2 = q2 - q1;
+    const double den = cross(d1,d2);
+    const double scale = d1.magnitude()*d2.magnitude();
+    if(scale < PF_TOLERANCE2) return;
+
+    if(std::fabs(den) <= PF_TOLERANCE_ANGLE*scale){
+        const double tol = PF_TOLERANCE*std::sqrt(scale);
+        for(const PF_Vector& p : {p1,p2}){
+            if(p.distanceTo(q1) <= tol || p.distanceTo(q2) <= tol){
+                out.push_back(p);
+            }
+        }
+        return;
+    }
+
+    const PF_Vector w = q1 - p1;
+    const double t = cross(w,d2)/den;
+    const double u = cross(w,d1)/den;
+    if(t < -ParamTolerance || t > 1. + ParamTolerance
+            || u < -ParamTolerance || u > 1. + ParamTolerance){
+        return;
+    }
+    out.push_back(p1 + d1*t);
+}
+
+/*!
+ \brief 线段与圆求交，相切时只有一个交点。
+
+*/
+void lineCircle(const PF_Vector& p1, const PF_Vector& p2,
+                const PF_Vector& c, double r,
+                std::vector<PF_Vector>& out)
+{
+    const PF_Vector d = p2 - p1;
+    const PF_Vector f = p1 - c;
+    const double a = d.squared();
+    if(a < PF_TOLERANCE2) return;
+    const double b = f.dotP(d);
+    const double cc = f.squared() - r*r;
+    double disc = b*b - a*cc;
+    const double tol = PF_TOLERANCE*std::max(1.,b*b);
+    if(disc < -tol) return;
+
+    std::vector<double> ts;
+    if(disc <= tol){
+        ts.push_back(-b/a);
+    }else{
+        disc = std::sqrt(disc);
+        ts.push_back((-b - disc)/a);
+        ts.push_back((-b + disc)/a);
+    }
+    for(double t : ts){
+        if(t >= -ParamTolerance && t <= 1. + ParamTolerance){
+            out.push_back(p1 + d*t);
+        }
+    }
+}
+
+/*!
+ \brief 圆与圆求交，同心圆没有交点。
+
+*/
+void circleCircle(const PF_Vector& c1, double r1,
+                  const PF_Vector& c2, double r2,
+                  std::vector<PF_Vector>& out)
+{
+    const PF_Vector dc = c2 - c1;
+    const double d = dc.magnitude();
+    const double tol = PF_TOLERANCE*std::max(1.,r1 + r2);
+    if(d < tol) return;
+    if(d > r1 + r2 + tol || d < std::fabs(r1 - r2) - tol) return;
+
+    const double a = (r1*r1 - r2*r2 + d*d)/(2.*d);
+    const double h2 = r1*r1 - a*a;
+    const PF_Vector base = c1 + dc*(a/d);
+    if(h2 <= tol*tol){
+        out.push_back(base);
+        return;
+    }
+    const double h = std::sqrt(h2);
+    const PF_Vector perp(-dc.y*h/d, dc.x*h/d);
+    out.push_back(base + perp);
+    out.push_back(base - perp);
+}
+
+}
+
+PF_IntersectionIndex::PF_IntersectionIndex()
+    :needRebuild(true)
+{
+
+}
+
+void PF_IntersectionIndex::invalidate(PF_Entity *e)
+{
+    if(!needRebuild) dirty.insert(e);
+}
+
+void PF_IntersectionIndex::invalidateAll()
+{
+    needRebuild = true;
+    dirty.clear();
+}
+
+/*!
+ \brief 实体从容器中删除，立即删除它的交点，之后不会再访问该实体。
+
+*/
+void PF_IntersectionIndex::remove(PF_Entity *e)
+{
+    dirty.remove(e);
+    hits.erase(std::remove_if(hits.begin(),hits.end(),[e](const Hit& h){
+        return h.a == e || h.b == e;
+    }),hits.end());
+}
+
+/*!
+ \brief 所有实体平移，交点一起平移，x坐标的顺序不变。
+
+*/
+void PF_IntersectionIndex::translate(const PF_Vector &offset)
+{
+    for(auto& h : hits){
+        h.point += offset;
+    }
+}
+
+void PF_IntersectionIndex::clear()
+{
+    hits.clear();
+    dirty.clear();
+    needRebuild = false;
+}
+
+/*!
+ \brief 把实体展开为参与求交的原子实体，目前只有直线和圆。
+
+*/
+void PF_IntersectionIndex::collectCurves(PF_Entity *e, PF_Entity *owner, std::vector<Curve> &curves)
+{
+    if(e->isContainer()){
+        for(auto child : static_cast<PF_EntityContainer*>(e)->getEntityList()){
+            collectCurves(child,owner,curves);
+        }
+        return;
+    }
+    switch(e->rtti()){
+    case PF::EntityLine:
+    case PF::EntityCircle:
+        curves.push_back(Curve{e,owner});
+        break;
+    default:
+        break;
+    }
+}
+
+void PF_IntersectionIndex::intersect(const Curve &c1, const Curve &c2)
+{
+    if(c1.entity == c2.entity || !boxesOverlap(c1.entity,c2.entity)) return;
+
+    std::vector<PF_Vector> points;
+    PF_Entity* e1 = c1.entity;
+    PF_Entity* e2 = c2.entity;
+    const bool circle1 = e1->rtti() == PF::EntityCircle;
+    const bool circle2 = e2->rtti() == PF::EntityCircle;
+    if(!circle1 && !circle2){
+        lineLine(e1->getStartpoint(),e1->getEndpoint(),
+                 e2->getStartpoint(),e2->getEndpoint(),points);
+    }else if(circle1 && circle2){
+        circleCircle(e1->getCenter(),e1->getRadius(),
+                     e2->getCenter(),e2->getRadius(),points);
+    }else if(circle1){
+        lineCircle(e2->getStartpoint(),e2->getEndpoint(),
+                   e1->getCenter(),e1->getRadius(),points);
+    }else{
+        lineCircle(e1->getStartpoint(),e1->getEndpoint(),
+                   e2->getCenter(),e2->getRadius(),points);
+    }
+
+    for(const auto& p : points){
+        hits.push_back(Hit{p,c1.owner,c2.owner});
+    }
+}
+
+/*!
+ \brief 扫描线求所有交点，按包围盒左边界排序，活动表中保存
+ 右边界还没有被扫过的实体。
+
+*/
+void PF_IntersectionIndex::rebuild(const QList<PF_Entity *> &entities)
+{
+    hits.clear();
+    std::vector<Curve> curves;
+    for(auto e : entities){
+        collectCurves(e,e,curves);
+    }
+    std::sort(curves.begin(),curves.end(),[](const Curve& c1, const Curve& c2){
+        return c1.entity->getMin().x < c2.entity->getMin().x;
+    });
+
+    std::vector<Curve> active;
+    for(const auto& c : curves){
+        const double x = c.entity->getMin().x - PF_TOLERANCE;
+        for(size_t i = 0; i < active.size();){
+            if(active[i].entity->getMax().x < x){
+                active[i] = active.back();
+                active.pop_back();
+            }else{
+                intersect(active[i],c);
+                i++;
+            }
+        }
+        active.push_back(c);
+    }
+}
+
+void PF_IntersectionIndex::sortHits()
+{
+    std::sort(hits.begin(),hits.end(),[](const Hit& h1, const Hit& h2){
+        return h1.point.x < h2.point.x;
+    });
+}
+
+/*!
+ \brief 查询之前调用，处理所有变化过的实体。
+
+ \param entities 容器的直接子实体
+ \param index 容器的空间索引，用来查找与变化的实体可能相交的实体
+*/
+void PF_IntersectionIndex::update(const QList<PF_Entity *> &entities, const PF_EntityIndex &index)
+{
+    /** 变化的实体较多时重新扫描更快 **/
+    if(needRebuild || dirty.size() > entities.size()/4 + 1){
+        rebuild(entities);
+        sortHits();
+        dirty.clear();
+        needRebuild = false;
+        return;
+    }
+    if(dirty.isEmpty()) return;
+
+    hits.erase(std::remove_if(hits.begin(),hits.end(),[this](const Hit& h){
+        return dirty.contains(h.a) || dirty.contains(h.b);
+    }),hits.end());
+
+    QSet<PF_Entity*> done;
+    std::vector<PF_Entity*> candidates;
+    std::vector<Curve> curves;
+    std::vector<Curve> others;
+    for(auto e : dirty){
+        if(!index.contains(e)) continue;
+        curves.clear();
+        collectCurves(e,e,curves);
+
+        /** 同一个子实体内部的交点 **/
+        for(size_t i = 0; i < curves.size(); i++){
+            for(size_t j = i+1; j < curves.size(); j++){
+                intersect(curves[i],curves[j]);
+            }
+        }
+
+        /** 两个都变化的实体只在后处理的一个中求交 **/
+        candidates.clear();
+        index.query(e->getMin(),e->getMax(),candidates);
+        others.clear();
+        for(auto other : candidates){
+            if(other == e || (dirty.contains(other) && !done.contains(other))) continue;
+            collectCurves(other,other,others);
+        }
+        for(const auto& c : curves){
+            for(const auto& o : others){
+                intersect(c,o);
+            }
+        }
+        done.insert(e);
+    }
+    dirty.clear();
+    sortHits();
+}
+
+/*!
+ \brief 查找距离coord最近的交点，两个实体中有隐藏的时候忽略该交点。
+
+ \param coord 查询点
+ \param dist 返回距离，可以为空
+ \return 没有交点时返回无效的点
+*/
+PF_Vector PF_IntersectionIndex::getNearest(const PF_Vector &coord, double *dist) const
+{
+    PF_Vector closest(false);
+    double minDist = PF_MAXDOUBLE;
+
+    auto visit = [&](const Hit& h){
+        if(!h.a->isVisible() || !h.b->isVisible()) return;
+        const double d = h.point.distanceTo(coord);
+        if(d < minDist){
+            minDist = d;
+            closest = h.point;
+        }
+    };
+
+    auto it = std::lower_bound(hits.begin(),hits.end(),coord.x,[](const Hit& h, double x){
+        return h.point.x < x;
+    });
+    for(auto right = it; right != hits.end() && right->point.x - coord.x <= minDist; ++right){
+        visit(*right);
+    }
+    for(auto left = it; left != hits.begin();){
+        --left;
+        if(coord.x - left->point.x > minDist) break;
+        visit(*left);
+    }
+
+    if(dist){
+        *dist = minDist;
+    }
+    return closest;
+}
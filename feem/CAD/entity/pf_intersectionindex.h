@@ -0,0 +1,73 @@
+#ifndef PF_INTERSECTIONINDEX_H
+#define PF_INTERSECTIONINDEX_H
+
+#include "pf_vector.h"
+
+#include <QList>
+#include <QSet>
+
+#include <vector>
+
+class PF_Entity;
+class PF_EntityIndex;
+
+/*!
+ \brief 容器中实体之间交点的缓存，用于交点捕捉。
+
+ 第一次查询时用扫描线求出所有直线、圆之间的交点：按包围盒左边界
+ 排序后扫描，只对包围盒相交的实体对求交。之后实体发生变化时只
+ 标记为脏，下次查询前删除它的交点，并通过容器的空间索引找到
+ 可能相交的实体重新求交。交点按x坐标排序保存，查询最近的交点时
+ 从光标的x坐标向两侧搜索。
+*/
+class PF_IntersectionIndex
+{
+public:
+    PF_IntersectionIndex();
+    ~PF_IntersectionIndex()=default;
+
+    /** 以下函数由容器在实体变化时调用 **/
+    void invalidate(PF_Entity* e);
+    void invalidateAll();
+    void remove(PF_Entity* e);
+    void translate(const PF_Vector& offset);
+    void clear();
+
+    void update(const QList<PF_Entity*>& entities, const PF_EntityIndex& index);
+
+    PF_Vector getNearest(const PF_Vector& coord, double* dist=nullptr) const;
+
+    int size() const{
+        return int(hits.size());
+    }
+
+private:
+    /*!
+     \brief 参与求交的原子实体，owner为它所属的容器的直接子实体。
+    */
+    struct Curve{
+        PF_Entity* entity;
+        PF_Entity* owner;
+    };
+
+    /*!
+     \brief 两个实体的一个交点，a、b为所属的直接子实体。
+    */
+    struct Hit{
+        PF_Vector point;
+        PF_Entity* a;
+        PF_Entity* b;
+    };
+
+    static void collectCurves(PF_Entity* e, PF_Entity* owner, std::vector<Curve>& curves);
+    void intersect(const Curve& c1, const Curve& c2);
+    void rebuild(const QList<PF_Entity*>& entities);
+    void sortHits();
+
+private:
+    std::vector<Hit> hits;      /**按x坐标排序**/
+    QSet<PF_Entity*> dirty;
+    bool needRebuild;
+};
+
+#endif // PF_INTERSECTIONINDEX_H
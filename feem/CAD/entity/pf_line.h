@@ -17,6 +17,10 @@ public:
     PF_Line(PF_EntityContainer* parent,PF_GraphicView *view, const PF_LineData& d);
     PF_Line(PF_EntityContainer* parent,PF_GraphicView *view, const PF_Vector& pStart, const PF_Vector& pEnd);
 
+    PF::EntityType rtti() const override{
+        return PF::EntityLine;
+    }
+
     /** @return Start point of the entity */
     PF_Vector getStartpoint() const override{
         return data.startpoint;
@@ -141,7 +141,9 @@ void PF_Point::draw(QCPPainter *painter)
         painter->drawLine(QPointF(x-width,y-width + i),QPointF(x+width,y-width+i));
 //        qDebug()<<"line "<<i<<QPoint(x-width,y-width + i)<<QPoint(x+width,y-width+i);
     }
-    painter->drawText(QPoint(x,y),toString());
+    if(mParentPlot->labelsVisible()){
+        painter->drawText(QPoint(x,y),toString());
+    }
     /** 绘制控制点 **/
     if (isSelected()) {
 //		if (!e->isParentSelected()) {
@@ -16,6 +16,10 @@ class PF_Point : public PF_AtomicEntity
 public:
     PF_Point(PF_EntityContainer* parent, PF_GraphicView* view, const PF_PointData & d);
 
+    PF::EntityType rtti() const override{
+        return PF::EntityPoint;
+    }
+
 
     PF_Vector getCenter() const override;
     double getRadius() const override;
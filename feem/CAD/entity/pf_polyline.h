@@ -31,6 +31,10 @@ public:
     PF_Polyline(PF_EntityContainer* parent, PF_GraphicView* view, const PF_PolylineData &d);
     ~PF_Polyline() = default;
 
+    PF::EntityType rtti() const override{
+        return PF::EntityPolyline;
+    }
+
     /** @return Copy of data that defines the polyline. */
     PF_PolylineData getData() const {
         return data;
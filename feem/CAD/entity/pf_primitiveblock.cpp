@@ -0,0 +1,329 @@
+#include "pf_primitiveblock.h"
+#include "pf_entitycontainer.h"
+#include "pf_graphicview.h"
+#include "pf_renderbatch.h"
+
+#include <cmath>
+
+namespace {
+
+inline bool isLive(quint32 flags)
+{
+    return !(flags & (PF_PrimitiveStore::FlagDeleted | PF_PrimitiveStore::FlagHidden));
+}
+
+double normalizeAngle(double a)
+{
+    a = std::fmod(a, 2.*M_PI);
+    return a < 0. ? a + 2.*M_PI : a;
+}
+
+PF_Vector nearestOnLine(const PF_PrimitiveStore::LineData& l, const PF_Vector& coord)
+{
+    const double dx = l.x2 - l.x1, dy = l.y2 - l.y1;
+    const double a = dx*dx + dy*dy;
+    if(a < PF_TOLERANCE2){
+        return PF_Vector(l.x1, l.y1);
+    }
+    const double t = qBound(0., ((coord.x - l.x1)*dx + (coord.y - l.y1)*dy)/a, 1.);
+    return PF_Vector(l.x1 + dx*t, l.y1 + dy*t);
+}
+
+PF_Vector nearestOnArc(const PF_PrimitiveStore::ArcData& a, const PF_Vector& coord)
+{
+    const double angle = normalizeAngle(std::atan2(coord.y - a.cy, coord.x - a.cx));
+    if(PF_PrimitiveStore::isAngleBetween(angle, a.a1, a.a2)){
+        return PF_Vector(a.cx + a.r*std::cos(angle), a.cy + a.r*std::sin(angle));
+    }
+    const PF_Vector p1(a.cx + a.r*std::cos(a.a1), a.cy + a.r*std::sin(a.a1));
+    const PF_Vector p2(a.cx + a.r*std::cos(a.a2), a.cy + a.r*std::sin(a.a2));
+    return (coord - p1).squared() <= (coord - p2).squared() ? p1 : p2;
+}
+
+PF_Vector nearestOnCircle(const PF_PrimitiveStore::CircleData& c, const PF_Vector& coord)
+{
+    const double angle = std::atan2(coord.y - c.cy, coord.x - c.cx);
+    return PF_Vector(c.cx + c.r*std::cos(angle), c.cy + c.r*std::sin(angle));
+}
+
+/** 记录距离最近的点 **/
+struct Nearest{
+    PF_Vector coord;
+    PF_Vector point{false};
+    double dist2 = PF_MAXDOUBLE;
+    PF_PrimitiveHandle handle;
+
+    void test(const PF_Vector& p, PF_PrimitiveHandle::Type type, quint32 index){
+        const double d = (p - coord).squared();
+        if(d < dist2){
+            dist2 = d;
+            point = p;
+            handle.type = type;
+            handle.index = index;
+        }
+    }
+    PF_Vector result(double* dist) const{
+        if(dist){
+            *dist = point.valid ? std::sqrt(dist2) : PF_MAXDOUBLE;
+        }
+        return point;
+    }
+};
+
+}
+
+PF_PrimitiveBlock::PF_PrimitiveBlock(PF_EntityContainer *parent, PF_GraphicView *view)
+    :PF_Entity(parent,view)
+{
+
+}
+
+/*!
+ \brief 直接修改存储之后调用，更新包围盒并通知所属容器更新空间索引。
+
+*/
+void PF_PrimitiveBlock::primitivesChanged()
+{
+    store.invalidateBounds();
+    calculateBorders();
+    if(parent){
+        parent->updateEntity(this);
+    }
+}
+
+/*!
+ \brief 顺序扫描所有可见的图元，返回距离coord最近的图元。
+
+*/
+PF_PrimitiveHandle PF_PrimitiveBlock::nearestPrimitive(const PF_Vector &coord, double *dist) const
+{
+    Nearest n;
+    n.coord = coord;
+    const auto& lines = store.lineArray();
+    for(quint32 i = 0; i < lines.size(); i++){
+        if(isLive(lines[i].flags)) n.test(nearestOnLine(lines[i],coord),PF_PrimitiveHandle::Line,i);
+    }
+    const auto& arcs = store.arcArray();
+    for(quint32 i = 0; i < arcs.size(); i++){
+        if(isLive(arcs[i].flags)) n.test(nearestOnArc(arcs[i],coord),PF_PrimitiveHandle::Arc,i);
+    }
+    const auto& circles = store.circleArray();
+    for(quint32 i = 0; i < circles.size(); i++){
+        if(isLive(circles[i].flags)) n.test(nearestOnCircle(circles[i],coord),PF_PrimitiveHandle::Circle,i);
+    }
+    n.result(dist);
+    return n.handle;
+}
+
+/*!
+ \brief 按句柄创建一个临时实体，由调用者负责删除。圆弧目前没有对应的实体，返回nullptr。
+
+*/
+PF_Entity *PF_PrimitiveBlock::entityAt(const PF_PrimitiveHandle &h) const
+{
+    return store.createEntity(h,parent,mParentPlot);
+}
+
+/*!
+ \brief 把临时实体修改后的几何写回存储。
+
+*/
+bool PF_PrimitiveBlock::commit(const PF_PrimitiveHandle &h, const PF_Entity *e)
+{
+    if(!store.assign(h,e)){
+        return false;
+    }
+    primitivesChanged();
+    return true;
+}
+
+/*!
+ \brief 顺序扫描数组，跳过可见范围之外和小于一个像素的图元，按样式批量绘制。
+
+ 整个块被选中时所有图元用蓝色绘制，否则只有单独选中的图元用蓝色绘制。
+*/
+void PF_PrimitiveBlock::draw(QCPPainter *painter)
+{
+    if(!(painter && mParentPlot)){
+        qDebug()<<Q_FUNC_INFO<<"NULL";
+        return;
+    }
+
+    PF_Vector minV, maxV;
+    mParentPlot->getVisibleRange(minV, maxV);
+    if (painter->hasClipping()) {
+        const QRect clip = painter->clipBoundingRect().toAlignedRect();
+        const PF_Vector c1 = mParentPlot->toGraph(clip.left(), clip.bottom()+1);
+        const PF_Vector c2 = mParentPlot->toGraph(clip.right()+1, clip.top());
+        minV = PF_Vector::maximum(minV, PF_Vector::minimum(c1, c2));
+        maxV = PF_Vector::minimum(maxV, PF_Vector::maximum(c1, c2));
+        if (minV.x > maxV.x || minV.y > maxV.y) {
+            return;
+        }
+    }
+    const double pixelX = fabs(mParentPlot->toGraphDX(1));
+    const double pixelY = fabs(mParentPlot->toGraphDY(1));
+    auto culled = [&](double x0, double y0, double x1, double y1){
+        return x1 < minV.x || x0 > maxV.x || y1 < minV.y || y0 > maxV.y
+                || (x1 - x0 < pixelX && y1 - y0 < pixelY);
+    };
+
+    const QPen basePen = painter->pen();
+    const QBrush baseBrush = painter->brush();
+    QPen selectedPen = basePen;
+    selectedPen.setColor(QColor(0,0,255));
+    const bool blockSelected = isSelected();
+    auto penFor = [&](quint32 style, quint32 flags) -> QPen{
+        if(blockSelected || (flags & PF_PrimitiveStore::FlagSelected)) return selectedPen;
+        return style ? store.pen(style) : basePen;
+    };
+
+    PF_RenderBatch batch(mParentPlot);
+    for(const auto& l : store.lineArray()){
+        if(!isLive(l.flags)) continue;
+        if(culled(std::min(l.x1,l.x2),std::min(l.y1,l.y2),std::max(l.x1,l.x2),std::max(l.y1,l.y2))) continue;
+        batch.addLine(PF_Vector(l.x1,l.y1),PF_Vector(l.x2,l.y2),penFor(l.style,l.flags));
+    }
+    for(const auto& a : store.arcArray()){
+        if(!isLive(a.flags)) continue;
+        PF_Vector amin, amax;
+        PF_PrimitiveStore::arcBounds(a,amin,amax);
+        if(culled(amin.x,amin.y,amax.x,amax.y)) continue;
+        batch.addArc(PF_Vector(a.cx,a.cy),a.r,a.a1,a.a2,penFor(a.style,a.flags));
+    }
+    for(const auto& c : store.circleArray()){
+        if(!isLive(c.flags)) continue;
+        if(culled(c.cx - c.r,c.cy - c.r,c.cx + c.r,c.cy + c.r)) continue;
+        batch.addCircle(PF_Vector(c.cx,c.cy),c.r,penFor(c.style,c.flags),
+                        c.style ? store.brush(c.style) : baseBrush);
+    }
+    batch.flush(painter);
+}
+
+PF_Vector PF_PrimitiveBlock::getNearestEndpoint(const PF_Vector &coord, double *dist) const
+{
+    Nearest n;
+    n.coord = coord;
+    const auto& lines = store.lineArray();
+    for(quint32 i = 0; i < lines.size(); i++){
+        const auto& l = lines[i];
+        if(!isLive(l.flags)) continue;
+        n.test(PF_Vector(l.x1,l.y1),PF_PrimitiveHandle::Line,i);
+        n.test(PF_Vector(l.x2,l.y2),PF_PrimitiveHandle::Line,i);
+    }
+    const auto& arcs = store.arcArray();
+    for(quint32 i = 0; i < arcs.size(); i++){
+        const auto& a = arcs[i];
+        if(!isLive(a.flags)) continue;
+        n.test(PF_Vector(a.cx + a.r*std::cos(a.a1),a.cy + a.r*std::sin(a.a1)),PF_PrimitiveHandle::Arc,i);
+        n.test(PF_Vector(a.cx + a.r*std::cos(a.a2),a.cy + a.r*std::sin(a.a2)),PF_PrimitiveHandle::Arc,i);
+    }
+    return n.result(dist);
+}
+
+PF_Vector PF_PrimitiveBlock::getNearestPointOnEntity(const PF_Vector &coord, bool onEntity, double *dist, PF_Entity **entity) const
+{
+    Q_UNUSED(onEntity);
+    if (entity) {
+        *entity = const_cast<PF_PrimitiveBlock*>(this);
+    }
+    Nearest n;
+    n.coord = coord;
+    const auto& lines = store.lineArray();
+    for(quint32 i = 0; i < lines.size(); i++){
+        if(isLive(lines[i].flags)) n.test(nearestOnLine(lines[i],coord),PF_PrimitiveHandle::Line,i);
+    }
+    const auto& arcs = store.arcArray();
+    for(quint32 i = 0; i < arcs.size(); i++){
+        if(isLive(arcs[i].flags)) n.test(nearestOnArc(arcs[i],coord),PF_PrimitiveHandle::Arc,i);
+    }
+    const auto& circles = store.circleArray();
+    for(quint32 i = 0; i < circles.size(); i++){
+        if(isLive(circles[i].flags)) n.test(nearestOnCircle(circles[i],coord),PF_PrimitiveHandle::Circle,i);
+    }
+    return n.result(dist);
+}
+
+PF_Vector PF_PrimitiveBlock::getNearestCenter(const PF_Vector &coord, double *dist) const
+{
+    Nearest n;
+    n.coord = coord;
+    const auto& arcs = store.arcArray();
+    for(quint32 i = 0; i < arcs.size(); i++){
+        if(isLive(arcs[i].flags)) n.test(PF_Vector(arcs[i].cx,arcs[i].cy),PF_PrimitiveHandle::Arc,i);
+    }
+    const auto& circles = store.circleArray();
+    for(quint32 i = 0; i < circles.size(); i++){
+        if(isLive(circles[i].flags)) n.test(PF_Vector(circles[i].cx,circles[i].cy),PF_PrimitiveHandle::Circle,i);
+    }
+    return n.result(dist);
+}
+
+PF_Vector PF_PrimitiveBlock::getNearestMiddle(const PF_Vector &coord, double *dist, int middlePoints) const
+{
+    Q_UNUSED(middlePoints);
+    Nearest n;
+    n.coord = coord;
+    const auto& lines = store.lineArray();
+    for(quint32 i = 0; i < lines.size(); i++){
+        const auto& l = lines[i];
+        if(isLive(l.flags)) n.test(PF_Vector((l.x1 + l.x2)/2.,(l.y1 + l.y2)/2.),PF_PrimitiveHandle::Line,i);
+    }
+    const auto& arcs = store.arcArray();
+    for(quint32 i = 0; i < arcs.size(); i++){
+        const auto& a = arcs[i];
+        if(!isLive(a.flags)) continue;
+        double span = a.a2 - a.a1;
+        if(span < 0.) span += 2.*M_PI;
+        const double m = a.a1 + span/2.;
+        n.test(PF_Vector(a.cx + a.r*std::cos(m),a.cy + a.r*std::sin(m)),PF_PrimitiveHandle::Arc,i);
+    }
+    return n.result(dist);
+}
+
+PF_Vector PF_PrimitiveBlock::getNearestDist(double distance, const PF_Vector &coord, double *dist) const
+{
+    Q_UNUSED(distance);
+    Q_UNUSED(coord);
+    if(dist){
+        *dist = PF_MAXDOUBLE;
+    }
+    return PF_Vector(false);
+}
+
+void PF_PrimitiveBlock::move(const PF_Vector &offset)
+{
+    store.move(offset);
+    moveBorders(offset);
+}
+
+void PF_PrimitiveBlock::rotate(const PF_Vector &center, const double &angle)
+{
+    store.rotate(center,angle);
+    calculateBorders();
+}
+
+void PF_PrimitiveBlock::rotate(const PF_Vector &center, const PF_Vector &angleVector)
+{
+    store.rotate(center,angleVector.angle());
+    calculateBorders();
+}
+
+void PF_PrimitiveBlock::scale(const PF_Vector &center, const PF_Vector &factor)
+{
+    store.scale(center,factor);
+    calculateBorders();
+}
+
+void PF_PrimitiveBlock::mirror(const PF_Vector &axisPoint1, const PF_Vector &axisPoint2)
+{
+    store.mirror(axisPoint1,axisPoint2);
+    calculateBorders();
+}
+
+void PF_PrimitiveBlock::calculateBorders()
+{
+    if(!store.getBounds(minV,maxV)){
+        resetBorders();
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef PF_PRIMITIVEBLOCK_H
+#define PF_PRIMITIVEBLOCK_H
+
+#include "pf_entity.h"
+#include "pf_primitivestore.h"
+
+/*!
+ \brief 以紧凑数组保存大量直线、圆弧和圆的实体。
+
+ 导入的网格边界、DXF等包含几十万条线段时，每条线段一个PF_Line对象
+ 占用的内存和遍历时的缓存缺失都很可观。PF_PrimitiveBlock作为一个实体
+ 加入容器，内部的图元保存在PF_PrimitiveStore中，绘制时顺序扫描数组批量
+ 绘制，空间索引和瓦片只看到一个实体。需要单独编辑某个图元时，用entityAt()
+ 按句柄创建临时实体，修改后用commit()写回。
+*/
+class PF_PrimitiveBlock : public PF_Entity
+{
+public:
+    PF_PrimitiveBlock(PF_EntityContainer* parent, PF_GraphicView* view);
+    ~PF_PrimitiveBlock()=default;
+
+    PF::EntityType rtti() const override{
+        return PF::EntityPrimitives;
+    }
+    bool isContainer() const override{
+        return false;
+    }
+    bool isAtomic() const override{
+        return false;
+    }
+    unsigned int count() const override{
+        return unsigned(store.size());
+    }
+
+    PF_PrimitiveStore& getStore(){
+        return store;
+    }
+    const PF_PrimitiveStore& getStore() const{
+        return store;
+    }
+    void primitivesChanged();
+
+    PF_PrimitiveHandle nearestPrimitive(const PF_Vector& coord, double* dist=nullptr) const;
+    PF_Entity* entityAt(const PF_PrimitiveHandle& h) const;
+    bool commit(const PF_PrimitiveHandle& h, const PF_Entity* e);
+
+    /** 继承的虚函数 **/
+    void draw(QCPPainter* painter) override;
+
+    PF_Vector getNearestEndpoint(const PF_Vector& coord,
+                                 double* dist = nullptr) const override;
+    PF_Vector getNearestPointOnEntity(const PF_Vector& coord,
+                                      bool onEntity = true, double* dist = nullptr,
+                                      PF_Entity** entity=nullptr) const override;
+    PF_Vector getNearestCenter(const PF_Vector& coord,
+                               double* dist = nullptr) const override;
+    PF_Vector getNearestMiddle(const PF_Vector& coord,
+                               double* dist = nullptr,
+                               int middlePoints = 1) const override;
+    PF_Vector getNearestDist(double distance,
+                             const PF_Vector& coord,
+                             double* dist = nullptr) const override;
+
+    void move(const PF_Vector& offset) override;
+    void rotate(const PF_Vector& center, const double& angle) override;
+    void rotate(const PF_Vector& center, const PF_Vector& angleVector) override;
+    void scale(const PF_Vector& center, const PF_Vector& factor) override;
+    void mirror(const PF_Vector& axisPoint1, const PF_Vector& axisPoint2) override;
+
+    void calculateBorders() override;
+
+private:
+    PF_PrimitiveStore store;
+};
+
+#endif // PF_PRIMITIVEBLOCK_H
@@ -0,0 +1,454 @@
+#include "pf_primitivestore.h"
+#include "pf_circle.h"
+#include "pf_line.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double normalizeAngle(double a)
+{
+    a = std::fmod(a, 2.*M_PI);
+    return a < 0. ? a + 2.*M_PI : a;
+}
+
+PF_Vector rotatePoint(double x, double y, const PF_Vector& center, double c, double s)
+{
+    const double dx = x - center.x;
+    const double dy = y - center.y;
+    return PF_Vector(center.x + dx*c - dy*s, center.y + dx*s + dy*c);
+}
+
+}
+
+PF_PrimitiveStore::PF_PrimitiveStore()
+    :liveCount(0)
+    ,boundsValid(false)
+{
+    /** 样式0使用painter当前的画笔和画刷 **/
+    styles.push_back(Style{QPen(),QBrush()});
+}
+
+/*!
+ \brief 添加样式，相同的样式只保存一次。
+
+ \return 样式编号
+*/
+quint32 PF_PrimitiveStore::addStyle(const QPen &pen, const QBrush &brush)
+{
+    for(size_t i = 1; i < styles.size(); i++){
+        if(styles[i].pen == pen && styles[i].brush == brush){
+            return quint32(i);
+        }
+    }
+    styles.push_back(Style{pen,brush});
+    return quint32(styles.size() - 1);
+}
+
+template<class T>
+quint32 PF_PrimitiveStore::allocate(std::vector<T> &array, std::vector<quint32> &freeList, const T &item)
+{
+    liveCount++;
+    boundsValid = false;
+    if(!freeList.empty()){
+        const quint32 i = freeList.back();
+        freeList.pop_back();
+        array[i] = item;
+        return i;
+    }
+    array.push_back(item);
+    return quint32(array.size() - 1);
+}
+
+PF_PrimitiveHandle PF_PrimitiveStore::addLine(const PF_Vector &p1, const PF_Vector &p2, quint32 style)
+{
+    PF_PrimitiveHandle h;
+    h.type = PF_PrimitiveHandle::Line;
+    h.index = allocate(lines,freeLines,LineData{p1.x,p1.y,p2.x,p2.y,style,0});
+    return h;
+}
+
+PF_PrimitiveHandle PF_PrimitiveStore::addArc(const PF_Vector &center, double radius,
+                                             double angle1, double angle2, quint32 style)
+{
+    PF_PrimitiveHandle h;
+    h.type = PF_PrimitiveHandle::Arc;
+    h.index = allocate(arcs,freeArcs,ArcData{center.x,center.y,radius,
+                                             normalizeAngle(angle1),normalizeAngle(angle2),style,0});
+    return h;
+}
+
+PF_PrimitiveHandle PF_PrimitiveStore::addCircle(const PF_Vector &center, double radius, quint32 style)
+{
+    PF_PrimitiveHandle h;
+    h.type = PF_PrimitiveHandle::Circle;
+    h.index = allocate(circles,freeCircles,CircleData{center.x,center.y,radius,style,0});
+    return h;
+}
+
+quint32 *PF_PrimitiveStore::flagPtr(const PF_PrimitiveHandle &h)
+{
+    switch(h.type){
+    case PF_PrimitiveHandle::Line:
+        return h.index < lines.size() ? &lines[h.index].flags : nullptr;
+    case PF_PrimitiveHandle::Arc:
+        return h.index < arcs.size() ? &arcs[h.index].flags : nullptr;
+    case PF_PrimitiveHandle::Circle:
+        return h.index < circles.size() ? &circles[h.index].flags : nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+bool PF_PrimitiveStore::contains(const PF_PrimitiveHandle &h) const
+{
+    const quint32* f = const_cast<PF_PrimitiveStore*>(this)->flagPtr(h);
+    return f && !(*f & FlagDeleted);
+}
+
+quint32 PF_PrimitiveStore::flags(const PF_PrimitiveHandle &h) const
+{
+    const quint32* f = const_cast<PF_PrimitiveStore*>(this)->flagPtr(h);
+    return f ? *f : quint32(FlagDeleted);
+}
+
+void PF_PrimitiveStore::setFlag(const PF_PrimitiveHandle &h, quint32 flag, bool on)
+{
+    quint32* f = flagPtr(h);
+    if(!f || (*f & FlagDeleted)) return;
+    if(on){
+        *f |= flag;
+    }else{
+        *f &= ~flag;
+    }
+}
+
+/*!
+ \brief 删除图元，只做标记，下标在之后添加图元时重用。
+
+*/
+bool PF_PrimitiveStore::remove(const PF_PrimitiveHandle &h)
+{
+    quint32* f = flagPtr(h);
+    if(!f || (*f & FlagDeleted)) return false;
+    *f = FlagDeleted;
+    switch(h.type){
+    case PF_PrimitiveHandle::Line:
+        freeLines.push_back(h.index);
+        break;
+    case PF_PrimitiveHandle::Arc:
+        freeArcs.push_back(h.index);
+        break;
+    default:
+        freeCircles.push_back(h.index);
+        break;
+    }
+    liveCount--;
+    boundsValid = false;
+    return true;
+}
+
+void PF_PrimitiveStore::clear()
+{
+    lines.clear();
+    arcs.clear();
+    circles.clear();
+    freeLines.clear();
+    freeArcs.clear();
+    freeCircles.clear();
+    styles.resize(1);
+    liveCount = 0;
+    boundsValid = false;
+}
+
+void PF_PrimitiveStore::reserve(size_t lineCount, size_t arcCount, size_t circleCount)
+{
+    lines.reserve(lineCount);
+    arcs.reserve(arcCount);
+    circles.reserve(circleCount);
+}
+
+/*!
+ \brief 占用的内存，字节。
+
+*/
+size_t PF_PrimitiveStore::memoryUsage() const
+{
+    return lines.capacity()*sizeof(LineData)
+            + arcs.capacity()*sizeof(ArcData)
+            + circles.capacity()*sizeof(CircleData)
+            + (freeLines.capacity() + freeArcs.capacity() + freeCircles.capacity())*sizeof(quint32)
+            + styles.capacity()*sizeof(Style);
+}
+
+/*!
+ \brief 角度a是否在从a1逆时针到a2的范围内，角度都在[0,2π)之间。
+
+*/
+bool PF_PrimitiveStore::isAngleBetween(double a, double a1, double a2)
+{
+    if(a1 <= a2){
+        return a >= a1 && a <= a2;
+    }
+    return a >= a1 || a <= a2;
+}
+
+/*!
+ \brief 圆弧的包围盒由两个端点和经过的象限点确定。
+
+*/
+void PF_PrimitiveStore::arcBounds(const ArcData &a, PF_Vector &minV, PF_Vector &maxV)
+{
+    const double x1 = a.cx + a.r*std::cos(a.a1), y1 = a.cy + a.r*std::sin(a.a1);
+    const double x2 = a.cx + a.r*std::cos(a.a2), y2 = a.cy + a.r*std::sin(a.a2);
+    double minX = std::min(x1,x2), maxX = std::max(x1,x2);
+    double minY = std::min(y1,y2), maxY = std::max(y1,y2);
+    if(isAngleBetween(0.,a.a1,a.a2)) maxX = a.cx + a.r;
+    if(isAngleBetween(M_PI_2,a.a1,a.a2)) maxY = a.cy + a.r;
+    if(isAngleBetween(M_PI,a.a1,a.a2)) minX = a.cx - a.r;
+    if(isAngleBetween(1.5*M_PI,a.a1,a.a2)) minY = a.cy - a.r;
+    minV = PF_Vector(minX,minY);
+    maxV = PF_Vector(maxX,maxY);
+}
+
+bool PF_PrimitiveStore::bounds(const PF_PrimitiveHandle &h, PF_Vector &minV, PF_Vector &maxV) const
+{
+    if(!contains(h)) return false;
+    switch(h.type){
+    case PF_PrimitiveHandle::Line:{
+        const LineData& l = lines[h.index];
+        minV = PF_Vector(std::min(l.x1,l.x2),std::min(l.y1,l.y2));
+        maxV = PF_Vector(std::max(l.x1,l.x2),std::max(l.y1,l.y2));
+        break;
+    }
+    case PF_PrimitiveHandle::Arc:
+        arcBounds(arcs[h.index],minV,maxV);
+        break;
+    default:{
+        const CircleData& c = circles[h.index];
+        minV = PF_Vector(c.cx - c.r,c.cy - c.r);
+        maxV = PF_Vector(c.cx + c.r,c.cy + c.r);
+        break;
+    }
+    }
+    return true;
+}
+
+/*!
+ \brief 所有图元的包围盒，修改之后第一次调用时顺序扫描数组重新计算。
+
+ \return 没有图元时返回false
+*/
+bool PF_PrimitiveStore::getBounds(PF_Vector &minV, PF_Vector &maxV) const
+{
+    if(liveCount == 0) return false;
+    if(!boundsValid){
+        double minX = PF_MAXDOUBLE, minY = PF_MAXDOUBLE;
+        double maxX = PF_MINDOUBLE, maxY = PF_MINDOUBLE;
+        for(const auto& l : lines){
+            if(l.flags & FlagDeleted) continue;
+            minX = std::min(minX,std::min(l.x1,l.x2));
+            maxX = std::max(maxX,std::max(l.x1,l.x2));
+            minY = std::min(minY,std::min(l.y1,l.y2));
+            maxY = std::max(maxY,std::max(l.y1,l.y2));
+        }
+        for(const auto& a : arcs){
+            if(a.flags & FlagDeleted) continue;
+            PF_Vector amin, amax;
+            arcBounds(a,amin,amax);
+            minX = std::min(minX,amin.x);
+            maxX = std::max(maxX,amax.x);
+            minY = std::min(minY,amin.y);
+            maxY = std::max(maxY,amax.y);
+        }
+        for(const auto& c : circles){
+            if(c.flags & FlagDeleted) continue;
+            minX = std::min(minX,c.cx - c.r);
+            maxX = std::max(maxX,c.cx + c.r);
+            minY = std::min(minY,c.cy - c.r);
+            maxY = std::max(maxY,c.cy + c.r);
+        }
+        cachedMin = PF_Vector(minX,minY);
+        cachedMax = PF_Vector(maxX,maxY);
+        boundsValid = true;
+    }
+    minV = cachedMin;
+    maxV = cachedMax;
+    return true;
+}
+
+/*!
+ \brief 按句柄创建一个独立的实体，由调用者负责释放。
+
+ 目前还没有圆弧实体，圆弧返回nullptr。
+*/
+PF_Entity *PF_PrimitiveStore::createEntity(const PF_PrimitiveHandle &h,
+                                           PF_EntityContainer *parent, PF_GraphicView *view) const
+{
+    if(!contains(h)) return nullptr;
+
+    PF_Entity* e = nullptr;
+    quint32 style = 0;
+    quint32 f = 0;
+    switch(h.type){
+    case PF_PrimitiveHandle::Line:{
+        const LineData& l = lines[h.index];
+        e = new PF_Line(parent,view,PF_Vector(l.x1,l.y1),PF_Vector(l.x2,l.y2));
+        style = l.style;
+        f = l.flags;
+        break;
+    }
+    case PF_PrimitiveHandle::Circle:{
+        const CircleData& c = circles[h.index];
+        PF_CircleData d;
+        d.center = PF_Vector(c.cx,c.cy);
+        d.radius = c.r;
+        e = new PF_Circle(parent,view,d);
+        style = c.style;
+        f = c.flags;
+        break;
+    }
+    default:
+        return nullptr;
+    }
+
+    if(style > 0){
+        e->setPen(styles[style].pen);
+        e->setBrush(styles[style].brush);
+    }
+    if(f & FlagSelected) e->setFlag(PF::FlagSelected);
+    if(f & FlagHidden) e->delFlag(PF::FlagVisible);
+    e->calculateBorders();
+    return e;
+}
+
+/*!
+ \brief 把实体修改后的几何写回句柄对应的图元，类型必须一致。
+
+*/
+bool PF_PrimitiveStore::assign(const PF_PrimitiveHandle &h, const PF_Entity *e)
+{
+    if(!e || !contains(h)) return false;
+    switch(h.type){
+    case PF_PrimitiveHandle::Line:{
+        if(e->rtti() != PF::EntityLine) return false;
+        LineData& l = lines[h.index];
+        const PF_Vector s = e->getStartpoint();
+        const PF_Vector t = e->getEndpoint();
+        l.x1 = s.x; l.y1 = s.y;
+        l.x2 = t.x; l.y2 = t.y;
+        break;
+    }
+    case PF_PrimitiveHandle::Circle:{
+        if(e->rtti() != PF::EntityCircle) return false;
+        CircleData& c = circles[h.index];
+        const PF_Vector center = e->getCenter();
+        c.cx = center.x;
+        c.cy = center.y;
+        c.r = e->getRadius();
+        break;
+    }
+    default:
+        return false;
+    }
+    setFlag(h,FlagSelected,e->getFlag(PF::FlagSelected));
+    boundsValid = false;
+    return true;
+}
+
+void PF_PrimitiveStore::move(const PF_Vector &offset)
+{
+    for(auto& l : lines){
+        l.x1 += offset.x; l.y1 += offset.y;
+        l.x2 += offset.x; l.y2 += offset.y;
+    }
+    for(auto& a : arcs){
+        a.cx += offset.x; a.cy += offset.y;
+    }
+    for(auto& c : circles){
+        c.cx += offset.x; c.cy += offset.y;
+    }
+    if(boundsValid){
+        cachedMin += offset;
+        cachedMax += offset;
+    }
+}
+
+void PF_PrimitiveStore::rotate(const PF_Vector &center, double angle)
+{
+    const double c = std::cos(angle), s = std::sin(angle);
+    for(auto& l : lines){
+        const PF_Vector p1 = rotatePoint(l.x1,l.y1,center,c,s);
+        const PF_Vector p2 = rotatePoint(l.x2,l.y2,center,c,s);
+        l.x1 = p1.x; l.y1 = p1.y;
+        l.x2 = p2.x; l.y2 = p2.y;
+    }
+    for(auto& a : arcs){
+        const PF_Vector p = rotatePoint(a.cx,a.cy,center,c,s);
+        a.cx = p.x; a.cy = p.y;
+        a.a1 = normalizeAngle(a.a1 + angle);
+        a.a2 = normalizeAngle(a.a2 + angle);
+    }
+    for(auto& ci : circles){
+        const PF_Vector p = rotatePoint(ci.cx,ci.cy,center,c,s);
+        ci.cx = p.x; ci.cy = p.y;
+    }
+    boundsValid = false;
+}
+
+/*!
+ \brief 与PF_Circle::scale()相同，半径按x方向的比例缩放。
+
+*/
+void PF_PrimitiveStore::scale(const PF_Vector &center, const PF_Vector &factor)
+{
+    auto sx = [&](double x){ return center.x + (x - center.x)*factor.x; };
+    auto sy = [&](double y){ return center.y + (y - center.y)*factor.y; };
+    for(auto& l : lines){
+        l.x1 = sx(l.x1); l.y1 = sy(l.y1);
+        l.x2 = sx(l.x2); l.y2 = sy(l.y2);
+    }
+    for(auto& a : arcs){
+        a.cx = sx(a.cx); a.cy = sy(a.cy);
+        a.r *= std::fabs(factor.x);
+    }
+    for(auto& c : circles){
+        c.cx = sx(c.cx); c.cy = sy(c.cy);
+        c.r *= std::fabs(factor.x);
+    }
+    boundsValid = false;
+}
+
+/*!
+ \brief 镜像之后圆弧的方向相反，起点和终点交换。
+
+*/
+void PF_PrimitiveStore::mirror(const PF_Vector &axisPoint1, const PF_Vector &axisPoint2)
+{
+    const PF_Vector d = axisPoint2 - axisPoint1;
+    const double len2 = d.squared();
+    if(len2 < PF_TOLERANCE2) return;
+    const double axisAngle = d.angle();
+    auto reflect = [&](double& x, double& y){
+        const double t = ((x - axisPoint1.x)*d.x + (y - axisPoint1.y)*d.y)/len2;
+        const double px = axisPoint1.x + d.x*t, py = axisPoint1.y + d.y*t;
+        x = 2.*px - x;
+        y = 2.*py - y;
+    };
+    for(auto& l : lines){
+        reflect(l.x1,l.y1);
+        reflect(l.x2,l.y2);
+    }
+    for(auto& a : arcs){
+        reflect(a.cx,a.cy);
+        const double a1 = normalizeAngle(2.*axisAngle - a.a2);
+        const double a2 = normalizeAngle(2.*axisAngle - a.a1);
+        a.a1 = a1;
+        a.a2 = a2;
+    }
+    for(auto& c : circles){
+        reflect(c.cx,c.cy);
+    }
+    boundsValid = false;
+}
@@ -0,0 +1,173 @@
+#ifndef PF_PRIMITIVESTORE_H
+#define PF_PRIMITIVESTORE_H
+
+#include "pf_vector.h"
+
+#include <QBrush>
+#include <QPen>
+#include <QtGlobal>
+
+#include <vector>
+
+class PF_Entity;
+class PF_EntityContainer;
+class PF_GraphicView;
+
+/*!
+ \brief 紧凑存储中一个图元的句柄，由类型和数组下标组成。
+
+ 删除的图元只做标记，下标回收后才会被新的图元使用，
+ 所以在图元被删除之前句柄一直有效。
+*/
+struct PF_PrimitiveHandle
+{
+    enum Type : quint32 {
+        Line,
+        Arc,
+        Circle,
+        Invalid
+    };
+
+    Type type = Invalid;
+    quint32 index = 0;
+
+    bool isValid() const{
+        return type != Invalid;
+    }
+    bool operator==(const PF_PrimitiveHandle& h) const{
+        return type == h.type && index == h.index;
+    }
+};
+
+/*!
+ \brief 直线、圆弧和圆的紧凑存储。
+
+ 每种图元保存在各自连续的数组中，只有坐标、样式编号和标志位，
+ 直线40字节，圆弧48字节，圆32字节，而一个PF_Line对象连同QObject、
+ 画笔和画刷有几百字节。样式（画笔和画刷）在所有图元之间共享，
+ 编号0表示使用painter当前的样式。需要PF_Entity的接口时通过
+ createEntity()按句柄临时创建实体，修改之后用assign()写回。
+*/
+class PF_PrimitiveStore
+{
+public:
+    enum Flag : quint32 {
+        FlagDeleted  = 1,
+        FlagSelected = 2,
+        FlagHidden   = 4
+    };
+
+    struct LineData{
+        double x1, y1, x2, y2;
+        quint32 style;
+        quint32 flags;
+    };
+
+    /** 圆弧从角度a1逆时针到a2，单位为弧度 **/
+    struct ArcData{
+        double cx, cy, r, a1, a2;
+        quint32 style;
+        quint32 flags;
+    };
+
+    struct CircleData{
+        double cx, cy, r;
+        quint32 style;
+        quint32 flags;
+    };
+
+    PF_PrimitiveStore();
+    ~PF_PrimitiveStore()=default;
+
+    quint32 addStyle(const QPen& pen, const QBrush& brush=Qt::NoBrush);
+    const QPen& pen(quint32 style) const{
+        return styles[style].pen;
+    }
+    const QBrush& brush(quint32 style) const{
+        return styles[style].brush;
+    }
+    int styleCount() const{
+        return int(styles.size());
+    }
+
+    PF_PrimitiveHandle addLine(const PF_Vector& p1, const PF_Vector& p2, quint32 style=0);
+    PF_PrimitiveHandle addArc(const PF_Vector& center, double radius,
+                              double angle1, double angle2, quint32 style=0);
+    PF_PrimitiveHandle addCircle(const PF_Vector& center, double radius, quint32 style=0);
+    bool remove(const PF_PrimitiveHandle& h);
+    void clear();
+    void reserve(size_t lineCount, size_t arcCount=0, size_t circleCount=0);
+
+    bool contains(const PF_PrimitiveHandle& h) const;
+    quint32 flags(const PF_PrimitiveHandle& h) const;
+    void setFlag(const PF_PrimitiveHandle& h, quint32 flag, bool on=true);
+
+    /** 数组直接访问，包括已删除的图元，修改之后需要调用invalidateBounds() **/
+    const std::vector<LineData>& lineArray() const{
+        return lines;
+    }
+    const std::vector<ArcData>& arcArray() const{
+        return arcs;
+    }
+    const std::vector<CircleData>& circleArray() const{
+        return circles;
+    }
+    LineData& line(quint32 i){
+        return lines[i];
+    }
+    ArcData& arc(quint32 i){
+        return arcs[i];
+    }
+    CircleData& circle(quint32 i){
+        return circles[i];
+    }
+
+    int size() const{
+        return liveCount;
+    }
+    bool isEmpty() const{
+        return liveCount == 0;
+    }
+    size_t memoryUsage() const;
+
+    bool getBounds(PF_Vector& minV, PF_Vector& maxV) const;
+    bool bounds(const PF_PrimitiveHandle& h, PF_Vector& minV, PF_Vector& maxV) const;
+    void invalidateBounds(){
+        boundsValid = false;
+    }
+
+    PF_Entity* createEntity(const PF_PrimitiveHandle& h,
+                            PF_EntityContainer* parent, PF_GraphicView* view) const;
+    bool assign(const PF_PrimitiveHandle& h, const PF_Entity* e);
+
+    void move(const PF_Vector& offset);
+    void rotate(const PF_Vector& center, double angle);
+    void scale(const PF_Vector& center, const PF_Vector& factor);
+    void mirror(const PF_Vector& axisPoint1, const PF_Vector& axisPoint2);
+
+    static void arcBounds(const ArcData& a, PF_Vector& minV, PF_Vector& maxV);
+    static bool isAngleBetween(double a, double a1, double a2);
+
+private:
+    struct Style{
+        QPen pen;
+        QBrush brush;
+    };
+
+    quint32* flagPtr(const PF_PrimitiveHandle& h);
+    template<class T>
+    quint32 allocate(std::vector<T>& array, std::vector<quint32>& freeList, const T& item);
+
+private:
+    std::vector<LineData> lines;
+    std::vector<ArcData> arcs;
+    std::vector<CircleData> circles;
+    std::vector<quint32> freeLines, freeArcs, freeCircles;
+    std::vector<Style> styles;
+    int liveCount;
+
+    mutable bool boundsValid;
+    mutable PF_Vector cachedMin, cachedMax;
+};
+
+#endif // PF_PRIMITIVESTORE_H
@@ -0,0 +1,922 @@
+#include "pf_regionindex.h"
+#include "pf_entitycontainer.h"
+#include "pf_entityindex.h"
+#include "pf_pointhash.h"
+#include "pf_primitiveblock.h"
+
+#include <QMultiHash>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/** 圆弧离散为折线时每段转过的最大角度 **/
+const double ArcStep = M_PI/18.;
+
+double normalizeAngle(double a)
+{
+    a = std::fmod(a, 2.*M_PI);
+    return a < 0. ? a + 2.*M_PI : a;
+}
+
+double cross(const PF_Vector& a, const PF_Vector& b)
+{
+    return a.x*b.y - a.y*b.x;
+}
+
+bool boxesOverlap(const PF_Vector& min1, const PF_Vector& max1,
+                  const PF_Vector& min2, const PF_Vector& max2, double tol)
+{
+    return !(min2.x > max1.x + tol || max2.x < min1.x - tol
+             || min2.y > max1.y + tol || max2.y < min1.y - tol);
+}
+
+double signedArea(const std::vector<PF_Vector>& poly)
+{
+    double area = 0.;
+    for(size_t i = 0, j = poly.size()-1; i < poly.size(); j = i++){
+        area += poly[j].x*poly[i].y - poly[i].x*poly[j].y;
+    }
+    return area*0.5;
+}
+
+/** 射线法 **/
+bool polygonContains(const std::vector<PF_Vector>& poly, const PF_Vector& p)
+{
+    bool inside = false;
+    for(size_t i = 0, j = poly.size()-1; i < poly.size(); j = i++){
+        const PF_Vector& a = poly[i];
+        const PF_Vector& b = poly[j];
+        if((a.y > p.y) != (b.y > p.y)
+                && p.x < (b.x-a.x)*(p.y-a.y)/(b.y-a.y)+a.x){
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+int findRoot(std::vector<int>& parent, int i)
+{
+    while(parent[i] != i){
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+/*!
+ \brief 用水平线穿过区域，取最宽的一段内部区间的中点。
+
+ 水平线稍微偏离包围盒的中线，避免正好经过对称图形的顶点。
+*/
+PF_Vector labelPoint(const PF_RegionIndex::Region& r)
+{
+    const double y = r.minV.y + (r.maxV.y - r.minV.y)*0.5031;
+    std::vector<double> xs;
+    auto scan = [&](const std::vector<PF_Vector>& poly){
+        for(size_t i = 0, j = poly.size()-1; i < poly.size(); j = i++){
+            const PF_Vector& a = poly[i];
+            const PF_Vector& b = poly[j];
+            if((a.y > y) != (b.y > y)){
+                xs.push_back(a.x + (y - a.y)*(b.x - a.x)/(b.y - a.y));
+            }
+        }
+    };
+    scan(r.outer);
+    for(const auto& h : r.holes){
+        scan(h);
+    }
+    std::sort(xs.begin(),xs.end());
+    double width = -1., x = (r.minV.x + r.maxV.x)/2.;
+    for(size_t i = 0; i + 1 < xs.size(); i += 2){
+        if(xs[i+1] - xs[i] > width){
+            width = xs[i+1] - xs[i];
+            x = (xs[i] + xs[i+1])/2.;
+        }
+    }
+    return PF_Vector(x,y);
+}
+
+std::vector<qint64> regionKey(const PF_RegionIndex::Region& r, double quantum)
+{
+    return {std::llround(r.minV.x/quantum),std::llround(r.minV.y/quantum),
+                std::llround(r.maxV.x/quantum),std::llround(r.maxV.y/quantum),
+                std::llround(r.area/(quantum*quantum)),qint64(r.holes.size())};
+}
+
+}
+
+PF_Vector PF_RegionIndex::Curve::pointAt(double t) const
+{
+    if(!arc){
+        return p1 + (p2 - p1)*t;
+    }
+    return center + PF_Vector(angle + t)*radius;
+}
+
+PF_RegionIndex::PF_RegionIndex()
+    :needRebuild(true)
+    ,graphDirty(false)
+    ,tolerance(PF_TOLERANCE)
+    ,nextId(1)
+    ,rev(0)
+{
+
+}
+
+void PF_RegionIndex::invalidate(PF_Entity *e)
+{
+    if(!needRebuild) dirty.insert(e);
+}
+
+void PF_RegionIndex::invalidateAll()
+{
+    needRebuild = true;
+    dirty.clear();
+    removedBoxes.clear();
+}
+
+/*!
+ \brief 实体从容器中删除，记录它原来的包围盒，附近的实体在下次更新时重新打断。
+
+*/
+void PF_RegionIndex::remove(PF_Entity *e)
+{
+    dirty.remove(e);
+    if(needRebuild) return;
+    auto it = owners.find(e);
+    if(it == owners.end()) return;
+    removedBoxes.emplace_back(it->minV,it->maxV);
+    owners.erase(it);
+    graphDirty = true;
+}
+
+/*!
+ \brief 所有实体平移，打断参数不变，区域直接平移，编号保持不变。
+
+*/
+void PF_RegionIndex::translate(const PF_Vector &offset)
+{
+    for(auto& o : owners){
+        for(auto& c : o.curves){
+            c.p1 += offset;
+            c.p2 += offset;
+            c.center += offset;
+            c.minV += offset;
+            c.maxV += offset;
+        }
+        o.minV += offset;
+        o.maxV += offset;
+    }
+    for(auto& b : removedBoxes){
+        b.first += offset;
+        b.second += offset;
+    }
+
+    ids.clear();
+    for(auto& r : regions){
+        for(auto& p : r.outer){
+            p += offset;
+        }
+        for(auto& h : r.holes){
+            for(auto& p : h){
+                p += offset;
+            }
+        }
+        r.minV += offset;
+        r.maxV += offset;
+        r.labelPoint += offset;
+        ids[regionKey(r,tolerance*1e3)] = r.id;
+    }
+    for(auto& e : edges){
+        e.p1 += offset;
+        e.p2 += offset;
+        e.center += offset;
+    }
+    rev++;
+}
+
+void PF_RegionIndex::clear()
+{
+    owners.clear();
+    dirty.clear();
+    removedBoxes.clear();
+    regions.clear();
+    edges.clear();
+    order.clear();
+    ids.clear();
+    needRebuild = false;
+    graphDirty = false;
+    rev++;
+}
+
+/*!
+ \brief 查询之前调用，处理所有变化过的实体并重新生成区域。
+
+ \param entities 容器的直接子实体
+ \param index 容器的空间索引，用来查找与变化的实体可能相交的实体
+*/
+void PF_RegionIndex::update(const QList<PF_Entity *> &entities, const PF_EntityIndex &index)
+{
+    /** 变化的实体较多时重新扫描更快 **/
+    if(needRebuild || dirty.size() > entities.size()/4 + 1){
+        rebuild(entities);
+        dirty.clear();
+        needRebuild = false;
+        graphDirty = true;
+    }else if(!dirty.isEmpty() || !removedBoxes.empty()){
+        refresh(index);
+        graphDirty = true;
+    }
+    if(!graphDirty) return;
+
+    buildRegions();
+    assignIds();
+    graphDirty = false;
+    rev++;
+}
+
+/*!
+ \brief 查找包含coord的区域，嵌套时返回最内层的区域。
+
+ \return 区域在getRegions()中的下标，不在任何区域内时返回-1
+*/
+int PF_RegionIndex::regionAt(const PF_Vector &coord) const
+{
+    for(int i : order){
+        const Region& r = regions[i];
+        if(coord.x < r.minV.x || coord.x > r.maxV.x
+                || coord.y < r.minV.y || coord.y > r.maxV.y
+                || !polygonContains(r.outer,coord)){
+            continue;
+        }
+        bool inHole = false;
+        for(const auto& h : r.holes){
+            if(polygonContains(h,coord)){
+                inHole = true;
+                break;
+            }
+        }
+        if(!inHole) return i;
+    }
+    return -1;
+}
+
+/*!
+ \brief 把实体展开为直线和圆弧，owner为容器的直接子实体。
+
+*/
+void PF_RegionIndex::collectCurves(PF_Entity *e, PF_Entity *owner, std::vector<Curve> &curves)
+{
+    if(e->isContainer()){
+        for(auto child : static_cast<PF_EntityContainer*>(e)->getEntityList()){
+            collectCurves(child,owner,curves);
+        }
+        return;
+    }
+
+    auto addLine = [&](const PF_Vector& p1, const PF_Vector& p2){
+        if(p1.squaredTo(p2) < PF_TOLERANCE2) return;
+        Curve c;
+        c.owner = owner;
+        c.arc = false;
+        c.p1 = p1;
+        c.p2 = p2;
+        c.radius = c.angle = c.span = 0.;
+        c.minV = PF_Vector::minimum(p1,p2);
+        c.maxV = PF_Vector::maximum(p1,p2);
+        curves.push_back(c);
+    };
+    auto addArc = [&](const PF_Vector& center, double radius, double angle, double span){
+        if(radius <= PF_TOLERANCE || span <= PF_TOLERANCE_ANGLE) return;
+        Curve c;
+        c.owner = owner;
+        c.arc = true;
+        c.center = center;
+        c.radius = radius;
+        c.angle = normalizeAngle(angle);
+        c.span = std::min(span,2.*M_PI);
+        c.p1 = c.pointAt(0.);
+        c.p2 = c.pointAt(c.span);
+        c.minV = PF_Vector::minimum(c.p1,c.p2);
+        c.maxV = PF_Vector::maximum(c.p1,c.p2);
+        /** 经过的象限点 **/
+        for(int k = 0; k < 4; k++){
+            if(normalizeAngle(k*M_PI_2 - c.angle) <= c.span){
+                const PF_Vector q = center + PF_Vector(k*M_PI_2)*radius;
+                c.minV = PF_Vector::minimum(c.minV,q);
+                c.maxV = PF_Vector::maximum(c.maxV,q);
+            }
+        }
+        curves.push_back(c);
+    };
+
+    switch(e->rtti()){
+    case PF::EntityLine:
+        addLine(e->getStartpoint(),e->getEndpoint());
+        break;
+    case PF::EntityCircle:
+        addArc(e->getCenter(),e->getRadius(),0.,2.*M_PI);
+        break;
+    case PF::EntityPrimitives:{
+        const PF_PrimitiveStore& store = static_cast<PF_PrimitiveBlock*>(e)->getStore();
+        const quint32 skip = PF_PrimitiveStore::FlagDeleted | PF_PrimitiveStore::FlagHidden;
+        for(const auto& l : store.lineArray()){
+            if(!(l.flags & skip)) addLine(PF_Vector(l.x1,l.y1),PF_Vector(l.x2,l.y2));
+        }
+        for(const auto& a : store.arcArray()){
+            if(!(a.flags & skip)) addArc(PF_Vector(a.cx,a.cy),a.r,a.a1,normalizeAngle(a.a2 - a.a1));
+        }
+        for(const auto& c : store.circleArray()){
+            if(!(c.flags & skip)) addArc(PF_Vector(c.cx,c.cy),c.r,0.,2.*M_PI);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/*!
+ \brief 判断p是否在曲线上，并求出它的参数。
+
+*/
+bool PF_RegionIndex::param(const Curve &c, const PF_Vector &p, double &t) const
+{
+    if(!c.arc){
+        const PF_Vector d = c.p2 - c.p1;
+        const double a = d.squared();
+        const double eps = tolerance/std::sqrt(a);
+        t = (p - c.p1).dotP(d)/a;
+        if(t < -eps || t > 1. + eps) return false;
+        t = std::max(0.,std::min(1.,t));
+        return c.pointAt(t).distanceTo(p) <= tolerance;
+    }
+
+    if(std::fabs(p.distanceTo(c.center) - c.radius) > tolerance) return false;
+    const double eps = tolerance/c.radius;
+    t = normalizeAngle(std::atan2(p.y - c.center.y,p.x - c.center.x) - c.angle);
+    if(t > c.span + eps){
+        if(t < 2.*M_PI - eps) return false;
+        t = 0.;
+    }
+    t = std::min(t,c.span);
+    return true;
+}
+
+/*!
+ \brief 求b与a的交点，在a上记录打断参数。重合的直线或圆弧在对方的端点处打断。
+
+*/
+void PF_RegionIndex::split(Curve &a, const Curve &b) const
+{
+    std::vector<PF_Vector> points;
+    if(!a.arc && !b.arc){
+        const PF_Vector d1 = a.p2 - a.p1;
+        const PF_Vector d2 = b.p2 - b.p1;
+        const double den = cross(d1,d2);
+        if(std::fabs(den) <= PF_TOLERANCE_ANGLE*d1.magnitude()*d2.magnitude()){
+            points.push_back(b.p1);
+            points.push_back(b.p2);
+        }else{
+            points.push_back(a.p1 + d1*(cross(b.p1 - a.p1,d2)/den));
+        }
+    }else if(a.arc && b.arc){
+        const PF_Vector dc = b.center - a.center;
+        const double d = dc.magnitude();
+        const double r1 = a.radius, r2 = b.radius;
+        if(d <= tolerance){
+            if(std::fabs(r1 - r2) <= tolerance){
+                points.push_back(b.p1);
+                points.push_back(b.p2);
+            }
+        }else if(d <= r1 + r2 + tolerance && d >= std::fabs(r1 - r2) - tolerance){
+            const double l = (r1*r1 - r2*r2 + d*d)/(2.*d);
+            const PF_Vector base = a.center + dc*(l/d);
+            const double h2 = r1*r1 - l*l;
+            if(h2 <= tolerance*tolerance){
+                points.push_back(base);
+            }else{
+                const double h = std::sqrt(h2);
+                const PF_Vector perp(-dc.y*h/d,dc.x*h/d);
+                points.push_back(base + perp);
+                points.push_back(base - perp);
+            }
+        }
+    }else{
+        const Curve& line = a.arc ? b : a;
+        const Curve& circle = a.arc ? a : b;
+        const PF_Vector d = line.p2 - line.p1;
+        const PF_Vector f = line.p1 - circle.center;
+        const double len2 = d.squared();
+        const PF_Vector foot = line.p1 - d*(f.dotP(d)/len2);
+        const double h = foot.distanceTo(circle.center);
+        if(h <= circle.radius + tolerance){
+            if(h >= circle.radius - tolerance){
+                points.push_back(foot);
+            }else{
+                const double s = std::sqrt(circle.radius*circle.radius - h*h)/std::sqrt(len2);
+                points.push_back(foot + d*s);
+                points.push_back(foot - d*s);
+            }
+        }
+    }
+
+    const double eps = a.arc ? tolerance/a.radius : tolerance/a.p1.distanceTo(a.p2);
+    for(const auto& p : points){
+        double ta, tb;
+        if(!param(a,p,ta) || !param(b,p,tb)) continue;
+        if(ta > eps && ta < a.end() - eps){
+            a.splits.push_back(ta);
+        }
+    }
+}
+
+void PF_RegionIndex::collect(PF_Entity *e)
+{
+    Owner& o = owners[e];
+    o.curves.clear();
+    collectCurves(e,e,o.curves);
+    o.minV = e->getMin();
+    o.maxV = e->getMax();
+}
+
+/*!
+ \brief 扫描线求所有曲线的打断参数，按包围盒左边界排序，活动表中
+ 保存右边界还没有被扫过的曲线。
+
+*/
+void PF_RegionIndex::rebuild(const QList<PF_Entity *> &entities)
+{
+    owners.clear();
+    removedBoxes.clear();
+
+    /** 容差与图形的大小成比例 **/
+    double size = 1.;
+    for(auto e : entities){
+        collect(e);
+        const PF_Vector minV = e->getMin(), maxV = e->getMax();
+        size = std::max(size,std::max(std::fabs(minV.x),std::fabs(minV.y)));
+        size = std::max(size,std::max(std::fabs(maxV.x),std::fabs(maxV.y)));
+    }
+    tolerance = size*1e-9;
+
+    std::vector<Curve*> curves;
+    for(auto& o : owners){
+        for(auto& c : o.curves){
+            curves.push_back(&c);
+        }
+    }
+    std::sort(curves.begin(),curves.end(),[](const Curve* c1, const Curve* c2){
+        return c1->minV.x < c2->minV.x;
+    });
+
+    std::vector<Curve*> active;
+    for(auto c : curves){
+        const double x = c->minV.x - tolerance;
+        for(size_t i = 0; i < active.size();){
+            if(active[i]->maxV.x < x){
+                active[i] = active.back();
+                active.pop_back();
+                continue;
+            }
+            if(boxesOverlap(active[i]->minV,active[i]->maxV,c->minV,c->maxV,tolerance)){
+                split(*active[i],*c);
+                split(*c,*active[i]);
+            }
+            i++;
+        }
+        active.push_back(c);
+    }
+}
+
+/*!
+ \brief 局部更新：变化的实体与新、旧包围盒附近的实体重新求打断参数。
+
+ 一个实体的打断参数只来自与它相交的曲线，所以不在这些包围盒附近的
+ 实体的打断参数不会改变。
+*/
+void PF_RegionIndex::refresh(const PF_EntityIndex &index)
+{
+    const PF_Vector margin(tolerance,tolerance);
+    QSet<PF_Entity*> affected;
+    std::vector<PF_Entity*> found;
+    auto touch = [&](const PF_Vector& minV, const PF_Vector& maxV){
+        found.clear();
+        index.query(minV - margin,maxV + margin,found);
+        for(auto o : found){
+            affected.insert(o);
+        }
+    };
+
+    for(const auto& b : removedBoxes){
+        touch(b.first,b.second);
+    }
+    removedBoxes.clear();
+    for(auto e : dirty){
+        auto it = owners.find(e);
+        if(it != owners.end()){
+            touch(it->minV,it->maxV);
+            owners.erase(it);
+        }
+        if(index.contains(e)){
+            collect(e);
+            touch(e->getMin(),e->getMax());
+        }
+    }
+    dirty.clear();
+
+    /** 先补齐所有相关的实体，之后不再插入，引用保持有效 **/
+    std::vector<PF_Entity*> neighbours;
+    for(auto e : affected){
+        if(!owners.contains(e)) collect(e);
+    }
+    for(auto e : affected){
+        Owner& owner = owners[e];
+        for(auto& c : owner.curves){
+            c.splits.clear();
+        }
+        for(const auto& c : owner.curves){
+            found.clear();
+            index.query(c.minV - margin,c.maxV + margin,found);
+            for(auto o : found){
+                if(!owners.contains(o)) neighbours.push_back(o);
+            }
+        }
+    }
+    for(auto e : neighbours){
+        if(!owners.contains(e)) collect(e);
+    }
+
+    for(auto e : affected){
+        Owner& owner = owners[e];
+        for(auto& c : owner.curves){
+            found.clear();
+            index.query(c.minV - margin,c.maxV + margin,found);
+            for(auto o : found){
+                auto it = owners.constFind(o);
+                if(it == owners.constEnd()) continue;
+                for(const auto& d : it->curves){
+                    if(&d == &c || !boxesOverlap(c.minV,c.maxV,d.minV,d.maxV,tolerance)) continue;
+                    split(c,d);
+                }
+            }
+        }
+    }
+}
+
+/*!
+ \brief 用缓存的打断参数建立半边结构并提取所有的面。
+
+*/
+void PF_RegionIndex::buildRegions()
+{
+    regions.clear();
+    edges.clear();
+    order.clear();
+
+    struct Piece{
+        int v0, v1;
+        const Curve* curve;
+        double t0, t1;
+    };
+
+    /** 曲线在打断点处分段，端点合并为顶点，重复的边只保留一条 **/
+    PF_PointHash vertices(tolerance);
+    std::vector<Piece> pieces;
+    QMultiHash<quint64,int> edgeOfPair;
+    std::vector<double> params;
+    for(auto& o : owners){
+        for(auto& c : o.curves){
+            const double eps = c.arc ? tolerance/c.radius : tolerance/c.p1.distanceTo(c.p2);
+            std::sort(c.splits.begin(),c.splits.end());
+            params.clear();
+            params.push_back(0.);
+            for(double s : c.splits){
+                if(s - params.back() > eps) params.push_back(s);
+            }
+            if(c.end() - params.back() <= eps) params.pop_back();
+            params.push_back(c.end());
+            /** 没有打断的圆至少分成两段，避免自环 **/
+            if(params.size() == 2 && c.arc && c.p1.distanceTo(c.p2) <= tolerance){
+                params.insert(params.begin()+1,c.span/2.);
+            }
+
+            for(size_t i = 0; i + 1 < params.size(); i++){
+                const double t0 = params[i], t1 = params[i+1];
+                const int v0 = vertices.insert(c.pointAt(t0));
+                const int v1 = vertices.insert(c.pointAt(t1));
+                if(v0 == v1) continue;
+
+                const quint64 key = (quint64(quint32(std::min(v0,v1))) << 32) | quint32(std::max(v0,v1));
+                const PF_Vector mid = c.pointAt((t0 + t1)/2.);
+                bool duplicate = false;
+                for(auto it = edgeOfPair.constFind(key); it != edgeOfPair.constEnd() && it.key() == key; ++it){
+                    const Piece& e = pieces[it.value()];
+                    if(e.curve->pointAt((e.t0 + e.t1)/2.).distanceTo(mid) <= 10.*tolerance){
+                        duplicate = true;
+                        break;
+                    }
+                }
+                if(duplicate) continue;
+                edgeOfPair.insert(key,int(pieces.size()));
+                pieces.push_back(Piece{v0,v1,&c,t0,t1});
+            }
+        }
+    }
+
+    const int nv = vertices.size();
+    const int ne = int(pieces.size());
+
+    /** 第i段对外为第i条边，半边h对应的边编号为±(h/2+1) **/
+    edges.reserve(ne);
+    for(const auto& e : pieces){
+        const Curve& c = *e.curve;
+        Edge edge;
+        edge.p1 = vertices.point(e.v0);
+        edge.p2 = vertices.point(e.v1);
+        edge.arc = c.arc;
+        edge.center = c.center;
+        edge.radius = c.arc ? c.radius : 0.;
+        edge.angle = c.arc ? c.angle + e.t0 : 0.;
+        edge.span = c.arc ? e.t1 - e.t0 : 0.;
+        edges.push_back(edge);
+    }
+    auto edgeOf = [](int h){
+        return (h & 1) ? -(h/2 + 1) : h/2 + 1;
+    };
+
+    /** 反复删除度为1的顶点上的悬挂边 **/
+    std::vector<int> offset(nv+1,0);
+    for(const auto& e : pieces){
+        offset[e.v0+1]++;
+        offset[e.v1+1]++;
+    }
+    for(int i = 0; i < nv; i++){
+        offset[i+1] += offset[i];
+    }
+    std::vector<int> incident(offset[nv]);
+    std::vector<int> fill(offset.begin(),offset.end()-1);
+    for(int i = 0; i < ne; i++){
+        incident[fill[pieces[i].v0]++] = i;
+        incident[fill[pieces[i].v1]++] = i;
+    }
+    std::vector<int> degree(nv);
+    for(int v = 0; v < nv; v++){
+        degree[v] = offset[v+1] - offset[v];
+    }
+    std::vector<char> removed(ne,0);
+    std::vector<int> stack;
+    for(int v = 0; v < nv; v++){
+        if(degree[v] == 1) stack.push_back(v);
+    }
+    while(!stack.empty()){
+        const int v = stack.back();
+        stack.pop_back();
+        if(degree[v] != 1) continue;
+        for(int k = offset[v]; k < offset[v+1]; k++){
+            const int i = incident[k];
+            if(removed[i]) continue;
+            removed[i] = 1;
+            const Piece& e = pieces[i];
+            degree[e.v0]--;
+            degree[e.v1]--;
+            const int other = e.v0 == v ? e.v1 : e.v0;
+            if(degree[other] == 1) stack.push_back(other);
+            break;
+        }
+    }
+
+    /** 半边2i从v0到v1，2i+1从v1到v0。出边按切线方向排序，方向相同时按曲率排序 **/
+    struct HalfEdge{
+        int origin;
+        qint64 direction;
+        double curvature;
+    };
+    std::vector<HalfEdge> halves(2*ne);
+    for(int i = 0; i < ne; i++){
+        const Piece& e = pieces[i];
+        const Curve& c = *e.curve;
+        double dir0, dir1, k;
+        if(c.arc){
+            dir0 = c.angle + e.t0 + M_PI_2;
+            dir1 = c.angle + e.t1 - M_PI_2;
+            k = 1./c.radius;
+        }else{
+            dir0 = (c.p2 - c.p1).angle();
+            dir1 = dir0 + M_PI;
+            k = 0.;
+        }
+        halves[2*i] = HalfEdge{e.v0,std::llround(normalizeAngle(dir0)*1e9),k};
+        halves[2*i+1] = HalfEdge{e.v1,std::llround(normalizeAngle(dir1)*1e9),-k};
+    }
+
+    std::vector<int> outStart(nv+1,0);
+    for(int h = 0; h < 2*ne; h++){
+        if(!removed[h/2]) outStart[halves[h].origin+1]++;
+    }
+    for(int i = 0; i < nv; i++){
+        outStart[i+1] += outStart[i];
+    }
+    std::vector<int> outgoing(outStart[nv]);
+    fill.assign(outStart.begin(),outStart.end()-1);
+    for(int h = 0; h < 2*ne; h++){
+        if(!removed[h/2]) outgoing[fill[halves[h].origin]++] = h;
+    }
+    std::vector<int> position(2*ne,-1);
+    for(int v = 0; v < nv; v++){
+        auto first = outgoing.begin() + outStart[v];
+        auto last = outgoing.begin() + outStart[v+1];
+        std::sort(first,last,[&halves](int h1, int h2){
+            const HalfEdge& a = halves[h1];
+            const HalfEdge& b = halves[h2];
+            if(a.direction != b.direction) return a.direction < b.direction;
+            return a.curvature < b.curvature;
+        });
+        for(int k = outStart[v]; k < outStart[v+1]; k++){
+            position[outgoing[k]] = k;
+        }
+    }
+
+    /** 下一条半边为终点处在反向半边顺时针方向上的第一条出边，面在半边的左侧 **/
+    auto next = [&](int h){
+        const int twin = h ^ 1;
+        const int v = halves[twin].origin;
+        const int start = outStart[v];
+        const int deg = outStart[v+1] - start;
+        const int k = position[twin] - start;
+        return outgoing[start + (k + deg - 1)%deg];
+    };
+
+    /** 离散半边，不包括终点 **/
+    auto appendPolyline = [&](int h, std::vector<PF_Vector>& poly){
+        const Piece& e = pieces[h/2];
+        const bool forward = !(h & 1);
+        poly.push_back(vertices.point(forward ? e.v0 : e.v1));
+        if(!e.curve->arc) return;
+        const int n = std::max(2,int(std::ceil((e.t1 - e.t0)/ArcStep)));
+        for(int k = 1; k < n; k++){
+            const double s = double(k)/n;
+            poly.push_back(e.curve->pointAt(forward ? e.t0 + (e.t1 - e.t0)*s : e.t1 - (e.t1 - e.t0)*s));
+        }
+    };
+
+    std::vector<int> component(nv);
+    for(int v = 0; v < nv; v++){
+        component[v] = v;
+    }
+    for(int i = 0; i < ne; i++){
+        if(removed[i]) continue;
+        const int a = findRoot(component,pieces[i].v0);
+        const int b = findRoot(component,pieces[i].v1);
+        if(a != b) component[a] = b;
+    }
+
+    struct Hole{
+        std::vector<PF_Vector> poly;
+        std::vector<int> edges;
+        double area;
+        int component;
+    };
+    std::vector<Hole> holes;
+    std::vector<double> outerArea;
+    std::vector<int> regionComponent;
+    std::vector<char> visited(2*ne,0);
+    std::vector<int> cycle;
+    for(int h0 = 0; h0 < 2*ne; h0++){
+        if(visited[h0] || removed[h0/2]) continue;
+        cycle.clear();
+        int h = h0;
+        do{
+            visited[h] = 1;
+            cycle.push_back(h);
+            h = next(h);
+        }while(h != h0 && int(cycle.size()) <= 2*ne);
+
+        std::vector<PF_Vector> poly;
+        for(int k : cycle){
+            appendPolyline(k,poly);
+        }
+        const double area = signedArea(poly);
+        if(std::fabs(area) <= tolerance*tolerance) continue;
+        const int comp = findRoot(component,halves[h0].origin);
+        std::vector<int> cycleEdges;
+        cycleEdges.reserve(cycle.size());
+        for(int k : cycle){
+            cycleEdges.push_back(edgeOf(k));
+        }
+        if(area < 0.){
+            holes.push_back(Hole{poly,cycleEdges,-area,comp});
+            continue;
+        }
+
+        Region r;
+        r.id = 0;
+        r.outer.swap(poly);
+        r.outerEdges.swap(cycleEdges);
+        r.area = area;
+        r.minV = r.maxV = r.outer.front();
+        for(const auto& p : r.outer){
+            r.minV = PF_Vector::minimum(r.minV,p);
+            r.maxV = PF_Vector::maximum(r.maxV,p);
+        }
+        for(int k : cycle){
+            r.boundary.push_back(pieces[k/2].curve->owner);
+        }
+        std::sort(r.boundary.begin(),r.boundary.end());
+        r.boundary.erase(std::unique(r.boundary.begin(),r.boundary.end()),r.boundary.end());
+        regions.push_back(r);
+        outerArea.push_back(area);
+        regionComponent.push_back(comp);
+    }
+
+    order.resize(regions.size());
+    for(size_t i = 0; i < order.size(); i++){
+        order[i] = int(i);
+    }
+    std::sort(order.begin(),order.end(),[&outerArea](int a, int b){
+        return outerArea[a] < outerArea[b];
+    });
+
+    /** 每个连通分量的外边界是包含它的、属于其它分量的最小的面的孔，
+     *  面的包围盒按均匀网格分桶 **/
+    if(!holes.empty() && !regions.empty()){
+        PF_Vector gmin = regions.front().minV, gmax = regions.front().maxV;
+        for(const auto& r : regions){
+            gmin = PF_Vector::minimum(gmin,r.minV);
+            gmax = PF_Vector::maximum(gmax,r.maxV);
+        }
+        const int n = std::max(1,std::min(256,int(std::sqrt(double(regions.size())))));
+        const double cw = std::max(gmax.x - gmin.x,tolerance)/n;
+        const double ch = std::max(gmax.y - gmin.y,tolerance)/n;
+        auto cellX = [&](double x){ return std::max(0,std::min(n-1,int((x - gmin.x)/cw))); };
+        auto cellY = [&](double y){ return std::max(0,std::min(n-1,int((y - gmin.y)/ch))); };
+
+        std::vector<int> cellStart(n*n+1,0);
+        for(const auto& r : regions){
+            for(int y = cellY(r.minV.y); y <= cellY(r.maxV.y); y++){
+                for(int x = cellX(r.minV.x); x <= cellX(r.maxV.x); x++){
+                    cellStart[y*n + x+1]++;
+                }
+            }
+        }
+        for(size_t i = 1; i < cellStart.size(); i++){
+            cellStart[i] += cellStart[i-1];
+        }
+        std::vector<int> cellItems(cellStart.back());
+        fill.assign(cellStart.begin(),cellStart.end()-1);
+        for(int i : order){
+            const Region& r = regions[i];
+            for(int y = cellY(r.minV.y); y <= cellY(r.maxV.y); y++){
+                for(int x = cellX(r.minV.x); x <= cellX(r.maxV.x); x++){
+                    cellItems[fill[y*n + x]++] = i;
+                }
+            }
+        }
+
+        for(auto& hole : holes){
+            const PF_Vector& p = hole.poly.front();
+            if(p.x < gmin.x || p.x > gmax.x || p.y < gmin.y || p.y > gmax.y) continue;
+            const int cell = cellY(p.y)*n + cellX(p.x);
+            for(int k = cellStart[cell]; k < cellStart[cell+1]; k++){
+                Region& r = regions[cellItems[k]];
+                if(regionComponent[cellItems[k]] == hole.component
+                        || outerArea[cellItems[k]] <= hole.area
+                        || p.x < r.minV.x || p.x > r.maxV.x || p.y < r.minV.y || p.y > r.maxV.y
+                        || !polygonContains(r.outer,p)){
+                    continue;
+                }
+                r.area -= hole.area;
+                r.holes.push_back(std::move(hole.poly));
+                r.holeEdges.push_back(std::move(hole.edges));
+                break;
+            }
+        }
+    }
+
+    for(auto& r : regions){
+        r.labelPoint = labelPoint(r);
+    }
+}
+
+/*!
+ \brief 与上一次的区域按包围盒和面积匹配，匹配上的区域沿用原来的编号。
+
+*/
+void PF_RegionIndex::assignIds()
+{
+    const double quantum = tolerance*1e3;
+    std::map<std::vector<qint64>,int> current;
+    for(auto& r : regions){
+        const std::vector<qint64> key = regionKey(r,quantum);
+        auto it = ids.find(key);
+        if(it != ids.end() && !current.count(key)){
+            r.id = it->second;
+        }else{
+            r.id = nextId++;
+        }
+        current[key] = r.id;
+    }
+    ids.swap(current);
+}
@@ -0,0 +1,136 @@
+#ifndef PF_REGIONINDEX_H
+#define PF_REGIONINDEX_H
+
+#include "pf_vector.h"
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+#include <map>
+#include <vector>
+
+class PF_Entity;
+class PF_EntityIndex;
+
+/*!
+ \brief 容器中直线、圆弧和圆围成的闭合区域，用于给草图的面指定材料。
+
+ 所有曲线先在交点处打断，重合的端点合并为同一个顶点，悬挂的边被删除，
+ 剩下的边组成半边结构（DCEL）：每个顶点的出边按切线方向逆时针排序，
+ 沿着每条半边左侧的面行走得到所有的环。面积为正的环是有界的面，
+ 面积为负的环是一个连通分量的外边界，它作为孔属于包含它的面积最小的面。
+
+ 打断是最耗时的部分，每条曲线的打断参数被缓存。实体变化时只标记为脏，
+ 下次查询前重新计算它以及新、旧包围盒附近的实体的打断参数，
+ 然后用缓存的参数重新建立半边结构，代价与曲线数目成线性（排序除外）。
+ 区域的编号在几何不变时保持不变，材料可以按编号关联。
+ 相邻的区域共用打断后的边，区域的边界同时以边的编号给出，可以直接导出几何模型。
+*/
+class PF_RegionIndex
+{
+public:
+    /*!
+     \brief 在交点处打断后的一段曲线，相邻的区域共用同一条边。
+     圆弧从angle逆时针转过span，span小于2π。
+    */
+    struct Edge{
+        PF_Vector p1, p2;
+        bool arc;
+        PF_Vector center;
+        double radius, angle, span;
+    };
+
+    /*!
+     \brief 一个有界的面，圆弧已经离散为折线。
+    */
+    struct Region{
+        int id;                                     /**几何不变时保持不变**/
+        std::vector<PF_Vector> outer;               /**外边界，逆时针**/
+        std::vector<std::vector<PF_Vector> > holes; /**孔的边界，顺时针**/
+        std::vector<int> outerEdges;                /**外边界依次经过的边，为getEdges()的下标加一，反向时为负**/
+        std::vector<std::vector<int> > holeEdges;   /**每个孔依次经过的边，编号方式同上**/
+        std::vector<PF_Entity*> boundary;           /**组成边界的实体，为容器的直接子实体**/
+        PF_Vector minV;
+        PF_Vector maxV;
+        PF_Vector labelPoint;                       /**区域内部的一点，用于显示标签**/
+        double area;                                /**扣除孔之后的面积**/
+    };
+
+    PF_RegionIndex();
+    ~PF_RegionIndex()=default;
+
+    /** 以下函数由容器在实体变化时调用 **/
+    void invalidate(PF_Entity* e);
+    void invalidateAll();
+    void remove(PF_Entity* e);
+    void translate(const PF_Vector& offset);
+    void clear();
+
+    void update(const QList<PF_Entity*>& entities, const PF_EntityIndex& index);
+
+    const std::vector<Region>& getRegions() const{
+        return regions;
+    }
+    /** 所有打断后的边，包括不属于任何区域的悬挂边 **/
+    const std::vector<Edge>& getEdges() const{
+        return edges;
+    }
+    int regionAt(const PF_Vector& coord) const;
+
+    /** 区域每重新计算一次加一，用于判断列表是否需要刷新 **/
+    int revision() const{
+        return rev;
+    }
+
+private:
+    /*!
+     \brief 参与打断的曲线，圆为起始角为0、转角为2π的圆弧。参数t对直线
+     为[0,1]，对圆弧为相对起始角逆时针转过的角度[0,span]。
+    */
+    struct Curve{
+        PF_Entity* owner;
+        bool arc;
+        PF_Vector p1, p2;
+        PF_Vector center;
+        double radius, angle, span;
+        PF_Vector minV, maxV;
+        std::vector<double> splits;
+
+        double end() const{
+            return arc ? span : 1.;
+        }
+        PF_Vector pointAt(double t) const;
+    };
+
+    struct Owner{
+        std::vector<Curve> curves;
+        PF_Vector minV, maxV;
+    };
+
+    static void collectCurves(PF_Entity* e, PF_Entity* owner, std::vector<Curve>& curves);
+    bool param(const Curve& c, const PF_Vector& p, double& t) const;
+    void split(Curve& a, const Curve& b) const;
+    void collect(PF_Entity* e);
+    void rebuild(const QList<PF_Entity*>& entities);
+    void refresh(const PF_EntityIndex& index);
+    void buildRegions();
+    void assignIds();
+
+private:
+    QHash<PF_Entity*,Owner> owners;
+    QSet<PF_Entity*> dirty;
+    std::vector<std::pair<PF_Vector,PF_Vector> > removedBoxes;
+    bool needRebuild;
+    bool graphDirty;
+    double tolerance;
+
+    std::vector<Region> regions;
+    std::vector<Edge> edges;
+    std::vector<int> order;     /**按外边界面积从小到大排列的区域**/
+    std::map<std::vector<qint64>,int> ids;
+    int nextId;
+    int rev;
+};
+
+#endif // PF_REGIONINDEX_H
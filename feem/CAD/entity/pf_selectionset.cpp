@@ -0,0 +1,121 @@
+#include "pf_selectionset.h"
+
+namespace {
+
+inline int countTrailingZeros(quint64 w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+    while(!(w & 1)){
+        w >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+}
+
+PF_SelectionSet::PF_SelectionSet()
+    :selectedCount(0)
+{
+
+}
+
+/*!
+ \brief 实体加入容器时分配编号，已经存在的实体只更新选择状态。
+
+*/
+void PF_SelectionSet::add(PF_Entity *e, bool selected)
+{
+    if(!e) return;
+    if(slots.contains(e)){
+        set(e,selected);
+        return;
+    }
+    int slot;
+    if(!freeSlots.empty()){
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        entities[size_t(slot)] = e;
+    }else{
+        slot = int(entities.size());
+        entities.push_back(e);
+        if(size_t(slot)/64 >= bits.size()){
+            bits.push_back(0);
+        }
+    }
+    slots.insert(e,slot);
+    set(e,selected);
+}
+
+void PF_SelectionSet::remove(PF_Entity *e)
+{
+    auto it = slots.find(e);
+    if(it == slots.end()) return;
+    const int slot = it.value();
+    set(e,false);
+    slots.erase(it);
+    entities[size_t(slot)] = nullptr;
+    freeSlots.push_back(slot);
+}
+
+void PF_SelectionSet::clear()
+{
+    entities.clear();
+    bits.clear();
+    freeSlots.clear();
+    slots.clear();
+    selectedCount = 0;
+}
+
+/*!
+ \brief 设置实体的选择状态。
+
+ \return 状态发生变化时返回true
+*/
+bool PF_SelectionSet::set(PF_Entity *e, bool selected)
+{
+    auto it = slots.constFind(e);
+    if(it == slots.constEnd()) return false;
+    const int slot = it.value();
+    quint64& word = bits[size_t(slot)/64];
+    const quint64 mask = quint64(1) << (slot % 64);
+    if(bool(word & mask) == selected) return false;
+    if(selected){
+        word |= mask;
+        selectedCount++;
+    }else{
+        word &= ~mask;
+        selectedCount--;
+    }
+    return true;
+}
+
+bool PF_SelectionSet::test(PF_Entity *e) const
+{
+    auto it = slots.constFind(e);
+    if(it == slots.constEnd()) return false;
+    const int slot = it.value();
+    return bits[size_t(slot)/64] & (quint64(1) << (slot % 64));
+}
+
+/*!
+ \brief 按编号顺序返回所有选中的实体。
+
+*/
+void PF_SelectionSet::selected(std::vector<PF_Entity*> &result) const
+{
+    result.clear();
+    result.reserve(size_t(selectedCount));
+    for(size_t i = 0; i < bits.size(); i++){
+        quint64 w = bits[i];
+        while(w){
+            const int b = countTrailingZeros(w);
+            result.push_back(entities[i*64 + size_t(b)]);
+            w &= w - 1;
+        }
+    }
+}
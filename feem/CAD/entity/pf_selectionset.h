@@ -0,0 +1,49 @@
+#ifndef PF_SELECTIONSET_H
+#define PF_SELECTIONSET_H
+
+#include <QHash>
+#include <QtGlobal>
+
+#include <vector>
+
+class PF_Entity;
+
+/*!
+ \brief 容器中实体的选择状态，用位集合保存。
+
+ 实体加入容器时分配一个编号（删除后回收重用），第i位表示编号为i的
+ 实体是否被选中。切换选择只修改一位，统计和遍历选中的实体时
+ 按64位的字跳过没有选中的部分，与选中的数目而不是实体总数有关。
+ 实体自身的选择标志仍然保留，用于绘制，由PF_Entity::setSelected()同步。
+*/
+class PF_SelectionSet
+{
+public:
+    PF_SelectionSet();
+    ~PF_SelectionSet()=default;
+
+    void add(PF_Entity* e, bool selected=false);
+    void remove(PF_Entity* e);
+    void clear();
+
+    bool set(PF_Entity* e, bool selected);
+    bool test(PF_Entity* e) const;
+
+    int count() const{
+        return selectedCount;
+    }
+    bool isEmpty() const{
+        return selectedCount == 0;
+    }
+
+    void selected(std::vector<PF_Entity*>& result) const;
+
+private:
+    std::vector<PF_Entity*> entities;   /**编号对应的实体，空闲的编号为nullptr**/
+    std::vector<quint64> bits;
+    std::vector<int> freeSlots;
+    QHash<PF_Entity*,int> slots;
+    int selectedCount;
+};
+
+#endif // PF_SELECTIONSET_H
@@ -1,8 +1,8 @@
 #include "pf_cadwidget.h"
 
 #include "pf_graphicview.h"
-
-#include <stdio.h>
+#include "pf_document.h"
+#include "pf_meshscheduler.h"
 
 #include <QToolBar>
 #include <QPushButton>
@@ -11,11 +11,16 @@
 #include <QVBoxLayout>
 #include <QAction>
 #include <QStatusBar>
+#include <QFileDialog>
+#include <QMessageBox>
 
 QStatusBar* PF_CADWidget::statusbar = nullptr;
 
 PF_CADWidget::PF_CADWidget(PF_Document* doc, QWidget *parent)
     : QWidget(parent)
+    , document(nullptr)
+    , scheduler(new PF_MeshScheduler(this))
+    , meshJob(0)
 {
     if(doc == nullptr){
 
@@ -24,6 +29,9 @@ PF_CADWidget::PF_CADWidget(PF_Document* doc, QWidget *parent)
     }
     init();
     setSizePolicy(QSizePolicy::Preferred,QSizePolicy::Preferred);
+
+    connect(scheduler,&PF_MeshScheduler::meshFinished,this,&PF_CADWidget::onMeshFinished);
+    connect(scheduler,&PF_MeshScheduler::meshFailed,this,&PF_CADWidget::onMeshFailed);
 }
 
 PF_CADWidget::~PF_CADWidget()
@@ -140,8 +148,52 @@ PF_Document* PF_CADWidget::getDocument()
 */
 void PF_CADWidget::exportGmshGeo()
 {
-    FILE* fp = NULL;
+    QString filename = QFileDialog::getSaveFileName(this,tr("Export Gmsh geometry"),
+                                                    QString(),tr("Gmsh geometry (*.geo)"));
+    if(filename.isEmpty() || !document) return;
+
+    if(!document->exportGmshGeo(filename)){
+        QMessageBox::warning(this,tr("Export Gmsh geometry"),
+                             tr("Failed to export %1.").arg(filename));
+    }
+}
+
+/*!
+ \brief 提交一个Gmsh剖分任务。几何在提交时复制，剖分在后台线程中进行，
+ 期间可以继续编辑；还没有完成的上一个任务被取消。
+
+*/
+void PF_CADWidget::generateMesh()
+{
+    if(!document) return;
 
+    if(meshJob)
+        scheduler->cancel(meshJob);
+    meshJob = scheduler->submit(new PF_GmshMeshJob(document));
+    if(statusbar)
+        statusbar->showMessage(tr("Generating mesh..."));
+}
+
+/*!
+ \brief 剖分完成，网格交给文档。
+
+*/
+void PF_CADWidget::onMeshFinished(int id, PF_MeshResultPtr mesh)
+{
+    if(id != meshJob) return;
+    meshJob = 0;
+    document->setMesh(mesh);
+    if(statusbar)
+        statusbar->showMessage(tr("Mesh generated."),3000);
+}
+
+void PF_CADWidget::onMeshFailed(int id, const QString &error)
+{
+    if(id != meshJob) return;
+    meshJob = 0;
+    if(statusbar)
+        statusbar->clearMessage();
+    QMessageBox::warning(this,tr("Mesh"),tr("Failed to generate the mesh.\n%1").arg(error));
 }
 
 void PF_CADWidget::paintEvent(QPaintEvent *e)
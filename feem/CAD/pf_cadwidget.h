@@ -3,6 +3,8 @@
 
 #include <QWidget>
 
+#include "pf_meshjob.h"
+
 class QPushButton;
 class PF_GraphicView;
 class QToolBar;
@@ -11,6 +13,7 @@ class QAction;
 class QStatusBar;
 
 class PF_Document;
+class PF_MeshScheduler;
 /*!
  \brief 包含坐标轴和上方的按钮。
 
@@ -27,6 +30,7 @@ public:
     PF_Document* getDocument();
 
     void exportGmshGeo();
+    void generateMesh();
 
     void paintEvent(QPaintEvent *e);
 
@@ -42,9 +46,13 @@ private:
 
     PF_GraphicView* view;
     PF_Document* document;
+    PF_MeshScheduler* scheduler;/**在后台线程中剖分，剖分时可以继续编辑**/
+    int meshJob;/**最后提交的剖分任务，之前的结果被丢弃**/
 signals:
 
 public slots:
+    void onMeshFinished(int id, PF_MeshResultPtr mesh);
+    void onMeshFailed(int id, const QString& error);
 };
 
 #endif // PF_CADWIDGET_H
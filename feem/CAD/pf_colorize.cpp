@@ -0,0 +1,170 @@
+#include "pf_colorize.h"
+
+// SIMD paths of QCPColorGradient::colorize. The AVX2 path is compiled for AVX2 in its own function
+// and only selected at runtime, the rest of the file keeps the baseline instruction set. MSVC
+// allows AVX2 intrinsics without /arch:AVX2 and does not define __SSE2__ but always has it on x64.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#  define QCP_COLORIZE_AVX2
+#  include <immintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    define QCP_TARGET_AVX2
+#  else
+#    include <cpuid.h>
+#    define QCP_TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define QCP_COLORIZE_SSE2
+#  endif
+#endif
+
+#if defined(QCP_COLORIZE_AVX2)
+/*! \internal
+
+  Returns whether the CPU supports AVX2 and the operating system saves the YMM registers. The
+  result is determined once.
+*/
+static bool qcpCpuHasAvx2()
+{
+    static const bool hasAvx2 = []() -> bool
+    {
+#  if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        const int osxsaveAvx = (1<<27) | (1<<28);
+        if ((info[2] & osxsaveAvx) != osxsaveAvx || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1<<5)) != 0;
+#  else
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid_max(0, nullptr) < 7)
+            return false;
+        __cpuid(1, eax, ebx, ecx, edx);
+        const unsigned int osxsaveAvx = (1u<<27) | (1u<<28);
+        if ((ecx & osxsaveAvx) != osxsaveAvx)
+            return false;
+        unsigned int xcr0, xcr0High;
+        __asm__ ("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+        if ((xcr0 & 6) != 6)
+            return false;
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        return (ebx & (1u<<5)) != 0;
+#  endif
+    }();
+    return hasAvx2;
+}
+
+/*! \internal
+
+  AVX2 part of \ref qcpColorizeLinear, gathers eight colors at a time. Must only be called if \ref
+  qcpCpuHasAvx2 returns true. Returns the number of values processed, a multiple of eight.
+*/
+QCP_TARGET_AVX2 static int qcpColorizeLinearAvx2(const double *data, double lower, double posToIndexFactor, const unsigned int *colors, int levelCount, unsigned int *scanLine, int n)
+{
+    const __m256d lowerV = _mm256_set1_pd(lower);
+    const __m256d factorV = _mm256_set1_pd(posToIndexFactor);
+    const __m256d zeroV = _mm256_setzero_pd();
+    const __m256d maxV = _mm256_set1_pd(levelCount-1);
+    int i = 0;
+    for (; i+8 <= n; i += 8)
+    {
+        // _mm256_max_pd returns the second operand if the first one is NaN, so NaN maps to index 0
+        __m256d a = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(data+i), lowerV), factorV);
+        __m256d b = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(data+i+4), lowerV), factorV);
+        a = _mm256_min_pd(_mm256_max_pd(a, zeroV), maxV);
+        b = _mm256_min_pd(_mm256_max_pd(b, zeroV), maxV);
+        const __m256i index = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(a)), _mm256_cvttpd_epi32(b), 1);
+        const __m256i rgb = _mm256_i32gather_epi32(reinterpret_cast<const int*>(colors), index, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(scanLine+i), rgb);
+    }
+    return i;
+}
+#endif
+
+#if defined(QCP_COLORIZE_SSE2)
+/*! \internal
+
+  SSE2 part of \ref qcpColorizeLinear, converts four indices at a time. Returns the number of
+  values processed, a multiple of four.
+*/
+static int qcpColorizeLinearSse2(const double *data, double lower, double posToIndexFactor, const unsigned int *colors, int levelCount, unsigned int *scanLine, int n)
+{
+    const __m128d lowerV = _mm_set1_pd(lower);
+    const __m128d factorV = _mm_set1_pd(posToIndexFactor);
+    const __m128d zeroV = _mm_setzero_pd();
+    const __m128d maxV = _mm_set1_pd(levelCount-1);
+    int index[4];
+    int i = 0;
+    for (; i+4 <= n; i += 4)
+    {
+        __m128d a = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(data+i), lowerV), factorV);
+        __m128d b = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(data+i+2), lowerV), factorV);
+        a = _mm_min_pd(_mm_max_pd(a, zeroV), maxV);
+        b = _mm_min_pd(_mm_max_pd(b, zeroV), maxV);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(index), _mm_cvttpd_epi32(a));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(index+2), _mm_cvttpd_epi32(b));
+        scanLine[i] = colors[index[0]];
+        scanLine[i+1] = colors[index[1]];
+        scanLine[i+2] = colors[index[2]];
+        scanLine[i+3] = colors[index[3]];
+    }
+    return i;
+}
+#endif
+
+/*!
+  Returns whether \a path can be used on this CPU. \ref cpAuto and \ref cpScalar are always
+  available.
+*/
+bool qcpColorizePathAvailable(QCPColorizePath path)
+{
+    switch (path)
+    {
+        case cpAuto:
+        case cpScalar: return true;
+#if defined(QCP_COLORIZE_SSE2)
+        case cpSse2: return true;
+#endif
+#if defined(QCP_COLORIZE_AVX2)
+        case cpAvx2: return qcpCpuHasAvx2();
+#endif
+        default: return false;
+    }
+}
+
+/*!
+  Maps the contiguous \a data array linearly onto the color lookup table \a colors with
+  \a levelCount entries and writes the result to \a scanLine. This is the hot path of \ref
+  QCPColorGradient::colorize for non-periodic, linear gradients: indices are computed and clamped
+  in double precision and the colors are gathered eight at a time if the CPU supports AVX2,
+  otherwise four at a time with SSE2. Values below the range, and NaN, map to the first color. The
+  scalar loop handles the remainder and is the only path on other architectures.
+
+  \a path selects the implementation; paths that are not available (see \ref
+  qcpColorizePathAvailable) fall back to the scalar loop. All paths give the same result.
+*/
+void qcpColorizeLinear(const double *data, double lower, double posToIndexFactor, const unsigned int *colors, int levelCount, unsigned int *scanLine, int n, QCPColorizePath path)
+{
+    int i = 0;
+#if defined(QCP_COLORIZE_AVX2)
+    if ((path == cpAuto || path == cpAvx2) && qcpCpuHasAvx2())
+        i = qcpColorizeLinearAvx2(data, lower, posToIndexFactor, colors, levelCount, scanLine, n);
+#  if defined(QCP_COLORIZE_SSE2)
+    else if (path == cpAuto || path == cpSse2)
+        i = qcpColorizeLinearSse2(data, lower, posToIndexFactor, colors, levelCount, scanLine, n);
+#  endif
+#endif
+    for (; i < n; ++i)
+    {
+        int index = (data[i]-lower)*posToIndexFactor;
+        if (index < 0)
+            index = 0;
+        else if (index >= levelCount)
+            index = levelCount-1;
+        scanLine[i] = colors[index];
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef PF_COLORIZE_H
+#define PF_COLORIZE_H
+
+/*! \file
+  Inner loop of \ref QCPColorGradient::colorize for non-periodic, linear gradients. It does not
+  depend on Qt, colors are QRgb values (unsigned int), so the benchmark in bench/ can build it
+  without the rest of the plot.
+*/
+
+/*!
+  Defines which implementation \ref qcpColorizeLinear uses. \ref cpAuto picks the fastest one the
+  CPU supports, the others are only used to compare the implementations.
+*/
+enum QCPColorizePath { cpAuto   ///< AVX2 if available, otherwise SSE2, otherwise scalar
+                       ,cpScalar ///< one value at a time
+                       ,cpSse2   ///< four indices at a time, scalar lookups
+                       ,cpAvx2   ///< eight indices and lookups at a time
+                     };
+
+bool qcpColorizePathAvailable(QCPColorizePath path);
+void qcpColorizeLinear(const double *data, double lower, double posToIndexFactor, const unsigned int *colors, int levelCount, unsigned int *scanLine, int n, QCPColorizePath path=cpAuto);
+
+#endif // PF_COLORIZE_H
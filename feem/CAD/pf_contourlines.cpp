@@ -0,0 +1,212 @@
+#include "pf_contourlines.h"
+#include "pf_graphicview.h"
+
+#include <algorithm>
+
+namespace {
+
+/** 按符号域截取范围，与QCPColorMap的做法相同 **/
+QCPRange restrictToSignDomain(QCPRange result, QCP::SignDomain inSignDomain, bool& foundRange)
+{
+    if(inSignDomain == QCP::sdPositive){
+        if(result.lower <= 0 && result.upper > 0)
+            result.lower = result.upper*1e-3;
+        else if(result.lower <= 0 && result.upper <= 0)
+            foundRange = false;
+    }else if(inSignDomain == QCP::sdNegative){
+        if(result.upper >= 0 && result.lower < 0)
+            result.upper = result.lower*1e-3;
+        else if(result.upper >= 0 && result.lower >= 0)
+            foundRange = false;
+    }
+    return result;
+}
+
+}
+
+PF_ContourLines::PF_ContourLines(QCPAxis *keyAxis, QCPAxis *valueAxis)
+    :QCPAbstractPlottable(keyAxis, valueAxis)
+    ,mColorByLevel(false)
+    ,mDataRange(0,1)
+    ,mGradient(QCPColorGradient::gpJet)
+{
+    mPen = QPen(Qt::black,0);
+    mBrush = Qt::NoBrush;
+}
+
+PF_ContourLines::~PF_ContourLines()
+{
+}
+
+void PF_ContourLines::setContours(std::vector<PF_ContourExtractor::Contour> contours)
+{
+    mContours.swap(contours);
+    if(mContours.empty()){
+        mKeyBounds = QCPRange();
+        mValueBounds = QCPRange();
+        return;
+    }
+    PF_Vector minV = mContours.front().minV;
+    PF_Vector maxV = mContours.front().maxV;
+    for(const PF_ContourExtractor::Contour& c : mContours){
+        minV = PF_Vector::minimum(minV,c.minV);
+        maxV = PF_Vector::maximum(maxV,c.maxV);
+    }
+    mKeyBounds = QCPRange(minV.x,maxV.x);
+    mValueBounds = QCPRange(minV.y,maxV.y);
+}
+
+void PF_ContourLines::setColorByLevel(bool enabled)
+{
+    mColorByLevel = enabled;
+}
+
+void PF_ContourLines::setDataRange(const QCPRange &dataRange)
+{
+    if(!QCPRange::validRange(dataRange)) return;
+    mDataRange = dataRange.sanitizedForLinScale();
+}
+
+void PF_ContourLines::setGradient(const QCPColorGradient &gradient)
+{
+    mGradient = gradient;
+}
+
+/*!
+ \brief 把颜色范围设置为所有等值线的最小值和最大值。
+
+*/
+void PF_ContourLines::rescaleDataRange()
+{
+    if(mContours.empty()) return;
+    double lower = mContours.front().value;
+    double upper = lower;
+    for(const PF_ContourExtractor::Contour& c : mContours){
+        lower = std::min(lower,c.value);
+        upper = std::max(upper,c.value);
+    }
+    setDataRange(QCPRange(lower,upper));
+}
+
+/*!
+ \brief 在像素坐标下计算到各条等值线的最短距离，包围盒离得太远的线被跳过。
+
+*/
+double PF_ContourLines::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(details)
+    if((onlySelectable && mSelectable == QCP::stNone) || mContours.empty())
+        return -1;
+    if(!mKeyAxis || !mValueAxis)
+        return -1;
+    if(!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()))
+        return -1;
+
+    const double tolerance = mParentPlot->selectionTolerance();
+    double k1, v1, k2, v2;
+    pixelsToCoords(pos - QPointF(tolerance,tolerance),k1,v1);
+    pixelsToCoords(pos + QPointF(tolerance,tolerance),k2,v2);
+    QCPRange keyRange(k1,k2), valueRange(v1,v2);
+    keyRange.normalize();
+    valueRange.normalize();
+
+    const QCPVector2D p(pos);
+    double best = -1;
+    for(const PF_ContourExtractor::Contour& c : mContours){
+        if(!isVisible(c,keyRange,valueRange)) continue;
+        QPointF last = coordsToPixels(c.points.front().x,c.points.front().y);
+        for(size_t i=1;i<c.points.size();++i){
+            const QPointF next = coordsToPixels(c.points[i].x,c.points[i].y);
+            const double d = p.distanceSquaredToLine(QCPVector2D(last),QCPVector2D(next));
+            if(best < 0 || d < best) best = d;
+            last = next;
+        }
+    }
+    if(best < 0) return -1;
+    best = qSqrt(best);
+    if(best > tolerance) return -1;
+    if(details)
+        details->setValue(QCPDataSelection(QCPDataRange(0, 1)));
+    return best;
+}
+
+QCPRange PF_ContourLines::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
+{
+    foundRange = !mContours.empty();
+    return restrictToSignDomain(mKeyBounds,inSignDomain,foundRange);
+}
+
+QCPRange PF_ContourLines::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+    if(inKeyRange != QCPRange()){
+        if(mKeyBounds.upper < inKeyRange.lower || mKeyBounds.lower > inKeyRange.upper){
+            foundRange = false;
+            return QCPRange();
+        }
+    }
+    foundRange = !mContours.empty();
+    return restrictToSignDomain(mValueBounds,inSignDomain,foundRange);
+}
+
+void PF_ContourLines::draw(QCPPainter *painter)
+{
+    if(mContours.empty()) return;
+    if(!mKeyAxis || !mValueAxis) return;
+    applyDefaultAntialiasingHint(painter);
+
+    const QCPRange keyRange = mKeyAxis->range();
+    const QCPRange valueRange = mValueAxis->range();
+    const bool linear = mKeyAxis->scaleType() == QCPAxis::stLinear
+            && mValueAxis->scaleType() == QCPAxis::stLinear;
+    const QPointF o = coordsToPixels(0.,0.);
+    const QPointF ex = coordsToPixels(1.,0.) - o;
+    const QPointF ey = coordsToPixels(0.,1.) - o;
+
+    QPen pen = selected() && mSelectionDecorator ? mSelectionDecorator->pen() : mPen;
+    const bool colored = mColorByLevel && !selected();
+    painter->setBrush(Qt::NoBrush);
+    painter->setPen(pen);
+    int level = -1;
+    for(const PF_ContourExtractor::Contour& c : mContours){
+        if(!isVisible(c,keyRange,valueRange)) continue;
+        if(colored && c.level != level){
+            level = c.level;
+            pen.setColor(mGradient.color(c.value,mDataRange));
+            painter->setPen(pen);
+        }
+
+        mPolyline.resize(0);
+        QPointF last;
+        const int n = int(c.points.size());
+        for(int i=0;i<n;++i){
+            const PF_Vector& v = c.points[i];
+            const QPointF p = linear ? QPointF(o.x() + ex.x()*v.x + ey.x()*v.y,o.y() + ex.y()*v.x + ey.y()*v.y)
+                                     : coordsToPixels(v.x,v.y);
+            /** 相距不到半个像素的点合并，保留最后一个点 **/
+            if(i > 0 && i < n - 1 && qAbs(p.x() - last.x()) < 0.5 && qAbs(p.y() - last.y()) < 0.5)
+                continue;
+            mPolyline.append(p);
+            last = p;
+        }
+        painter->drawPolyline(mPolyline);
+    }
+}
+
+void PF_ContourLines::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    applyDefaultAntialiasingHint(painter);
+    QPen pen = mPen;
+    if(mColorByLevel){
+        QCPColorGradient gradient(mGradient);
+        pen.setColor(gradient.color(mDataRange.center(),mDataRange));
+    }
+    painter->setPen(pen);
+    painter->drawLine(QLineF(rect.left(),rect.center().y(),rect.right(),rect.center().y()));
+}
+
+bool PF_ContourLines::isVisible(const PF_ContourExtractor::Contour &c, const QCPRange &keyRange,
+                                const QCPRange &valueRange) const
+{
+    return c.maxV.x >= keyRange.lower && c.minV.x <= keyRange.upper
+            && c.maxV.y >= valueRange.lower && c.minV.y <= valueRange.upper;
+}
@@ -0,0 +1,65 @@
+#ifndef PF_CONTOURLINES_H
+#define PF_CONTOURLINES_H
+
+#include "pf_plot.h"
+#include "pf_contourextractor.h"
+
+#include <vector>
+
+/*!
+ \brief 把PF_ContourExtractor提取的所有等值线作为一个图形绘制，例如磁力线。
+
+ 等值线按等值排列，同一个等值的线共用一个画笔，只有等值变化时才切换画笔。
+ 包围盒在可见范围之外的线被跳过，相距不到半个像素的点被合并。
+ 可以用颜色渐变按等值着色，也可以全部使用plottable的画笔。
+*/
+class PF_ContourLines : public QCPAbstractPlottable
+{
+    Q_OBJECT
+public:
+    explicit PF_ContourLines(QCPAxis *keyAxis, QCPAxis *valueAxis);
+    ~PF_ContourLines() override;
+
+    void setContours(std::vector<PF_ContourExtractor::Contour> contours);
+    const std::vector<PF_ContourExtractor::Contour>& contours() const{
+        return mContours;
+    }
+
+    bool colorByLevel() const{
+        return mColorByLevel;
+    }
+    QCPRange dataRange() const{
+        return mDataRange;
+    }
+    QCPColorGradient gradient() const{
+        return mGradient;
+    }
+    void setColorByLevel(bool enabled);
+    void setDataRange(const QCPRange& dataRange);
+    void setGradient(const QCPColorGradient& gradient);
+    void rescaleDataRange();
+
+    /** 继承的虚函数 **/
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const override;
+    QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const override;
+    QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth,
+                           const QCPRange &inKeyRange=QCPRange()) const override;
+
+protected:
+    void draw(QCPPainter *painter) override;
+    void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const override;
+
+private:
+    bool isVisible(const PF_ContourExtractor::Contour& c, const QCPRange& keyRange,
+                   const QCPRange& valueRange) const;
+
+private:
+    std::vector<PF_ContourExtractor::Contour> mContours;
+    QCPRange mKeyBounds, mValueBounds;
+    bool mColorByLevel;
+    QCPRange mDataRange;
+    QCPColorGradient mGradient;
+    QPolygonF mPolyline;    /**绘制时复用的缓冲区**/
+};
+
+#endif // PF_CONTOURLINES_H
@@ -6,9 +6,12 @@
 #include <QMouseEvent>
 #include <QDebug>
 #include <QGridLayout>
+#include <QElapsedTimer>
+#include <QTimer>
 
 #include "pf_actioninterface.h"
 #include "pf_eventhandler.h"
+#include "pf_tilerenderer.h"
 
 
 /*! \var QCPAxis *PF_GraphicView::xAxis
@@ -120,6 +123,8 @@ PF_GraphicView::PF_GraphicView(PF_Document *doc, QWidget *parent)
     yAxis2(nullptr),
     legend(nullptr),
     eventHandler(new PF_EventHandler(this)),
+    container(nullptr),
+    redrawMethod(PF::RedrawNone),
     mBufferDevicePixelRatio(1.0), // will be adapted to primary screen below
     mPlotLayout(nullptr),
     mAutoAddPlottableToLegend(true),
@@ -137,6 +142,8 @@ PF_GraphicView::PF_GraphicView(PF_Document *doc, QWidget *parent)
     mSelectionRectMode(QCP::srmNone),
     mSelectionRect(nullptr),
     mOpenGl(false),
+    mLabelEntityLimit(500),
+    mTileEntityThreshold(100000),
     mMouseHasMoved(false),
     mMouseEventLayerable(nullptr),
     mMouseSignalLayerable(nullptr),
@@ -144,7 +151,11 @@ PF_GraphicView::PF_GraphicView(PF_Document *doc, QWidget *parent)
     mReplotQueued(false),
     mOpenGlMultisamples(16),
     mOpenGlAntialiasedElementsBackup(QCP::aeNone),
-    mOpenGlCacheLabelsBackup(true)
+    mOpenGlCacheLabelsBackup(true),
+    mLabelsVisible(true),
+    mReplotTime(0),
+    mTileRenderer(nullptr),
+    mTileTimer(new QTimer(this))
 {
     //qDebug()<<"PF_GraphicView::PF_GraphicView";
     if(doc){
@@ -186,6 +197,9 @@ PF_GraphicView::PF_GraphicView(PF_Document *doc, QWidget *parent)
     updateLayerIndices();
     setCurrentLayer(QLatin1String("main"));
     layer(QLatin1String("overlay"))->setMode(QCPLayer::lmBuffered);
+    /** 网格、实体分别缓存，只有辅助图形变化时不需要重绘实体 **/
+    layer(QLatin1String("grid"))->setMode(QCPLayer::lmBuffered);
+    layer(QLatin1String("main"))->setMode(QCPLayer::lmBuffered);
 
     // create initial layout, axis rect and legend:
     mPlotLayout = new QCPLayoutGrid;
@@ -260,6 +274,16 @@ PF_GraphicView::PF_GraphicView(PF_Document *doc, QWidget *parent)
 
     setViewport(rect()); // needs to be called after mPlotLayout has been created
 
+    /** 后台瓦片陆续完成，最多每16ms重绘一次实体图层 **/
+    mTileTimer->setSingleShot(true);
+    mTileTimer->setInterval(16);
+    connect(mTileTimer, &QTimer::timeout, this, [this](){
+        if (isBufferValid())
+            layer(QLatin1String("main"))->replot();
+        else
+            replot();
+    });
+
     replot(rpQueuedReplot);
 }
 
@@ -274,6 +298,9 @@ PF_GraphicView::~PF_GraphicView()
         mPlotLayout = nullptr;
     }
 
+    delete mTileRenderer;
+    mTileRenderer = nullptr;
+
     mCurrentLayer = nullptr;
     qDeleteAll(mLayers); // don't use removeLayer, because it would prevent the last layer to be removed
     mLayers.clear();
@@ -452,6 +479,9 @@ void PF_GraphicView::back()
 void PF_GraphicView::setContainer(PF_EntityContainer *_container)
 {
     this->container = _container;
+    /** 瓦片属于原来的图形 **/
+    delete mTileRenderer;
+    mTileRenderer = nullptr;
 }
 
 void PF_GraphicView::setCurrentAction(PF_ActionInterface *action)
@@ -488,11 +518,128 @@ PF_ActionInterface *PF_GraphicView::getDefaultAction()
     }
 }
 
+/*!
+ \brief 只重绘需要更新的图层，坐标范围或窗口大小变化后图层缓存失效，
+ 此时重绘所有图层。
+
+ \param method 需要重绘的图层
+*/
 void PF_GraphicView::redraw(PF::RedrawMethod method)
 {
     redrawMethod = (PF::RedrawMethod ) (redrawMethod | method);
-    update(); // Paint when reeady to pain
-    repaint(); //Paint immediate
+    if ((redrawMethod & PF::RedrawAll) == PF::RedrawAll || !isBufferValid()) {
+        if ((redrawMethod & PF::RedrawAll) == PF::RedrawAll && mTileRenderer)
+            mTileRenderer->invalidateAll();
+        redrawMethod = PF::RedrawNone;
+        replot();
+        return;
+    }
+
+    if (redrawMethod & PF::RedrawGrid)
+        layer(QLatin1String("grid"))->replot();
+    if (redrawMethod & PF::RedrawDrawing)
+        replotEntities();
+    if (redrawMethod & PF::RedrawOverlay)
+        layer(QLatin1String("overlay"))->replot();
+    redrawMethod = PF::RedrawNone;
+}
+
+/*!
+ \brief 实体被添加、删除或修改后调用，记录需要重绘的区域。
+ 只处理属于当前图形的实体，预览等辅助图形在overlay图层中重绘。
+
+ \param e
+*/
+void PF_GraphicView::invalidateEntity(PF_Entity *e)
+{
+    if (!e || !container) return;
+
+    for (PF_Entity* p = e; p != container; p = p->getParent()) {
+        PF_EntityContainer* parent = p->getParent();
+        if (!parent || !parent->getIndex().contains(p))
+            return;
+    }
+    invalidateRect(e->getMin(), e->getMax());
+}
+
+/*!
+ \brief 将实际坐标系中的矩形转换为屏幕上的区域，加入需要重绘的区域。
+ 区域向外扩展，包括线宽和控制点。
+
+ \param minV
+ \param maxV
+*/
+void PF_GraphicView::invalidateRect(const PF_Vector &minV, const PF_Vector &maxV)
+{
+    if (minV.x > maxV.x || minV.y > maxV.y) return;
+    if (mTileRenderer)
+        mTileRenderer->invalidate(minV, maxV);
+
+    const int margin = 8;
+    const QRectF r(QPointF(toGuiX(minV.x), toGuiY(maxV.y)),
+                   QPointF(toGuiX(maxV.x), toGuiY(minV.y)));
+    const QRect rect = r.normalized().toAlignedRect().adjusted(-margin, -margin, margin, margin);
+    mDirtyRegion += rect.intersected(mViewport);
+}
+
+/*!
+ \brief 图层缓存是否与当前的坐标范围和窗口大小一致。
+
+*/
+bool PF_GraphicView::isBufferValid()
+{
+    return !hasInvalidatedPaintBuffers()
+            && mBufferedViewport == mViewport
+            && mBufferedXRange == xAxis->range()
+            && mBufferedYRange == yAxis->range();
+}
+
+/*!
+ \brief 只重绘实体图层缓存中发生变化的区域。
+
+ 显示标注或者区域过于零碎时重绘整个图层，否则先擦除区域，
+ 再在该区域的裁剪下绘制实体图层。
+*/
+void PF_GraphicView::replotEntities()
+{
+    QCPLayer* mainLayer = layer(QLatin1String("main"));
+    if (mDirtyRegion.isEmpty() || mainLayer->mPaintBuffer.isNull())
+        return;
+
+    if (mLabelsVisible || mDirtyRegion.rectCount() > 64) {
+        mDirtyRegion = QRegion();
+        mainLayer->replot();
+        return;
+    }
+
+    QCPAbstractPaintBuffer* buffer = mainLayer->mPaintBuffer.data();
+    if (QCPPainter *painter = buffer->startPainting())
+    {
+        if (painter->isActive())
+        {
+            painter->setCompositionMode(QPainter::CompositionMode_Source);
+            for (const QRect& rect : mDirtyRegion.rects())
+                painter->fillRect(rect, Qt::transparent);
+            painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+            foreach (QCPLayerable *child, mainLayer->children())
+            {
+                if (child->realVisibility())
+                {
+                    painter->save();
+                    painter->setClipRect(child->clipRect().translated(0, -1));
+                    painter->setClipRegion(mDirtyRegion, Qt::IntersectClip);
+                    child->applyDefaultAntialiasingHint(painter);
+                    child->draw(painter);
+                    painter->restore();
+                }
+            }
+        }
+        delete painter;
+        buffer->donePainting();
+    }
+    update(mDirtyRegion);
+    mDirtyRegion = QRegion();
 }
 
 void PF_GraphicView::drawEntity(QCPPainter *painter, PF_Entity *e)
@@ -503,6 +650,38 @@ void PF_GraphicView::drawEntity(QCPPainter *painter, PF_Entity *e)
     e->draw(painter);
 }
 
+/*!
+ \brief 实体很多时用后台绘制的瓦片代替直接绘制，由顶层容器在绘制之前调用。
+
+ 瓦片按屏幕上的正方形像素绘制，只支持等比例的线性坐标轴。瓦片模式下
+ 不绘制标注，选中的实体仍然直接绘制。
+
+ \param painter
+ \param c 正在绘制的容器
+ \return 已经用瓦片绘制时返回true
+*/
+bool PF_GraphicView::drawTiles(QCPPainter *painter, PF_EntityContainer *c)
+{
+    if (c != container || c->count() < mTileEntityThreshold)
+        return false;
+    if (xAxis->scaleType() != QCPAxis::stLinear || yAxis->scaleType() != QCPAxis::stLinear
+            || xAxis->rangeReversed() || yAxis->rangeReversed())
+        return false;
+    const double unit = toGraphDX(1);
+    if (qAbs(toGraphDY(1) - unit) > 1e-6*unit)
+        return false;
+
+    if (!mTileRenderer) {
+        mTileRenderer = new PF_TileRenderer(container);
+        connect(mTileRenderer, &PF_TileRenderer::tileReady, mTileTimer, [this](){
+            if (!mTileTimer->isActive())
+                mTileTimer->start();
+        });
+    }
+    mLabelsVisible = false;
+    return mTileRenderer->paint(painter, this);
+}
+
 //void PF_GraphicView::drawEntityLayer(QPainter *painter)
 //{
 //    drawEntity(painter, container);
@@ -1010,6 +1189,40 @@ void PF_GraphicView::setBackground(const QBrush &brush)
     mBackgroundBrush = brush;
 }
 
+/*!
+ \brief 设置绘制标注的实体数目上限，可见的实体超过该数目时不绘制
+ 坐标、编号等标注。
+
+ \param limit
+*/
+void PF_GraphicView::setLabelEntityLimit(int limit)
+{
+    mLabelEntityLimit = limit;
+}
+
+/*!
+ \brief 由顶层容器在绘制之前根据可见的实体数目设置。
+
+ \param visible
+*/
+void PF_GraphicView::setLabelsVisible(bool visible)
+{
+    mLabelsVisible = visible;
+}
+
+/*!
+ \brief 设置使用瓦片绘制的实体数目，顶层容器中的实体达到该数目时
+ 在线程池中绘制实体图层。
+
+ \param count
+*/
+void PF_GraphicView::setTileEntityThreshold(int count)
+{
+    mTileEntityThreshold = count;
+    if (mTileRenderer)
+        mTileRenderer->invalidateAll();
+}
+
 /*! \overload
 
   Allows setting the background pixmap of the viewport, whether it shall be scaled and how it
@@ -1095,24 +1308,24 @@ void PF_GraphicView::setBackgroundScaledMode(Qt::AspectRatioMode mode)
 
   \see clearPlottables
 */
-//bool PF_GraphicView::removePlottable(QCPAbstractPlottable *plottable)
-//{
-//    if (!mPlottables.contains(plottable))
-//    {
-//        qDebug() << Q_FUNC_INFO << "plottable not in list:" << reinterpret_cast<quintptr>(plottable);
-//        return false;
-//    }
+bool PF_GraphicView::removePlottable(QCPAbstractPlottable *plottable)
+{
+    if (!mPlottables.contains(plottable))
+    {
+        qDebug() << Q_FUNC_INFO << "plottable not in list:" << reinterpret_cast<quintptr>(plottable);
+        return false;
+    }
 
-//    // remove plottable from legend:
-//    plottable->removeFromLegend();
-//    // special handling for QCPGraphs to maintain the simple graph interface:
-//    if (QCPGraph *graph = qobject_cast<QCPGraph*>(plottable))
-//        mGraphs.removeOne(graph);
-//    // remove plottable:
-//    delete plottable;
-//    mPlottables.removeOne(plottable);
-//    return true;
-//}
+    // remove plottable from legend:
+    plottable->removeFromLegend();
+    // special handling for QCPGraphs to maintain the simple graph interface:
+    if (QCPGraph *graph = qobject_cast<QCPGraph*>(plottable))
+        mGraphs.removeOne(graph);
+    // remove plottable:
+    delete plottable;
+    mPlottables.removeOne(plottable);
+    return true;
+}
 
 /*! \overload
 
@@ -1224,17 +1437,17 @@ void PF_GraphicView::setBackgroundScaledMode(Qt::AspectRatioMode mode)
 
   \see graphCount, addGraph
 */
-//QCPGraph *PF_GraphicView::graph(int index) const
-//{
-//    if (index >= 0 && index < mGraphs.size())
-//    {
-//        return mGraphs.at(index);
-//    } else
-//    {
-//        qDebug() << Q_FUNC_INFO << "index out of bounds:" << index;
-//        return nullptr;
-//    }
-//}
+QCPGraph *PF_GraphicView::graph(int index) const
+{
+    if (index >= 0 && index < mGraphs.size())
+    {
+        return mGraphs.at(index);
+    } else
+    {
+        qDebug() << Q_FUNC_INFO << "index out of bounds:" << index;
+        return nullptr;
+    }
+}
 
 /*! \overload
 
@@ -1243,14 +1456,14 @@ void PF_GraphicView::setBackgroundScaledMode(Qt::AspectRatioMode mode)
 
   \see graphCount, addGraph
 */
-//QCPGraph *PF_GraphicView::graph() const
-//{
-//    if (!mGraphs.isEmpty())
-//    {
-//        return mGraphs.last();
-//    } else
-//        return nullptr;
-//}
+QCPGraph *PF_GraphicView::graph() const
+{
+    if (!mGraphs.isEmpty())
+    {
+        return mGraphs.last();
+    } else
+        return nullptr;
+}
 
 /*!
   Creates a new graph inside the plot. If \a keyAxis and \a valueAxis are left unspecified (0), the
@@ -1264,25 +1477,25 @@ void PF_GraphicView::setBackgroundScaledMode(Qt::AspectRatioMode mode)
 
   \see graph, graphCount, removeGraph, clearGraphs
 */
-//QCPGraph *PF_GraphicView::addGraph(QCPAxis *keyAxis, QCPAxis *valueAxis)
-//{
-//    if (!keyAxis) keyAxis = xAxis;
-//    if (!valueAxis) valueAxis = yAxis;
-//    if (!keyAxis || !valueAxis)
-//    {
-//        qDebug() << Q_FUNC_INFO << "can't use default PF_GraphicView xAxis or yAxis, because at least one is invalid (has been deleted)";
-//        return nullptr;
-//    }
-//    if (keyAxis->parentPlot() != this || valueAxis->parentPlot() != this)
-//    {
-//        qDebug() << Q_FUNC_INFO << "passed keyAxis or valueAxis doesn't have this PF_GraphicView as parent";
-//        return nullptr;
-//    }
+QCPGraph *PF_GraphicView::addGraph(QCPAxis *keyAxis, QCPAxis *valueAxis)
+{
+    if (!keyAxis) keyAxis = xAxis;
+    if (!valueAxis) valueAxis = yAxis;
+    if (!keyAxis || !valueAxis)
+    {
+        qDebug() << Q_FUNC_INFO << "can't use default PF_GraphicView xAxis or yAxis, because at least one is invalid (has been deleted)";
+        return nullptr;
+    }
+    if (keyAxis->parentPlot() != this || valueAxis->parentPlot() != this)
+    {
+        qDebug() << Q_FUNC_INFO << "passed keyAxis or valueAxis doesn't have this PF_GraphicView as parent";
+        return nullptr;
+    }
 
-//    QCPGraph *newGraph = new QCPGraph(keyAxis, valueAxis);
-//    newGraph->setName(QLatin1String("Graph ")+QString::number(mGraphs.size()));
-//    return newGraph;
-//}
+    QCPGraph *newGraph = new QCPGraph(keyAxis, valueAxis);
+    newGraph->setName(QLatin1String("Graph ")+QString::number(mGraphs.size()));
+    return newGraph;
+}
 
 /*!
   Removes the specified \a graph from the plot and deletes it. If necessary, the corresponding
@@ -1294,22 +1507,22 @@ void PF_GraphicView::setBackgroundScaledMode(Qt::AspectRatioMode mode)
 
   \see clearGraphs
 */
-//bool PF_GraphicView::removeGraph(QCPGraph *graph)
-//{
-//    return removePlottable(graph);
-//}
+bool PF_GraphicView::removeGraph(QCPGraph *graph)
+{
+    return removePlottable(graph);
+}
 
 /*! \overload
 
   Removes and deletes the graph by its \a index.
 */
-//bool PF_GraphicView::removeGraph(int index)
-//{
-//    if (index >= 0 && index < mGraphs.size())
-//        return removeGraph(mGraphs[index]);
-//    else
-//        return false;
-//}
+bool PF_GraphicView::removeGraph(int index)
+{
+    if (index >= 0 && index < mGraphs.size())
+        return removeGraph(mGraphs[index]);
+    else
+        return false;
+}
 
 /*!
   Removes all graphs from the plot and deletes them. Corresponding legend items are also removed
@@ -1319,23 +1532,23 @@ void PF_GraphicView::setBackgroundScaledMode(Qt::AspectRatioMode mode)
 
   \see removeGraph
 */
-//int PF_GraphicView::clearGraphs()
-//{
-//    int c = mGraphs.size();
-//    for (int i=c-1; i >= 0; --i)
-//        removeGraph(mGraphs[i]);
-//    return c;
-//}
+int PF_GraphicView::clearGraphs()
+{
+    int c = mGraphs.size();
+    for (int i=c-1; i >= 0; --i)
+        removeGraph(mGraphs[i]);
+    return c;
+}
 
 /*!
   Returns the number of currently existing graphs in the plot
 
   \see graph, addGraph
 */
-//int PF_GraphicView::graphCount() const
-//{
-//    return mGraphs.size();
-//}
+int PF_GraphicView::graphCount() const
+{
+    return mGraphs.size();
+}
 
 /*!
   Returns a list of the selected graphs. If no graphs are currently selected, the list is empty.
@@ -1345,16 +1558,16 @@ void PF_GraphicView::setBackgroundScaledMode(Qt::AspectRatioMode mode)
 
   \see setInteractions, selectedPlottables, QCPAbstractPlottable::setSelectable, QCPAbstractPlottable::setSelection
 */
-//QList<QCPGraph*> PF_GraphicView::selectedGraphs() const
-//{
-//    QList<QCPGraph*> result;
-//    foreach (QCPGraph *graph, mGraphs)
-//    {
-//        if (graph->selected())
-//            result.append(graph);
-//    }
-//    return result;
-//}
+QList<QCPGraph*> PF_GraphicView::selectedGraphs() const
+{
+    QList<QCPGraph*> result;
+    foreach (QCPGraph *graph, mGraphs)
+    {
+        if (graph->selected())
+            result.append(graph);
+    }
+    return result;
+}
 
 /*!
   Returns the item with \a index. If the index is invalid, returns 0.
@@ -2090,6 +2303,20 @@ double PF_GraphicView::toGraphDY(int d) const
     return d*factor;
 }
 
+/*!
+ \brief 当前坐标轴范围对应的实际坐标系中的矩形
+
+ \param minV 左下角
+ \param maxV 右上角
+*/
+void PF_GraphicView::getVisibleRange(PF_Vector &minV, PF_Vector &maxV) const
+{
+    const QCPRange rx = xAxis->range();
+    const QCPRange ry = yAxis->range();
+    minV = PF_Vector(rx.lower, ry.lower);
+    maxV = PF_Vector(rx.upper, ry.upper);
+}
+
 /*!
  \brief 通过控制坐标轴来实现放大
 
@@ -2300,6 +2527,8 @@ void PF_GraphicView::replot(PF_GraphicView::RefreshPriority refreshPriority)
         return;
     mReplotting = true;
     mReplotQueued = false;
+    QElapsedTimer replotTimer;
+    replotTimer.start();
     emit beforeReplot();
     /**必须在更新布局之前生成好刻度**/
     xAxis->setScaleRatio(yAxis,1);
@@ -2313,6 +2542,11 @@ void PF_GraphicView::replot(PF_GraphicView::RefreshPriority refreshPriority)
         layer->drawToPaintBuffer();
     for (int i=0; i<mPaintBuffers.size(); ++i)
         mPaintBuffers.at(i)->setInvalidated(false);
+    mReplotTime = replotTimer.nsecsElapsed()*1e-6;
+    mDirtyRegion = QRegion();
+    mBufferedViewport = mViewport;
+    mBufferedXRange = xAxis->range();
+    mBufferedYRange = yAxis->range();
 
     if ((refreshPriority == rpRefreshHint && mPlottingHints.testFlag(QCP::phImmediateRefresh)) || refreshPriority==rpImmediateRefresh)
         repaint();
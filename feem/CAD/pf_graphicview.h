@@ -15,6 +15,8 @@ class QKeyEvent;
 class QGridLayout;
 class PF_ActionInterface;
 class PF_EventHandler;
+class PF_TileRenderer;
+class QTimer;
 
 #include "pf_plot.h"
 /**来自pf_plot的前置声明**/
@@ -26,7 +28,7 @@ class PF_EventHandler;
 //class QCPAxisRect;
 //class QCPAxisPainterPrivate;
 //class QCPAbstractPlottable;
-//class QCPGraph;
+class QCPGraph;
 //class QCPAbstractItem;
 //class QCPPlottableInterface1D;
 //class QCPLegend;
@@ -92,8 +94,11 @@ public:
     PF_ActionInterface* getDefaultAction();
 
     void redraw(PF::RedrawMethod method=PF::RedrawAll);
+    void invalidateEntity(PF_Entity* e);
+    void invalidateRect(const PF_Vector& minV, const PF_Vector& maxV);
 
     void drawEntity(QCPPainter* painter, PF_Entity* e);
+    bool drawTiles(QCPPainter* painter, PF_EntityContainer* c);
 
     //void drawEntityLayer(QPainter* painter);
 
@@ -121,6 +126,10 @@ public:
     QCP::SelectionRectMode selectionRectMode() const { return mSelectionRectMode; }
     QCPSelectionRect *selectionRect() const { return mSelectionRect; }
     bool openGl() const { return mOpenGl; }
+    int labelEntityLimit() const { return mLabelEntityLimit; }
+    bool labelsVisible() const { return mLabelsVisible; }
+    double replotTime() const { return mReplotTime; }
+    int tileEntityThreshold() const { return mTileEntityThreshold; }
 
     // setters:
     void setViewport(const QRect &rect);
@@ -128,6 +137,9 @@ public:
     void setBackground(const QPixmap &pm);
     void setBackground(const QPixmap &pm, bool scaled, Qt::AspectRatioMode mode=Qt::KeepAspectRatioByExpanding);
     void setBackground(const QBrush &brush);
+    void setLabelEntityLimit(int limit);
+    void setLabelsVisible(bool visible);
+    void setTileEntityThreshold(int count);
     void setBackgroundScaled(bool scaled);
     void setBackgroundScaledMode(Qt::AspectRatioMode mode);
     void setAntialiasedElements(const QCP::AntialiasedElements &antialiasedElements);
@@ -150,7 +162,7 @@ public:
     // plottable interface:
 //    QCPAbstractPlottable *plottable(int index);
 //    QCPAbstractPlottable *plottable();
-//    bool removePlottable(QCPAbstractPlottable *plottable);
+    bool removePlottable(QCPAbstractPlottable *plottable);
 //    bool removePlottable(int index);
 //    int clearPlottables();
 //    int plottableCount() const;
@@ -159,14 +171,14 @@ public:
 //    bool hasPlottable(QCPAbstractPlottable *plottable) const;
 
     // specialized interface for QCPGraph:
-//    QCPGraph *graph(int index) const;
-//    QCPGraph *graph() const;
-//    QCPGraph *addGraph(QCPAxis *keyAxis=0, QCPAxis *valueAxis=0);
-//    bool removeGraph(QCPGraph *graph);
-//    bool removeGraph(int index);
-//    int clearGraphs();
-//    int graphCount() const;
-//    QList<QCPGraph*> selectedGraphs() const;
+    QCPGraph *graph(int index) const;
+    QCPGraph *graph() const;
+    QCPGraph *addGraph(QCPAxis *keyAxis=0, QCPAxis *valueAxis=0);
+    bool removeGraph(QCPGraph *graph);
+    bool removeGraph(int index);
+    int clearGraphs();
+    int graphCount() const;
+    QList<QCPGraph*> selectedGraphs() const;
 
     // item interface:
     QCPAbstractItem *item(int index) const;
@@ -215,6 +227,7 @@ public:
     double toGraphY(int y) const;
     double toGraphDX(int d) const;
     double toGraphDY(int d) const;
+    void getVisibleRange(PF_Vector& minV, PF_Vector& maxV) const;
 
     virtual void zoomIn(double f=1.5, const PF_Vector& center=PF_Vector(false));
 //	virtual void zoomInX(double f=1.5);
@@ -308,6 +321,8 @@ protected:
     QCP::SelectionRectMode mSelectionRectMode;
     QCPSelectionRect *mSelectionRect;
     bool mOpenGl;
+    int mLabelEntityLimit;/**可见实体少于该数目时才绘制标注**/
+    int mTileEntityThreshold;/**实体数目达到该值时在后台绘制瓦片**/
 
     // non-property members:
     QList<QSharedPointer<QCPAbstractPaintBuffer> > mPaintBuffers;
@@ -322,12 +337,22 @@ protected:
     int mOpenGlMultisamples;
     QCP::AntialiasedElements mOpenGlAntialiasedElementsBackup;
     bool mOpenGlCacheLabelsBackup;
+    bool mLabelsVisible;
+    double mReplotTime;/**上一次重绘的时间，毫秒**/
+    QRegion mDirtyRegion;/**实体图层中需要重绘的区域**/
+    QCPRange mBufferedXRange, mBufferedYRange;/**图层缓存绘制时的坐标范围**/
+    QRect mBufferedViewport;
+    PF_TileRenderer* mTileRenderer;
+    QTimer* mTileTimer;/**合并瓦片完成后的重绘**/
 #ifdef QCP_OPENGL_FBO
     QSharedPointer<QOpenGLContext> mGlContext;
     QSharedPointer<QSurface> mGlSurface;
     QSharedPointer<QOpenGLPaintDevice> mGlPaintDevice;
 #endif
 
+    bool isBufferValid();
+    void replotEntities();
+
     // reimplemented virtual methods:
     virtual QSize minimumSizeHint() const Q_DECL_OVERRIDE;
     virtual QSize sizeHint() const Q_DECL_OVERRIDE;
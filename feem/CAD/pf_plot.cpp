@@ -1,6 +1,7 @@
 
 #include "pf_plot.h"
 #include "pf_graphicview.h"
+#include "pf_colorize.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPVector2D
@@ -12987,6 +12988,9 @@ void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb
                     index += mLevelCount;
                 scanLine[i] = mColorBuffer.at(index);
             }
+        } else if (dataIndexFactor == 1)
+        {
+            qcpColorizeLinear(data, range.lower, posToIndexFactor, mColorBuffer.constData(), mLevelCount, scanLine, n);
         } else
         {
             for (int i=0; i<n; ++i)
@@ -13001,11 +13005,12 @@ void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb
         }
     } else // logarithmic == true
     {
+        const double logToIndexFactor = (mLevelCount-1)/qLn(range.upper/range.lower);
         if (mPeriodic)
         {
             for (int i=0; i<n; ++i)
             {
-                int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1)) % mLevelCount;
+                int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)*logToIndexFactor) % mLevelCount;
                 if (index < 0)
                     index += mLevelCount;
                 scanLine[i] = mColorBuffer.at(index);
@@ -13014,7 +13019,7 @@ void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb
         {
             for (int i=0; i<n; ++i)
             {
-                int index = qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1);
+                int index = qLn(data[dataIndexFactor*i]/range.lower)*logToIndexFactor;
                 if (index < 0)
                     index = 0;
                 else if (index >= mLevelCount)
@@ -13074,6 +13079,19 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
                     scanLine[i] = qRgba(qRed(rgb)*alphaF, qGreen(rgb)*alphaF, qBlue(rgb)*alphaF, qAlpha(rgb)*alphaF);
                 }
             }
+        } else if (dataIndexFactor == 1)
+        {
+            // colors are looked up in bulk, then only the partially transparent pixels are premultiplied
+            qcpColorizeLinear(data, range.lower, posToIndexFactor, mColorBuffer.constData(), mLevelCount, scanLine, n);
+            for (int i=0; i<n; ++i)
+            {
+                if (alpha[i] != 255)
+                {
+                    const QRgb rgb = scanLine[i];
+                    const float alphaF = alpha[i]/255.0f;
+                    scanLine[i] = qRgba(qRed(rgb)*alphaF, qGreen(rgb)*alphaF, qBlue(rgb)*alphaF, qAlpha(rgb)*alphaF);
+                }
+            }
         } else
         {
             for (int i=0; i<n; ++i)
@@ -13096,11 +13114,12 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
         }
     } else // logarithmic == true
     {
+        const double logToIndexFactor = (mLevelCount-1)/qLn(range.upper/range.lower);
         if (mPeriodic)
         {
             for (int i=0; i<n; ++i)
             {
-                int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1)) % mLevelCount;
+                int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)*logToIndexFactor) % mLevelCount;
                 if (index < 0)
                     index += mLevelCount;
                 if (alpha[dataIndexFactor*i] == 255)
@@ -13117,7 +13136,7 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
         {
             for (int i=0; i<n; ++i)
             {
-                int index = qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1);
+                int index = qLn(data[dataIndexFactor*i]/range.lower)*logToIndexFactor;
                 if (index < 0)
                     index = 0;
                 else if (index >= mLevelCount)
@@ -17836,6 +17855,585 @@ void QCPColorMap::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 
 
 
+/* including file 'src/plottables/plottable-graph.cpp'                        */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPGraphData
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPGraphData
+  \brief Holds the data of one single data point for QCPGraph.
+
+  The stored data is:
+  \li \a key: coordinate on the key axis of this data point (this is the \a mainKey and the \a sortKey)
+  \li \a value: coordinate on the value axis of this data point (this is the \a mainValue)
+
+  The container for storing multiple data points is \ref QCPGraphDataContainer. It is a typedef for
+  \ref QCPDataContainer with \ref QCPGraphData as the DataType template parameter. See the
+  documentation there for an explanation regarding the data type's generic methods.
+
+  \see QCPGraphDataContainer
+*/
+
+/*!
+  Constructs a data point with key and value set to zero.
+*/
+QCPGraphData::QCPGraphData() :
+    key(0),
+    value(0)
+{
+}
+
+/*!
+  Constructs a data point with the specified \a key and \a value.
+*/
+QCPGraphData::QCPGraphData(double key, double value) :
+    key(key),
+    value(value)
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPGraph
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPGraph
+  \brief A plottable representing a graph in a plot.
+
+  Usually you create new graphs by calling PF_GraphicView::addGraph. The resulting instance can be
+  accessed via PF_GraphicView::graph.
+
+  To plot data, assign it with the \ref setData or \ref addData functions. Alternatively, you can
+  also access and modify the data via the \ref data method, which returns a pointer to the internal
+  \ref QCPGraphDataContainer. Data points with a NaN value interrupt the line.
+
+  Compared to the full QCustomPlot graph, this version only supports the \ref lsNone and \ref
+  lsLine line styles and no fills. It is used for result plots along cut lines and for telemetry
+  of long running computations.
+
+  \section qcpgraph-lod Level of detail
+
+  Waveforms of transient simulations easily reach millions of data points. To keep drawing fast at
+  any zoom level, the graph maintains a min/max pyramid over its data container: Level 0 stores
+  the minimum and maximum value of each block of \ref lodFactor consecutive data points, every
+  further level combines \ref lodFactor blocks of the level below. When a visible data point
+  falls on less than a pixel, the graph draws from the coarsest level whose blocks still contain
+  fewer data points than fall on one pixel, and reduces the blocks to the minimum and maximum of
+  each pixel column. The number of drawn points is thus proportional to the pixel width of the
+  axis rect instead of the number of data points.
+
+  The pyramid is built on the first draw. Data points appended with \ref addData (or \ref
+  QCPDataContainer::add with keys not smaller than the existing ones) only update the last blocks
+  of each level, so streaming data during a running simulation stays cheap. Any other
+  modification of the data, see \ref QCPDataContainer::revision, rebuilds the pyramid on the
+  next draw.
+*/
+
+/*! \fn QSharedPointer<QCPGraphDataContainer> QCPGraph::data() const
+
+  Returns a shared pointer to the internal data storage of type \ref QCPGraphDataContainer. You may
+  use it to directly manipulate the data, which may be more convenient and faster than using the
+  regular \ref setData or \ref addData methods.
+*/
+
+/*!
+  Number of data points combined in one block of the lowest level of the level of detail pyramid,
+  and the number of blocks combined in each further level. See \ref qcpgraph-lod.
+*/
+const int QCPGraph::lodFactor = 8;
+
+/*!
+  Constructs a graph which uses \a keyAxis as its key axis ("x") and \a valueAxis as its value
+  axis ("y"). \a keyAxis and \a valueAxis must reside in the same PF_GraphicView instance and not
+  have the same orientation. If either of these restrictions is violated, a corresponding message
+  is printed to the debug output (qDebug), the construction is not aborted, though.
+
+  The created QCPGraph is automatically registered with the PF_GraphicView instance inferred from
+  \a keyAxis.
+
+  To directly create a graph inside a plot, you can also use the simpler PF_GraphicView::addGraph
+  function.
+*/
+QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
+    QCPAbstractPlottable(keyAxis, valueAxis),
+    mDataContainer(new QCPGraphDataContainer),
+    mLineStyle(lsLine),
+    mLodContainer(0),
+    mLodRevision(0),
+    mLodSize(0)
+{
+    // special handling for QCPGraphs to maintain the simple graph interface:
+    mParentPlot->registerGraph(this);
+
+    setPen(QPen(Qt::blue, 0));
+    setBrush(Qt::NoBrush);
+}
+
+QCPGraph::~QCPGraph()
+{
+}
+
+/*! \overload
+
+  Replaces the current data container with the provided \a data container.
+
+  Since a QSharedPointer is used, multiple QCPGraphs may share the same data container safely.
+*/
+void QCPGraph::setData(QSharedPointer<QCPGraphDataContainer> data)
+{
+    mDataContainer = data;
+    mLodContainer = 0;
+}
+
+/*! \overload
+
+  Replaces the current data with the provided points in \a keys and \a values. The provided
+  vectors should have equal length. Else, the number of added points will be the size of the
+  smallest vector.
+
+  If you can guarantee that the passed data points are sorted by \a keys in ascending order, you
+  can set \a alreadySorted to true, to improve performance by saving a sorting run.
+*/
+void QCPGraph::setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
+{
+    mDataContainer->clear();
+    addData(keys, values, alreadySorted);
+}
+
+/*!
+  Sets how the single data points are connected in the plot. For scatter-only plots, set \a ls to
+  \ref lsNone and \ref setScatterStyle to the desired scatter style.
+
+  \see setScatterStyle
+*/
+void QCPGraph::setLineStyle(LineStyle ls)
+{
+    mLineStyle = ls;
+}
+
+/*!
+  Sets the visual appearance of single data points in the plot. If set to \ref
+  QCPScatterStyle::ssNone, no scatter points are drawn (e.g. for line-only-plots with appropriate
+  line style).
+
+  \see QCPScatterStyle, setLineStyle
+*/
+void QCPGraph::setScatterStyle(const QCPScatterStyle &style)
+{
+    mScatterStyle = style;
+}
+
+/*! \overload
+
+  Adds the provided points in \a keys and \a values to the current data. The provided vectors
+  should have equal length. Else, the number of added points will be the size of the smallest
+  vector.
+
+  If you can guarantee that the passed data points are sorted by \a keys in ascending order, you
+  can set \a alreadySorted to true, to improve performance by saving a sorting run.
+*/
+void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
+{
+    if (keys.size() != values.size())
+        qDebug() << Q_FUNC_INFO << "keys and values have different sizes:" << keys.size() << values.size();
+    const int n = qMin(keys.size(), values.size());
+    QVector<QCPGraphData> tempData(n);
+    QVector<QCPGraphData>::iterator it = tempData.begin();
+    const QVector<QCPGraphData>::iterator itEnd = tempData.end();
+    int i = 0;
+    while (it != itEnd)
+    {
+        it->key = keys[i];
+        it->value = values[i];
+        ++it;
+        ++i;
+    }
+    mDataContainer->add(tempData, alreadySorted); // don't modify tempData beyond this to prevent copy on write
+}
+
+/*! \overload
+
+  Adds the provided data point as \a key and \a value to the current data.
+*/
+void QCPGraph::addData(double key, double value)
+{
+    mDataContainer->add(QCPGraphData(key, value));
+}
+
+/* inherits documentation from base class */
+double QCPGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    if ((onlySelectable && mSelectable == QCP::stNone) || mDataContainer->isEmpty())
+        return -1;
+    if (!mKeyAxis || !mValueAxis)
+        return -1;
+    if (!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()))
+        return -1;
+
+    QCPGraphDataContainer::const_iterator begin, end;
+    getVisibleDataBounds(begin, end);
+    if (begin == end)
+        return -1;
+
+    const QCPVector2D p(pos);
+    double minDistSqr = (std::numeric_limits<double>::max)();
+    QCPGraphDataContainer::const_iterator closest = end;
+    QPointF last;
+    for (QCPGraphDataContainer::const_iterator it=begin; it!=end; ++it)
+    {
+        if (qIsNaN(it->value))
+            continue;
+        const QPointF point = coordsToPixels(it->key, it->value);
+        const double distSqr = (QCPVector2D(point)-p).lengthSquared();
+        if (distSqr < minDistSqr)
+        {
+            minDistSqr = distSqr;
+            closest = it;
+        }
+        if (mLineStyle == lsLine && it != begin && !qIsNaN((it-1)->value))
+            minDistSqr = qMin(minDistSqr, p.distanceSquaredToLine(QCPVector2D(last), QCPVector2D(point)));
+        last = point;
+    }
+    if (closest == end)
+        return -1;
+    if (details)
+    {
+        const int index = int(closest-mDataContainer->constBegin());
+        details->setValue(QCPDataSelection(QCPDataRange(index, index+1)));
+    }
+    return qSqrt(minDistSqr);
+}
+
+/* inherits documentation from base class */
+QCPRange QCPGraph::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
+{
+    return mDataContainer->keyRange(foundRange, inSignDomain);
+}
+
+/* inherits documentation from base class */
+QCPRange QCPGraph::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+    return mDataContainer->valueRange(foundRange, inSignDomain, inKeyRange);
+}
+
+/* inherits documentation from base class */
+void QCPGraph::draw(QCPPainter *painter)
+{
+    if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+    if (mKeyAxis.data()->range().size() <= 0 || mDataContainer->isEmpty()) return;
+    if (mLineStyle == lsNone && mScatterStyle.isNone()) return;
+
+    updateLodPyramid();
+    QVector<QPointF> points;
+    getPixelData(&points);
+    if (points.isEmpty())
+        return;
+
+    if (mLineStyle == lsLine)
+    {
+        painter->setPen(selected() && mSelectionDecorator ? mSelectionDecorator->pen() : mPen);
+        painter->setBrush(Qt::NoBrush);
+        applyDefaultAntialiasingHint(painter);
+        // NaN values interrupt the line:
+        int segmentStart = 0;
+        for (int i=0; i<=points.size(); ++i)
+        {
+            if (i == points.size() || qIsNaN(points.at(i).y()) || qIsNaN(points.at(i).x()))
+            {
+                if (i-segmentStart > 1)
+                    painter->drawPolyline(points.constData()+segmentStart, i-segmentStart);
+                segmentStart = i+1;
+            }
+        }
+    }
+
+    if (!mScatterStyle.isNone())
+    {
+        applyScattersAntialiasingHint(painter);
+        mScatterStyle.applyTo(painter, mPen);
+        foreach (const QPointF &point, points)
+        {
+            if (!qIsNaN(point.x()) && !qIsNaN(point.y()))
+                mScatterStyle.drawShape(painter, point);
+        }
+    }
+}
+
+/* inherits documentation from base class */
+void QCPGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    if (mLineStyle != lsNone)
+    {
+        applyDefaultAntialiasingHint(painter);
+        painter->setPen(mPen);
+        painter->drawLine(QLineF(rect.left(), rect.top()+rect.height()/2.0, rect.right()+5, rect.top()+rect.height()/2.0)); // +5 on x2 else last segment is missing from dashed/dotted pens
+    }
+    if (!mScatterStyle.isNone())
+    {
+        applyScattersAntialiasingHint(painter);
+        mScatterStyle.applyTo(painter, mPen);
+        mScatterStyle.drawShape(painter, QRectF(rect).center());
+    }
+}
+
+/*! \internal
+
+  Returns the iterator range of the data points that lie within the current key axis range,
+  expanded by one point on each side so lines leaving the visible area are drawn correctly.
+*/
+void QCPGraph::getVisibleDataBounds(QCPGraphDataContainer::const_iterator &begin, QCPGraphDataContainer::const_iterator &end) const
+{
+    if (!mKeyAxis)
+    {
+        begin = end = mDataContainer->constEnd();
+        return;
+    }
+    begin = mDataContainer->findBegin(mKeyAxis.data()->range().lower);
+    end = mDataContainer->findEnd(mKeyAxis.data()->range().upper);
+}
+
+/*! \internal
+
+  Converts the visible data points to pixel coordinates and stores them in \a points. Data points
+  with a NaN value are kept as NaN points so the drawing code can interrupt the line there.
+
+  If more than \ref lodFactor visible data points fall on one pixel and the level of detail
+  pyramid is up to date, the points are taken from the pyramid instead, see \ref
+  getLodPixelData.
+*/
+void QCPGraph::getPixelData(QVector<QPointF> *points) const
+{
+    if (!points) return;
+    QCPGraphDataContainer::const_iterator begin, end;
+    getVisibleDataBounds(begin, end);
+
+    if (lodPyramidValid())
+    {
+        const QCPRange range = mKeyAxis.data()->range();
+        const double pixels = qAbs(mKeyAxis.data()->coordToPixel(range.upper)-mKeyAxis.data()->coordToPixel(range.lower));
+        const double pointsPerPixel = int(end-begin)/qMax(pixels, 1.0);
+        // use the coarsest level whose blocks don't span more than one pixel:
+        int level = -1;
+        qint64 blockSize = lodFactor;
+        while (level+1 < mLodLevels.size() && blockSize <= pointsPerPixel)
+        {
+            ++level;
+            blockSize *= lodFactor;
+        }
+        if (level >= 0)
+        {
+            const QCPGraphDataContainer::const_iterator first = mDataContainer->constBegin();
+            getLodPixelData(points, int(begin-first), int(end-first), level);
+            return;
+        }
+    }
+
+    points->resize(int(end-begin));
+    QPointF *out = points->data();
+    for (QCPGraphDataContainer::const_iterator it=begin; it!=end; ++it)
+    {
+        if (qIsNaN(it->value))
+            *out++ = QPointF(qQNaN(), qQNaN());
+        else
+            *out++ = coordsToPixels(it->key, it->value);
+    }
+}
+
+/*! \internal
+
+  Fills \a points from the pyramid \a level for the data points with indices from \a begin to
+  \a end (exclusive). At each position the largest block of at most that level which starts there
+  and ends before \a end is used, so the unaligned ends of the range only cost a few smaller
+  blocks. Consecutive blocks starting in the same pixel column are combined and emitted as the
+  column's minimum and maximum data points in data order, see \ref appendLodColumn.
+*/
+void QCPGraph::getLodPixelData(QVector<QPointF> *points, int begin, int end, int level) const
+{
+    points->clear();
+    const QCPGraphDataContainer::const_iterator data = mDataContainer->constBegin();
+    QCPAxis *keyAxis = mKeyAxis.data();
+
+    LodBlock column;
+    int columnPixel = 0;
+    bool hasColumn = false;
+    int i = begin;
+    while (i < end)
+    {
+        // find the largest block starting at i and ending before end:
+        LodBlock block;
+        int next = i+1;
+        int blockLevel = level;
+        qint64 blockSize = lodFactor;
+        for (int l=0; l<blockLevel; ++l)
+            blockSize *= lodFactor;
+        while (blockLevel >= 0 && (i % blockSize != 0 || i+blockSize > end))
+        {
+            --blockLevel;
+            blockSize /= lodFactor;
+        }
+        if (blockLevel >= 0)
+        {
+            block = mLodLevels.at(blockLevel).at(int(i/blockSize));
+            next = int(i+blockSize);
+        } else
+        {
+            const double value = (data+i)->value;
+            block.gap = qIsNaN(value);
+            block.minIndex = block.maxIndex = block.gap ? -1 : i;
+            block.minValue = block.maxValue = value;
+        }
+
+        const int pixel = qFloor(keyAxis->coordToPixel((data+i)->key));
+        if (hasColumn && pixel != columnPixel)
+        {
+            appendLodColumn(points, column);
+            hasColumn = false;
+        }
+        if (!hasColumn)
+        {
+            column = block;
+            columnPixel = pixel;
+            hasColumn = true;
+        } else
+        {
+            column.gap = column.gap || block.gap;
+            if (block.minIndex >= 0 && (column.minIndex < 0 || block.minValue < column.minValue))
+            {
+                column.minIndex = block.minIndex;
+                column.minValue = block.minValue;
+            }
+            if (block.maxIndex >= 0 && (column.maxIndex < 0 || block.maxValue > column.maxValue))
+            {
+                column.maxIndex = block.maxIndex;
+                column.maxValue = block.maxValue;
+            }
+        }
+        i = next;
+    }
+    if (hasColumn)
+        appendLodColumn(points, column);
+}
+
+/*! \internal
+
+  Appends the minimum and maximum data point of \a column to \a points, in the order they appear
+  in the data. If the column contains NaN values, a NaN point follows, so the line is interrupted
+  with the resolution of one pixel column.
+*/
+void QCPGraph::appendLodColumn(QVector<QPointF> *points, const LodBlock &column) const
+{
+    const QCPGraphDataContainer::const_iterator data = mDataContainer->constBegin();
+    if (column.minIndex >= 0)
+    {
+        const int first = qMin(column.minIndex, column.maxIndex);
+        const int second = qMax(column.minIndex, column.maxIndex);
+        points->append(coordsToPixels((data+first)->key, (data+first)->value));
+        if (second != first)
+            points->append(coordsToPixels((data+second)->key, (data+second)->value));
+    }
+    if (column.gap)
+        points->append(QPointF(qQNaN(), qQNaN()));
+}
+
+/*! \internal
+
+  Brings the level of detail pyramid up to date with the data container. If the container was
+  replaced or its \ref QCPDataContainer::revision changed, the pyramid is rebuilt. Otherwise only
+  the blocks touched by data points appended since the last update are recomputed, including the
+  previously incomplete last block of each level.
+*/
+void QCPGraph::updateLodPyramid()
+{
+    const QCPGraphDataContainer *container = mDataContainer.data();
+    const int size = container->size();
+    if (container != mLodContainer || container->revision() != mLodRevision || size < mLodSize)
+    {
+        mLodLevels.clear();
+        mLodContainer = container;
+        mLodRevision = container->revision();
+        mLodSize = 0;
+    }
+    if (size == mLodSize)
+        return;
+
+    const QCPGraphDataContainer::const_iterator data = container->constBegin();
+    int changed = mLodSize; // first changed item of the level below, starting with the data points
+    int below = size;       // number of items of the level below
+    for (int level=0; below > lodFactor; ++level)
+    {
+        if (mLodLevels.size() <= level)
+            mLodLevels.append(QVector<LodBlock>());
+        QVector<LodBlock> &blocks = mLodLevels[level];
+        const int firstBlock = qMin(changed/lodFactor, blocks.size());
+        const int blockCount = (below+lodFactor-1)/lodFactor;
+        blocks.resize(blockCount);
+        for (int b=firstBlock; b<blockCount; ++b)
+        {
+            LodBlock block;
+            block.minValue = block.maxValue = 0;
+            block.minIndex = block.maxIndex = -1;
+            block.gap = false;
+            const int itemEnd = qMin((b+1)*lodFactor, below);
+            for (int j=b*lodFactor; j<itemEnd; ++j)
+            {
+                if (level == 0)
+                {
+                    const double value = (data+j)->value;
+                    if (qIsNaN(value))
+                    {
+                        block.gap = true;
+                        continue;
+                    }
+                    if (block.minIndex < 0 || value < block.minValue)
+                    {
+                        block.minValue = value;
+                        block.minIndex = j;
+                    }
+                    if (block.maxIndex < 0 || value > block.maxValue)
+                    {
+                        block.maxValue = value;
+                        block.maxIndex = j;
+                    }
+                } else
+                {
+                    const LodBlock &item = mLodLevels.at(level-1).at(j);
+                    block.gap = block.gap || item.gap;
+                    if (item.minIndex >= 0 && (block.minIndex < 0 || item.minValue < block.minValue))
+                    {
+                        block.minValue = item.minValue;
+                        block.minIndex = item.minIndex;
+                    }
+                    if (item.maxIndex >= 0 && (block.maxIndex < 0 || item.maxValue > block.maxValue))
+                    {
+                        block.maxValue = item.maxValue;
+                        block.maxIndex = item.maxIndex;
+                    }
+                }
+            }
+            blocks[b] = block;
+        }
+        changed = firstBlock;
+        below = blockCount;
+    }
+    mLodSize = size;
+}
+
+/*! \internal
+
+  Returns whether the level of detail pyramid describes the current content of the data container.
+  It is updated by \ref draw, so this is false when \ref getPixelData is called from elsewhere
+  after the data was modified.
+*/
+bool QCPGraph::lodPyramidValid() const
+{
+    return !mLodLevels.isEmpty() && mLodContainer == mDataContainer.data()
+            && mLodRevision == mDataContainer->revision() && mLodSize == mDataContainer->size();
+}
+/* end of 'src/plottables/plottable-graph.cpp' */
+
+
+
 /* including file 'src/items/item-line.cpp', size 8498                       */
 /* commit ce344b3f96a62e5f652585e55f1ae7c7883cd45b 2018-06-25 01:03:39 +0200 */
 
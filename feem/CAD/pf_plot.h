@@ -2427,6 +2427,7 @@ public:
     int size() const { return mData.size()-mPreallocSize; }
     bool isEmpty() const { return size() == 0; }
     bool autoSqueeze() const { return mAutoSqueeze; }
+    quint32 revision() const { return mRevision; }
 
     // setters:
     void setAutoSqueeze(bool enabled);
@@ -2447,8 +2448,8 @@ public:
 
     const_iterator constBegin() const { return mData.constBegin()+mPreallocSize; }
     const_iterator constEnd() const { return mData.constEnd(); }
-    iterator begin() { return mData.begin()+mPreallocSize; }
-    iterator end() { return mData.end(); }
+    iterator begin() { ++mRevision; return mData.begin()+mPreallocSize; }
+    iterator end() { ++mRevision; return mData.end(); }
     const_iterator findBegin(double sortKey, bool expandedRange=true) const;
     const_iterator findEnd(double sortKey, bool expandedRange=true) const;
     const_iterator at(int index) const { return constBegin()+qBound(0, index, size()); }
@@ -2465,6 +2466,7 @@ protected:
     QVector<DataType> mData;
     int mPreallocSize;
     int mPreallocIteration;
+    quint32 mRevision;
 
     // non-virtual methods:
     void preallocateGrow(int minimumPreallocSize);
@@ -2603,6 +2605,17 @@ protected:
   begin index of the returned range is 0, and the end index is \ref size.
 */
 
+/*! \fn quint32 QCPDataContainer::revision() const
+
+  Returns a counter that changes whenever the data is modified in any way other than appending
+  points with keys greater than or equal to the existing ones. Caches derived from the data, like
+  the level of detail pyramid of \ref QCPGraph, compare it to decide whether they can be extended
+  incrementally or must be rebuilt.
+
+  Obtaining non-const iterators via \ref begin or \ref end also changes the revision, since the
+  data may be modified through them. Don't keep such iterators across replots.
+*/
+
 /* end documentation of inline functions */
 
 /*!
@@ -2613,7 +2626,8 @@ template <class DataType>
 QCPDataContainer<DataType>::QCPDataContainer() :
     mAutoSqueeze(true),
     mPreallocSize(0),
-    mPreallocIteration(0)
+    mPreallocIteration(0),
+    mRevision(0)
 {
 }
 
@@ -2664,6 +2678,7 @@ void QCPDataContainer<DataType>::set(const QVector<DataType> &data, bool already
     mData = data;
     mPreallocSize = 0;
     mPreallocIteration = 0;
+    ++mRevision;
     if (!alreadySorted)
         sort();
 }
@@ -2692,7 +2707,7 @@ void QCPDataContainer<DataType>::add(const QCPDataContainer<DataType> &data)
     } else // don't need to prepend, so append and merge if necessary
     {
         mData.resize(mData.size()+n);
-        std::copy(data.constBegin(), data.constEnd(), end()-n);
+        std::copy(data.constBegin(), data.constEnd(), mData.end()-n); // appending keeps the revision
         if (oldSize > 0 && !qcpLessThanSortKey<DataType>(*(constEnd()-n-1), *(constEnd()-n))) // if appended range keys aren't all greater than existing ones, merge the two partitions
             std::inplace_merge(begin(), end()-n, end(), qcpLessThanSortKey<DataType>);
     }
@@ -2729,9 +2744,9 @@ void QCPDataContainer<DataType>::add(const QVector<DataType> &data, bool already
     } else // don't need to prepend, so append and then sort and merge if necessary
     {
         mData.resize(mData.size()+n);
-        std::copy(data.constBegin(), data.constEnd(), end()-n);
+        std::copy(data.constBegin(), data.constEnd(), mData.end()-n); // appending keeps the revision
         if (!alreadySorted) // sort appended subrange if it wasn't already sorted
-            std::sort(end()-n, end(), qcpLessThanSortKey<DataType>);
+            std::sort(mData.end()-n, mData.end(), qcpLessThanSortKey<DataType>);
         if (oldSize > 0 && !qcpLessThanSortKey<DataType>(*(constEnd()-n-1), *(constEnd()-n))) // if appended range keys aren't all greater than existing ones, merge the two partitions
             std::inplace_merge(begin(), end()-n, end(), qcpLessThanSortKey<DataType>);
     }
@@ -2847,6 +2862,7 @@ void QCPDataContainer<DataType>::clear()
     mData.clear();
     mPreallocIteration = 0;
     mPreallocSize = 0;
+    ++mRevision;
 }
 
 /*!
@@ -4351,6 +4367,126 @@ protected:
 /* end of 'src/plottables/plottable-colormap.h' */
 
 
+/* including file 'src/plottables/plottable-graph.h'                          */
+
+class QCP_LIB_DECL QCPGraphData
+{
+public:
+    QCPGraphData();
+    QCPGraphData(double key, double value);
+
+    inline double sortKey() const { return key; }
+    inline static QCPGraphData fromSortKey(double sortKey) { return QCPGraphData(sortKey, 0); }
+    inline static bool sortKeyIsMainKey() { return true; }
+
+    inline double mainKey() const { return key; }
+    inline double mainValue() const { return value; }
+
+    inline QCPRange valueRange() const { return QCPRange(value, value); }
+
+    double key, value;
+};
+Q_DECLARE_TYPEINFO(QCPGraphData, Q_PRIMITIVE_TYPE);
+
+
+/*! \typedef QCPGraphDataContainer
+
+  Container for storing \ref QCPGraphData points. The data is stored sorted by \a key.
+
+  This template instantiation is the container in which QCPGraph holds its data. For details about
+  the generic container, see the documentation of the class template \ref QCPDataContainer.
+
+  \see QCPGraphData, QCPGraph::setData
+*/
+typedef QCPDataContainer<QCPGraphData> QCPGraphDataContainer;
+
+class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable
+{
+    Q_OBJECT
+    /// \cond INCLUDE_QPROPERTIES
+    Q_PROPERTY(LineStyle lineStyle READ lineStyle WRITE setLineStyle)
+    Q_PROPERTY(QCPScatterStyle scatterStyle READ scatterStyle WRITE setScatterStyle)
+    /// \endcond
+public:
+    /*!
+      Defines how the graph's line is represented visually in the plot. The line is drawn with the
+      current pen of the graph (\ref setPen).
+      \see setLineStyle
+    */
+    enum LineStyle { lsNone  ///< data points are not connected with any lines (e.g. data only represented
+                             ///< with symbols according to the scatter style, see \ref setScatterStyle)
+                     ,lsLine ///< data points are connected by a straight line
+                   };
+    Q_ENUMS(LineStyle)
+
+    explicit QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis);
+    virtual ~QCPGraph();
+
+    // getters:
+    QSharedPointer<QCPGraphDataContainer> data() const { return mDataContainer; }
+    LineStyle lineStyle() const { return mLineStyle; }
+    QCPScatterStyle scatterStyle() const { return mScatterStyle; }
+
+    // setters:
+    void setData(QSharedPointer<QCPGraphDataContainer> data);
+    void setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
+    void setLineStyle(LineStyle ls);
+    void setScatterStyle(const QCPScatterStyle &style);
+
+    // non-property methods:
+    void addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
+    void addData(double key, double value);
+
+    // reimplemented virtual methods:
+    virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=0) const Q_DECL_OVERRIDE;
+    virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const Q_DECL_OVERRIDE;
+    virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const Q_DECL_OVERRIDE;
+
+protected:
+    /*!
+      Minimum and maximum value of a block of consecutive data points in the level of detail
+      pyramid. The indices refer to the data container and are -1 if the block only contains NaN
+      values. \a gap is set if the block contains at least one NaN value.
+    */
+    struct LodBlock
+    {
+        double minValue, maxValue;
+        int minIndex, maxIndex;
+        bool gap;
+    };
+    static const int lodFactor; ///< number of blocks of one pyramid level combined in the next level
+
+    // property members:
+    QSharedPointer<QCPGraphDataContainer> mDataContainer;
+    LineStyle mLineStyle;
+    QCPScatterStyle mScatterStyle;
+
+    // non-property members:
+    QVector<QVector<LodBlock> > mLodLevels; // level i combines lodFactor^(i+1) data points per block
+    const QCPGraphDataContainer *mLodContainer;
+    quint32 mLodRevision;
+    int mLodSize;
+
+    // reimplemented virtual methods:
+    virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
+    virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const Q_DECL_OVERRIDE;
+
+    // non-virtual methods:
+    void getVisibleDataBounds(QCPGraphDataContainer::const_iterator &begin, QCPGraphDataContainer::const_iterator &end) const;
+    void getPixelData(QVector<QPointF> *points) const;
+    void getLodPixelData(QVector<QPointF> *points, int begin, int end, int level) const;
+    void appendLodColumn(QVector<QPointF> *points, const LodBlock &column) const;
+    void updateLodPyramid();
+    bool lodPyramidValid() const;
+
+    friend class PF_GraphicView;
+    friend class QCPLegend;
+};
+Q_DECLARE_METATYPE(QCPGraph::LineStyle)
+
+/* end of 'src/plottables/plottable-graph.h' */
+
+
 
 /* including file 'src/items/item-line.h', size 3407                         */
 /* commit ce344b3f96a62e5f652585e55f1ae7c7883cd45b 2018-06-25 01:03:39 +0200 */
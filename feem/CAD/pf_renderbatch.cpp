@@ -0,0 +1,141 @@
+#include "pf_renderbatch.h"
+#include "pf_graphicview.h"
+#include "pf_plot.h"
+
+#include <QtMath>
+
+#include <cmath>
+
+PF_RenderBatch::PF_RenderBatch(const PF_GraphicView *view)
+    :view(view)
+    ,linear(false)
+    ,sx(1.),ox(0.)
+    ,sy(1.),oy(0.)
+    ,last(-1)
+    ,barrier(0)
+    ,count(0)
+{
+    /** 线性坐标轴上coordToPixel是仿射变换，由两个点确定 **/
+    if(view->xAxis->scaleType() == QCPAxis::stLinear
+            && view->yAxis->scaleType() == QCPAxis::stLinear){
+        linear = true;
+        ox = view->toGuiX(0.);
+        sx = view->toGuiX(1.) - ox;
+        oy = view->toGuiY(0.);
+        sy = view->toGuiY(1.) - oy;
+    }
+}
+
+double PF_RenderBatch::toGuiX(double x) const
+{
+    return linear ? ox + sx*x : view->toGuiX(x);
+}
+
+double PF_RenderBatch::toGuiY(double y) const
+{
+    return linear ? oy + sy*y : view->toGuiY(y);
+}
+
+/*!
+ \brief 查找画笔和画刷相同的分组，一般连续的实体样式相同，先检查上一次的分组。
+ 有填充的图元只能放入最后一个分组，否则新建分组并作为之后查找的起点。
+
+*/
+PF_RenderBatch::Group &PF_RenderBatch::group(const QPen &pen, const QBrush &brush)
+{
+    if(brush.style() != Qt::NoBrush){
+        if(groups.empty() || groups.back().pen != pen || groups.back().brush != brush){
+            newGroup(pen,brush);
+            barrier = int(groups.size());
+        }
+        last = int(groups.size()) - 1;
+        return groups.back();
+    }
+    if(last >= barrier && groups[last].pen == pen && groups[last].brush == brush){
+        return groups[last];
+    }
+    for(size_t i = size_t(barrier); i < groups.size(); i++){
+        if(groups[i].pen == pen && groups[i].brush == brush){
+            last = int(i);
+            return groups[i];
+        }
+    }
+    newGroup(pen,brush);
+    last = int(groups.size()) - 1;
+    return groups.back();
+}
+
+void PF_RenderBatch::newGroup(const QPen &pen, const QBrush &brush)
+{
+    groups.push_back(Group());
+    groups.back().pen = pen;
+    groups.back().brush = brush;
+    /** 默认的奇偶规则下嵌套或重叠的圆会互相挖空，与逐个drawEllipse不同 **/
+    groups.back().curves.setFillRule(Qt::WindingFill);
+}
+
+void PF_RenderBatch::addLine(const PF_Vector &p1, const PF_Vector &p2, const QPen &pen)
+{
+    group(pen,Qt::NoBrush).lines.append(QLineF(toGuiX(p1.x),toGuiY(p1.y),
+                                               toGuiX(p2.x),toGuiY(p2.y)));
+    count++;
+}
+
+/*!
+ \brief 与PF_Circle::draw()相同，两个方向的半径都按y方向换算。
+
+*/
+void PF_RenderBatch::addCircle(const PF_Vector &center, double radius,
+                               const QPen &pen, const QBrush &brush)
+{
+    const double r = linear ? std::fabs(sy*radius) : view->toGuiDY(radius);
+    group(pen,brush).curves.addEllipse(QPointF(toGuiX(center.x),toGuiY(center.y)),r,r);
+    count++;
+}
+
+/*!
+ \brief 圆弧从angle1逆时针到angle2，单位为弧度。y轴向上，所以屏幕上同样是逆时针。
+
+*/
+void PF_RenderBatch::addArc(const PF_Vector &center, double radius,
+                            double angle1, double angle2, const QPen &pen)
+{
+    const double r = linear ? std::fabs(sy*radius) : view->toGuiDY(radius);
+    const QRectF rect(toGuiX(center.x) - r, toGuiY(center.y) - r, 2.*r, 2.*r);
+    double span = angle2 - angle1;
+    if(span < 0.) span += 2.*M_PI;
+    QPainterPath& path = group(pen,Qt::NoBrush).curves;
+    path.arcMoveTo(rect,qRadiansToDegrees(angle1));
+    path.arcTo(rect,qRadiansToDegrees(angle1),qRadiansToDegrees(span));
+    count++;
+}
+
+/*!
+ \brief 绘制所有图元并清空，painter的画笔和画刷会被恢复。
+
+*/
+void PF_RenderBatch::flush(QCPPainter *painter)
+{
+    if(count == 0) return;
+
+    const QPen oldPen = painter->pen();
+    const QBrush oldBrush = painter->brush();
+    for(auto& g : groups){
+        if(g.lines.isEmpty() && g.curves.isEmpty()) continue;
+        painter->setPen(g.pen);
+        painter->setBrush(g.brush);
+        if(!g.lines.isEmpty()){
+            painter->drawLines(g.lines.constData(),g.lines.size());
+        }
+        if(!g.curves.isEmpty()){
+            painter->drawPath(g.curves);
+        }
+    }
+    painter->setPen(oldPen);
+    painter->setBrush(oldBrush);
+
+    groups.clear();
+    last = -1;
+    barrier = 0;
+    count = 0;
+}
@@ -0,0 +1,71 @@
+#ifndef PF_RENDERBATCH_H
+#define PF_RENDERBATCH_H
+
+#include "pf_vector.h"
+
+#include <QBrush>
+#include <QLineF>
+#include <QPainterPath>
+#include <QPen>
+#include <QVector>
+
+#include <vector>
+
+class PF_GraphicView;
+class QCPPainter;
+
+/*!
+ \brief 批量绘制直线和圆。
+
+ 按画笔和画刷分组收集图元，坐标轴为线性时用同一个仿射变换把
+ 实际坐标转换为屏幕坐标，最后每组只设置一次画笔，直线用一次
+ drawLines()绘制，圆和圆弧合并成一个QPainterPath绘制，避免每个实体
+ 都保存和恢复painter的状态。
+
+ 只有不填充的图元可以跨越其他图元合并。有填充的圆会遮住之前的图元，
+ 它只和紧接着的同样式的圆合并，之后加入的图元放在它后面的新分组中，
+ 所以不同图元之间的遮挡关系与按实体列表逐个绘制相同（合并的圆之间
+ 轮廓线画在所有填充之上）。
+*/
+class PF_RenderBatch
+{
+public:
+    explicit PF_RenderBatch(const PF_GraphicView* view);
+    ~PF_RenderBatch()=default;
+
+    void addLine(const PF_Vector& p1, const PF_Vector& p2, const QPen& pen);
+    void addCircle(const PF_Vector& center, double radius,
+                   const QPen& pen, const QBrush& brush=Qt::NoBrush);
+    void addArc(const PF_Vector& center, double radius,
+                double angle1, double angle2, const QPen& pen);
+    void flush(QCPPainter* painter);
+
+    bool isEmpty() const{
+        return count == 0;
+    }
+
+private:
+    struct Group{
+        QPen pen;
+        QBrush brush;
+        QVector<QLineF> lines;
+        QPainterPath curves;
+    };
+
+    Group& group(const QPen& pen, const QBrush& brush);
+    void newGroup(const QPen& pen, const QBrush& brush);
+    double toGuiX(double x) const;
+    double toGuiY(double y) const;
+
+private:
+    const PF_GraphicView* view;
+    bool linear;        /**坐标轴是否为线性，否则逐点转换**/
+    double sx, ox;      /**x方向的缩放和平移**/
+    double sy, oy;      /**y方向的缩放和平移**/
+    std::vector<Group> groups;
+    int last;           /**上一次使用的分组**/
+    int barrier;        /**最后一个有填充的分组之后的位置，之前的分组不再接收图元**/
+    int count;
+};
+
+#endif // PF_RENDERBATCH_H
@@ -0,0 +1,299 @@
+#include "pf_streamlines.h"
+#include "pf_graphicview.h"
+#include "pf_pointlocator.h"
+
+#include <QRunnable>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+/** 追踪的范围比可见范围每边多出的比例，平移一点时流线不会在边界处断开 **/
+const double TraceMargin = 0.25;
+
+/** 按符号域截取范围，与QCPColorMap的做法相同 **/
+QCPRange restrictToSignDomain(QCPRange result, QCP::SignDomain inSignDomain, bool& foundRange)
+{
+    if(inSignDomain == QCP::sdPositive){
+        if(result.lower <= 0 && result.upper > 0)
+            result.lower = result.upper*1e-3;
+        else if(result.lower <= 0 && result.upper <= 0)
+            foundRange = false;
+    }else if(inSignDomain == QCP::sdNegative){
+        if(result.upper >= 0 && result.lower < 0)
+            result.upper = result.lower*1e-3;
+        else if(result.upper >= 0 && result.lower >= 0)
+            foundRange = false;
+    }
+    return result;
+}
+
+}
+
+/*!
+ \brief 在工作线程中追踪所有种子点并去掉重合的流线。追踪本身在全局线程池中并行。
+
+*/
+class PF_Streamlines::Job : public QRunnable
+{
+public:
+    Job(PF_Streamlines* plottable, int job, const PF_StreamlineTracer& tracer,
+        std::vector<PF_Vector> seeds, double distance, QSharedPointer<Lines> lines,
+        QSharedPointer<QAtomicInt> canceled)
+        :plottable(plottable),job(job),tracer(tracer),seeds(std::move(seeds)),distance(distance)
+        ,lines(lines),canceled(canceled)
+    {
+    }
+
+    void run() override
+    {
+        if(!canceled->load()){
+            *lines = tracer.trace(seeds);
+            if(!canceled->load())
+                PF_StreamlineTracer::removeOverlaps(*lines,distance);
+        }
+        emit plottable->traced(job);
+    }
+
+private:
+    PF_Streamlines* plottable;
+    int job;
+    PF_StreamlineTracer tracer;
+    std::vector<PF_Vector> seeds;
+    double distance;
+    QSharedPointer<Lines> lines;
+    QSharedPointer<QAtomicInt> canceled;
+};
+
+PF_Streamlines::PF_Streamlines(QCPAxis *keyAxis, QCPAxis *valueAxis)
+    :QCPAbstractPlottable(keyAxis, valueAxis)
+    ,mLocator(nullptr)
+    ,mVx(nullptr)
+    ,mVy(nullptr)
+    ,mSeedSpacing(40.)
+    ,mStepSize(2.)
+    ,mView{QRect(),QCPRange(),QCPRange(),-1.,-1.}
+    ,mJob(0)
+{
+    mPen = QPen(Qt::black,0);
+    mBrush = Qt::NoBrush;
+    /** 追踪本身用全局线程池并行，这里只需要一个线程协调 **/
+    mPool.setMaxThreadCount(1);
+    connect(this,&PF_Streamlines::traced,
+            this,&PF_Streamlines::onTraced,Qt::QueuedConnection);
+}
+
+PF_Streamlines::~PF_Streamlines()
+{
+    cancel();
+    mPool.waitForDone();
+}
+
+void PF_Streamlines::setField(const PF_PointLocator *locator, const double *vx, const double *vy)
+{
+    cancel();
+    mPool.waitForDone();
+    mLocator = locator && !locator->isEmpty() && vx && vy ? locator : nullptr;
+    mVx = vx;
+    mVy = vy;
+    mLines.reset();
+    mView.seedSpacing = -1.;
+
+    double minX, minY, maxX, maxY;
+    if(mLocator && mLocator->bounds(minX,minY,maxX,maxY)){
+        mKeyBounds = QCPRange(minX,maxX);
+        mValueBounds = QCPRange(minY,maxY);
+    }else{
+        mKeyBounds = QCPRange();
+        mValueBounds = QCPRange();
+    }
+}
+
+void PF_Streamlines::setSeedSpacing(double pixels)
+{
+    if(pixels >= 4.) mSeedSpacing = pixels;
+}
+
+void PF_Streamlines::setStepSize(double pixels)
+{
+    if(pixels > 0.) mStepSize = pixels;
+}
+
+const std::vector<PF_StreamlineTracer::Streamline> &PF_Streamlines::streamlines() const
+{
+    static const Lines empty;
+    return mLines ? *mLines : empty;
+}
+
+double PF_Streamlines::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(details)
+    if((onlySelectable && mSelectable == QCP::stNone) || !mLines || mLines->empty())
+        return -1;
+    if(!mKeyAxis || !mValueAxis)
+        return -1;
+    if(!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()))
+        return -1;
+
+    const double tolerance = mParentPlot->selectionTolerance();
+    double k1, v1, k2, v2;
+    pixelsToCoords(pos - QPointF(tolerance,tolerance),k1,v1);
+    pixelsToCoords(pos + QPointF(tolerance,tolerance),k2,v2);
+    QCPRange keyRange(k1,k2), valueRange(v1,v2);
+    keyRange.normalize();
+    valueRange.normalize();
+
+    const QCPVector2D p(pos);
+    double best = -1;
+    for(const PF_StreamlineTracer::Streamline& line : *mLines){
+        if(!isVisible(line,keyRange,valueRange)) continue;
+        QPointF last = coordsToPixels(line.points.front().x,line.points.front().y);
+        for(size_t i=1;i<line.points.size();++i){
+            const QPointF next = coordsToPixels(line.points[i].x,line.points[i].y);
+            const double d = p.distanceSquaredToLine(QCPVector2D(last),QCPVector2D(next));
+            if(best < 0 || d < best) best = d;
+            last = next;
+        }
+    }
+    if(best < 0) return -1;
+    best = qSqrt(best);
+    if(best > tolerance) return -1;
+    if(details)
+        details->setValue(QCPDataSelection(QCPDataRange(0, 1)));
+    return best;
+}
+
+QCPRange PF_Streamlines::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
+{
+    foundRange = mLocator != nullptr;
+    return restrictToSignDomain(mKeyBounds,inSignDomain,foundRange);
+}
+
+QCPRange PF_Streamlines::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+    if(inKeyRange != QCPRange()){
+        if(mKeyBounds.upper < inKeyRange.lower || mKeyBounds.lower > inKeyRange.upper){
+            foundRange = false;
+            return QCPRange();
+        }
+    }
+    foundRange = mLocator != nullptr;
+    return restrictToSignDomain(mValueBounds,inSignDomain,foundRange);
+}
+
+/*!
+ \brief 视图变化时提交重新追踪，先用上一次的流线绘制。
+
+*/
+void PF_Streamlines::draw(QCPPainter *painter)
+{
+    if(!mLocator) return;
+    if(!mKeyAxis || !mValueAxis) return;
+    const View view = currentView();
+    if(!(view == mView)) request(view);
+    if(!mLines || mLines->empty()) return;
+    applyDefaultAntialiasingHint(painter);
+
+    const QCPRange keyRange = mKeyAxis->range();
+    const QCPRange valueRange = mValueAxis->range();
+    const bool linear = mKeyAxis->scaleType() == QCPAxis::stLinear
+            && mValueAxis->scaleType() == QCPAxis::stLinear;
+    const QPointF o = coordsToPixels(0.,0.);
+    const QPointF ex = coordsToPixels(1.,0.) - o;
+    const QPointF ey = coordsToPixels(0.,1.) - o;
+
+    painter->setBrush(Qt::NoBrush);
+    painter->setPen(selected() && mSelectionDecorator ? mSelectionDecorator->pen() : mPen);
+    for(const PF_StreamlineTracer::Streamline& line : *mLines){
+        if(!isVisible(line,keyRange,valueRange)) continue;
+        mPolyline.resize(0);
+        QPointF last;
+        const int n = int(line.points.size());
+        for(int i=0;i<n;++i){
+            const PF_Vector& v = line.points[i];
+            const QPointF p = linear ? QPointF(o.x() + ex.x()*v.x + ey.x()*v.y,o.y() + ex.y()*v.x + ey.y()*v.y)
+                                     : coordsToPixels(v.x,v.y);
+            /** 相距不到半个像素的点合并，保留最后一个点 **/
+            if(i > 0 && i < n - 1 && qAbs(p.x() - last.x()) < 0.5 && qAbs(p.y() - last.y()) < 0.5)
+                continue;
+            mPolyline.append(p);
+            last = p;
+        }
+        painter->drawPolyline(mPolyline);
+    }
+}
+
+void PF_Streamlines::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLine(QLineF(rect.left(),rect.center().y(),rect.right(),rect.center().y()));
+}
+
+void PF_Streamlines::onTraced(int job)
+{
+    if(job != mJob || !mPending) return;
+    mLines = mPending;
+    mPending.reset();
+    if(mParentPlot)
+        mParentPlot->replot(PF_GraphicView::rpQueuedReplot);
+}
+
+PF_Streamlines::View PF_Streamlines::currentView() const
+{
+    return View{clipRect(),mKeyAxis->range(),mValueAxis->range(),mSeedSpacing,mStepSize};
+}
+
+/*!
+ \brief 在GUI线程中把像素间距换算为坐标长度，生成可见范围内的种子点，交给工作线程追踪。
+ 两个坐标轴的比例不同时取每像素较大的长度。
+
+*/
+void PF_Streamlines::request(const View &view)
+{
+    cancel();
+    mView = view;
+    if(view.rect.isEmpty()) return;
+
+    double k1, v1, k2, v2;
+    pixelsToCoords(QPointF(view.rect.topLeft()),k1,v1);
+    pixelsToCoords(QPointF(view.rect.bottomRight()),k2,v2);
+    const double unit = std::max(std::abs(k2 - k1)/view.rect.width(),std::abs(v2 - v1)/view.rect.height());
+    if(!(unit > 0.) || !std::isfinite(unit)) return;
+
+    const PF_Vector minV(std::max(std::min(k1,k2),mKeyBounds.lower),std::max(std::min(v1,v2),mValueBounds.lower));
+    const PF_Vector maxV(std::min(std::max(k1,k2),mKeyBounds.upper),std::min(std::max(v1,v2),mValueBounds.upper));
+    const double spacing = view.seedSpacing*unit;
+    std::vector<PF_Vector> seeds = PF_StreamlineTracer::gridSeeds(minV,maxV,spacing);
+
+    const PF_Vector margin = (maxV - minV)*TraceMargin;
+    PF_StreamlineTracer tracer;
+    tracer.setField(mLocator,mVx,mVy);
+    tracer.setStepSize(view.stepSize*unit);
+    tracer.setMaxSteps(int(4.*(view.rect.width() + view.rect.height())/view.stepSize));
+    tracer.setBounds(minV - margin,maxV + margin);
+
+    mPending = QSharedPointer<Lines>(new Lines);
+    mCanceled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    mPool.start(new Job(this,++mJob,tracer,std::move(seeds),0.5*spacing,mPending,mCanceled));
+}
+
+/*!
+ \brief 取消还没有完成的追踪，还没有开始的直接从队列中去掉。
+
+*/
+void PF_Streamlines::cancel()
+{
+    mPool.clear();
+    if(mCanceled) mCanceled->store(1);
+    mPending.reset();
+}
+
+bool PF_Streamlines::isVisible(const PF_StreamlineTracer::Streamline &line, const QCPRange &keyRange,
+                               const QCPRange &valueRange) const
+{
+    return line.maxV.x >= keyRange.lower && line.minV.x <= keyRange.upper
+            && line.maxV.y >= valueRange.lower && line.minV.y <= valueRange.upper;
+}
@@ -0,0 +1,104 @@
+#ifndef PF_STREAMLINES_H
+#define PF_STREAMLINES_H
+
+#include "pf_plot.h"
+#include "pf_streamlinetracer.h"
+
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include <vector>
+
+class PF_PointLocator;
+
+/*!
+ \brief 绘制网格上的向量场（例如B）的流线。
+
+ 种子点按固定的像素间距布置在可见范围内，步长也按像素给定，
+ 所以放大后流线更密、更精细。视图变化后在工作线程中用PF_StreamlineTracer
+ 重新追踪，与前面的流线重合的流线被去掉，完成之前继续显示原来的流线，
+ 不会阻塞GUI线程。绘制方式与PF_ContourLines相同。
+*/
+class PF_Streamlines : public QCPAbstractPlottable
+{
+    Q_OBJECT
+public:
+    explicit PF_Streamlines(QCPAxis *keyAxis, QCPAxis *valueAxis);
+    ~PF_Streamlines() override;
+
+    /** 节点上的向量分量，长度为locator的节点数，不复制，显示期间不能释放 **/
+    void setField(const PF_PointLocator* locator, const double* vx, const double* vy);
+    /** 种子点之间的像素距离 **/
+    void setSeedSpacing(double pixels);
+    double seedSpacing() const{
+        return mSeedSpacing;
+    }
+    /** 积分步长（像素） **/
+    void setStepSize(double pixels);
+    double stepSize() const{
+        return mStepSize;
+    }
+    /** 当前显示的流线 **/
+    const std::vector<PF_StreamlineTracer::Streamline>& streamlines() const;
+
+    /** 继承的虚函数 **/
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const override;
+    QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const override;
+    QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth,
+                           const QCPRange &inKeyRange=QCPRange()) const override;
+
+signals:
+    /** 内部使用，工作线程完成一次追踪 **/
+    void traced(int job);
+
+protected:
+    void draw(QCPPainter *painter) override;
+    void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const override;
+
+private slots:
+    void onTraced(int job);
+
+private:
+    typedef std::vector<PF_StreamlineTracer::Streamline> Lines;
+
+    /*!
+     \brief 追踪时的视图，变化后重新追踪。
+    */
+    struct View{
+        QRect rect;
+        QCPRange keyRange, valueRange;
+        double seedSpacing, stepSize;
+
+        bool operator==(const View& v) const{
+            return rect == v.rect && keyRange == v.keyRange && valueRange == v.valueRange
+                    && seedSpacing == v.seedSpacing && stepSize == v.stepSize;
+        }
+    };
+
+    class Job;
+
+    View currentView() const;
+    void request(const View& view);
+    void cancel();
+    bool isVisible(const PF_StreamlineTracer::Streamline& line, const QCPRange& keyRange,
+                   const QCPRange& valueRange) const;
+
+private:
+    const PF_PointLocator* mLocator;
+    const double* mVx;
+    const double* mVy;
+    QCPRange mKeyBounds, mValueBounds;
+    double mSeedSpacing;
+    double mStepSize;
+
+    QSharedPointer<const Lines> mLines;
+    View mView;
+    QThreadPool mPool;
+    int mJob;
+    QSharedPointer<Lines> mPending;
+    QSharedPointer<QAtomicInt> mCanceled;
+    QPolygonF mPolyline;    /**绘制时复用的缓冲区**/
+};
+
+#endif // PF_STREAMLINES_H
@@ -0,0 +1,125 @@
+#include "pf_telemetrymonitor.h"
+#include "pf_graphicview.h"
+
+PF_TelemetryMonitor::PF_TelemetryMonitor(QObject *parent)
+    :QObject(parent)
+    ,rescale(true)
+{
+    timer.setInterval(50);
+    connect(&timer,&QTimer::timeout,this,&PF_TelemetryMonitor::poll);
+}
+
+PF_TelemetryMonitor::~PF_TelemetryMonitor()
+{
+
+}
+
+void PF_TelemetryMonitor::bind(QSharedPointer<PF_TelemetryChannel> channel, int series, QCPGraph *graph)
+{
+    if(!channel || !graph) return;
+    int i = indexOf(channel.data());
+    if(i < 0){
+        Source source;
+        source.channel = channel;
+        source.dropped = channel->dropped();
+        sources.append(source);
+        i = sources.size() - 1;
+    }
+    sources[i].graphs.insert(series,graph);
+}
+
+void PF_TelemetryMonitor::unbind(PF_TelemetryChannel *channel)
+{
+    const int i = indexOf(channel);
+    if(i < 0) return;
+    QSet<PF_GraphicView*> plots;
+    drain(sources[i],plots);
+    sources.remove(i);
+    for(PF_GraphicView* plot : plots){
+        plot->replot(PF_GraphicView::rpQueuedReplot);
+    }
+}
+
+void PF_TelemetryMonitor::clear()
+{
+    sources.clear();
+}
+
+void PF_TelemetryMonitor::setInterval(int msec)
+{
+    timer.setInterval(qMax(1,msec));
+}
+
+void PF_TelemetryMonitor::setAutoRescale(bool enabled)
+{
+    rescale = enabled;
+}
+
+void PF_TelemetryMonitor::start()
+{
+    timer.start();
+}
+
+/*!
+ \brief 停止前读出已经发布的数据。
+
+*/
+void PF_TelemetryMonitor::stop()
+{
+    timer.stop();
+    poll();
+}
+
+void PF_TelemetryMonitor::poll()
+{
+    QSet<PF_GraphicView*> plots;
+    for(Source& source : sources){
+        drain(source,plots);
+    }
+    for(PF_GraphicView* plot : plots){
+        plot->replot(PF_GraphicView::rpQueuedReplot);
+    }
+}
+
+int PF_TelemetryMonitor::indexOf(const PF_TelemetryChannel *channel) const
+{
+    for(int i=0;i<sources.size();++i){
+        if(sources.at(i).channel.data() == channel) return i;
+    }
+    return -1;
+}
+
+/*!
+ \brief 读出一个通道的数据，按序列分开后批量追加到曲线上，有新数据的图表放入plots。
+
+*/
+void PF_TelemetryMonitor::drain(Source &source, QSet<PF_GraphicView *> &plots)
+{
+    samples.resize(0);
+    source.channel->drain(samples);
+
+    const quint32 dropped = source.channel->dropped();
+    if(dropped != source.dropped){
+        source.dropped = dropped;
+        emit samplesDropped(source.channel->name(),dropped);
+    }
+    if(samples.isEmpty()) return;
+
+    for(auto it=source.graphs.constBegin();it!=source.graphs.constEnd();++it){
+        QCPGraph* graph = it.value().data();
+        if(!graph) continue;
+        keys.resize(0);
+        values.resize(0);
+        for(const PF_TelemetryChannel::Sample& s : samples){
+            if(s.series != it.key()) continue;
+            keys.append(s.key);
+            values.append(s.value);
+        }
+        if(keys.isEmpty()) continue;
+        graph->addData(keys,values);
+        if(rescale)
+            graph->rescaleAxes();
+        if(graph->parentPlot())
+            plots.insert(graph->parentPlot());
+    }
+}
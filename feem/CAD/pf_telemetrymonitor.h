@@ -0,0 +1,81 @@
+#ifndef PF_TELEMETRYMONITOR_H
+#define PF_TELEMETRYMONITOR_H
+
+#include "pf_telemetrychannel.h"
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+
+class PF_GraphicView;
+class QCPGraph;
+
+/*!
+ \brief 在GUI线程中定时读出求解线程发布的监视数据，追加到对应的曲线上。
+
+ 每次读出后只对有新数据的图表以rpQueuedReplot请求重绘，同一个事件循环中的
+ 多次请求合并为一次，重绘的频率不超过定时器的频率。求解线程只向
+ PF_TelemetryChannel写入，不会因为绘图而等待。没有绑定曲线的序列被丢弃。
+*/
+class PF_TelemetryMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PF_TelemetryMonitor(QObject* parent=nullptr);
+    ~PF_TelemetryMonitor() override;
+
+    /** 把通道中的一个序列追加到graph上，一个序列只能绑定一条曲线 **/
+    void bind(QSharedPointer<PF_TelemetryChannel> channel, int series, QCPGraph* graph);
+    /** 读出剩余的数据后不再读取这个通道 **/
+    void unbind(PF_TelemetryChannel* channel);
+    void clear();
+
+    /** 两次读取之间的时间间隔（毫秒） **/
+    void setInterval(int msec);
+    int interval() const{
+        return timer.interval();
+    }
+    /** 追加数据后缩放坐标轴显示所有数据，需要遍历全部数据，数据很多时应关闭 **/
+    void setAutoRescale(bool enabled);
+    bool autoRescale() const{
+        return rescale;
+    }
+
+    bool isActive() const{
+        return timer.isActive();
+    }
+
+public slots:
+    void start();
+    void stop();
+    /** 立即读出所有通道 **/
+    void poll();
+
+signals:
+    /** 通道的缓冲区满过，total为累计丢弃的数据个数 **/
+    void samplesDropped(const QString& channel, quint32 total);
+
+private:
+    struct Source{
+        QSharedPointer<PF_TelemetryChannel> channel;
+        QHash<int,QPointer<QCPGraph>> graphs;
+        quint32 dropped;
+    };
+
+    int indexOf(const PF_TelemetryChannel* channel) const;
+    void drain(Source& source, QSet<PF_GraphicView*>& plots);
+
+private:
+    QVector<Source> sources;
+    QTimer timer;
+    bool rescale;
+    QVector<PF_TelemetryChannel::Sample> samples;   /**读取时复用的缓冲区**/
+    QVector<double> keys;
+    QVector<double> values;
+};
+
+#endif // PF_TELEMETRYMONITOR_H
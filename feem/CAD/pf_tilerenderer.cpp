@@ -0,0 +1,747 @@
+#include "pf_tilerenderer.h"
+#include "pf_entitycontainer.h"
+#include "pf_graphicview.h"
+#include "pf_plot.h"
+#include "pf_primitiveblock.h"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QRunnable>
+#include <QtMath>
+#include <QSet>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+/** 瓦片向外扩展的像素，包括线宽和点的大小 **/
+const double TileMargin = 4.;
+
+/** 一次绘制最多需要的瓦片数目，超过时不使用瓦片 **/
+const int MaxVisibleTiles = 1024;
+
+/** 待修补的范围最多保存的个数，超过时合并成一个 **/
+const size_t MaxDirtyRects = 64;
+
+/** 没有裁剪范围时收集所有图元 **/
+bool overlapsAny(const std::vector<PF_TileScene::Rect>* clip,
+                 double minX, double minY, double maxX, double maxY)
+{
+    if(!clip) return true;
+    for(const auto& r : *clip){
+        if(r.overlaps(minX,minY,maxX,maxY)) return true;
+    }
+    return false;
+}
+
+}
+
+PF_TileScene::PF_TileScene()
+    :baseCount(0)
+    ,removedCount(0)
+{
+}
+
+/*!
+ \brief 复制文档中所有直线、圆弧、圆和点，并建立网格。
+
+*/
+void PF_TileScene::build(PF_EntityContainer *document)
+{
+    added.clear();
+    selected.clear();
+    selectedBounds.clear();
+    for(auto e : document->getEntityList()){
+        collect(e,nullptr);
+    }
+    Grid* g = new Grid;
+    g->primitives.swap(added);
+    g->build();
+    setGrid(g);
+}
+
+void PF_TileScene::setGrid(Grid *g)
+{
+    grid = QSharedPointer<const Grid>(g);
+    baseCount = int(g->primitives.size());
+    removed.assign(size_t(baseCount),false);
+    removedCount = 0;
+    added.clear();
+}
+
+/*!
+ \brief 修补快照，rects为发生变化的范围，需要包括实体变化前后的包围盒。
+
+ 先去掉包围盒与这些范围相交的图元和选中的实体，再从文档的空间索引中
+ 找出与范围相交的实体，只把与范围相交的图元重新收集进来，范围外的图元
+ 没有去掉，也不会重复收集。代价与范围内的图元数目成正比。
+*/
+void PF_TileScene::patch(PF_EntityContainer *document, const std::vector<Rect> &rects)
+{
+    std::vector<int> items;
+    for(const auto& r : rects){
+        grid->query(r.minX,r.minY,r.maxX,r.maxY,items);
+        for(int i : items){
+            if(removed[size_t(i)]) continue;
+            removed[size_t(i)] = true;
+            removedCount++;
+        }
+    }
+    added.erase(std::remove_if(added.begin(),added.end(),[&](const Primitive& p){
+        return overlapsAny(&rects,p.minX,p.minY,p.maxX,p.maxY);
+    }),added.end());
+    size_t k = 0;
+    for(size_t i = 0; i < selected.size(); i++){
+        const Rect& b = selectedBounds[i];
+        if(overlapsAny(&rects,b.minX,b.minY,b.maxX,b.maxY)) continue;
+        selected[k] = selected[i];
+        selectedBounds[k] = b;
+        k++;
+    }
+    selected.resize(k);
+    selectedBounds.resize(k);
+
+    std::vector<PF_Entity*> entities;
+    for(const auto& r : rects){
+        document->getIndex().query(PF_Vector(r.minX,r.minY),PF_Vector(r.maxX,r.maxY),entities);
+    }
+    std::sort(entities.begin(),entities.end());
+    entities.erase(std::unique(entities.begin(),entities.end()),entities.end());
+    for(auto e : entities){
+        collect(e,&rects);
+    }
+}
+
+/*!
+ \brief 附加列表逐个查询，删除的图元仍然占用网格，二者较多时需要合并。
+
+*/
+bool PF_TileScene::needsCompaction() const
+{
+    return int(added.size()) > std::max(4096,baseCount/8)
+            || removedCount > std::max(4096,baseCount/4);
+}
+
+/*!
+ \brief 把网格中剩下的图元和附加的图元合并成新的网格。
+
+ 只访问图元，不访问实体，可以在工作线程中调用。
+*/
+void PF_TileScene::compact()
+{
+    Grid* g = new Grid;
+    g->primitives.reserve(size_t(baseCount - removedCount) + added.size());
+    for(int i = 0; i < baseCount; i++){
+        if(!removed[size_t(i)]) g->primitives.push_back(grid->primitives[size_t(i)]);
+    }
+    g->primitives.insert(g->primitives.end(),added.begin(),added.end());
+    g->build();
+    setGrid(g);
+}
+
+/*!
+ \brief 收集实体的图元。
+
+ \param clip 不为空时只收集包围盒与其中某个范围相交的图元和选中实体
+*/
+void PF_TileScene::collect(PF_Entity *e, const std::vector<Rect>* clip)
+{
+    if(e->isSelected() || e->isHighlighted()){
+        const PF_Vector minV = e->getMin(), maxV = e->getMax();
+        if(!overlapsAny(clip,minV.x,minV.y,maxV.x,maxV.y)) return;
+        selected.push_back(e);
+        selectedBounds.push_back(Rect{minV.x,minV.y,maxV.x,maxV.y});
+        return;
+    }
+    if(e->isContainer()){
+        for(auto child : static_cast<PF_EntityContainer*>(e)->getEntityList()){
+            collect(child,clip);
+        }
+        return;
+    }
+    if(e->rtti() == PF::EntityPrimitives){
+        collect(static_cast<PF_PrimitiveBlock*>(e)->getStore(),clip);
+        return;
+    }
+
+    Primitive p;
+    switch(e->rtti()){
+    case PF::EntityLine:{
+        const PF_Vector s = e->getStartpoint();
+        const PF_Vector t = e->getEndpoint();
+        p = Primitive{s.x,s.y,t.x,t.y,
+                std::min(s.x,t.x),std::min(s.y,t.y),
+                std::max(s.x,t.x),std::max(s.y,t.y),Line,0.};
+        break;
+    }
+    case PF::EntityCircle:{
+        const PF_Vector c = e->getCenter();
+        const double r = e->getRadius();
+        p = Primitive{c.x,c.y,r,0.,c.x-r,c.y-r,c.x+r,c.y+r,Circle,0.};
+        break;
+    }
+    case PF::EntityPoint:{
+        const PF_Vector c = e->getMin();
+        p = Primitive{c.x,c.y,0.,0.,c.x,c.y,c.x,c.y,Point,0.};
+        break;
+    }
+    default:
+        return;
+    }
+    add(p,clip);
+}
+
+/*!
+ \brief 紧凑存储的图元直接从数组复制，不创建实体。
+
+*/
+void PF_TileScene::collect(const PF_PrimitiveStore &store, const std::vector<Rect>* clip)
+{
+    const quint32 skip = PF_PrimitiveStore::FlagDeleted | PF_PrimitiveStore::FlagHidden;
+    for(const auto& l : store.lineArray()){
+        if(l.flags & skip) continue;
+        add(Primitive{l.x1,l.y1,l.x2,l.y2,
+                      std::min(l.x1,l.x2),std::min(l.y1,l.y2),
+                      std::max(l.x1,l.x2),std::max(l.y1,l.y2),Line,0.},clip);
+    }
+    for(const auto& a : store.arcArray()){
+        if(a.flags & skip) continue;
+        PF_Vector minV, maxV;
+        PF_PrimitiveStore::arcBounds(a,minV,maxV);
+        double span = a.a2 - a.a1;
+        if(span < 0.) span += 2.*M_PI;
+        add(Primitive{a.cx,a.cy,a.r,a.a1,
+                      minV.x,minV.y,maxV.x,maxV.y,Arc,span},clip);
+    }
+    for(const auto& c : store.circleArray()){
+        if(c.flags & skip) continue;
+        add(Primitive{c.cx,c.cy,c.r,0.,
+                      c.cx-c.r,c.cy-c.r,c.cx+c.r,c.cy+c.r,Circle,0.},clip);
+    }
+}
+
+void PF_TileScene::add(const Primitive &p, const std::vector<Rect>* clip)
+{
+    if(overlapsAny(clip,p.minX,p.minY,p.maxX,p.maxY)) added.push_back(p);
+}
+
+/*!
+ \brief 查找包围盒与矩形相交的图元，包括附加列表中的图元。
+
+*/
+void PF_TileScene::query(double minX, double minY, double maxX, double maxY,
+                         std::vector<int> &result) const
+{
+    grid->query(minX,minY,maxX,maxY,result);
+    if(removedCount > 0){
+        result.erase(std::remove_if(result.begin(),result.end(),[this](int i){
+            return removed[size_t(i)];
+        }),result.end());
+    }
+    for(size_t i = 0; i < added.size(); i++){
+        const auto& p = added[i];
+        if(p.maxX < minX || p.minX > maxX || p.maxY < minY || p.minY > maxY) continue;
+        result.push_back(baseCount + int(i));
+    }
+}
+
+int PF_TileScene::Grid::cellX(double x) const
+{
+    return std::max(0,std::min(nx-1,int(std::floor((x - gridX)/cellW))));
+}
+
+int PF_TileScene::Grid::cellY(double y) const
+{
+    return std::max(0,std::min(ny-1,int(std::floor((y - gridY)/cellH))));
+}
+
+/*!
+ \brief 均匀网格，平均每个格子约4个图元，格子中保存与它相交的图元编号。
+
+*/
+void PF_TileScene::Grid::build()
+{
+    const int n = int(primitives.size());
+    double minX = PF_MAXDOUBLE, minY = PF_MAXDOUBLE;
+    double maxX = PF_MINDOUBLE, maxY = PF_MINDOUBLE;
+    for(const auto& p : primitives){
+        minX = std::min(minX,p.minX);
+        minY = std::min(minY,p.minY);
+        maxX = std::max(maxX,p.maxX);
+        maxY = std::max(maxY,p.maxY);
+    }
+    if(n == 0){
+        minX = minY = 0.;
+        maxX = maxY = 1.;
+    }
+
+    nx = ny = std::max(1,std::min(1024,int(std::sqrt(n/4.))));
+    gridX = minX;
+    gridY = minY;
+    cellW = maxX > minX ? (maxX - minX)/nx : 1.;
+    cellH = maxY > minY ? (maxY - minY)/ny : 1.;
+
+    cellStart.assign(size_t(nx)*ny + 1,0);
+    for(const auto& p : primitives){
+        const int x0 = cellX(p.minX), x1 = cellX(p.maxX);
+        const int y0 = cellY(p.minY), y1 = cellY(p.maxY);
+        for(int y = y0; y <= y1; y++){
+            for(int x = x0; x <= x1; x++){
+                cellStart[size_t(y)*nx + x + 1]++;
+            }
+        }
+    }
+    for(size_t i = 1; i < cellStart.size(); i++){
+        cellStart[i] += cellStart[i-1];
+    }
+    cellItems.resize(size_t(cellStart.back()));
+    std::vector<int> fill(cellStart.begin(),cellStart.end()-1);
+    for(int i = 0; i < n; i++){
+        const auto& p = primitives[size_t(i)];
+        const int x0 = cellX(p.minX), x1 = cellX(p.maxX);
+        const int y0 = cellY(p.minY), y1 = cellY(p.maxY);
+        for(int y = y0; y <= y1; y++){
+            for(int x = x0; x <= x1; x++){
+                cellItems[size_t(fill[size_t(y)*nx + x]++)] = i;
+            }
+        }
+    }
+}
+
+/*!
+ \brief 查找包围盒与矩形相交的图元。
+
+ 跨越多个格子的图元只在它与查询范围共同的左下角格子中返回，不需要去重。
+*/
+void PF_TileScene::Grid::query(double minX, double minY, double maxX, double maxY,
+                               std::vector<int> &result) const
+{
+    result.clear();
+    const int qx0 = cellX(minX), qx1 = cellX(maxX);
+    const int qy0 = cellY(minY), qy1 = cellY(maxY);
+    for(int y = qy0; y <= qy1; y++){
+        for(int x = qx0; x <= qx1; x++){
+            const size_t cell = size_t(y)*nx + x;
+            for(int k = cellStart[cell]; k < cellStart[cell+1]; k++){
+                const int i = cellItems[size_t(k)];
+                const auto& p = primitives[size_t(i)];
+                if(x != std::max(cellX(p.minX),qx0) || y != std::max(cellY(p.minY),qy0)) continue;
+                if(p.maxX < minX || p.minX > maxX || p.maxY < minY || p.minY > maxY) continue;
+                result.push_back(i);
+            }
+        }
+    }
+}
+
+/*!
+ \brief 在工作线程中合并快照，GUI线程在完成之前继续使用原来的快照。
+
+*/
+class PF_TileRenderer::CompactJob : public QRunnable
+{
+public:
+    CompactJob(PF_TileRenderer* renderer, QSharedPointer<PF_TileScene> scene, int version)
+        :renderer(renderer),scene(scene),version(version)
+    {
+    }
+
+    void run() override
+    {
+        scene->compact();
+        emit renderer->sceneCompacted(version);
+    }
+
+private:
+    PF_TileRenderer* renderer;
+    QSharedPointer<PF_TileScene> scene;
+    int version;
+};
+
+/*!
+ \brief 在工作线程中绘制一个瓦片，只访问快照，完成后通过排队连接通知GUI线程。
+
+*/
+class PF_TileRenderer::Job : public QRunnable
+{
+public:
+    Job(PF_TileRenderer* renderer, QSharedPointer<const PF_TileScene> scene,
+        const TileKey& key, int job, const QPen& pen, double dpr, bool antialiased,
+        QSharedPointer<QAtomicInt> canceled)
+        :renderer(renderer),scene(scene),key(key),job(job),pen(pen),dpr(dpr)
+        ,antialiased(antialiased),canceled(canceled)
+    {
+    }
+
+    void run() override
+    {
+        QImage image;
+        const bool done = render(image);
+        emit renderer->tileRendered(key.scale,key.x,key.y,job,image,!done);
+    }
+
+private:
+    bool render(QImage& image)
+    {
+        if(canceled->load()) return false;
+
+        const double unit = unitOf(key.scale);
+        const double size = worldSize(unit);
+        const double x0 = key.x*size;
+        const double y1 = (key.y + 1)*size;
+        const double margin = TileMargin*unit;
+
+        std::vector<int> items;
+        scene->query(x0 - margin, y1 - size - margin, x0 + size + margin, y1 + margin, items);
+
+        const int pixels = int(std::ceil(TileSize*dpr));
+        image = QImage(pixels,pixels,QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(dpr);
+        image.fill(Qt::transparent);
+        if(items.empty()) return true;
+
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing,antialiased);
+        painter.setPen(pen);
+        auto toX = [&](double x){ return (x - x0)/unit; };
+        auto toY = [&](double y){ return (y1 - y)/unit; };
+
+        int count = 0;
+        for(int i : items){
+            if((++count & 1023) == 0 && canceled->load()) return false;
+
+            const auto& p = scene->primitive(i);
+            if(p.type != PF_TileScene::Point
+                    && p.maxX - p.minX < unit && p.maxY - p.minY < unit){
+                continue;
+            }
+            switch(p.type){
+            case PF_TileScene::Line:
+                painter.drawLine(QPointF(toX(p.x0),toY(p.y0)),QPointF(toX(p.x1),toY(p.y1)));
+                break;
+            case PF_TileScene::Circle:
+                painter.drawEllipse(QPointF(toX(p.x0),toY(p.y0)),p.x1/unit,p.x1/unit);
+                break;
+            case PF_TileScene::Arc:{
+                const double r = p.x1/unit;
+                const QRectF rect(toX(p.x0) - r,toY(p.y0) - r,2.*r,2.*r);
+                QPainterPath path;
+                path.arcMoveTo(rect,qRadiansToDegrees(p.y1));
+                path.arcTo(rect,qRadiansToDegrees(p.y1),qRadiansToDegrees(p.span));
+                painter.drawPath(path);
+                break;
+            }
+            case PF_TileScene::Point:{
+                /** 与PF_Point::draw()相同，5x5的方块 **/
+                const double x = toX(p.x0), y = toY(p.y0);
+                for(int k = 0; k <= 4; k++){
+                    painter.drawLine(QPointF(x-2,y-2+k),QPointF(x+2,y-2+k));
+                }
+                break;
+            }
+            }
+        }
+        return true;
+    }
+
+private:
+    PF_TileRenderer* renderer;
+    QSharedPointer<const PF_TileScene> scene;
+    TileKey key;
+    int job;
+    QPen pen;
+    double dpr;
+    bool antialiased;
+    QSharedPointer<QAtomicInt> canceled;
+};
+
+uint qHash(const PF_TileRenderer::TileKey &key, uint seed)
+{
+    return qHash(key.scale,seed) ^ uint(key.x*73856093) ^ uint(key.y*19349663);
+}
+
+PF_TileRenderer::PF_TileRenderer(PF_EntityContainer *document, QObject *parent)
+    :QObject(parent)
+    ,document(document)
+    ,sceneDirty(true)
+    ,sceneVersion(0)
+    ,dpr(1.)
+    ,maxTiles(192)
+    ,frame(0)
+    ,jobs(0)
+{
+    pool.setMaxThreadCount(std::max(1,QThread::idealThreadCount() - 1));
+    connect(this,&PF_TileRenderer::tileRendered,
+            this,&PF_TileRenderer::onTileRendered,Qt::QueuedConnection);
+    connect(this,&PF_TileRenderer::sceneCompacted,
+            this,&PF_TileRenderer::onSceneCompacted,Qt::QueuedConnection);
+}
+
+PF_TileRenderer::~PF_TileRenderer()
+{
+    pool.clear();
+    for(auto& p : pending){
+        p.canceled->store(1);
+    }
+    pool.waitForDone();
+}
+
+double PF_TileRenderer::unitOf(quint64 scale)
+{
+    double unit;
+    std::memcpy(&unit,&scale,sizeof(unit));
+    return unit;
+}
+
+QRectF PF_TileRenderer::screenRect(const PF_GraphicView *view, int x, int y, double unit)
+{
+    const double size = worldSize(unit);
+    return QRectF(QPointF(view->toGuiX(x*size),view->toGuiY((y + 1)*size)),
+                  QPointF(view->toGuiX((x + 1)*size),view->toGuiY(y*size)));
+}
+
+/*!
+ \brief 合成可见范围内的瓦片，并绘制选中的实体。
+
+ \return 坐标范围过大等情况返回false，由调用者直接绘制实体
+*/
+bool PF_TileRenderer::paint(QCPPainter *painter, PF_GraphicView *view)
+{
+    PF_Vector minV, maxV;
+    view->getVisibleRange(minV, maxV);
+    const double unit = view->toGraphDX(1);
+    if(!(unit > 0.) || std::isinf(unit)) return false;
+
+    const double size = worldSize(unit);
+    const double fx0 = std::floor(minV.x/size), fx1 = std::floor(maxV.x/size);
+    const double fy0 = std::floor(minV.y/size), fy1 = std::floor(maxV.y/size);
+    if(std::fabs(fx0) > 1e9 || std::fabs(fx1) > 1e9
+            || std::fabs(fy0) > 1e9 || std::fabs(fy1) > 1e9){
+        return false;
+    }
+    const int ix0 = int(fx0), ix1 = int(fx1);
+    const int iy0 = int(fy0), iy1 = int(fy1);
+    if((ix1 - ix0 + 1)*(iy1 - iy0 + 1) > MaxVisibleTiles) return false;
+
+    /** 样式或者分辨率变化后所有瓦片都不能再使用 **/
+    if(painter->pen() != pen || view->bufferDevicePixelRatio() != dpr){
+        pen = painter->pen();
+        dpr = view->bufferDevicePixelRatio();
+        for(auto it = pending.begin(); it != pending.end(); ++it){
+            it->canceled->store(1);
+        }
+        pending.clear();
+        tiles.clear();
+    }
+    updateScene();
+
+    frame++;
+    quint64 scale;
+    std::memcpy(&scale,&unit,sizeof(scale));
+    const bool antialiased = painter->testRenderHint(QPainter::Antialiasing);
+    QSet<TileKey> needed;
+    for(int y = iy0; y <= iy1; y++){
+        for(int x = ix0; x <= ix1; x++){
+            const TileKey key{scale,x,y};
+            needed.insert(key);
+            const QRectF target = screenRect(view,x,y,unit);
+            auto it = tiles.find(key);
+            if(it != tiles.end()){
+                it->lastUsed = frame;
+                if(!it->stale){
+                    /** 边界取整，相邻瓦片之间没有缝隙 **/
+                    const QRect r(QPoint(qRound(target.left()),qRound(target.top())),
+                                  QPoint(qRound(target.right())-1,qRound(target.bottom())-1));
+                    painter->drawImage(r,it->image);
+                    continue;
+                }
+            }
+            drawFallback(painter,view,key,target);
+            if(!pending.contains(key)){
+                request(key,antialiased);
+            }
+        }
+    }
+
+    /** 已经不可见的瓦片不再绘制 **/
+    for(auto it = pending.begin(); it != pending.end();){
+        if(!needed.contains(it.key())){
+            it->canceled->store(1);
+            it = pending.erase(it);
+        }else{
+            ++it;
+        }
+    }
+    evict();
+
+    for(auto e : scene->selectedEntities()){
+        view->drawEntity(painter,e);
+    }
+    return true;
+}
+
+/*!
+ \brief 第一次绘制或者invalidateAll()之后生成整个快照，其他情况只修补变化的范围。
+
+ 修补后附加的图元较多时在工作线程中合并，合并期间仍然使用修补后的快照。
+*/
+void PF_TileRenderer::updateScene()
+{
+    if(sceneDirty || !scene){
+        QSharedPointer<PF_TileScene> s(new PF_TileScene);
+        s->build(document);
+        scene = s;
+        sceneDirty = false;
+        dirty.clear();
+        sceneVersion++;
+    }else if(!dirty.empty()){
+        QSharedPointer<PF_TileScene> s(new PF_TileScene(*scene));
+        s->patch(document,dirty);
+        scene = s;
+        dirty.clear();
+        sceneVersion++;
+    }
+    if(!compacting && scene->needsCompaction()){
+        compacting = QSharedPointer<PF_TileScene>(new PF_TileScene(*scene));
+        pool.start(new CompactJob(this,compacting,sceneVersion));
+    }
+}
+
+void PF_TileRenderer::onSceneCompacted(int version)
+{
+    QSharedPointer<PF_TileScene> s = compacting;
+    compacting.clear();
+    /** 合并期间快照又被修补过，结果已经过期，下一帧重新合并 **/
+    if(version != sceneVersion) return;
+    scene = s;
+}
+
+/*!
+ \brief 瓦片还没有绘制好时，先用过期的瓦片或者其他缩放比例下与它重叠的瓦片代替。
+
+*/
+void PF_TileRenderer::drawFallback(QCPPainter *painter, const PF_GraphicView *view,
+                                   const TileKey &key, const QRectF &target)
+{
+    const double unit = unitOf(key.scale);
+    const double size = worldSize(unit);
+    const double x0 = key.x*size, x1 = x0 + size;
+    const double y0 = key.y*size, y1 = y0 + size;
+
+    painter->save();
+    painter->setClipRect(target,Qt::IntersectClip);
+    for(auto it = tiles.constBegin(); it != tiles.constEnd(); ++it){
+        const TileKey& k = it.key();
+        if(k.scale == key.scale && !(k == key)) continue;
+        const double s = worldSize(it->unit);
+        if(k.x*s >= x1 || (k.x + 1)*s <= x0 || k.y*s >= y1 || (k.y + 1)*s <= y0) continue;
+        painter->drawImage(screenRect(view,k.x,k.y,it->unit),it->image);
+    }
+    painter->restore();
+}
+
+void PF_TileRenderer::request(const TileKey &key, bool antialiased)
+{
+    PendingTile p{++jobs,QSharedPointer<QAtomicInt>(new QAtomicInt(0)),false};
+    pending.insert(key,p);
+    pool.start(new Job(this,scene,key,p.job,pen,dpr,antialiased,p.canceled));
+}
+
+void PF_TileRenderer::onTileRendered(quint64 scale, int x, int y, int job,
+                                     const QImage &image, bool canceled)
+{
+    const TileKey key{scale,x,y};
+    auto it = pending.find(key);
+    if(it == pending.end() || it->job != job) return;
+    const bool obsolete = it->obsolete;
+    pending.erase(it);
+    if(canceled) return;
+
+    /** 绘制过程中实体发生了变化，先显示，下一帧重新绘制 **/
+    tiles.insert(key,Tile{image,unitOf(scale),obsolete,frame});
+    emit tileReady();
+}
+
+/*!
+ \brief 实体在矩形范围内发生变化，与之重叠的瓦片过期，快照在下一次绘制时修补这个范围。
+
+*/
+void PF_TileRenderer::invalidate(const PF_Vector &minV, const PF_Vector &maxV)
+{
+    if(minV.x > maxV.x || minV.y > maxV.y) return;
+    if(!sceneDirty){
+        const PF_TileScene::Rect r{minV.x,minV.y,maxV.x,maxV.y};
+        if(dirty.size() < MaxDirtyRects){
+            dirty.push_back(r);
+        }else{
+            PF_TileScene::Rect& u = dirty.front();
+            for(const auto& d : dirty){
+                u.minX = std::min(u.minX,d.minX);
+                u.minY = std::min(u.minY,d.minY);
+                u.maxX = std::max(u.maxX,d.maxX);
+                u.maxY = std::max(u.maxY,d.maxY);
+            }
+            u.minX = std::min(u.minX,r.minX);
+            u.minY = std::min(u.minY,r.minY);
+            u.maxX = std::max(u.maxX,r.maxX);
+            u.maxY = std::max(u.maxY,r.maxY);
+            dirty.resize(1);
+        }
+    }
+
+    auto overlaps = [&](const TileKey& k, double unit){
+        const double s = worldSize(unit);
+        const double margin = TileMargin*unit;
+        return !(k.x*s - margin > maxV.x || (k.x + 1)*s + margin < minV.x
+                 || k.y*s - margin > maxV.y || (k.y + 1)*s + margin < minV.y);
+    };
+    for(auto it = tiles.begin(); it != tiles.end(); ++it){
+        if(overlaps(it.key(),it->unit)) it->stale = true;
+    }
+    for(auto it = pending.begin(); it != pending.end(); ++it){
+        if(overlaps(it.key(),unitOf(it.key().scale))) it->obsolete = true;
+    }
+}
+
+void PF_TileRenderer::invalidateAll()
+{
+    sceneDirty = true;
+    dirty.clear();
+    for(auto it = tiles.begin(); it != tiles.end(); ++it){
+        it->stale = true;
+    }
+    for(auto it = pending.begin(); it != pending.end(); ++it){
+        it->obsolete = true;
+    }
+}
+
+void PF_TileRenderer::setCacheSize(int tiles)
+{
+    maxTiles = std::max(1,tiles);
+    evict();
+}
+
+/*!
+ \brief 瓦片数目超过上限时删除最久没有使用的瓦片，当前帧用到的瓦片保留。
+
+*/
+void PF_TileRenderer::evict()
+{
+    if(tiles.size() <= maxTiles) return;
+
+    std::vector<std::pair<quint64,TileKey>> order;
+    order.reserve(size_t(tiles.size()));
+    for(auto it = tiles.constBegin(); it != tiles.constEnd(); ++it){
+        order.push_back(std::make_pair(it->lastUsed,it.key()));
+    }
+    std::sort(order.begin(),order.end(),[](const std::pair<quint64,TileKey>& a,
+                                           const std::pair<quint64,TileKey>& b){
+        return a.first < b.first;
+    });
+    for(const auto& o : order){
+        if(tiles.size() <= maxTiles || o.first == frame) break;
+        tiles.remove(o.second);
+    }
+}
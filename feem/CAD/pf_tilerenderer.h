@@ -0,0 +1,205 @@
+#ifndef PF_TILERENDERER_H
+#define PF_TILERENDERER_H
+
+#include "pf_vector.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPen>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include <vector>
+
+class PF_Entity;
+class PF_PrimitiveStore;
+class PF_EntityContainer;
+class PF_GraphicView;
+class QCPPainter;
+
+/*!
+ \brief 实体几何的只读快照，供工作线程绘制瓦片。
+
+ 工作线程不能访问实体和坐标轴，所以在GUI线程中把直线、圆弧、圆和点
+ 复制出来，并按均匀网格分桶，用于查找与瓦片相交的图元。
+ 实体变化后不重新建立快照，而是复制一份，去掉变化范围内的图元，再把
+ 范围内的实体重新收集到附加列表中。网格本身不修改，由多个快照共享，
+ 附加的图元较多时在工作线程中合并成新的网格。
+*/
+class PF_TileScene
+{
+public:
+    enum PrimitiveType{
+        Line,
+        Circle,
+        Point,
+        Arc
+    };
+
+    struct Primitive{
+        double x0, y0, x1, y1;  /**直线的两个端点，圆为圆心和半径，圆弧为圆心、半径和起始角，点只用x0,y0**/
+        double minX, minY, maxX, maxY;
+        PrimitiveType type;
+        double span;            /**圆弧逆时针转过的角度**/
+    };
+
+    struct Rect{
+        double minX, minY, maxX, maxY;
+
+        bool overlaps(double x0, double y0, double x1, double y1) const{
+            return !(x0 > maxX || x1 < minX || y0 > maxY || y1 < minY);
+        }
+    };
+
+    PF_TileScene();
+
+    void build(PF_EntityContainer* document);
+    void patch(PF_EntityContainer* document, const std::vector<Rect>& rects);
+    bool needsCompaction() const;
+    void compact();
+    void query(double minX, double minY, double maxX, double maxY,
+               std::vector<int>& result) const;
+
+    /** 编号小于网格中图元数目的在网格中，其余的在附加列表中 **/
+    const Primitive& primitive(int i) const{
+        return i < baseCount ? grid->primitives[size_t(i)] : added[size_t(i - baseCount)];
+    }
+
+    /** 选中或高亮的实体不画在瓦片中，由GUI线程直接绘制，只能在GUI线程中访问 **/
+    const std::vector<PF_Entity*>& selectedEntities() const{
+        return selected;
+    }
+
+private:
+    /*!
+     \brief 图元和均匀网格，建立后不再修改，可以在多个快照和线程之间共享。
+    */
+    struct Grid{
+        std::vector<Primitive> primitives;
+        double gridX, gridY;        /**网格左下角**/
+        double cellW, cellH;
+        int nx, ny;
+        std::vector<int> cellStart; /**CSR格式，长度为nx*ny+1**/
+        std::vector<int> cellItems;
+
+        void build();
+        int cellX(double x) const;
+        int cellY(double y) const;
+        void query(double minX, double minY, double maxX, double maxY,
+                   std::vector<int>& result) const;
+    };
+
+    void collect(PF_Entity* e, const std::vector<Rect>* clip);
+    void collect(const PF_PrimitiveStore& store, const std::vector<Rect>* clip);
+    void add(const Primitive& p, const std::vector<Rect>* clip);
+    void setGrid(Grid* g);
+
+private:
+    QSharedPointer<const Grid> grid;
+    int baseCount;
+    std::vector<bool> removed;  /**网格中已经删除的图元**/
+    int removedCount;
+    std::vector<Primitive> added;
+    std::vector<PF_Entity*> selected;
+    std::vector<Rect> selectedBounds;
+};
+
+/*!
+ \brief 在线程池中把实体图层绘制成屏幕大小固定的瓦片。
+
+ 瓦片在实际坐标系中对齐，同一缩放比例下平移时可以直接复用。
+ GUI线程只负责合成已经完成的瓦片，缺少的瓦片先用其他缩放比例或者
+ 过期的瓦片缩放后代替，并提交给工作线程绘制，完成后发出tileReady()。
+ 实体变化时只让相交的瓦片过期，下一帧只修补快照中变化的范围，
+ GUI线程不重新生成整个快照。
+*/
+class PF_TileRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PF_TileRenderer(PF_EntityContainer* document, QObject* parent=nullptr);
+    ~PF_TileRenderer() override;
+
+    static const int TileSize = 256;
+
+    bool paint(QCPPainter* painter, PF_GraphicView* view);
+    void invalidate(const PF_Vector& minV, const PF_Vector& maxV);
+    void invalidateAll();
+
+    void setCacheSize(int tiles);
+    int cacheSize() const{
+        return maxTiles;
+    }
+
+signals:
+    void tileReady();
+
+    /** 内部使用，工作线程合并完快照 **/
+    void sceneCompacted(int version);
+
+    /** 内部使用，工作线程完成一个瓦片 **/
+    void tileRendered(quint64 scale, int x, int y, int job, const QImage& image, bool canceled);
+
+private slots:
+    void onTileRendered(quint64 scale, int x, int y, int job, const QImage& image, bool canceled);
+    void onSceneCompacted(int version);
+
+private:
+    struct TileKey{
+        quint64 scale;      /**每像素对应的长度，按位保存**/
+        int x;
+        int y;
+
+        bool operator==(const TileKey& k) const{
+            return scale == k.scale && x == k.x && y == k.y;
+        }
+    };
+    friend uint qHash(const TileKey& key, uint seed);
+
+    struct Tile{
+        QImage image;
+        double unit;        /**每像素对应的长度**/
+        bool stale;
+        quint64 lastUsed;
+    };
+
+    struct PendingTile{
+        int job;            /**同一个瓦片可能被取消后重新提交**/
+        QSharedPointer<QAtomicInt> canceled;
+        bool obsolete;      /**绘制过程中实体发生了变化**/
+    };
+
+    class Job;
+    class CompactJob;
+
+    static double worldSize(double unit){
+        return TileSize*unit;
+    }
+    static double unitOf(quint64 scale);
+    static QRectF screenRect(const PF_GraphicView* view, int x, int y, double unit);
+    void request(const TileKey& key, bool antialiased);
+    void drawFallback(QCPPainter* painter, const PF_GraphicView* view,
+                      const TileKey& key, const QRectF& target);
+    void evict();
+    void updateScene();
+
+private:
+    PF_EntityContainer* document;
+    QSharedPointer<const PF_TileScene> scene;
+    bool sceneDirty;        /**需要重新生成整个快照**/
+    std::vector<PF_TileScene::Rect> dirty;  /**需要修补的范围**/
+    int sceneVersion;
+    QSharedPointer<PF_TileScene> compacting;
+    QPen pen;
+    double dpr;
+    QThreadPool pool;
+    QHash<TileKey,Tile> tiles;
+    QHash<TileKey,PendingTile> pending;
+    int maxTiles;
+    quint64 frame;          /**绘制的次数，用于淘汰最久没有使用的瓦片**/
+    int jobs;
+};
+
+#endif // PF_TILERENDERER_H
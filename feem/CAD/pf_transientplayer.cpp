@@ -0,0 +1,317 @@
+#include "pf_transientplayer.h"
+#include "pf_graphicview.h"
+#include "pf_transientresult.h"
+
+#include <QDebug>
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+/*!
+ \brief 在工作线程中读出一步的节点值并生成图像。读取映射的文件时
+ 缺页的等待发生在工作线程中。
+
+*/
+class PF_TransientPlayer::Job : public QRunnable
+{
+public:
+    Job(PF_TransientPlayer* player, const PF_TransientResult* result, int step, int job,
+        const PF_TriangleMap::RenderState& state, QSharedPointer<Frame> frame,
+        QSharedPointer<QAtomicInt> canceled)
+        :player(player),result(result),step(step),job(job),state(state)
+        ,frame(frame),canceled(canceled)
+    {
+    }
+
+    void run() override
+    {
+        prepare();
+        emit player->frameDecoded(step,job);
+    }
+
+private:
+    void prepare()
+    {
+        if(canceled->load()) return;
+        if(frame->values.isEmpty()){
+            const double* values = result->values(step);
+            if(!values) return;
+            frame->values.resize(result->nodeCount());
+            std::memcpy(frame->values.data(),values,sizeof(double)*size_t(result->nodeCount()));
+        }
+        if(state.isNull() || canceled->load()) return;
+        frame->image = PF_TriangleMap::render(state,frame->values);
+        frame->state = state;
+    }
+
+private:
+    PF_TransientPlayer* player;
+    const PF_TransientResult* result;
+    int step;
+    int job;
+    PF_TriangleMap::RenderState state;
+    QSharedPointer<Frame> frame;
+    QSharedPointer<QAtomicInt> canceled;
+};
+
+PF_TransientPlayer::PF_TransientPlayer(PF_TriangleMap *map, QObject *parent)
+    :QObject(parent)
+    ,map(map)
+    ,resultFile(nullptr)
+    ,current(-1)
+    ,wanted(-1)
+    ,maxFrames(16)
+    ,ahead(4)
+    ,loop(true)
+    ,clock(0)
+    ,jobs(0)
+{
+    pool.setMaxThreadCount(std::max(1,QThread::idealThreadCount() - 1));
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(40);
+    connect(&timer,&QTimer::timeout,this,&PF_TransientPlayer::onTimeout);
+    connect(this,&PF_TransientPlayer::frameDecoded,
+            this,&PF_TransientPlayer::onFrameDecoded,Qt::QueuedConnection);
+}
+
+PF_TransientPlayer::~PF_TransientPlayer()
+{
+    timer.stop();
+    cancel(true);
+    pool.waitForDone();
+}
+
+void PF_TransientPlayer::setResult(const PF_TransientResult *result)
+{
+    pause();
+    cancel(true);
+    pool.waitForDone();
+    frames.clear();
+    current = wanted = -1;
+    resultFile = nullptr;
+    if(!result || !map) return;
+    if(result->nodeCount() != map->nodeCount()){
+        qDebug()<<Q_FUNC_INFO<<"node count"<<result->nodeCount()<<"does not match the map"<<map->nodeCount();
+        return;
+    }
+    resultFile = result;
+
+    /** 整个过程使用同一个颜色范围，各帧的颜色可以互相比较 **/
+    double lower, upper;
+    if(resultFile->range(lower,upper))
+        map->setDataRange(QCPRange(lower,upper));
+}
+
+void PF_TransientPlayer::setCacheSize(int frames)
+{
+    maxFrames = std::max(1,frames);
+    ahead = std::min(ahead,maxFrames);
+    evict();
+}
+
+void PF_TransientPlayer::setPrefetch(int frames)
+{
+    ahead = std::max(0,std::min(frames,maxFrames));
+}
+
+void PF_TransientPlayer::setInterval(int msec)
+{
+    timer.setInterval(std::max(1,msec));
+}
+
+void PF_TransientPlayer::setLoop(bool enabled)
+{
+    loop = enabled;
+}
+
+void PF_TransientPlayer::play()
+{
+    if(!resultFile || timer.isActive()) return;
+    if(current < 0) setStep(nextStep(-1));
+    timer.start();
+    emit playingChanged(true);
+}
+
+void PF_TransientPlayer::pause()
+{
+    if(!timer.isActive()) return;
+    timer.stop();
+    emit playingChanged(false);
+}
+
+/*!
+ \brief 拖动时取消不再需要的请求，只保留新位置之后的几帧。
+
+*/
+void PF_TransientPlayer::setStep(int step)
+{
+    if(!resultFile || !resultFile->hasStep(step)) return;
+    wanted = step;
+    cancel(false);
+    refreshState();
+    if(frames.contains(step))
+        show(step);
+    else
+        request(step);
+    prefetchFrom(step);
+}
+
+/*!
+ \brief 上一帧已经显示时前进一步，下一帧还在准备时什么也不做。
+
+*/
+void PF_TransientPlayer::onTimeout()
+{
+    if(!resultFile) return;
+    if(wanted != current) return;
+    const int next = nextStep(current);
+    if(next < 0){
+        pause();
+        return;
+    }
+    wanted = next;
+    refreshState();
+    if(frames.contains(next))
+        show(next);
+    else
+        request(next);
+    prefetchFrom(next);
+}
+
+void PF_TransientPlayer::onFrameDecoded(int step, int job)
+{
+    auto it = pending.find(step);
+    if(it == pending.end() || it->job != job) return;
+    QSharedPointer<Frame> frame = it->frame;
+    const bool canceled = it->canceled->load();
+    pending.erase(it);
+    if(canceled || frame->values.isEmpty()) return;
+
+    frame->lastUsed = ++clock;
+    frames.insert(step,*frame);
+    if(step == wanted && wanted != current)
+        show(step);
+    evict();
+}
+
+int PF_TransientPlayer::nextStep(int step) const
+{
+    if(!resultFile) return -1;
+    const int count = resultFile->stepCount();
+    for(int s=step + 1;s<count;++s){
+        if(resultFile->hasStep(s)) return s;
+    }
+    if(!loop) return -1;
+    for(int s=0;s<=step && s<count;++s){
+        if(resultFile->hasStep(s)) return s;
+    }
+    return -1;
+}
+
+/** step是否在from之后准备的几帧之中 **/
+bool PF_TransientPlayer::isAhead(int step, int from) const
+{
+    if(from < 0) return false;
+    int s = from;
+    for(int i=0;i<=ahead;++i){
+        if(s == step) return true;
+        s = nextStep(s);
+        if(s < 0 || s == from) break;
+    }
+    return false;
+}
+
+void PF_TransientPlayer::refreshState()
+{
+    if(!map->isCurrent(state))
+        state = map->renderState();
+}
+
+/*!
+ \brief 提交一帧。已经读出节点值而图像过期的帧只重新生成图像。
+
+*/
+void PF_TransientPlayer::request(int step)
+{
+    if(pending.contains(step)) return;
+    PendingFrame p{++jobs,QSharedPointer<Frame>(new Frame),QSharedPointer<QAtomicInt>(new QAtomicInt(0))};
+    auto it = frames.constFind(step);
+    if(it != frames.constEnd())
+        p.frame->values = it->values;
+    p.frame->lastUsed = 0;
+    pending.insert(step,p);
+    pool.start(new Job(this,resultFile,step,p.job,state,p.frame,p.canceled));
+}
+
+void PF_TransientPlayer::prefetchFrom(int step)
+{
+    int s = step;
+    for(int i=0;i<ahead;++i){
+        s = nextStep(s);
+        if(s < 0 || s == step) break;
+        auto it = frames.constFind(s);
+        if(it != frames.constEnd() && (state.isNull() || map->isCurrent(it->state)))
+            continue;
+        request(s);
+    }
+}
+
+/*!
+ \brief 把一帧交给云图。图像按当前视图生成时直接使用，否则云图按节点值重新绘制。
+
+*/
+void PF_TransientPlayer::show(int step)
+{
+    auto it = frames.find(step);
+    if(it == frames.end()) return;
+    it->lastUsed = ++clock;
+    if(!it->image.isNull() && map->isCurrent(it->state))
+        map->setValues(it->values,it->image,it->state);
+    else
+        map->setValues(it->values);
+    current = step;
+    if(map->parentPlot())
+        map->parentPlot()->replot(PF_GraphicView::rpQueuedReplot);
+    emit stepChanged(step,resultFile->time(step));
+}
+
+/*!
+ \brief 取消正在准备的帧。all为false时保留等待显示的一步之后的几帧。
+
+*/
+void PF_TransientPlayer::cancel(bool all)
+{
+    for(auto it = pending.begin(); it != pending.end();){
+        if(!all && isAhead(it.key(),wanted)){
+            ++it;
+            continue;
+        }
+        it->canceled->store(1);
+        it = pending.erase(it);
+    }
+}
+
+/*!
+ \brief 超出数量时淘汰最久没有使用的帧，正在显示和将要显示的几帧不淘汰。
+
+*/
+void PF_TransientPlayer::evict()
+{
+    if(frames.size() <= maxFrames) return;
+
+    std::vector<std::pair<quint64,int>> order;
+    order.reserve(size_t(frames.size()));
+    for(auto it = frames.constBegin(); it != frames.constEnd(); ++it){
+        if(it.key() == current || isAhead(it.key(),wanted)) continue;
+        order.push_back(std::make_pair(it->lastUsed,it.key()));
+    }
+    std::sort(order.begin(),order.end());
+    for(const auto& o : order){
+        if(frames.size() <= maxFrames) break;
+        frames.remove(o.second);
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef PF_TRANSIENTPLAYER_H
+#define PF_TRANSIENTPLAYER_H
+
+#include "pf_trianglemap.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+
+class PF_TransientResult;
+
+/*!
+ \brief 在云图上播放和拖动瞬态计算结果的各个时间步。
+
+ 显示第k步时，后面几步在工作线程中从映射的结果文件中读出节点值，
+ 并按当前视图生成图像，GUI线程只需要把准备好的帧交给云图。
+ 准备好的帧按最近使用的顺序保留有限的数量，来回拖动时不需要重新读取。
+ 下一帧没有准备好时播放等待而不跳帧。视图变化后旧的图像不再使用，
+ 由云图按节点值重新绘制，之后的帧按新的视图生成。
+*/
+class PF_TransientPlayer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PF_TransientPlayer(PF_TriangleMap* map, QObject* parent=nullptr);
+    ~PF_TransientPlayer() override;
+
+    /** 结果文件的节点数必须与云图相同，文件由调用者管理，播放期间不能关闭 **/
+    void setResult(const PF_TransientResult* result);
+    const PF_TransientResult* result() const{
+        return resultFile;
+    }
+
+    void setCacheSize(int frames);
+    int cacheSize() const{
+        return maxFrames;
+    }
+    /** 提前准备的帧数 **/
+    void setPrefetch(int frames);
+    int prefetch() const{
+        return ahead;
+    }
+    /** 两帧之间的时间间隔（毫秒） **/
+    void setInterval(int msec);
+    int interval() const{
+        return timer.interval();
+    }
+    void setLoop(bool enabled);
+    bool isLooping() const{
+        return loop;
+    }
+
+    bool isPlaying() const{
+        return timer.isActive();
+    }
+    int currentStep() const{
+        return current;
+    }
+
+public slots:
+    void play();
+    void pause();
+    /** 跳到第step步，帧没有准备好时准备好之后再显示 **/
+    void setStep(int step);
+
+signals:
+    void stepChanged(int step, double time);
+    void playingChanged(bool playing);
+
+    /** 内部使用，工作线程准备好一帧 **/
+    void frameDecoded(int step, int job);
+
+private slots:
+    void onTimeout();
+    void onFrameDecoded(int step, int job);
+
+private:
+    struct Frame{
+        QVector<double> values;
+        QImage image;
+        PF_TriangleMap::RenderState state;
+        quint64 lastUsed;
+    };
+
+    struct PendingFrame{
+        int job;
+        QSharedPointer<Frame> frame;    /**工作线程写入，完成后由GUI线程取走**/
+        QSharedPointer<QAtomicInt> canceled;
+    };
+
+    class Job;
+
+    int nextStep(int step) const;
+    bool isAhead(int step, int from) const;
+    void refreshState();
+    void request(int step);
+    void prefetchFrom(int step);
+    void show(int step);
+    void cancel(bool all);
+    void evict();
+
+private:
+    PF_TriangleMap* map;
+    const PF_TransientResult* resultFile;
+    PF_TriangleMap::RenderState state;  /**当前视图的快照，视图变化时重新生成**/
+    QThreadPool pool;
+    QTimer timer;
+    QHash<int,Frame> frames;
+    QHash<int,PendingFrame> pending;
+    int current;
+    int wanted;                         /**等待显示的时间步**/
+    int maxFrames;
+    int ahead;
+    bool loop;
+    quint64 clock;
+    int jobs;
+};
+
+#endif // PF_TRANSIENTPLAYER_H
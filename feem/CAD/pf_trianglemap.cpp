@@ -0,0 +1,481 @@
+#include "pf_trianglemap.h"
+#include "pf_graphicview.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/*!
+ \brief 光栅化一幅图像所需的数组，values和alpha与图像同样大小。
+
+*/
+struct Raster{
+    const double* px;
+    const double* py;
+    const double* pv;
+    const int* tri;
+    int triangleCount;
+    int nodeCount;
+    int width;
+    QCPRange dataRange;
+    bool logarithmic;
+    double* values;
+    unsigned char* alpha;
+    uchar* bits;
+    int bytesPerLine;
+};
+
+/*!
+ \brief 光栅化与行[y0,y1)相交的三角形并把这些行着色。像素(i,j)的中心为
+ (i+0.5,j+0.5)，中心落在三角形内的像素被填充（左闭右开），相邻三角形
+ 共享的边不会留下缝隙或者重复填充。
+
+*/
+void rasterizeBand(const Raster& r, int y0, int y1, QCPColorGradient& gradient)
+{
+    const int w = r.width;
+    double* values = r.values + y0*w;
+    unsigned char* alpha = r.alpha + y0*w;
+    std::fill(values,values + (y1 - y0)*w,r.dataRange.lower);
+    std::memset(alpha,0,(y1 - y0)*w);
+
+    const double* px = r.px;
+    const double* py = r.py;
+    const double* pv = r.pv;
+    const int* tri = r.tri;
+    const int count = r.triangleCount;
+    const int n = r.nodeCount;
+
+    for(int t=0;t<count;++t){
+        int a = tri[3*t], b = tri[3*t + 1], c = tri[3*t + 2];
+        if(a < 0 || b < 0 || c < 0 || a >= n || b >= n || c >= n) continue;
+        /** 按y排序三个顶点 **/
+        if(py[b] < py[a]) std::swap(a,b);
+        if(py[c] < py[b]) std::swap(b,c);
+        if(py[b] < py[a]) std::swap(a,b);
+        const double ya = py[a], yb = py[b], yc = py[c];
+        const int rowBegin = std::max(y0,int(std::ceil(ya - 0.5)));
+        const int rowEnd = std::min(y1,int(std::ceil(yc - 0.5)));
+        if(rowBegin >= rowEnd) continue;
+
+        const double xa = px[a], xb = px[b], xc = px[c];
+        if(std::max(xa,std::max(xb,xc)) < 0. || std::min(xa,std::min(xb,xc)) > w) continue;
+        const double va = pv[a], vb = pv[b], vc = pv[c];
+        if(std::isnan(va) || std::isnan(vb) || std::isnan(vc)) continue;
+
+        /** 值的平面 v = va + dvdx*(x-xa) + dvdy*(y-ya) **/
+        const double det = (xb - xa)*(yc - ya) - (xc - xa)*(yb - ya);
+        if(std::abs(det) < PF_TOLERANCE) continue;
+        const double dvdx = ((vb - va)*(yc - ya) - (vc - va)*(yb - ya))/det;
+        const double dvdy = ((xb - xa)*(vc - va) - (xc - xa)*(vb - va))/det;
+
+        const double slopeAC = (xc - xa)/(yc - ya);
+        const double slopeAB = yb > ya ? (xb - xa)/(yb - ya) : 0.;
+        const double slopeBC = yc > yb ? (xc - xb)/(yc - yb) : 0.;
+        for(int row=rowBegin;row<rowEnd;++row){
+            const double yy = row + 0.5;
+            const double x1 = xa + (yy - ya)*slopeAC;
+            const double x2 = yy < yb ? xa + (yy - ya)*slopeAB : xb + (yy - yb)*slopeBC;
+            const double left = std::min(x1,x2);
+            const double right = std::max(x1,x2);
+            const int i0 = std::max(0,int(std::ceil(left - 0.5)));
+            const int i1 = std::min(w,int(std::ceil(right - 0.5)));
+            if(i0 >= i1) continue;
+            double* vrow = values + (row - y0)*w;
+            unsigned char* arow = alpha + (row - y0)*w;
+            double v = va + dvdx*(i0 + 0.5 - xa) + dvdy*(yy - ya);
+            for(int i=i0;i<i1;++i){
+                vrow[i] = v;
+                v += dvdx;
+            }
+            std::memset(arow + i0,255,i1 - i0);
+        }
+    }
+
+    for(int row=y0;row<y1;++row){
+        gradient.colorize(values + (row - y0)*w,alpha + (row - y0)*w,r.dataRange,
+                          reinterpret_cast<QRgb*>(r.bits + row*r.bytesPerLine),w,1,r.logarithmic);
+    }
+}
+
+/*!
+ \brief 在工作线程中光栅化并着色图像的一个水平条带。
+
+*/
+class BandJob : public QRunnable
+{
+public:
+    BandJob(const Raster* raster, int y0, int y1, const QCPColorGradient& gradient, QSemaphore* done)
+        :raster(raster),y0(y0),y1(y1),gradient(gradient),done(done)
+    {
+    }
+
+    void run() override
+    {
+        rasterizeBand(*raster,y0,y1,gradient);
+        done->release();
+    }
+
+private:
+    const Raster* raster;
+    int y0, y1;
+    QCPColorGradient gradient;  /**每个线程一份拷贝，颜色表是隐式共享的**/
+    QSemaphore* done;
+};
+
+}
+
+PF_TriangleMap::PF_TriangleMap(QCPAxis *keyAxis, QCPAxis *valueAxis)
+    :QCPAbstractPlottable(keyAxis, valueAxis)
+    ,mDataRange(0,1)
+    ,mDataScaleType(QCPAxis::stLinear)
+    ,mGradient(QCPColorGradient::gpJet)
+{
+}
+
+PF_TriangleMap::~PF_TriangleMap()
+{
+}
+
+void PF_TriangleMap::setData(const QVector<double> &x, const QVector<double> &y,
+                             const QVector<int> &triangles, const QVector<double> &values)
+{
+    if(x.size() != y.size() || x.size() != values.size() || triangles.size()%3 != 0){
+        qDebug()<<Q_FUNC_INFO<<"inconsistent sizes"<<x.size()<<y.size()<<values.size()<<triangles.size();
+        return;
+    }
+    mX = x;
+    mY = y;
+    mTriangles = triangles;
+    mValues = values;
+    mFrameImage = QImage();
+    updateBounds();
+}
+
+void PF_TriangleMap::setData(const double *x, const double *y, int nodeCount,
+                             const int *triangles, int triangleCount, const double *values)
+{
+    if(!x || !y || !triangles || !values || nodeCount < 0 || triangleCount < 0){
+        qDebug()<<Q_FUNC_INFO<<"invalid arrays";
+        return;
+    }
+    mX.resize(nodeCount);
+    mY.resize(nodeCount);
+    mValues.resize(nodeCount);
+    mTriangles.resize(triangleCount*3);
+    std::memcpy(mX.data(),x,sizeof(double)*nodeCount);
+    std::memcpy(mY.data(),y,sizeof(double)*nodeCount);
+    std::memcpy(mValues.data(),values,sizeof(double)*nodeCount);
+    std::memcpy(mTriangles.data(),triangles,sizeof(int)*triangleCount*3);
+    mFrameImage = QImage();
+    updateBounds();
+}
+
+void PF_TriangleMap::setValues(const QVector<double> &values)
+{
+    if(values.size() != mX.size()){
+        qDebug()<<Q_FUNC_INFO<<"value count"<<values.size()<<"does not match node count"<<mX.size();
+        return;
+    }
+    mValues = values;
+    mFrameImage = QImage();
+}
+
+void PF_TriangleMap::setValues(const QVector<double> &values, const QImage &image, const RenderState &state)
+{
+    setValues(values);
+    if(values.size() != mX.size() || state.triangles.constData() != mTriangles.constData())
+        return;
+    mFrameImage = image;
+    mFrameState = state;
+}
+
+/*!
+ \brief 生成当前视图的绘制状态，颜色表在这里生成，各线程的拷贝只读共享的表。
+
+*/
+PF_TriangleMap::RenderState PF_TriangleMap::renderState() const
+{
+    RenderState state;
+    state.dpr = 1.;
+    state.dataRange = mDataRange;
+    state.dataScaleType = mDataScaleType;
+    state.gradient = mGradient;
+    if(mTriangles.isEmpty() || !mKeyAxis || !mValueAxis) return state;
+
+    state.rect = clipRect();
+    state.dpr = mParentPlot->bufferDevicePixelRatio();
+    state.keyRange = mKeyAxis->range();
+    state.valueRange = mValueAxis->range();
+    state.triangles = mTriangles;
+    state.pixelX.resize(mX.size());
+    state.pixelY.resize(mX.size());
+    toPixels(state.rect,state.dpr,state.pixelX.data(),state.pixelY.data());
+    state.gradient.color(mDataRange.lower,mDataRange);
+    return state;
+}
+
+bool PF_TriangleMap::isCurrent(const RenderState &state) const
+{
+    if(state.isNull() || !mKeyAxis || !mValueAxis) return false;
+    return isCurrent(state,clipRect(),mParentPlot->bufferDevicePixelRatio());
+}
+
+QImage PF_TriangleMap::render(const RenderState &state, const QVector<double> &values)
+{
+    if(state.isNull() || values.size() != state.pixelX.size()) return QImage();
+    const int w = int(std::ceil(state.rect.width()*state.dpr));
+    const int h = int(std::ceil(state.rect.height()*state.dpr));
+    QImage image(w,h,QImage::Format_ARGB32_Premultiplied);
+    std::vector<double> pixelValues(size_t(w)*size_t(h));
+    std::vector<unsigned char> pixelAlpha(size_t(w)*size_t(h));
+
+    const Raster raster{state.pixelX.constData(),state.pixelY.constData(),values.constData(),
+                        state.triangles.constData(),state.triangles.size()/3,values.size(),w,
+                        state.dataRange,state.dataScaleType == QCPAxis::stLogarithmic,
+                        pixelValues.data(),pixelAlpha.data(),image.bits(),image.bytesPerLine()};
+    QCPColorGradient gradient(state.gradient);
+    rasterizeBand(raster,0,h,gradient);
+    image.setDevicePixelRatio(state.dpr);
+    return image;
+}
+
+void PF_TriangleMap::setDataRange(const QCPRange &dataRange)
+{
+    if(!QCPRange::validRange(dataRange)) return;
+    if(mDataRange.lower != dataRange.lower || mDataRange.upper != dataRange.upper){
+        if(mDataScaleType == QCPAxis::stLogarithmic)
+            mDataRange = dataRange.sanitizedForLogScale();
+        else
+            mDataRange = dataRange.sanitizedForLinScale();
+        emit dataRangeChanged(mDataRange);
+    }
+}
+
+void PF_TriangleMap::setDataScaleType(QCPAxis::ScaleType scaleType)
+{
+    if(mDataScaleType != scaleType){
+        mDataScaleType = scaleType;
+        emit dataScaleTypeChanged(mDataScaleType);
+        if(mDataScaleType == QCPAxis::stLogarithmic)
+            setDataRange(mDataRange.sanitizedForLogScale());
+    }
+}
+
+void PF_TriangleMap::setGradient(const QCPColorGradient &gradient)
+{
+    if(mGradient != gradient){
+        mGradient = gradient;
+        emit gradientChanged(mGradient);
+    }
+}
+
+/*!
+ \brief 把颜色范围设置为节点值的最小值和最大值，忽略NaN。
+
+*/
+void PF_TriangleMap::rescaleDataRange()
+{
+    double lower = PF_MAXDOUBLE;
+    double upper = -PF_MAXDOUBLE;
+    for(const double v : mValues){
+        if(std::isnan(v)) continue;
+        lower = std::min(lower,v);
+        upper = std::max(upper,v);
+    }
+    if(lower > upper) return;
+    setDataRange(QCPRange(lower,upper));
+}
+
+double PF_TriangleMap::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(details)
+    if((onlySelectable && mSelectable == QCP::stNone) || mX.isEmpty())
+        return -1;
+    if(!mKeyAxis || !mValueAxis)
+        return -1;
+
+    if(mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint())){
+        double posKey, posValue;
+        pixelsToCoords(pos, posKey, posValue);
+        if(mKeyBounds.contains(posKey) && mValueBounds.contains(posValue)){
+            if(details)
+                details->setValue(QCPDataSelection(QCPDataRange(0, 1)));
+            return mParentPlot->selectionTolerance()*0.99;
+        }
+    }
+    return -1;
+}
+
+QCPRange PF_TriangleMap::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
+{
+    foundRange = !mX.isEmpty();
+    QCPRange result = mKeyBounds;
+    if(inSignDomain == QCP::sdPositive){
+        if(result.lower <= 0 && result.upper > 0)
+            result.lower = result.upper*1e-3;
+        else if(result.lower <= 0 && result.upper <= 0)
+            foundRange = false;
+    }else if(inSignDomain == QCP::sdNegative){
+        if(result.upper >= 0 && result.lower < 0)
+            result.upper = result.lower*1e-3;
+        else if(result.upper >= 0 && result.lower >= 0)
+            foundRange = false;
+    }
+    return result;
+}
+
+QCPRange PF_TriangleMap::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+    if(inKeyRange != QCPRange()){
+        if(mKeyBounds.upper < inKeyRange.lower || mKeyBounds.lower > inKeyRange.upper){
+            foundRange = false;
+            return QCPRange();
+        }
+    }
+    foundRange = !mY.isEmpty();
+    QCPRange result = mValueBounds;
+    if(inSignDomain == QCP::sdPositive){
+        if(result.lower <= 0 && result.upper > 0)
+            result.lower = result.upper*1e-3;
+        else if(result.lower <= 0 && result.upper <= 0)
+            foundRange = false;
+    }else if(inSignDomain == QCP::sdNegative){
+        if(result.upper >= 0 && result.lower < 0)
+            result.upper = result.lower*1e-3;
+        else if(result.upper >= 0 && result.lower >= 0)
+            foundRange = false;
+    }
+    return result;
+}
+
+/*!
+ \brief 节点变换到图像的像素坐标之后按条带并行光栅化，再把图像画到坐标区域。
+ 提前生成的图像与当前视图一致时直接使用。
+
+*/
+void PF_TriangleMap::draw(QCPPainter *painter)
+{
+    if(mTriangles.isEmpty()) return;
+    if(!mKeyAxis || !mValueAxis) return;
+
+    const QRect rect = clipRect();
+    if(rect.isEmpty()) return;
+    const double dpr = painter->modes().testFlag(QCPPainter::pmVectorized) ? 3. : mParentPlot->bufferDevicePixelRatio();
+    if(!mFrameImage.isNull() && isCurrent(mFrameState,rect,dpr)){
+        painter->drawImage(QRectF(rect),mFrameImage);
+        return;
+    }
+    const int w = int(std::ceil(rect.width()*dpr));
+    const int h = int(std::ceil(rect.height()*dpr));
+
+    /** 节点的像素坐标，以像素左上角为原点 **/
+    mPixelX.resize(mX.size());
+    mPixelY.resize(mX.size());
+    toPixels(rect,dpr,mPixelX.data(),mPixelY.data());
+
+    if(mImage.width() != w || mImage.height() != h)
+        mImage = QImage(w,h,QImage::Format_ARGB32_Premultiplied);
+    mPixelValues.resize(w*h);
+    mPixelAlpha.resize(w*h);
+
+    /** 先在GUI线程生成颜色表，各线程的拷贝只读共享的表 **/
+    mGradient.color(mDataRange.lower,mDataRange);
+    const Raster raster{mPixelX.constData(),mPixelY.constData(),mValues.constData(),
+                        mTriangles.constData(),mTriangles.size()/3,mX.size(),w,
+                        mDataRange,mDataScaleType == QCPAxis::stLogarithmic,
+                        mPixelValues.data(),mPixelAlpha.data(),mImage.bits(),mImage.bytesPerLine()};
+
+    QThreadPool* pool = QThreadPool::globalInstance();
+    const int bands = std::max(1,std::min(h/16,pool->maxThreadCount()));
+    QSemaphore done;
+    for(int i=1;i<bands;++i){
+        pool->start(new BandJob(&raster,h*i/bands,h*(i + 1)/bands,mGradient,&done));
+    }
+    QCPColorGradient gradient(mGradient);
+    rasterizeBand(raster,0,h/bands,gradient);
+    done.acquire(bands - 1);
+
+    mImage.setDevicePixelRatio(dpr);
+    painter->drawImage(QRectF(rect),mImage);
+}
+
+void PF_TriangleMap::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    const int w = std::max(1,int(rect.width()));
+    QVector<double> ramp(w);
+    for(int i=0;i<w;++i){
+        ramp[i] = mDataRange.lower + mDataRange.size()*(i + 0.5)/w;
+    }
+    QImage strip(w,1,QImage::Format_ARGB32_Premultiplied);
+    QCPColorGradient gradient(mGradient);
+    gradient.colorize(ramp.constData(),QCPRange(mDataRange.lower,mDataRange.upper),
+                      reinterpret_cast<QRgb*>(strip.scanLine(0)),w);
+    painter->drawImage(rect,strip);
+}
+
+void PF_TriangleMap::updateBounds()
+{
+    double xmin = PF_MAXDOUBLE, xmax = -PF_MAXDOUBLE;
+    double ymin = PF_MAXDOUBLE, ymax = -PF_MAXDOUBLE;
+    for(int i=0;i<mX.size();++i){
+        xmin = std::min(xmin,mX.at(i));
+        xmax = std::max(xmax,mX.at(i));
+        ymin = std::min(ymin,mY.at(i));
+        ymax = std::max(ymax,mY.at(i));
+    }
+    if(xmin > xmax){
+        mKeyBounds = QCPRange();
+        mValueBounds = QCPRange();
+        return;
+    }
+    mKeyBounds = QCPRange(xmin,xmax);
+    mValueBounds = QCPRange(ymin,ymax);
+}
+
+/*!
+ \brief 坐标轴都是线性时变换是仿射的，只需要对三个点调用coordsToPixels()。
+
+*/
+void PF_TriangleMap::toPixels(const QRect &rect, double dpr, double *px, double *py) const
+{
+    const int n = mX.size();
+    const double* x = mX.constData();
+    const double* y = mY.constData();
+    if(mKeyAxis->scaleType() == QCPAxis::stLinear && mValueAxis->scaleType() == QCPAxis::stLinear){
+        const QPointF o = (coordsToPixels(0.,0.) - rect.topLeft())*dpr;
+        const QPointF ex = (coordsToPixels(1.,0.) - rect.topLeft())*dpr - o;
+        const QPointF ey = (coordsToPixels(0.,1.) - rect.topLeft())*dpr - o;
+        for(int i=0;i<n;++i){
+            px[i] = o.x() + ex.x()*x[i] + ey.x()*y[i];
+            py[i] = o.y() + ex.y()*x[i] + ey.y()*y[i];
+        }
+    }else{
+        for(int i=0;i<n;++i){
+            const QPointF p = (coordsToPixels(x[i],y[i]) - rect.topLeft())*dpr;
+            px[i] = p.x();
+            py[i] = p.y();
+        }
+    }
+}
+
+/*!
+ \brief 判断快照与当前的视图、网格和颜色设置是否一致。
+
+*/
+bool PF_TriangleMap::isCurrent(const RenderState &state, const QRect &rect, double dpr) const
+{
+    return state.rect == rect && state.dpr == dpr
+            && state.keyRange == mKeyAxis->range() && state.valueRange == mValueAxis->range()
+            && state.triangles.constData() == mTriangles.constData()
+            && state.dataRange == mDataRange && state.dataScaleType == mDataScaleType
+            && state.gradient == mGradient;
+}
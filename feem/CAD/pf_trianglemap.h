@@ -0,0 +1,138 @@
+#ifndef PF_TRIANGLEMAP_H
+#define PF_TRIANGLEMAP_H
+
+#include "pf_plot.h"
+
+#include <QImage>
+#include <QVector>
+
+/*!
+ \brief 在三角形网格上绘制节点场量的云图，不需要插值到规则网格。
+
+ 每次绘制时把节点变换为像素坐标，逐个三角形按扫描线光栅化，
+ 像素的值由三个顶点的值线性插值（Gouraud），写入与绘图区域同样
+ 大小的缓冲区，最后每一行用QCPColorGradient::colorize()查表得到颜色。
+ 图像按水平条带分给多个线程，每个线程只写自己的条带。
+
+ 动画播放时可以用renderState()取得绘制状态的快照，在工作线程中用render()
+ 提前生成下一帧的图像，再用setValues(values,image,state)交给云图，
+ 视图和颜色设置没有变化时绘制直接使用该图像。
+*/
+class PF_TriangleMap : public QCPAbstractPlottable
+{
+    Q_OBJECT
+public:
+    /*!
+     \brief 绘制所需状态的快照：节点的像素坐标、三角形、颜色表和颜色范围。
+     只能在GUI线程中生成，之后可以在任意线程中读取。
+    */
+    struct RenderState{
+        QRect rect;
+        double dpr;
+        QCPRange keyRange, valueRange;
+        QVector<double> pixelX, pixelY;
+        QVector<int> triangles;
+        QCPRange dataRange;
+        QCPAxis::ScaleType dataScaleType;
+        QCPColorGradient gradient;
+
+        bool isNull() const{
+            return triangles.isEmpty() || rect.isEmpty();
+        }
+    };
+
+    explicit PF_TriangleMap(QCPAxis *keyAxis, QCPAxis *valueAxis);
+    ~PF_TriangleMap() override;
+
+    /** 节点坐标、三角形的三个节点编号（从0开始）以及节点上的值 **/
+    void setData(const QVector<double>& x, const QVector<double>& y,
+                 const QVector<int>& triangles, const QVector<double>& values);
+    void setData(const double* x, const double* y, int nodeCount,
+                 const int* triangles, int triangleCount, const double* values);
+    /** 网格不变，只更换节点上的值，例如切换物理量或时间步 **/
+    void setValues(const QVector<double>& values);
+    /** 同时给出按state生成的图像，视图和颜色设置不变时绘制直接使用该图像 **/
+    void setValues(const QVector<double>& values, const QImage& image, const RenderState& state);
+
+    RenderState renderState() const;
+    /** 快照与当前的视图、网格和颜色设置是否一致 **/
+    bool isCurrent(const RenderState& state) const;
+    /** 按快照生成图像，可以在工作线程中调用 **/
+    static QImage render(const RenderState& state, const QVector<double>& values);
+
+    int nodeCount() const{
+        return mX.size();
+    }
+    int triangleCount() const{
+        return mTriangles.size()/3;
+    }
+    const QVector<double>& xData() const{
+        return mX;
+    }
+    const QVector<double>& yData() const{
+        return mY;
+    }
+    const QVector<int>& triangles() const{
+        return mTriangles;
+    }
+    const QVector<double>& values() const{
+        return mValues;
+    }
+
+    QCPRange dataRange() const{
+        return mDataRange;
+    }
+    QCPAxis::ScaleType dataScaleType() const{
+        return mDataScaleType;
+    }
+    QCPColorGradient gradient() const{
+        return mGradient;
+    }
+
+    Q_SLOT void setDataRange(const QCPRange& dataRange);
+    Q_SLOT void setDataScaleType(QCPAxis::ScaleType scaleType);
+    Q_SLOT void setGradient(const QCPColorGradient& gradient);
+    void rescaleDataRange();
+
+    /** 继承的虚函数 **/
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const override;
+    QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const override;
+    QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth,
+                           const QCPRange &inKeyRange=QCPRange()) const override;
+
+signals:
+    void dataRangeChanged(const QCPRange &newRange);
+    void dataScaleTypeChanged(QCPAxis::ScaleType scaleType);
+    void gradientChanged(const QCPColorGradient &newGradient);
+
+protected:
+    void draw(QCPPainter *painter) override;
+    void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const override;
+
+private:
+    void updateBounds();
+    void toPixels(const QRect& rect, double dpr, double* px, double* py) const;
+    bool isCurrent(const RenderState& state, const QRect& rect, double dpr) const;
+
+private:
+    QVector<double> mX, mY;
+    QVector<int> mTriangles;
+    QVector<double> mValues;
+    QCPRange mKeyBounds, mValueBounds;
+
+    QCPRange mDataRange;
+    QCPAxis::ScaleType mDataScaleType;
+    QCPColorGradient mGradient;
+
+    /** 绘制时使用的缓冲区，在多次绘制之间保留以避免重新分配 **/
+    QVector<double> mPixelX, mPixelY;
+    QVector<double> mPixelValues;
+    QVector<unsigned char> mPixelAlpha;
+    QImage mImage;
+
+    /** 在其他线程中提前生成的图像及其状态 **/
+    QImage mFrameImage;
+    RenderState mFrameState;
+};
+
+#endif // PF_TRIANGLEMAP_H
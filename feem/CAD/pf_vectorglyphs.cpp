@@ -0,0 +1,348 @@
+#include "pf_vectorglyphs.h"
+#include "pf_graphicview.h"
+#include "pf_pointlocator.h"
+
+#include <QPainterPath>
+#include <QRunnable>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+/** 一次最多的采样点数，避免间距过小时占用过多内存 **/
+const double MaxSamples = 2e5;
+/** 箭头的长度与采样间距之比 **/
+const double GlyphLength = 0.8;
+
+/** 按符号域截取范围，与QCPColorMap的做法相同 **/
+QCPRange restrictToSignDomain(QCPRange result, QCP::SignDomain inSignDomain, bool& foundRange)
+{
+    if(inSignDomain == QCP::sdPositive){
+        if(result.lower <= 0 && result.upper > 0)
+            result.lower = result.upper*1e-3;
+        else if(result.lower <= 0 && result.upper <= 0)
+            foundRange = false;
+    }else if(inSignDomain == QCP::sdNegative){
+        if(result.upper >= 0 && result.lower < 0)
+            result.upper = result.lower*1e-3;
+        else if(result.upper >= 0 && result.lower >= 0)
+            foundRange = false;
+    }
+    return result;
+}
+
+}
+
+/*!
+ \brief 在工作线程中插值得到各采样点的向量，网格外的点被去掉。
+
+*/
+class PF_VectorGlyphs::Job : public QRunnable
+{
+public:
+    Job(PF_VectorGlyphs* glyphs, int job, const PF_PointLocator* locator, const double* vx, const double* vy,
+        std::vector<double> x, std::vector<double> y, QSharedPointer<Samples> samples,
+        QSharedPointer<QAtomicInt> canceled)
+        :glyphs(glyphs),job(job),locator(locator),vx(vx),vy(vy),x(std::move(x)),y(std::move(y))
+        ,samples(samples),canceled(canceled)
+    {
+    }
+
+    void run() override
+    {
+        sample();
+        emit glyphs->resampled(job);
+    }
+
+private:
+    void sample()
+    {
+        samples->maxMagnitude = 0.;
+        const int n = int(x.size());
+        if(canceled->load() || n == 0) return;
+        std::vector<double> bx(n), by(n);
+        locator->interpolate(vx,x.data(),y.data(),n,bx.data());
+        if(canceled->load()) return;
+        locator->interpolate(vy,x.data(),y.data(),n,by.data());
+
+        samples->items.reserve(n);
+        for(int i=0;i<n;++i){
+            if(std::isnan(bx[i]) || std::isnan(by[i])) continue;
+            const Sample s{PF_Vector(x[i],y[i]),PF_Vector(bx[i],by[i])};
+            samples->maxMagnitude = std::max(samples->maxMagnitude,s.value.magnitude());
+            samples->items.push_back(s);
+        }
+    }
+
+private:
+    PF_VectorGlyphs* glyphs;
+    int job;
+    const PF_PointLocator* locator;
+    const double* vx;
+    const double* vy;
+    std::vector<double> x, y;
+    QSharedPointer<Samples> samples;
+    QSharedPointer<QAtomicInt> canceled;
+};
+
+PF_VectorGlyphs::PF_VectorGlyphs(QCPAxis *keyAxis, QCPAxis *valueAxis)
+    :QCPAbstractPlottable(keyAxis, valueAxis)
+    ,mLocator(nullptr)
+    ,mVx(nullptr)
+    ,mVy(nullptr)
+    ,mSpacing(28.)
+    ,mLengthMode(lmMagnitude)
+    ,mView{QRect(),QCPRange(),QCPRange(),-1.}
+    ,mJob(0)
+{
+    mPen = QPen(Qt::black,0);
+    mBrush = Qt::NoBrush;
+    /** 采样本身用全局线程池并行，这里只需要一个线程协调 **/
+    mPool.setMaxThreadCount(1);
+    connect(this,&PF_VectorGlyphs::resampled,
+            this,&PF_VectorGlyphs::onResampled,Qt::QueuedConnection);
+}
+
+PF_VectorGlyphs::~PF_VectorGlyphs()
+{
+    cancel();
+    mPool.waitForDone();
+}
+
+void PF_VectorGlyphs::setField(const PF_PointLocator *locator, const double *vx, const double *vy)
+{
+    cancel();
+    mPool.waitForDone();
+    mLocator = locator && !locator->isEmpty() && vx && vy ? locator : nullptr;
+    mVx = vx;
+    mVy = vy;
+    mSamples.reset();
+    mView.spacing = -1.;
+
+    double minX, minY, maxX, maxY;
+    if(mLocator && mLocator->bounds(minX,minY,maxX,maxY)){
+        mKeyBounds = QCPRange(minX,maxX);
+        mValueBounds = QCPRange(minY,maxY);
+    }else{
+        mKeyBounds = QCPRange();
+        mValueBounds = QCPRange();
+    }
+}
+
+void PF_VectorGlyphs::setSpacing(double pixels)
+{
+    if(pixels >= 4.) mSpacing = pixels;
+}
+
+void PF_VectorGlyphs::setLengthMode(LengthMode mode)
+{
+    mLengthMode = mode;
+}
+
+double PF_VectorGlyphs::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    Q_UNUSED(details)
+    if((onlySelectable && mSelectable == QCP::stNone) || !mSamples || mSamples->items.empty())
+        return -1;
+    if(!mKeyAxis || !mValueAxis)
+        return -1;
+    if(!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()))
+        return -1;
+
+    const Transform t = transform();
+    const QCPVector2D p(pos);
+    double best = -1;
+    QPointF tail, tip;
+    for(const Sample& s : mSamples->items){
+        if(!shaft(s,mSamples->maxMagnitude,t,tail,tip)) continue;
+        const double d = p.distanceSquaredToLine(QCPVector2D(tail),QCPVector2D(tip));
+        if(best < 0 || d < best) best = d;
+    }
+    if(best < 0) return -1;
+    best = qSqrt(best);
+    if(best > mParentPlot->selectionTolerance()) return -1;
+    if(details)
+        details->setValue(QCPDataSelection(QCPDataRange(0, 1)));
+    return best;
+}
+
+QCPRange PF_VectorGlyphs::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
+{
+    foundRange = mLocator != nullptr;
+    return restrictToSignDomain(mKeyBounds,inSignDomain,foundRange);
+}
+
+QCPRange PF_VectorGlyphs::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+    if(inKeyRange != QCPRange()){
+        if(mKeyBounds.upper < inKeyRange.lower || mKeyBounds.lower > inKeyRange.upper){
+            foundRange = false;
+            return QCPRange();
+        }
+    }
+    foundRange = mLocator != nullptr;
+    return restrictToSignDomain(mValueBounds,inSignDomain,foundRange);
+}
+
+/*!
+ \brief 视图变化时提交重新采样，先用上一次的采样点绘制。
+ 所有箭头的杆和头放在一个路径中，只调用一次drawPath()。
+
+*/
+void PF_VectorGlyphs::draw(QCPPainter *painter)
+{
+    if(!mLocator) return;
+    if(!mKeyAxis || !mValueAxis) return;
+    const View view = currentView();
+    if(!(view == mView)) request(view);
+    if(!mSamples || mSamples->items.empty()) return;
+
+    const Transform t = transform();
+    const QRectF visible = QRectF(clipRect()).adjusted(-mSpacing,-mSpacing,mSpacing,mSpacing);
+    QPainterPath path;
+    QPointF tail, tip;
+    for(const Sample& s : mSamples->items){
+        if(!shaft(s,mSamples->maxMagnitude,t,tail,tip)) continue;
+        if(!visible.contains(tip)) continue;
+        const QPointF d = tip - tail;
+        const double length = std::hypot(d.x(),d.y());
+        const QPointF u = d/length;
+        const QPointF n(-u.y(),u.x());
+        const double head = std::min(0.35*length,8.);
+        const QPointF back = tip - u*head;
+        path.moveTo(tail);
+        path.lineTo(tip);
+        path.moveTo(back + n*(0.4*head));
+        path.lineTo(tip);
+        path.lineTo(back - n*(0.4*head));
+    }
+
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(selected() && mSelectionDecorator ? mSelectionDecorator->pen() : mPen);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawPath(path);
+}
+
+void PF_VectorGlyphs::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
+{
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    const double y = rect.center().y();
+    const double head = std::min(rect.height()*0.4,rect.width()*0.3);
+    painter->drawLine(QLineF(rect.left(),y,rect.right(),y));
+    painter->drawLine(QLineF(rect.right() - head,y - head*0.5,rect.right(),y));
+    painter->drawLine(QLineF(rect.right() - head,y + head*0.5,rect.right(),y));
+}
+
+void PF_VectorGlyphs::onResampled(int job)
+{
+    if(job != mJob || !mPending) return;
+    mSamples = mPending;
+    mPending.reset();
+    if(mParentPlot)
+        mParentPlot->replot(PF_GraphicView::rpQueuedReplot);
+}
+
+PF_VectorGlyphs::View PF_VectorGlyphs::currentView() const
+{
+    return View{clipRect(),mKeyAxis->range(),mValueAxis->range(),mSpacing};
+}
+
+PF_VectorGlyphs::Transform PF_VectorGlyphs::transform() const
+{
+    Transform t;
+    t.linear = mKeyAxis->scaleType() == QCPAxis::stLinear && mValueAxis->scaleType() == QCPAxis::stLinear;
+    t.origin = coordsToPixels(0.,0.);
+    t.unitX = coordsToPixels(1.,0.) - t.origin;
+    t.unitY = coordsToPixels(0.,1.) - t.origin;
+    return t;
+}
+
+/*!
+ \brief 在GUI线程中生成可见范围内的采样点，交给工作线程插值。
+ 坐标轴为线性时采样点取在坐标的整数倍上，否则按像素均匀布置。
+
+*/
+void PF_VectorGlyphs::request(const View &view)
+{
+    cancel();
+    mView = view;
+    if(view.rect.isEmpty()) return;
+
+    std::vector<double> x, y;
+    const Transform t = transform();
+    if(t.linear){
+        const double sx = view.spacing/std::hypot(t.unitX.x(),t.unitX.y());
+        const double sy = view.spacing/std::hypot(t.unitY.x(),t.unitY.y());
+        double k1, v1, k2, v2;
+        pixelsToCoords(QPointF(view.rect.topLeft()),k1,v1);
+        pixelsToCoords(QPointF(view.rect.bottomRight()),k2,v2);
+        const double i0 = std::ceil(std::max(std::min(k1,k2),mKeyBounds.lower)/sx - 0.5);
+        const double i1 = std::floor(std::min(std::max(k1,k2),mKeyBounds.upper)/sx - 0.5);
+        const double j0 = std::ceil(std::max(std::min(v1,v2),mValueBounds.lower)/sy - 0.5);
+        const double j1 = std::floor(std::min(std::max(v1,v2),mValueBounds.upper)/sy - 0.5);
+        if(std::isfinite(sx) && std::isfinite(sy) && i1 >= i0 && j1 >= j0
+                && (i1 - i0 + 1.)*(j1 - j0 + 1.) <= MaxSamples){
+            for(double j=j0;j<=j1;++j){
+                for(double i=i0;i<=i1;++i){
+                    x.push_back((i + 0.5)*sx);
+                    y.push_back((j + 0.5)*sy);
+                }
+            }
+        }
+    }else{
+        for(double py=view.rect.top() + 0.5*view.spacing;py<view.rect.bottom();py+=view.spacing){
+            for(double px=view.rect.left() + 0.5*view.spacing;px<view.rect.right();px+=view.spacing){
+                double k, v;
+                pixelsToCoords(QPointF(px,py),k,v);
+                if(!mKeyBounds.contains(k) || !mValueBounds.contains(v)) continue;
+                x.push_back(k);
+                y.push_back(v);
+            }
+        }
+    }
+
+    mPending = QSharedPointer<Samples>(new Samples);
+    mCanceled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    mPool.start(new Job(this,++mJob,mLocator,mVx,mVy,std::move(x),std::move(y),mPending,mCanceled));
+}
+
+/*!
+ \brief 取消还没有完成的采样，还没有开始的直接从队列中去掉。
+
+*/
+void PF_VectorGlyphs::cancel()
+{
+    mPool.clear();
+    if(mCanceled) mCanceled->store(1);
+    mPending.reset();
+}
+
+bool PF_VectorGlyphs::shaft(const Sample &s, double maxMagnitude, const Transform &t,
+                            QPointF &tail, QPointF &tip) const
+{
+    const double magnitude = s.value.magnitude();
+    if(!(magnitude > 0.)) return false;
+    double length = GlyphLength*mSpacing;
+    if(mLengthMode == lmMagnitude)
+        length *= maxMagnitude > 0. ? std::min(1.,magnitude/maxMagnitude) : 0.;
+    if(length < 1.) return false;
+
+    QPointF c, d;
+    if(t.linear){
+        c = t.origin + t.unitX*s.position.x + t.unitY*s.position.y;
+        d = t.unitX*s.value.x + t.unitY*s.value.y;
+    }else{
+        const double e = 1e-3*mKeyAxis->range().size()/magnitude;
+        c = coordsToPixels(s.position.x,s.position.y);
+        d = coordsToPixels(s.position.x + e*s.value.x,s.position.y + e*s.value.y) - c;
+    }
+    const double pixels = std::hypot(d.x(),d.y());
+    if(!(pixels > 0.)) return false;
+    const QPointF half = d*(0.5*length/pixels);
+    tail = c - half;
+    tip = c + half;
+    return true;
+}
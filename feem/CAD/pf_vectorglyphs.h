@@ -0,0 +1,129 @@
+#ifndef PF_VECTORGLYPHS_H
+#define PF_VECTORGLYPHS_H
+
+#include "pf_plot.h"
+#include "pf_vector.h"
+
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include <vector>
+
+class PF_PointLocator;
+
+/*!
+ \brief 用箭头绘制网格上的向量场，例如B。
+
+ 采样点在屏幕上按固定的像素间距均匀布置（坐标轴为线性时与原点对齐，
+ 平移时不动），用点定位结构插值得到各点的向量。视图变化后在工作线程中
+ 重新采样，完成之前继续显示原来的箭头，不会阻塞GUI线程。
+ 所有箭头放在一个QPainterPath中一次绘制。
+*/
+class PF_VectorGlyphs : public QCPAbstractPlottable
+{
+    Q_OBJECT
+public:
+    /*!
+     \brief 箭头的长度，按向量的大小缩放时最大的箭头等于采样间距的0.8倍。
+    */
+    enum LengthMode{
+        lmUniform,
+        lmMagnitude
+    };
+
+    explicit PF_VectorGlyphs(QCPAxis *keyAxis, QCPAxis *valueAxis);
+    ~PF_VectorGlyphs() override;
+
+    /** 节点上的向量分量，长度为locator的节点数，不复制，显示期间不能释放 **/
+    void setField(const PF_PointLocator* locator, const double* vx, const double* vy);
+    /** 采样点之间的像素距离 **/
+    void setSpacing(double pixels);
+    double spacing() const{
+        return mSpacing;
+    }
+    void setLengthMode(LengthMode mode);
+    LengthMode lengthMode() const{
+        return mLengthMode;
+    }
+    /** 当前显示的箭头数 **/
+    int sampleCount() const{
+        return mSamples ? int(mSamples->items.size()) : 0;
+    }
+
+    /** 继承的虚函数 **/
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const override;
+    QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const override;
+    QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth,
+                           const QCPRange &inKeyRange=QCPRange()) const override;
+
+signals:
+    /** 内部使用，工作线程完成一次采样 **/
+    void resampled(int job);
+
+protected:
+    void draw(QCPPainter *painter) override;
+    void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const override;
+
+private slots:
+    void onResampled(int job);
+
+private:
+    struct Sample{
+        PF_Vector position;
+        PF_Vector value;
+    };
+
+    struct Samples{
+        std::vector<Sample> items;
+        double maxMagnitude;
+    };
+
+    /*!
+     \brief 采样时的视图，变化后重新采样。
+    */
+    struct View{
+        QRect rect;
+        QCPRange keyRange, valueRange;
+        double spacing;
+
+        bool operator==(const View& v) const{
+            return rect == v.rect && keyRange == v.keyRange && valueRange == v.valueRange
+                    && spacing == v.spacing;
+        }
+    };
+
+    /*!
+     \brief 坐标到像素的变换，坐标轴都是线性时为仿射变换。
+    */
+    struct Transform{
+        QPointF origin, unitX, unitY;
+        bool linear;
+    };
+
+    class Job;
+
+    View currentView() const;
+    Transform transform() const;
+    void request(const View& view);
+    void cancel();
+    /** 箭头杆在像素坐标中的两个端点，太短时返回false **/
+    bool shaft(const Sample& s, double maxMagnitude, const Transform& t, QPointF& tail, QPointF& tip) const;
+
+private:
+    const PF_PointLocator* mLocator;
+    const double* mVx;
+    const double* mVy;
+    QCPRange mKeyBounds, mValueBounds;
+    double mSpacing;
+    LengthMode mLengthMode;
+
+    QSharedPointer<const Samples> mSamples;
+    View mView;
+    QThreadPool mPool;
+    int mJob;
+    QSharedPointer<Samples> mPending;
+    QSharedPointer<QAtomicInt> mCanceled;
+};
+
+#endif // PF_VECTORGLYPHS_H
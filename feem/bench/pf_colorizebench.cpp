@@ -0,0 +1,81 @@
+#include "pf_colorize.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+/*!
+ \brief QCPColorGradient::colorize()线性路径的测试，比较标量、SSE2和AVX2实现。
+
+ 数据为3840×2160的双精度数组（4K色图），每次按扫描线调用qcpColorizeLinear()，
+ 颜色表为350级（QCPColorGradient的默认值）。数据中包含超出范围的值和NaN。
+ 每种实现重复20次，输出中位数和最小值（毫秒）以及相对标量实现的加速比，
+ 并检查结果与标量实现完全相同。参数为重复次数。
+
+ 不依赖Qt，可以用qmake构建，也可以直接编译：
+ qmake feem_colorizebench.pro && make
+ g++ -O2 -I CAD bench/pf_colorizebench.cpp CAD/pf_colorize.cpp -o colorizebench
+*/
+int main(int argc, char *argv[])
+{
+    const int width = 3840, height = 2160, levelCount = 350;
+    const int repeats = argc > 1 && std::atoi(argv[1]) > 0 ? std::atoi(argv[1]) : 20;
+
+    std::mt19937 gen(1);
+    std::normal_distribution<double> noise(0., 0.05);
+    std::vector<double> data(size_t(width)*height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            data[size_t(y)*width + x] = std::sin(x*0.003)*std::cos(y*0.004) + noise(gen);
+        }
+    }
+    for (size_t i = 0; i < data.size(); i += 997) {
+        data[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+    std::vector<unsigned int> colors(levelCount);
+    for (int i = 0; i < levelCount; ++i) {
+        colors[size_t(i)] = 0xff000000u | (unsigned(i*255/(levelCount-1)) << 16) | unsigned(255 - i*255/(levelCount-1));
+    }
+    const double lower = -0.9, upper = 0.9;
+    const double posToIndexFactor = (levelCount-1)/(upper - lower);
+
+    const struct { QCPColorizePath path; const char* name; } paths[] = {
+        {cpScalar, "scalar"}, {cpSse2, "sse2"}, {cpAvx2, "avx2"}
+    };
+
+    std::vector<unsigned int> reference(data.size()), image(data.size());
+    double scalarMedian = 0.;
+    std::printf("path\tmedian(ms)\tmin(ms)\tspeedup\n");
+    for (const auto& p : paths) {
+        if (!qcpColorizePathAvailable(p.path)) {
+            std::printf("%s\tunavailable\n", p.name);
+            continue;
+        }
+        std::vector<unsigned int>& out = p.path == cpScalar ? reference : image;
+        std::vector<double> times;
+        for (int r = 0; r < repeats + 1; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            for (int y = 0; y < height; ++y) {
+                qcpColorizeLinear(data.data() + size_t(y)*width, lower, posToIndexFactor, colors.data(),
+                                  levelCount, out.data() + size_t(y)*width, width, p.path);
+            }
+            const auto end = std::chrono::steady_clock::now();
+            /** 第一次用于预热 **/
+            if (r > 0) times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        std::sort(times.begin(), times.end());
+        const double median = times[times.size()/2];
+        if (p.path == cpScalar) scalarMedian = median;
+        if (p.path != cpScalar && out != reference) {
+            std::printf("%s\tresult differs from scalar\n", p.name);
+            return 1;
+        }
+        std::printf("%s\t%.2f\t%.2f\t%.2fx\n", p.name, median, times.front(), scalarMedian/median);
+    }
+    return 0;
+}
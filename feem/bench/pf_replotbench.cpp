@@ -0,0 +1,65 @@
+#include "pf_graphicview.h"
+#include "pf_document.h"
+#include "pf_line.h"
+
+#include <QApplication>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <climits>
+#include <random>
+#include <vector>
+
+/*!
+ \brief 批量绘制的帧时间测试。
+
+ 在1920×1080的离屏PF_GraphicView中绘制n条随机线段，关闭分块渲染，
+ 每帧调用replot()完整重绘，输出replotTime()的中位数和最大值（毫秒）。
+ 参数为线段数，默认为10000、100000和1000000。
+
+ qmake feem_bench.pro && make
+ QT_QPA_PLATFORM=offscreen ../bin/feem_bench 10000 100000 1000000
+*/
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    QTextStream out(stdout);
+
+    QList<int> counts;
+    for (const QString& arg : a.arguments().mid(1)) {
+        if (arg.toInt() > 0) counts.append(arg.toInt());
+    }
+    if (counts.isEmpty()) counts = {10000, 100000, 1000000};
+
+    const int frames = 20;
+    out << "segments\tmedian(ms)\tmax(ms)\n";
+    for (int n : counts) {
+        PF_Document doc;
+        PF_GraphicView view(&doc);
+        view.resize(1920, 1080);
+        view.setTileEntityThreshold(INT_MAX);
+
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<double> pos(0., 1000.);
+        std::uniform_real_distribution<double> len(-5., 5.);
+        for (int i = 0; i < n; ++i) {
+            const PF_Vector p(pos(gen), pos(gen));
+            doc.addEntity(new PF_Line(&doc, &view, p, p + PF_Vector(len(gen), len(gen))));
+        }
+        view.show();
+        a.processEvents();
+        view.zoomAuto(true, true);
+        view.replot();
+
+        std::vector<double> times;
+        for (int f = 0; f < frames; ++f) {
+            view.replot();
+            times.push_back(view.replotTime());
+        }
+        std::sort(times.begin(), times.end());
+        out << n << '\t' << times[times.size()/2] << '\t' << times.back() << '\n';
+        out.flush();
+    }
+    return 0;
+}
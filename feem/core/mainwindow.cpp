@@ -78,6 +78,7 @@ void MainWindow::init()
     setCentralWidget(cad);
     actionHandler->set_view(cad->getGraphicView());
     actionHandler->set_document(doc);
+    actionHandler->set_widget(cad);
 
     /** 需要在设置dock之前初始化 **/
     m_proPlugin = new PF_ProjectExplorerPlugin;
@@ -110,6 +110,18 @@ void PF_ActionFactory::fillActionContainer(QMap<QString, QAction*>& a_map, PF_Ac
     action->setObjectName("DeSelectAll");
     a_map["DeSelectAll"] = action;
 
+    action = new QAction(tr("SelectWindow"), agm->file);
+    action->setIcon(QIcon(":/main/select16x16.png"));
+    connect(action, SIGNAL(triggered()), action_handler, SLOT(slotSelectWindow()));
+    action->setObjectName("SelectWindow");
+    a_map["SelectWindow"] = action;
+
+    action = new QAction(tr("SelectLasso"), agm->file);
+    action->setIcon(QIcon(":/main/select16x16.png"));
+    connect(action, SIGNAL(triggered()), action_handler, SLOT(slotSelectLasso()));
+    action->setObjectName("SelectLasso");
+    a_map["SelectLasso"] = action;
+
     /**画点**/
 	action = new QAction(tr("DrawPoint"), agm->file);
     action->setIcon(QIcon(":/main/dot.png"));
@@ -6,10 +6,16 @@
 #include "pf_actiondrawrectangle.h"
 #include "pf_actionselectall.h"
 #include "pf_actionselectsingle.h"
+#include "pf_actionselectwindow.h"
+#include "pf_cadwidget.h"
 #include "pf_document.h"
 #include "pf_graphicview.h"
 
-PF_ActionHandler::PF_ActionHandler(QObject *parent) : QObject(parent)
+PF_ActionHandler::PF_ActionHandler(QObject *parent)
+    :QObject(parent)
+    ,view(nullptr)
+    ,document(nullptr)
+    ,widget(nullptr)
 {
 
 }
@@ -97,7 +103,7 @@ PF_ActionInterface *PF_ActionHandler::setCurrentAction(PF::ActionType typeId)
 
         break;
     case PF::ActionMeshDoMesh:
-
+        if(widget) widget->generateMesh();
         break;
     case PF::ActionMeshHideMesh:
 
@@ -118,6 +124,12 @@ PF_ActionInterface *PF_ActionHandler::setCurrentAction(PF::ActionType typeId)
     case PF::ActionDeSelectAll:
         a = new PF_ActionSelectAll(document, view, false);
         break;
+    case PF::ActionSelectWindow:
+        a = new PF_ActionSelectWindow(document, view, false);
+        break;
+    case PF::ActionSelectLasso:
+        a = new PF_ActionSelectWindow(document, view, true);
+        break;
     case PF::ActionShowResult:
 
         break;
@@ -165,6 +177,11 @@ void PF_ActionHandler::set_document(PF_Document *_document)
     document = _document;
 }
 
+void PF_ActionHandler::set_widget(PF_CADWidget *_widget)
+{
+    widget = _widget;
+}
+
 void PF_ActionHandler::slotUndo() {
     setCurrentAction(PF::ActionEditUndo);
 }
@@ -202,6 +219,14 @@ void PF_ActionHandler::slotDeSelectAll()
     setCurrentAction(PF::ActionDeSelectAll);
 }
 
+void PF_ActionHandler::slotSelectWindow() {
+    setCurrentAction(PF::ActionSelectWindow);
+}
+
+void PF_ActionHandler::slotSelectLasso() {
+    setCurrentAction(PF::ActionSelectLasso);
+}
+
 void PF_ActionHandler::slotDrawPoint() {
     setCurrentAction(PF::ActionDrawPoint);
 }
@@ -6,6 +6,8 @@
 #include "pf.h"
 #include "pf_actioninterface.h"
 
+class PF_CADWidget;
+
 //2018-01-23
 //by Poofee
 /**这个类实现菜单、工具栏的动作**/
@@ -21,6 +23,7 @@ public:
 
     void set_view(PF_GraphicView * graphicView);
     void set_document(PF_Document * _document);
+    void set_widget(PF_CADWidget * _widget);
 
 signals:
 
@@ -39,6 +42,8 @@ public slots:
     void slotSelectSingle();
     void slotSelectAll();
     void slotDeSelectAll();
+    void slotSelectWindow();
+    void slotSelectLasso();
     void slotDrawPoint();
     void slotDrawLine();
     void slotDrawArc();
@@ -84,6 +89,7 @@ public slots:
 private:
     PF_GraphicView* view;
     PF_Document * document;
+    PF_CADWidget * widget;
 };
 
 #endif // PF_ACTIONHANDLER_H
@@ -61,6 +61,8 @@ void PF_WidgetFactory::createMenus(QMenuBar* menu_bar){
 	QMenu* operation_menu = new QMenu(tr("&Operation"), menu_bar);
 	operation_menu->setObjectName("operation");
 	operation_menu->addAction(a_map["SelectSingle"]);
+	operation_menu->addAction(a_map["SelectWindow"]);
+	operation_menu->addAction(a_map["SelectLasso"]);
 	operation_menu->addAction(a_map["SelectAll"]);
 	operation_menu->addSeparator();
 	operation_menu->addAction(a_map["DrawPoint"]);
@@ -341,6 +343,8 @@ void PF_WidgetFactory::createGroupDrawOperation(RibbonPage *page)
 //        groupDrawOperation->addAction(QIcon(":/main/select16x16.png"), tr("Select"), Qt::ToolButtonTextBesideIcon);
 //        groupDrawOperation->addAction(QIcon(":/main/snapgeometry.png"), tr("Select All"), Qt::ToolButtonTextBesideIcon);
         groupDrawOperation->addAction(a_map["SelectSingle"],Qt::ToolButtonTextBesideIcon);
+        groupDrawOperation->addAction(a_map["SelectWindow"],Qt::ToolButtonTextBesideIcon);
+        groupDrawOperation->addAction(a_map["SelectLasso"],Qt::ToolButtonTextBesideIcon);
         groupDrawOperation->addAction(a_map["SelectAll"],Qt::ToolButtonTextBesideIcon);
         groupDrawOperation->addAction(a_map["DeSelectAll"],Qt::ToolButtonTextBesideIcon);
 //        groupDrawOperation->addAction(QIcon(":/main/solid.png"), tr("Unselect All"), Qt::ToolButtonTextBesideIcon);
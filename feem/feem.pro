@@ -37,8 +37,15 @@ INCLUDEPATH += \
     ./material \
     ./project \
     ./fem \
+    ./fem/mesh \
+    ./fem/solver \
+    ./fem/plugins \
+    ./include/gmsh \
     ./core \
 
+#in-process meshing through the Gmsh SDK
+LIBS += -lgmsh
+
 RESOURCES += \
     ./res/main.qrc
 
@@ -65,11 +72,18 @@ HEADERS += \
     ./CAD/entity/pf_vector.h \
     ./CAD/action/pf_snapper.h \
     ./CAD/entity/pf_entitycontainer.h \
+    ./CAD/entity/pf_entityindex.h \
+    ./CAD/entity/pf_intersectionindex.h \
+    ./CAD/entity/pf_selectionset.h \
+    ./CAD/entity/pf_primitivestore.h \
+    ./CAD/entity/pf_primitiveblock.h \
+    ./CAD/entity/pf_regionindex.h \
     ./CAD/entity/pf_document.h \
     ./CAD/entity/pf_preview.h \
     ./CAD/entity/pf_point.h \
     ./CAD/entity/pf_line.h \
     ./CAD/pf_plot.h \
+    ./CAD/pf_colorize.h \
     project/pf_project.h \
     project/pf_projecttree.h \
     project/pf_node.h \
@@ -83,6 +97,14 @@ HEADERS += \
     util/constants.h \
     ./core/mainwindow.h \
     ./CAD/pf_graphicview.h \
+    ./CAD/pf_renderbatch.h \
+    ./CAD/pf_tilerenderer.h \
+    ./CAD/pf_trianglemap.h \
+    ./CAD/pf_transientplayer.h \
+    ./CAD/pf_streamlines.h \
+    ./CAD/pf_vectorglyphs.h \
+    ./CAD/pf_telemetrymonitor.h \
+    ./CAD/pf_contourlines.h \
     project/viewitem.h \
     project/navigationtreeview.h \
     project/treemodel.h \
@@ -113,6 +135,7 @@ HEADERS += \
     project/pf_nodetreebuilder.h \
     project/pf_sessionmanager.h \
     CAD/action/pf_actionselectsingle.h \
+    CAD/action/pf_actionselectwindow.h \
     project/inavigationwidgetfactory.h \
     core/coreapp.h \
     project/projectexplorerconstants.h \
@@ -120,8 +143,25 @@ HEADERS += \
     material/pf_magmaterialdialog.h \
     fem/solver/magnetodynamics2d.h \
     fem/solver/types.h \
+    fem/solver/pf_telemetrychannel.h \
     CAD/action/pf_actionselectall.h \
-    CAD/action/pf_selection.h
+    CAD/action/pf_selection.h \
+    fem/mesh/pf_gmshmesher.h \
+    fem/mesh/pf_gmshgeowriter.h \
+    fem/mesh/pf_pointhash.h \
+    fem/mesh/pf_pointlocator.h \
+    fem/mesh/pf_contourextractor.h \
+    fem/mesh/pf_cutline.h \
+    fem/mesh/pf_derivedfield.h \
+    fem/mesh/pf_transientresult.h \
+    fem/mesh/pf_streamlinetracer.h \
+    fem/mesh/pf_meshjob.h \
+    fem/mesh/pf_meshscheduler.h \
+    fem/plugins/egdef.h \
+    fem/plugins/egtypes.h \
+    fem/plugins/egutils.h \
+    fem/plugins/egmesh.h \
+    fem/plugins/egnative.h
 
 SOURCES += \
     ./CAD/action/pf_eventhandler.cpp \
@@ -143,11 +183,18 @@ SOURCES += \
     ./CAD/entity/pf_vector.cpp \
     ./CAD/action/pf_snapper.cpp \
     ./CAD/entity/pf_entitycontainer.cpp \
+    ./CAD/entity/pf_entityindex.cpp \
+    ./CAD/entity/pf_intersectionindex.cpp \
+    ./CAD/entity/pf_selectionset.cpp \
+    ./CAD/entity/pf_primitivestore.cpp \
+    ./CAD/entity/pf_primitiveblock.cpp \
+    ./CAD/entity/pf_regionindex.cpp \
     ./CAD/entity/pf_document.cpp \
     ./CAD/entity/pf_preview.cpp \
     ./CAD/entity/pf_point.cpp \
     ./CAD/entity/pf_line.cpp \
     ./CAD/pf_plot.cpp \
+    ./CAD/pf_colorize.cpp \
     project/pf_project.cpp \
     project/pf_projecttree.cpp \
     project/pf_node.cpp \
@@ -161,6 +208,14 @@ SOURCES += \
     ./main.cpp \
     ./core/mainwindow.cpp \
     ./CAD/pf_graphicview.cpp \
+    ./CAD/pf_renderbatch.cpp \
+    ./CAD/pf_tilerenderer.cpp \
+    ./CAD/pf_trianglemap.cpp \
+    ./CAD/pf_transientplayer.cpp \
+    ./CAD/pf_streamlines.cpp \
+    ./CAD/pf_vectorglyphs.cpp \
+    ./CAD/pf_telemetrymonitor.cpp \
+    ./CAD/pf_contourlines.cpp \
     project/viewitem.cpp \
     project/navigationtreeview.cpp \
     project/treemodel.cpp \
@@ -187,14 +242,30 @@ SOURCES += \
     project/pf_nodetreebuilder.cpp \
     project/pf_sessionmanager.cpp \
     CAD/action/pf_actionselectsingle.cpp \
+    CAD/action/pf_actionselectwindow.cpp \
     project/inavigationwidgetfactory.cpp \
     core/coreapp.cpp \
     material/pf_materialtreemodel.cpp \
     material/pf_magmaterialdialog.cpp \
     fem/solver/magnetodynamics2d.cpp \
     fem/solver/types.cpp \
+    fem/solver/pf_telemetrychannel.cpp \
     CAD/action/pf_actionselectall.cpp \
-    CAD/action/pf_selection.cpp
+    CAD/action/pf_selection.cpp \
+    fem/mesh/pf_gmshmesher.cpp \
+    fem/mesh/pf_gmshgeowriter.cpp \
+    fem/mesh/pf_pointhash.cpp \
+    fem/mesh/pf_pointlocator.cpp \
+    fem/mesh/pf_contourextractor.cpp \
+    fem/mesh/pf_cutline.cpp \
+    fem/mesh/pf_derivedfield.cpp \
+    fem/mesh/pf_transientresult.cpp \
+    fem/mesh/pf_streamlinetracer.cpp \
+    fem/mesh/pf_meshjob.cpp \
+    fem/mesh/pf_meshscheduler.cpp \
+    fem/plugins/egutils.cpp \
+    fem/plugins/egmesh.cpp \
+    fem/plugins/egnative.cpp
 
 
 include($$PWD/../qtribbon/ribbonsample/shared/aboutdialog.pri)
@@ -0,0 +1,16 @@
+#-------------------------------------------------
+#
+# Benchmarks, linked against the same sources as feem
+# with bench/ entry points instead of main.cpp:
+#   qmake feem_bench.pro && make
+#   QT_QPA_PLATFORM=offscreen ../bin/feem_bench 10000 100000 1000000
+#
+#-------------------------------------------------
+
+include(feem.pro)
+
+TARGET = feem_bench
+
+SOURCES -= ./main.cpp
+SOURCES += \
+    ./bench/pf_replotbench.cpp
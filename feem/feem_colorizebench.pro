@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Benchmark of the linear colorize path (scalar, SSE2, AVX2)
+# on 4K buffers, only needs CAD/pf_colorize.cpp, no Qt:
+#   qmake feem_colorizebench.pro && make
+#   ../bin/feem_colorizebench 20
+#
+#-------------------------------------------------
+
+QT -= core gui
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+TARGET = feem_colorizebench
+TEMPLATE = app
+DESTDIR = $$PWD/../bin
+
+INCLUDEPATH += ./CAD
+
+HEADERS += \
+    ./CAD/pf_colorize.h
+
+SOURCES += \
+    ./CAD/pf_colorize.cpp \
+    ./bench/pf_colorizebench.cpp
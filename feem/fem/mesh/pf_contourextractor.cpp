@@ -0,0 +1,231 @@
+#include "pf_contourextractor.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+/*!
+ \brief 在工作线程中提取一个等值的等值线。
+
+*/
+class PF_ContourExtractor::LevelJob : public QRunnable
+{
+public:
+    LevelJob(const PF_ContourExtractor* extractor, const double* values, int level, double value,
+             const int* items, int count, std::vector<Contour>* contours, QSemaphore* done)
+        :extractor(extractor),values(values),level(level),value(value)
+        ,items(items),count(count),contours(contours),done(done)
+    {
+    }
+
+    void run() override
+    {
+        extractor->extractLevel(values,level,value,items,count,*contours);
+        if(done) done->release();
+    }
+
+private:
+    const PF_ContourExtractor* extractor;
+    const double* values;
+    int level;
+    double value;
+    const int* items;
+    int count;
+    std::vector<Contour>* contours;
+    QSemaphore* done;
+};
+
+PF_ContourExtractor::PF_ContourExtractor()
+{
+
+}
+
+void PF_ContourExtractor::setMesh(const double *x, const double *y, int nodeCount,
+                                  const int *triangles, int triangleCount)
+{
+    nx.clear();
+    ny.clear();
+    tri.clear();
+    if(!x || !y || !triangles || nodeCount <= 0 || triangleCount <= 0) return;
+
+    nx.assign(x,x + nodeCount);
+    ny.assign(y,y + nodeCount);
+    tri.reserve(3*triangleCount);
+    for(int t=0;t<triangleCount;++t){
+        const int* v = triangles + 3*t;
+        if(v[0] < 0 || v[1] < 0 || v[2] < 0
+                || v[0] >= nodeCount || v[1] >= nodeCount || v[2] >= nodeCount){
+            continue;
+        }
+        tri.insert(tri.end(),v,v + 3);
+    }
+}
+
+/*!
+ \brief 三角形跨过等值L是指 min < L <= max（节点值大于等于L算作在上方），
+ 每个三角形跨过的等值是排序后的等值中连续的一段，用二分查找得到。
+
+*/
+std::vector<PF_ContourExtractor::Contour> PF_ContourExtractor::extract(const double *values, const std::vector<double> &levels) const
+{
+    std::vector<Contour> result;
+    const int levelCount = int(levels.size());
+    if(!values || tri.empty() || levelCount == 0) return result;
+
+    std::vector<int> order(levelCount);
+    for(int i=0;i<levelCount;++i) order[i] = i;
+    std::sort(order.begin(),order.end(),[&](int a, int b){
+        return levels[a] < levels[b];
+    });
+    std::vector<double> sorted(levelCount);
+    for(int i=0;i<levelCount;++i) sorted[i] = levels[order[i]];
+
+    const int count = int(tri.size())/3;
+    std::vector<int> first(count), last(count);
+    std::vector<int> start(levelCount + 1,0);
+    for(int t=0;t<count;++t){
+        const double a = values[tri[3*t]], b = values[tri[3*t + 1]], c = values[tri[3*t + 2]];
+        if(std::isnan(a) || std::isnan(b) || std::isnan(c)){
+            first[t] = last[t] = 0;
+            continue;
+        }
+        const double vmin = std::min(a,std::min(b,c));
+        const double vmax = std::max(a,std::max(b,c));
+        first[t] = int(std::upper_bound(sorted.begin(),sorted.end(),vmin) - sorted.begin());
+        last[t] = int(std::upper_bound(sorted.begin() + first[t],sorted.end(),vmax) - sorted.begin());
+        for(int l=first[t];l<last[t];++l) ++start[l + 1];
+    }
+    for(int l=0;l<levelCount;++l) start[l + 1] += start[l];
+    std::vector<int> items(start.back());
+    std::vector<int> fill(start.begin(),start.end() - 1);
+    for(int t=0;t<count;++t){
+        for(int l=first[t];l<last[t];++l) items[fill[l]++] = t;
+    }
+
+    std::vector<std::vector<Contour> > perLevel(levelCount);
+    QThreadPool* pool = QThreadPool::globalInstance();
+    QSemaphore done;
+    int started = 0;
+    for(int l=1;l<levelCount;++l){
+        if(start[l + 1] == start[l]) continue;
+        pool->start(new LevelJob(this,values,order[l],sorted[l],items.data() + start[l],
+                                 start[l + 1] - start[l],&perLevel[l],&done));
+        ++started;
+    }
+    if(start[1] > 0)
+        extractLevel(values,order[0],sorted[0],items.data(),start[1],perLevel[0]);
+    done.acquire(started);
+
+    /** 按原来的等值序号排列 **/
+    std::vector<int> position(levelCount);
+    for(int i=0;i<levelCount;++i) position[order[i]] = i;
+    for(int i=0;i<levelCount;++i){
+        std::vector<Contour>& c = perLevel[position[i]];
+        result.insert(result.end(),std::make_move_iterator(c.begin()),std::make_move_iterator(c.end()));
+    }
+    return result;
+}
+
+std::vector<double> PF_ContourExtractor::uniformLevels(double lower, double upper, int count)
+{
+    std::vector<double> levels;
+    if(count <= 0) return levels;
+    levels.reserve(count);
+    const double step = (upper - lower)/(count + 1);
+    for(int i=1;i<=count;++i) levels.push_back(lower + step*i);
+    return levels;
+}
+
+/*!
+ \brief 每个跨过等值的三角形给出一条线段，端点在两条被跨过的边上，
+ 以边的两个节点编号作为键。每条内部的边被两条线段共享，边界上的边只有一条，
+ 从边界上的端点出发得到不闭合的折线，剩下的线段组成闭合的折线。
+
+*/
+void PF_ContourExtractor::extractLevel(const double *values, int level, double value,
+                                       const int *items, int count, std::vector<Contour> &contours) const
+{
+    const long long n = static_cast<long long>(nx.size());
+    std::vector<long long> keys(2*count);
+    std::vector<PF_Vector> points(2*count);
+    for(int s=0;s<count;++s){
+        const int* v = tri.data() + 3*items[s];
+        int end = 0;
+        for(int k=0;k<3 && end<2;++k){
+            int a = v[k], b = v[(k + 1)%3];
+            if((values[a] >= value) == (values[b] >= value)) continue;
+            if(a > b) std::swap(a,b);
+            const double t = (value - values[a])/(values[b] - values[a]);
+            keys[2*s + end] = a*n + b;
+            points[2*s + end] = PF_Vector(nx[a] + t*(nx[b] - nx[a]),ny[a] + t*(ny[b] - ny[a]));
+            ++end;
+        }
+    }
+
+    /** 边 -> 共享它的两个线段端点（线段*2+端点），没有为-1 **/
+    std::unordered_map<long long,std::pair<int,int> > edges;
+    edges.reserve(2*count);
+    for(int r=0;r<2*count;++r){
+        auto it = edges.find(keys[r]);
+        if(it == edges.end())
+            edges.emplace(keys[r],std::make_pair(r,-1));
+        else if(it->second.second < 0)
+            it->second.second = r;
+    }
+
+    std::vector<char> used(count,0);
+    auto follow = [&](int r, Contour& c){
+        /** r为当前线段离开的端点 **/
+        while(true){
+            const std::pair<int,int>& shared = edges[keys[r]];
+            const int other = shared.first == r ? shared.second : shared.first;
+            if(other < 0 || used[other/2]) break;
+            used[other/2] = 1;
+            r = other ^ 1;
+            c.points.push_back(points[r]);
+        }
+        return r;
+    };
+    auto append = [&](Contour& c){
+        c.level = level;
+        c.value = value;
+        c.minV = c.maxV = c.points.front();
+        for(const PF_Vector& p : c.points){
+            c.minV = PF_Vector::minimum(c.minV,p);
+            c.maxV = PF_Vector::maximum(c.maxV,p);
+        }
+        contours.push_back(std::move(c));
+    };
+
+    for(int pass=0;pass<2;++pass){
+        for(int s=0;s<count;++s){
+            if(used[s]) continue;
+            int r = 2*s;
+            if(pass == 0){
+                /** 第一遍只从边界上的端点出发 **/
+                if(edges[keys[2*s]].second < 0) r = 2*s;
+                else if(edges[keys[2*s + 1]].second < 0) r = 2*s + 1;
+                else continue;
+            }
+            used[s] = 1;
+            Contour c;
+            c.points.push_back(points[r]);
+            c.points.push_back(points[r ^ 1]);
+            const int last = follow(r ^ 1,c);
+            c.closed = pass == 1 && keys[last] == keys[r];
+            if(pass == 1 && !c.closed){
+                /** 非流形的边使折线在中途断开，从起点反向继续 **/
+                Contour back;
+                follow(r,back);
+                std::reverse(back.points.begin(),back.points.end());
+                back.points.insert(back.points.end(),c.points.begin(),c.points.end());
+                c.points.swap(back.points);
+            }
+            append(c);
+        }
+    }
+}
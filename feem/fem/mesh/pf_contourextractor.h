@@ -0,0 +1,61 @@
+#ifndef PF_CONTOUREXTRACTOR_H
+#define PF_CONTOUREXTRACTOR_H
+
+#include "pf_vector.h"
+
+#include <vector>
+
+/*!
+ \brief 用marching triangles在三角形网格上提取节点场量的等值线，
+ 例如磁矢位A的等值线就是磁力线。
+
+ 先按每个三角形的最小值和最大值把三角形分到它跨过的各个等值上（CSR存储），
+ 每个等值只处理跨过它的三角形，不同的等值在线程池中并行提取。
+ 等值线与边的交点只由边的两个节点决定，相邻三角形得到的交点完全相同，
+ 线段按所在的边用哈希表首尾相连成折线。
+*/
+class PF_ContourExtractor
+{
+public:
+    /*!
+     \brief 一条等值线，闭合时首尾两点相同。
+    */
+    struct Contour{
+        int level;                      /**等值的序号**/
+        double value;
+        bool closed;
+        std::vector<PF_Vector> points;
+        PF_Vector minV;
+        PF_Vector maxV;
+    };
+
+    PF_ContourExtractor();
+    ~PF_ContourExtractor()=default;
+
+    /** 节点坐标和三角形的三个节点编号（从0开始），数据会被复制 **/
+    void setMesh(const double* x, const double* y, int nodeCount,
+                 const int* triangles, int triangleCount);
+    int nodeCount() const{
+        return int(nx.size());
+    }
+    int triangleCount() const{
+        return int(tri.size())/3;
+    }
+
+    /** 提取values在每个等值上的等值线，结果按等值的序号排列 **/
+    std::vector<Contour> extract(const double* values, const std::vector<double>& levels) const;
+
+    /** 在[lower,upper]内均匀分布的count个等值，不包括两个端点 **/
+    static std::vector<double> uniformLevels(double lower, double upper, int count);
+
+private:
+    class LevelJob;
+    void extractLevel(const double* values, int level, double value,
+                      const int* items, int count, std::vector<Contour>& contours) const;
+
+private:
+    std::vector<double> nx, ny;
+    std::vector<int> tri;
+};
+
+#endif // PF_CONTOUREXTRACTOR_H
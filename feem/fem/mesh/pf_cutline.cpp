@@ -0,0 +1,343 @@
+#include "pf_cutline.h"
+#include "pf_entitycontainer.h"
+#include "pf_plot.h"
+#include "pf_pointlocator.h"
+#include "pf_primitiveblock.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/** 真空磁导率 **/
+const double Mu0 = 4e-7*M_PI;
+/** 圆弧积分和采样的最大角度 **/
+const double ArcStep = M_PI/90.;
+/** 并行计算时一段圆弧的最大角度 **/
+const double ArcPiece = M_PI/4.;
+/** 三点Gauss积分的节点和权重，区间[-1,1] **/
+const double GaussPoint[3] = {-0.7745966692414834, 0., 0.7745966692414834};
+const double GaussWeight[3] = {5./9., 8./9., 5./9.};
+
+}
+
+/*!
+ \brief 在工作线程中计算路径的一段，结果的弧长从这一段的起点开始。
+
+*/
+class PF_CutLine::PieceJob : public QRunnable
+{
+public:
+    PieceJob(const PF_CutLine* cut, const Piece* piece, const PF_PointLocator* locator,
+             const double* potential, Result* result, QSemaphore* done)
+        :cut(cut),piece(piece),locator(locator),potential(potential),result(result),done(done)
+    {
+    }
+
+    void run() override
+    {
+        cut->evaluatePiece(*piece,*locator,potential,*result);
+        done->release();
+    }
+
+private:
+    const PF_CutLine* cut;
+    const Piece* piece;
+    const PF_PointLocator* locator;
+    const double* potential;
+    Result* result;
+    QSemaphore* done;
+};
+
+PF_Vector PF_CutLine::Piece::pointAt(double s) const
+{
+    if(!arc) return p1 + (p2 - p1)*(s/length);
+    const double a = angle + (span < 0. ? -s : s)/radius;
+    return center + PF_Vector(a)*radius;
+}
+
+PF_Vector PF_CutLine::Piece::tangentAt(double s) const
+{
+    if(!arc) return (p2 - p1)*(1./length);
+    const double a = angle + (span < 0. ? -s : s)/radius;
+    return span < 0. ? PF_Vector(a - M_PI_2) : PF_Vector(a + M_PI_2);
+}
+
+PF_CutLine::PF_CutLine()
+    :mu(Mu0)
+    ,torqueCenter(0.,0.)
+{
+
+}
+
+void PF_CutLine::addLine(const PF_Vector &p1, const PF_Vector &p2)
+{
+    const double length = p1.distanceTo(p2);
+    if(length < PF_TOLERANCE) return;
+    Piece p;
+    p.arc = false;
+    p.p1 = p1;
+    p.p2 = p2;
+    p.radius = p.angle = p.span = 0.;
+    p.length = length;
+    pieces.push_back(p);
+}
+
+/*!
+ \brief 较长的圆弧被分成不超过45°的几段，以便整圆也能并行计算。
+
+*/
+void PF_CutLine::addArc(const PF_Vector &center, double radius, double angle, double span)
+{
+    if(radius < PF_TOLERANCE || std::abs(span) < PF_TOLERANCE_ANGLE) return;
+    span = std::max(-2.*M_PI,std::min(2.*M_PI,span));
+    const int count = int(std::ceil(std::abs(span)/ArcPiece - PF_TOLERANCE));
+    for(int i=0;i<count;++i){
+        Piece p;
+        p.arc = true;
+        p.center = center;
+        p.radius = radius;
+        p.angle = angle + span*i/count;
+        p.span = span/count;
+        p.length = radius*std::abs(p.span);
+        p.p1 = p.pointAt(0.);
+        p.p2 = p.pointAt(p.length);
+        pieces.push_back(p);
+    }
+}
+
+void PF_CutLine::addEntity(PF_Entity *e)
+{
+    if(!e) return;
+    if(e->isContainer()){
+        for(auto child : static_cast<PF_EntityContainer*>(e)->getEntityList()){
+            addEntity(child);
+        }
+        return;
+    }
+
+    switch(e->rtti()){
+    case PF::EntityLine:
+        addLine(e->getStartpoint(),e->getEndpoint());
+        break;
+    case PF::EntityCircle:
+        addArc(e->getCenter(),e->getRadius(),0.,2.*M_PI);
+        break;
+    case PF::EntityPrimitives:{
+        const PF_PrimitiveStore& store = static_cast<PF_PrimitiveBlock*>(e)->getStore();
+        const quint32 skip = PF_PrimitiveStore::FlagDeleted | PF_PrimitiveStore::FlagHidden;
+        for(const auto& l : store.lineArray()){
+            if(!(l.flags & skip)) addLine(PF_Vector(l.x1,l.y1),PF_Vector(l.x2,l.y2));
+        }
+        for(const auto& a : store.arcArray()){
+            if(a.flags & skip) continue;
+            double span = std::fmod(a.a2 - a.a1,2.*M_PI);
+            if(span < 0.) span += 2.*M_PI;
+            addArc(PF_Vector(a.cx,a.cy),a.r,a.a1,span);
+        }
+        for(const auto& c : store.circleArray()){
+            if(!(c.flags & skip)) addArc(PF_Vector(c.cx,c.cy),c.r,0.,2.*M_PI);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void PF_CutLine::clear()
+{
+    pieces.clear();
+}
+
+double PF_CutLine::length() const
+{
+    double length = 0.;
+    for(const Piece& p : pieces) length += p.length;
+    return length;
+}
+
+void PF_CutLine::setPermeability(double mu)
+{
+    if(mu > 0.) this->mu = mu;
+}
+
+void PF_CutLine::setTorqueCenter(const PF_Vector &center)
+{
+    torqueCenter = center;
+}
+
+/*!
+ \brief 各段在线程池中并行计算，再按顺序拼接，采样点的弧长加上前面各段的长度。
+
+*/
+PF_CutLine::Result PF_CutLine::evaluate(const PF_PointLocator &locator, const double *potential) const
+{
+    Result result;
+    result.length = result.outside = result.flux = result.tangential = result.torque = 0.;
+    result.force = PF_Vector(0.,0.);
+    if(pieces.empty() || locator.isEmpty() || !potential) return result;
+
+    const int count = int(pieces.size());
+    std::vector<Result> parts(count);
+    QThreadPool* pool = QThreadPool::globalInstance();
+    QSemaphore done;
+    for(int i=1;i<count;++i){
+        pool->start(new PieceJob(this,&pieces[i],&locator,potential,&parts[i],&done));
+    }
+    evaluatePiece(pieces[0],locator,potential,parts[0]);
+    done.acquire(count - 1);
+
+    for(int i=0;i<count;++i){
+        const Result& part = parts[i];
+        for(Sample sample : part.samples){
+            sample.s += result.length;
+            result.samples.push_back(sample);
+        }
+        result.length += pieces[i].length;
+        result.outside += part.outside;
+        result.flux += part.flux;
+        result.tangential += part.tangential;
+        result.force += part.force;
+        result.torque += part.torque;
+    }
+    return result;
+}
+
+void PF_CutLine::plot(const Result &result, Quantity quantity, QCPGraph *graph)
+{
+    if(!graph) return;
+    const int n = int(result.samples.size());
+    QVector<double> keys(n), values(n);
+    for(int i=0;i<n;++i){
+        const Sample& s = result.samples[i];
+        keys[i] = s.s;
+        switch(quantity){
+        case BMagnitude: values[i] = s.b; break;
+        case BNormal: values[i] = s.bn; break;
+        case BTangential: values[i] = s.bt; break;
+        case StressNormal: values[i] = s.tn; break;
+        case StressTangential: values[i] = s.tt; break;
+        }
+    }
+    graph->setData(keys,values,true);
+}
+
+/*!
+ \brief 沿一段路径找出它经过的单元。从当前位置稍微向前一点确定所在的单元，
+ 然后按倍增的步长前进直到离开该单元，再二分到容差以内。
+ 直线与三角形的交是一个区间，所以倍增不会跳过单元；圆弧的步长不超过2°，
+ 网格外的部分步长不超过路径长度的1/64，避免跳过重新进入网格的部分。
+
+*/
+void PF_CutLine::evaluatePiece(const Piece &piece, const PF_PointLocator &locator,
+                               const double *potential, Result &result) const
+{
+    result.length = piece.length;
+    result.outside = result.flux = result.tangential = result.torque = 0.;
+    result.force = PF_Vector(0.,0.);
+
+    const double L = piece.length;
+    const double tol = std::max(L*1e-9,PF_TOLERANCE);
+    const double inStep = piece.arc ? std::min(L,piece.radius*ArcStep) : L;
+    const double outStep = piece.arc ? inStep : L/64.;
+
+    int hint = -1;
+    double s = 0.;
+    while(s < L - tol){
+        const double probe = s + std::min(4.*tol,0.5*(L - s));
+        PF_Vector p = piece.pointAt(probe);
+        const int e = locator.locate(p.x,p.y,&hint);
+
+        auto same = [&](double t){
+            const PF_Vector q = piece.pointAt(t);
+            if(e >= 0) return locator.contains(e,q.x,q.y);
+            int h = hint;
+            return locator.locate(q.x,q.y,&h) < 0;
+        };
+
+        const double maxStep = e >= 0 ? inStep : outStep;
+        double lo = probe, hi = L;
+        double step = e >= 0 && !piece.arc ? L : maxStep;
+        while(lo < L){
+            hi = std::min(lo + step,L);
+            if(!same(hi)) break;
+            lo = hi;
+            step = std::min(2.*step,e >= 0 && !piece.arc ? L : maxStep);
+        }
+        double end = L;
+        if(lo < L){
+            while(hi - lo > tol){
+                const double mid = 0.5*(lo + hi);
+                if(same(mid)) lo = mid;
+                else hi = mid;
+            }
+            end = 0.5*(lo + hi);
+        }
+
+        if(e < 0){
+            result.outside += end - s;
+            Sample sample;
+            sample.s = 0.5*(s + end);
+            sample.point = piece.pointAt(sample.s);
+            sample.element = -1;
+            sample.bn = sample.bt = sample.b = sample.tn = sample.tt = std::numeric_limits<double>::quiet_NaN();
+            result.samples.push_back(sample);
+        }else{
+            double gx = 0., gy = 0.;
+            locator.gradient(potential,e,gx,gy);
+            integrate(piece,s,end,e,gy,-gx,result);
+        }
+        s = end;
+    }
+}
+
+/*!
+ \brief 在单元内的一段[a,b]上积分，B为常数，圆弧按2°细分，每一小段一个采样点。
+ Maxwell应力 T = (Bn B - |B|²n/2)/μ = Tn n + Tt t。
+
+*/
+void PF_CutLine::integrate(const Piece &piece, double a, double b, int element,
+                           double bx, double by, Result &result) const
+{
+    const int count = piece.arc ? std::max(1,int(std::ceil((b - a)/(piece.radius*ArcStep)))) : 1;
+    const PF_Vector field(bx,by);
+    const double h = (b - a)/count;
+    for(int k=0;k<count;++k){
+        const double s0 = a + k*h;
+        for(int g=0;g<3;++g){
+            const double s = s0 + 0.5*h*(1. + GaussPoint[g]);
+            const double w = 0.5*h*GaussWeight[g];
+            const PF_Vector t = piece.tangentAt(s);
+            const PF_Vector n(t.y,-t.x);
+            const double bn = field.dotP(n);
+            const double bt = field.dotP(t);
+            const double tn = (bn*bn - bt*bt)/(2.*mu);
+            const double tt = bn*bt/mu;
+            const PF_Vector traction = n*tn + t*tt;
+            const PF_Vector r = piece.pointAt(s) - torqueCenter;
+            result.flux += w*bn;
+            result.tangential += w*bt;
+            result.force += traction*w;
+            result.torque += w*(r.x*traction.y - r.y*traction.x);
+        }
+
+        Sample sample;
+        sample.s = s0 + 0.5*h;
+        sample.point = piece.pointAt(sample.s);
+        sample.element = element;
+        const PF_Vector t = piece.tangentAt(sample.s);
+        const PF_Vector n(t.y,-t.x);
+        sample.bn = field.dotP(n);
+        sample.bt = field.dotP(t);
+        sample.b = field.magnitude();
+        sample.tn = (sample.bn*sample.bn - sample.bt*sample.bt)/(2.*mu);
+        sample.tt = sample.bn*sample.bt/mu;
+        result.samples.push_back(sample);
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef PF_CUTLINE_H
+#define PF_CUTLINE_H
+
+#include "pf_vector.h"
+
+#include <vector>
+
+class PF_Entity;
+class PF_PointLocator;
+class QCPGraph;
+
+/*!
+ \brief 沿CAD中的直线、多段线和圆（弧）对二维静磁场的解进行采样和积分。
+
+ 路径被单元边界分成若干段，每段用点定位结构找到所在的单元，
+ 先按倍增的步长前进，再二分找到离开单元的位置，因此分段的位置与网格一致，
+ 与网格的疏密无关。线性单元内B = curl A为常数，每段用三点Gauss积分
+ 计算法向、切向磁感应强度和Maxwell应力的积分，圆弧按2°再细分。
+ 路径的各段互相独立，在线程池中并行计算。
+*/
+class PF_CutLine
+{
+public:
+    /*!
+     \brief 可以绘制的量，法向为切向顺时针转90°，对逆时针的圆为外法向。
+    */
+    enum Quantity{
+        BMagnitude,         /**|B|**/
+        BNormal,            /**Bn**/
+        BTangential,        /**Bt**/
+        StressNormal,       /**(Bn²-Bt²)/(2μ)**/
+        StressTangential    /**BnBt/μ**/
+    };
+
+    /*!
+     \brief 一个采样点，s为从路径起点开始的弧长。在网格外的点各个量为NaN。
+    */
+    struct Sample{
+        double s;
+        PF_Vector point;
+        int element;
+        double bn, bt, b;
+        double tn, tt;
+    };
+
+    /*!
+     \brief 采样和积分的结果，积分都是单位深度的值。
+    */
+    struct Result{
+        std::vector<Sample> samples;
+        double length;      /**路径总长**/
+        double outside;     /**路径在网格外的长度**/
+        double flux;        /**∫Bn ds**/
+        double tangential;  /**∫Bt ds，等于μ0乘以路径上的磁压降（空气中）**/
+        PF_Vector force;    /**Maxwell应力的合力∫T ds**/
+        double torque;      /**对转矩中心的转矩**/
+    };
+
+    PF_CutLine();
+    ~PF_CutLine()=default;
+
+    void addLine(const PF_Vector& p1, const PF_Vector& p2);
+    /** 从angle开始转过span（弧度），span为负时顺时针 **/
+    void addArc(const PF_Vector& center, double radius, double angle, double span);
+    /** 直线、圆、多段线等容器（按子实体的顺序）以及紧凑存储的图元 **/
+    void addEntity(PF_Entity* e);
+    void clear();
+
+    double length() const;
+    bool isEmpty() const{
+        return pieces.empty();
+    }
+
+    /** 计算Maxwell应力使用的磁导率，默认为真空磁导率 **/
+    void setPermeability(double mu);
+    void setTorqueCenter(const PF_Vector& center);
+
+    /** potential为节点上的磁矢位Az，与locator使用同一个网格 **/
+    Result evaluate(const PF_PointLocator& locator, const double* potential) const;
+
+    /** 把某个量沿弧长的分布写入图形，替换图形原来的数据 **/
+    static void plot(const Result& result, Quantity quantity, QCPGraph* graph);
+
+private:
+    /*!
+     \brief 路径的一段，参数为从这一段的起点开始的弧长。
+    */
+    struct Piece{
+        bool arc;
+        PF_Vector p1, p2;
+        PF_Vector center;
+        double radius, angle, span;
+        double length;
+
+        PF_Vector pointAt(double s) const;
+        PF_Vector tangentAt(double s) const;
+    };
+
+    class PieceJob;
+    void evaluatePiece(const Piece& piece, const PF_PointLocator& locator,
+                       const double* potential, Result& result) const;
+    void integrate(const Piece& piece, double a, double b, int element,
+                   double bx, double by, Result& result) const;
+
+private:
+    std::vector<Piece> pieces;
+    double mu;
+    PF_Vector torqueCenter;
+};
+
+#endif // PF_CUTLINE_H
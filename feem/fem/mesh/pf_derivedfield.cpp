@@ -0,0 +1,352 @@
+#include "pf_derivedfield.h"
+#include "pf.h"
+
+#include <QDebug>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+/** 真空磁导率 **/
+const double Mu0 = 4e-7*M_PI;
+/** 并行计算时每一块的单元数 **/
+const int BlockSize = 16384;
+
+/*!
+ \brief 映射文件的文件头，数组从HeaderSize字节处开始。
+
+*/
+struct FileHeader{
+    char magic[8];
+    quint32 version;
+    quint32 fields;
+    qint64 elements;
+    quint64 key;        /**网格的散列值，不同时重新建立文件**/
+    quint64 material;   /**磁导率的散列值，不同时只是结果无效**/
+    quint64 revision;
+    quint32 valid;
+    quint32 reserved;
+};
+const qint64 HeaderSize = 64;
+const char Magic[8] = {'F','E','E','M','D','R','V','1'};
+const quint32 Version = 2;
+
+/** FNV-1a，用于判断文件中的结果是否属于同一个网格和材料 **/
+quint64 hashBytes(const void* bytes, size_t size, quint64 h)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(bytes);
+    for(size_t i=0;i<size;++i){
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+const quint64 HashBasis = 14695981039346656037ULL;
+
+quint64 meshKey(const std::vector<double>& x, const std::vector<double>& y,
+                const std::vector<int>& tri)
+{
+    quint64 h = HashBasis;
+    h = hashBytes(x.data(),x.size()*sizeof(double),h);
+    h = hashBytes(y.data(),y.size()*sizeof(double),h);
+    return hashBytes(tri.data(),tri.size()*sizeof(int),h);
+}
+
+quint64 materialKey(const std::vector<double>& mu)
+{
+    return hashBytes(mu.data(),mu.size()*sizeof(double),HashBasis);
+}
+
+}
+
+/*!
+ \brief 在工作线程中计算一块连续的单元。
+
+*/
+class PF_DerivedField::BlockJob : public QRunnable
+{
+public:
+    BlockJob(PF_DerivedField* cache, const double* potential, int begin, int end, QSemaphore* done)
+        :cache(cache),potential(potential),begin(begin),end(end),done(done)
+    {
+    }
+
+    void run() override
+    {
+        cache->computeBlock(potential,begin,end);
+        done->release();
+    }
+
+private:
+    PF_DerivedField* cache;
+    const double* potential;
+    int begin, end;
+    QSemaphore* done;
+};
+
+PF_DerivedField::PF_DerivedField()
+    :mapped(nullptr)
+    ,data(nullptr)
+    ,valid(false)
+    ,cachedRevision(0)
+    ,muKey(materialKey(std::vector<double>()))
+{
+
+}
+
+PF_DerivedField::~PF_DerivedField()
+{
+    release();
+}
+
+void PF_DerivedField::setMesh(const double *x, const double *y, int nodeCount,
+                              const int *triangles, int triangleCount)
+{
+    release();
+    valid = false;
+    nx.clear();
+    ny.clear();
+    tri.clear();
+    mu.clear();
+    muKey = materialKey(mu);
+    if(!x || !y || !triangles || nodeCount <= 0 || triangleCount <= 0) return;
+
+    nx.assign(x,x + nodeCount);
+    ny.assign(y,y + nodeCount);
+    tri.reserve(3*triangleCount);
+    for(int t=0;t<triangleCount;++t){
+        const int* v = triangles + 3*t;
+        if(v[0] < 0 || v[1] < 0 || v[2] < 0
+                || v[0] >= nodeCount || v[1] >= nodeCount || v[2] >= nodeCount){
+            /** 无效的单元保留位置，使数组与求解器的单元编号一致 **/
+            tri.insert(tri.end(),{0,0,0});
+            continue;
+        }
+        tri.insert(tri.end(),v,v + 3);
+    }
+    if(!file.fileName().isEmpty())
+        allocate();
+}
+
+/*!
+ \brief 磁导率变化时结果无效。使用文件时，文件中的结果如果是用相同的磁导率
+ 计算的，仍然可以使用，因此打开文件后再设置磁导率不会丢弃文件中的结果。
+
+*/
+void PF_DerivedField::setPermeability(const double *mu)
+{
+    if(mu)
+        this->mu.assign(mu,mu + elementCount());
+    else
+        this->mu.clear();
+    const quint64 key = materialKey(this->mu);
+    if(mapped){
+        const FileHeader* header = reinterpret_cast<const FileHeader*>(mapped);
+        valid = header->valid != 0 && header->material == key;
+        cachedRevision = header->revision;
+    }else if(key != muKey){
+        valid = false;
+    }
+    muKey = key;
+}
+
+bool PF_DerivedField::setBackingFile(const QString &path)
+{
+    release();
+    valid = false;
+    file.setFileName(path);
+    if(path.isEmpty() || tri.empty()) return true;
+    return allocate();
+}
+
+bool PF_DerivedField::update(const double *potential, quint64 revision)
+{
+    if(!potential || tri.empty()) return false;
+    if(valid && revision == cachedRevision) return false;
+    if(!data && !allocate()) return false;
+
+    /** 计算过程中文件中的结果不完整 **/
+    FileHeader* header = reinterpret_cast<FileHeader*>(mapped);
+    if(header)
+        header->valid = 0;
+    const int count = elementCount();
+    const int blocks = (count + BlockSize - 1)/BlockSize;
+    QThreadPool* pool = QThreadPool::globalInstance();
+    QSemaphore done;
+    for(int i=1;i<blocks;++i){
+        pool->start(new BlockJob(this,potential,i*BlockSize,std::min(count,(i + 1)*BlockSize),&done));
+    }
+    computeBlock(potential,0,std::min(count,BlockSize));
+    done.acquire(blocks - 1);
+
+    valid = true;
+    cachedRevision = revision;
+    if(header){
+        header->material = muKey;
+        header->revision = revision;
+        header->valid = 1;
+    }
+    return true;
+}
+
+void PF_DerivedField::invalidate()
+{
+    valid = false;
+    if(mapped)
+        reinterpret_cast<FileHeader*>(mapped)->valid = 0;
+}
+
+const double *PF_DerivedField::field(Field f) const
+{
+    if(!valid || !data || f < 0 || f >= FieldCount) return nullptr;
+    return data + qint64(f)*elementCount();
+}
+
+double PF_DerivedField::totalEnergy() const
+{
+    const double* w = field(EnergyDensity);
+    const double* area = field(Area);
+    if(!w || !area) return 0.;
+    double sum = 0.;
+    for(int e=0;e<elementCount();++e) sum += w[e]*area[e];
+    return sum;
+}
+
+void PF_DerivedField::toNodes(Field f, double *out) const
+{
+    if(!out) return;
+    const int n = int(nx.size());
+    const double* values = field(f);
+    const double* area = field(Area);
+    if(!values || !area){
+        std::fill(out,out + n,0.);
+        return;
+    }
+    std::vector<double> weight(n,0.);
+    std::fill(out,out + n,0.);
+    for(int e=0;e<elementCount();++e){
+        for(int k=0;k<3;++k){
+            const int v = tri[3*e + k];
+            out[v] += values[e]*area[e];
+            weight[v] += area[e];
+        }
+    }
+    for(int i=0;i<n;++i){
+        if(weight[i] > 0.) out[i] /= weight[i];
+    }
+}
+
+/*!
+ \brief 为数组分配空间。使用文件时，文件头中的单元数和网格散列值一致则直接映射，
+ 其中的结果在磁导率和版本号都相同时可以直接使用；否则重新建立文件。
+
+*/
+bool PF_DerivedField::allocate()
+{
+    release();
+    const qint64 count = elementCount();
+    const qint64 bytes = qint64(FieldCount)*count*qint64(sizeof(double));
+    if(file.fileName().isEmpty()){
+        heap.assign(size_t(FieldCount)*size_t(count),0.);
+        data = heap.data();
+        return true;
+    }
+
+    const quint64 key = meshKey(nx,ny,tri);
+    if(!file.open(QIODevice::ReadWrite)){
+        qDebug()<<Q_FUNC_INFO<<"cannot open"<<file.fileName()<<file.errorString();
+        return false;
+    }
+    bool reuse = false;
+    if(file.size() == HeaderSize + bytes){
+        FileHeader header;
+        if(file.read(reinterpret_cast<char*>(&header),sizeof(header)) == qint64(sizeof(header))){
+            reuse = std::memcmp(header.magic,Magic,sizeof(Magic)) == 0 && header.version == Version
+                    && header.fields == quint32(FieldCount) && header.elements == count && header.key == key;
+        }
+    }
+    if(!reuse && !file.resize(HeaderSize + bytes)){
+        qDebug()<<Q_FUNC_INFO<<"cannot resize"<<file.fileName()<<file.errorString();
+        file.close();
+        return false;
+    }
+    mapped = file.map(0,HeaderSize + bytes);
+    file.close();
+    if(!mapped){
+        qDebug()<<Q_FUNC_INFO<<"cannot map"<<file.fileName();
+        return false;
+    }
+
+    FileHeader* header = reinterpret_cast<FileHeader*>(mapped);
+    if(reuse){
+        valid = header->valid != 0 && header->material == muKey;
+        cachedRevision = header->revision;
+    }else{
+        std::memset(header,0,HeaderSize);
+        std::memcpy(header->magic,Magic,sizeof(Magic));
+        header->version = Version;
+        header->fields = FieldCount;
+        header->elements = count;
+        header->key = key;
+        valid = false;
+    }
+    data = reinterpret_cast<double*>(mapped + HeaderSize);
+    return true;
+}
+
+void PF_DerivedField::release()
+{
+    if(mapped){
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    heap.clear();
+    heap.shrink_to_fit();
+    data = nullptr;
+}
+
+/*!
+ \brief 线性单元上 grad A 为常数，B = (dA/dy, -dA/dx)，H = B/μ。
+
+*/
+void PF_DerivedField::computeBlock(const double *potential, int begin, int end)
+{
+    const qint64 count = elementCount();
+    double* bx = data + Bx*count;
+    double* by = data + By*count;
+    double* hx = data + Hx*count;
+    double* hy = data + Hy*count;
+    double* b = data + BMagnitude*count;
+    double* w = data + EnergyDensity*count;
+    double* area = data + Area*count;
+    for(int e=begin;e<end;++e){
+        const int* v = tri.data() + 3*e;
+        const double xa = nx[v[0]], ya = ny[v[0]];
+        const double x1 = nx[v[1]] - xa, y1 = ny[v[1]] - ya;
+        const double x2 = nx[v[2]] - xa, y2 = ny[v[2]] - ya;
+        const double det = x1*y2 - x2*y1;
+        if(det == 0.){
+            bx[e] = by[e] = hx[e] = hy[e] = b[e] = w[e] = area[e] = 0.;
+            continue;
+        }
+        const double d1 = potential[v[1]] - potential[v[0]];
+        const double d2 = potential[v[2]] - potential[v[0]];
+        const double gx = (d1*y2 - d2*y1)/det;
+        const double gy = (x1*d2 - x2*d1)/det;
+        const double m = mu.empty() ? Mu0 : mu[e];
+        bx[e] = gy;
+        by[e] = -gx;
+        hx[e] = gy/m;
+        hy[e] = -gx/m;
+        const double b2 = gx*gx + gy*gy;
+        b[e] = std::sqrt(b2);
+        w[e] = b2/(2.*m);
+        area[e] = 0.5*std::abs(det);
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef PF_DERIVEDFIELD_H
+#define PF_DERIVEDFIELD_H
+
+#include <QFile>
+#include <QString>
+
+#include <vector>
+
+/*!
+ \brief 由节点上的磁矢位计算的单元量（B、H、|B|、能量密度）的缓存。
+
+ 线性三角形单元内B = curl A为常数，每个解只需要计算一次，所有单元在线程池中
+ 分块并行计算。结果按量分别存放在连续的数组中（SoA），云图、探针、力的积分
+ 和导出都直接读取这些数组。只有解的版本号、网格或磁导率变化时才重新计算。
+
+ 瞬态计算的结果很大时可以指定一个文件，数组放在映射到内存的文件中，
+ 由操作系统换入换出；文件头记录了单元数、网格和磁导率的散列值以及解的版本号，
+ 再次打开同一个解的文件时不需要重新计算。
+*/
+class PF_DerivedField
+{
+public:
+    enum Field{
+        Bx,
+        By,
+        Hx,
+        Hy,
+        BMagnitude,
+        EnergyDensity,  /**B²/(2μ)，线性材料**/
+        Area,           /**单元面积，用于积分和平均到节点**/
+        FieldCount
+    };
+
+    PF_DerivedField();
+    ~PF_DerivedField();
+
+    /** 节点坐标和三角形的三个节点编号（从0开始），数据会被复制 **/
+    void setMesh(const double* x, const double* y, int nodeCount,
+                 const int* triangles, int triangleCount);
+    /** 每个单元的磁导率（绝对值），为空时全部为真空磁导率 **/
+    void setPermeability(const double* mu);
+    /** 使用映射到内存的文件存放数组，为空时使用内存 **/
+    bool setBackingFile(const QString& path);
+    QString backingFile() const{
+        return file.fileName();
+    }
+
+    /*!
+     \brief 按节点上的磁矢位计算所有单元的量。版本号与缓存的相同时直接返回false，
+     否则重新计算并返回true。
+    */
+    bool update(const double* potential, quint64 revision);
+    void invalidate();
+
+    bool isValid() const{
+        return valid;
+    }
+    quint64 revision() const{
+        return cachedRevision;
+    }
+    int elementCount() const{
+        return int(tri.size())/3;
+    }
+
+    /** 某个量的数组，长度为单元数，缓存无效时为空 **/
+    const double* field(Field f) const;
+    double totalEnergy() const;
+    /** 按面积加权平均到节点，out的长度为节点数，用于绘制光滑的云图 **/
+    void toNodes(Field f, double* out) const;
+
+private:
+    class BlockJob;
+    bool allocate();
+    void release();
+    void computeBlock(const double* potential, int begin, int end);
+
+private:
+    std::vector<double> nx, ny;
+    std::vector<int> tri;
+    std::vector<double> mu;
+
+    std::vector<double> heap;
+    QFile file;
+    uchar* mapped;
+    double* data;
+
+    bool valid;
+    quint64 cachedRevision;
+    quint64 muKey;      /**当前磁导率的散列值**/
+};
+
+#endif // PF_DERIVEDFIELD_H
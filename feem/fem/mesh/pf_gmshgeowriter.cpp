@@ -0,0 +1,191 @@
+#include "pf_gmshgeowriter.h"
+
+#include "pf_document.h"
+#include "pf_entitycontainer.h"
+
+#include <QFile>
+#include <QObject>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+PF_GmshGeoWriter::PF_GmshGeoWriter(PF_Document *doc)
+    :document(doc)
+    ,meshSize(0.)
+{
+
+}
+
+/*!
+ \brief 将文档写入filename。
+
+ \param filename .geo文件名
+ \return 成功返回true，失败时可由errorString()获得原因
+*/
+bool PF_GmshGeoWriter::write(const QString &filename)
+{
+    error.clear();
+    points.clear();
+    curves.clear();
+    edgeCurves.clear();
+    loops.clear();
+    surfaces.clear();
+
+    if(!document){
+        error = QObject::tr("No document to export.");
+        return false;
+    }
+
+    document->calculateBorders();
+    PF_Vector size = document->getMax() - document->getMin();
+    points.setTolerance(std::max(1.,std::max(std::fabs(size.x),std::fabs(size.y)))*1e-9);
+
+    const std::vector<PF_RegionIndex::Region>& regions = document->getRegions();
+    addEdges(document->getRegionEdges());
+    for(const auto& r : regions){
+        std::vector<int> surface;
+        addLoop(r.outerEdges);
+        surface.push_back(int(loops.size()));
+        for(const auto& h : r.holeEdges){
+            addLoop(h);
+            surface.push_back(int(loops.size()));
+        }
+        surfaces.push_back(surface);
+    }
+    for(auto e : *document){
+        collectPoints(e);
+    }
+
+    FILE* fp = fopen(QFile::encodeName(filename).constData(),"w");
+    if(!fp){
+        error = QObject::tr("Can not open %1 for writing.").arg(filename);
+        return false;
+    }
+    /** 大缓冲区，减少系统调用 **/
+    setvbuf(fp,nullptr,_IOFBF,1<<20);
+
+    fprintf(fp,"// Gmsh geometry exported by FEEM\n");
+    if(meshSize > 0){
+        fprintf(fp,"lc = %.16g;\n",meshSize);
+    }
+    writePoints(fp);
+    writeCurves(fp);
+    writeSurfaces(fp);
+
+    bool ok = !ferror(fp);
+    if(fclose(fp) != 0) ok = false;
+    if(!ok){
+        error = QObject::tr("Failed to write %1.").arg(filename);
+    }
+    return ok;
+}
+
+/*!
+ \brief 收集单独的点实体，容器会被展开。曲线的端点由addEdges()加入。
+
+*/
+void PF_GmshGeoWriter::collectPoints(PF_Entity *e)
+{
+    if(!e || !e->isVisible()) return;
+
+    if(e->rtti() == PF::EntityPoint){
+        points.insert(e->getCenter());
+    }else if(e->isContainer()){
+        for(auto sub : *static_cast<PF_EntityContainer*>(e)){
+            collectPoints(sub);
+        }
+    }
+}
+
+/*!
+ \brief 每条边转换为一条Line或若干段Circle。.geo中的圆弧必须小于180度，
+ 圆弧按不超过120度均分。
+
+*/
+void PF_GmshGeoWriter::addEdges(const std::vector<PF_RegionIndex::Edge> &edges)
+{
+    edgeCurves.resize(edges.size());
+    for(std::size_t i = 0; i < edges.size(); i++){
+        const PF_RegionIndex::Edge& e = edges[i];
+        const int start = points.insert(e.p1);
+        const int end = points.insert(e.p2);
+        if(!e.arc){
+            curves.push_back(Curve{start,end,-1});
+            edgeCurves[i].push_back(int(curves.size()));
+            continue;
+        }
+        const int center = points.insert(e.center);
+        const int n = std::max(1,int(std::ceil(e.span/(2.*M_PI/3.))));
+        int from = start;
+        for(int k = 1; k <= n; k++){
+            const int to = k == n ? end
+                                  : points.insert(e.center + PF_Vector(e.angle + e.span*k/n)*e.radius);
+            curves.push_back(Curve{from,to,center});
+            edgeCurves[i].push_back(int(curves.size()));
+            from = to;
+        }
+    }
+}
+
+/*!
+ \brief 把区域边界的边编号换成曲线编号，反向的边曲线倒序并取负。
+
+*/
+void PF_GmshGeoWriter::addLoop(const std::vector<int> &edgeRefs)
+{
+    std::vector<int> loop;
+    for(int ref : edgeRefs){
+        const std::vector<int>& c = edgeCurves[std::abs(ref)-1];
+        if(ref > 0){
+            loop.insert(loop.end(),c.begin(),c.end());
+        }else{
+            for(auto it = c.rbegin(); it != c.rend(); ++it){
+                loop.push_back(-*it);
+            }
+        }
+    }
+    loops.push_back(loop);
+}
+
+void PF_GmshGeoWriter::writePoints(FILE *fp) const
+{
+    const char* format = meshSize > 0 ? "Point(%d) = {%.16g, %.16g, 0, lc};\n"
+                                      : "Point(%d) = {%.16g, %.16g, 0};\n";
+    for(int i = 0; i < points.size(); i++){
+        const PF_Vector& v = points.point(i);
+        fprintf(fp,format,i+1,v.x,v.y);
+    }
+}
+
+void PF_GmshGeoWriter::writeCurves(FILE *fp) const
+{
+    for(std::size_t i = 0; i < curves.size(); i++){
+        const Curve& c = curves[i];
+        if(c.center < 0){
+            fprintf(fp,"Line(%d) = {%d, %d};\n",int(i)+1,c.start+1,c.end+1);
+        }else{
+            fprintf(fp,"Circle(%d) = {%d, %d, %d};\n",int(i)+1,c.start+1,c.center+1,c.end+1);
+        }
+    }
+}
+
+void PF_GmshGeoWriter::writeSurfaces(FILE *fp) const
+{
+    for(std::size_t i = 0; i < loops.size(); i++){
+        fprintf(fp,"Curve Loop(%d) = {",int(i)+1);
+        const std::vector<int>& loop = loops[i];
+        for(std::size_t j = 0; j < loop.size(); j++){
+            fprintf(fp,j ? ", %d" : "%d",loop[j]);
+        }
+        fputs("};\n",fp);
+    }
+    for(std::size_t i = 0; i < surfaces.size(); i++){
+        const std::vector<int>& surface = surfaces[i];
+        fprintf(fp,"Plane Surface(%d) = {",int(i)+1);
+        for(std::size_t j = 0; j < surface.size(); j++){
+            fprintf(fp,j ? ", %d" : "%d",surface[j]);
+        }
+        fputs("};\n",fp);
+    }
+}
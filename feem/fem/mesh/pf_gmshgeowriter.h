@@ -0,0 +1,72 @@
+#ifndef PF_GMSHGEOWRITER_H
+#define PF_GMSHGEOWRITER_H
+
+#include "pf_pointhash.h"
+#include "pf_regionindex.h"
+
+#include <QString>
+
+#include <cstdio>
+#include <vector>
+
+class PF_Document;
+class PF_Entity;
+
+/*!
+ \brief 将PF_Document导出为Gmsh的.geo文件。
+
+ 几何取自文档的区域索引（PF_RegionIndex）：曲线在交点处打断，
+ 相邻的区域共用同一条曲线，因此线圈和空气、铁心和气隙这样相接的
+ 区域剖分后在界面上是协调的。每个区域输出一个Plane Surface，
+ 外边界和每个孔各是一个Curve Loop。不围成区域的悬挂曲线也输出，
+ 重合的端点通过空间哈希合并为同一个Point。
+ 输出直接写入带缓冲的FILE，不经过QString拼接。
+*/
+class PF_GmshGeoWriter
+{
+public:
+    explicit PF_GmshGeoWriter(PF_Document* doc);
+    ~PF_GmshGeoWriter()=default;
+
+    /** 写入Point的网格尺寸，小于等于0时不写 **/
+    void setMeshSize(double size){
+        meshSize = size;
+    }
+
+    bool write(const QString& filename);
+
+    QString errorString() const{
+        return error;
+    }
+
+private:
+    /*!
+     \brief .geo中的一条Line或Circle，center为-1时是直线。
+    */
+    struct Curve{
+        int start;
+        int end;
+        int center;
+    };
+
+    void collectPoints(PF_Entity* e);
+    void addEdges(const std::vector<PF_RegionIndex::Edge>& edges);
+    void addLoop(const std::vector<int>& edgeRefs);
+
+    void writePoints(FILE* fp) const;
+    void writeCurves(FILE* fp) const;
+    void writeSurfaces(FILE* fp) const;
+
+private:
+    PF_Document* document;
+    double meshSize;
+    QString error;
+
+    PF_PointHash points;
+    std::vector<Curve> curves;
+    std::vector<std::vector<int> > edgeCurves;  /**每条边依次对应的曲线编号，从1开始**/
+    std::vector<std::vector<int> > loops;       /**带方向的曲线编号**/
+    std::vector<std::vector<int> > surfaces;    /**外边界和孔的环编号，从1开始**/
+};
+
+#endif // PF_GMSHGEOWRITER_H
@@ -0,0 +1,277 @@
+#include "pf_gmshmesher.h"
+
+#include "pf_document.h"
+#include "pf_entitycontainer.h"
+#include "pf_circle.h"
+#include "pf_line.h"
+#include "pf_point.h"
+
+#include "gmsh.h"
+
+#include "egutils.h"
+#include "egdef.h"
+#include "egtypes.h"
+#include "egmesh.h"
+
+#include <QDebug>
+#include <QObject>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+/** 保证每次剖分结束后Gmsh都被关闭，包括抛出异常的情况 **/
+struct GmshSession{
+    GmshSession(){
+        gmsh::initialize();
+        gmsh::option::setNumber("General.Terminal",0);
+    }
+    ~GmshSession(){
+        try{
+            gmsh::finalize();
+        }catch(...){
+        }
+    }
+};
+
+/** Gmsh一阶单元类型到Elmer单元类型的转换，其余类型返回0 **/
+int gmshToElmerType(int gmshtype)
+{
+    switch (gmshtype) {
+    case 1:
+        return 202;
+    case 2:
+        return 303;
+    case 3:
+        return 404;
+    default:
+        return 0;
+    }
+}
+}
+
+PF_GmshMesher::PF_GmshMesher(PF_Document *doc)
+    :meshSize(0.)
+{
+    if(doc){
+        doc->calculateBorders();
+        minV = doc->getMin();
+        maxV = doc->getMax();
+        for(auto e : *doc){
+            collect(e);
+        }
+    }
+}
+
+/*!
+ \brief 复制实体的几何，容器会被展开。
+
+*/
+void PF_GmshMesher::collect(PF_Entity *e)
+{
+    if(!e || !e->isVisible()) return;
+
+    switch (e->rtti()) {
+    case PF::EntityPoint:
+        isolated.push_back(e->getCenter());
+        break;
+    case PF::EntityLine:
+        lines.push_back({e->getStartpoint(),e->getEndpoint()});
+        break;
+    case PF::EntityCircle:
+        circles.push_back({e->getCenter(),e->getRadius()});
+        break;
+    default:
+        /** 多段线等容器，逐个加入其中的实体 **/
+        if(e->isContainer()){
+            for(auto sub : *static_cast<PF_EntityContainer*>(e)){
+                collect(sub);
+            }
+        }
+        break;
+    }
+}
+
+bool PF_GmshMesher::report(int percent, const QString &stage)
+{
+    if(progressHandler && !progressHandler(percent,stage)){
+        error = QObject::tr("Meshing was canceled.");
+        return false;
+    }
+    return true;
+}
+
+/*!
+ \brief 对文档进行剖分，结果写入data和bound。
+
+ \param data 剖分得到的节点和单元，调用前不需要分配
+ \param bound 剖分得到的边界，至少包含MAXBOUNDARIES个元素
+ \return 成功返回true，失败时可由errorString()获得原因
+*/
+bool PF_GmshMesher::mesh(FemType *data, BoundaryType *bound)
+{
+    error.clear();
+    pointTags.clear();
+    tools.clear();
+
+    if(lines.empty() && circles.empty()){
+        error = QObject::tr("The document is empty.");
+        return false;
+    }
+
+    try{
+        if(!report(0,QObject::tr("Building geometry"))) return false;
+        GmshSession session;
+        gmsh::model::add("feem");
+
+        buildModel();
+        if(!error.isEmpty()) return false;
+
+        if(meshSize > 0){
+            gmsh::option::setNumber("Mesh.CharacteristicLengthMax",meshSize);
+        }
+        gmsh::option::setNumber("Mesh.ElementOrder",1);
+        if(!report(10,QObject::tr("Generating 2D mesh"))) return false;
+        gmsh::model::mesh::generate(2);
+
+        if(!report(80,QObject::tr("Transferring mesh"))) return false;
+        fetchMesh(data,bound);
+        gmsh::model::remove();
+        if(error.isEmpty()) report(100,QObject::tr("Done"));
+    }catch(int ierr){
+        error = QObject::tr("Gmsh failed with error code %1.").arg(ierr);
+        qDebug()<<Q_FUNC_INFO<<error;
+        return false;
+    }
+    return error.isEmpty();
+}
+
+/*!
+ \brief 将文档中的实体写入Gmsh的OCC模型，并用它们分割包围盒。
+
+*/
+void PF_GmshMesher::buildModel()
+{
+    double dx = maxV.x - minV.x;
+    double dy = maxV.y - minV.y;
+    if(dx <= PF_TOLERANCE || dy <= PF_TOLERANCE){
+        error = QObject::tr("The geometry does not enclose any area.");
+        return;
+    }
+    points.setTolerance(std::max(dx,dy)*1e-9);
+
+    int rect = gmsh::model::occ::addRectangle(minV.x,minV.y,0,dx,dy);
+
+    for(auto& v : isolated){
+        tools.push_back({0,addPoint(v)});
+    }
+    for(auto& l : lines){
+        int p1 = addPoint(l.first);
+        int p2 = addPoint(l.second);
+        if(p1 != p2){
+            tools.push_back({1,gmsh::model::occ::addLine(p1,p2)});
+        }
+    }
+    for(auto& c : circles){
+        tools.push_back({1,gmsh::model::occ::addCircle(c.first.x,c.first.y,0,c.second)});
+    }
+
+    gmsh::vectorpair out;
+    std::vector<gmsh::vectorpair> outMap;
+    gmsh::model::occ::fragment({{2,rect}},tools,out,outMap);
+    gmsh::model::occ::synchronize();
+}
+
+/*!
+ \brief 添加一个点，与已有点重合时直接返回已有点的tag。
+
+*/
+int PF_GmshMesher::addPoint(const PF_Vector &v)
+{
+    bool isNew = false;
+    int index = points.insert(v,&isNew);
+    if(isNew){
+        pointTags.push_back(gmsh::model::occ::addPoint(v.x,v.y,0));
+    }
+    return pointTags[index];
+}
+
+/*!
+ \brief 将Gmsh中的网格读入FemType，一维单元转换为边界。
+
+*/
+void PF_GmshMesher::fetchMesh(FemType *data, BoundaryType *bound)
+{
+    std::vector<std::size_t> nodeTags;
+    std::vector<double> coord, parametricCoord;
+    gmsh::model::mesh::getNodes(nodeTags,coord,parametricCoord,-1,-1,false,false);
+
+    std::size_t maxtag = 0;
+    for(auto tag : nodeTags) maxtag = std::max(maxtag,tag);
+    std::vector<int> revindx(maxtag+1,0);
+    for(std::size_t i = 0; i < nodeTags.size(); i++){
+        revindx[nodeTags[i]] = int(i)+1;
+    }
+
+    /** 先统计单元，再一次性分配 **/
+    struct Block{
+        int elmertype;
+        int material;
+        std::vector<std::size_t> nodes;
+    };
+    std::vector<Block> blocks;
+    int noelements = 0;
+    int maxelemtype = 0;
+    for(int dim = 2; dim >= 1; dim--){
+        gmsh::vectorpair dimTags;
+        gmsh::model::getEntities(dimTags,dim);
+        for(auto& dt : dimTags){
+            std::vector<int> types;
+            std::vector<std::vector<std::size_t> > elemTags, elemNodes;
+            gmsh::model::mesh::getElements(types,elemTags,elemNodes,dt.first,dt.second);
+            for(std::size_t t = 0; t < types.size(); t++){
+                int elmertype = gmshToElmerType(types[t]);
+                if(!elmertype) continue;
+                noelements += int(elemTags[t].size());
+                maxelemtype = std::max(maxelemtype,elmertype);
+                blocks.push_back({elmertype,dt.second,std::move(elemNodes[t])});
+            }
+        }
+    }
+    if(noelements == 0){
+        error = QObject::tr("Gmsh did not create any elements.");
+        return;
+    }
+
+    InitializeKnots(data);
+    data->dim = 2;
+    data->maxnodes = maxelemtype % 100;
+    data->noknots = int(nodeTags.size());
+    data->noelements = noelements;
+    AllocateKnots(data);
+
+    for(std::size_t i = 0; i < nodeTags.size(); i++){
+        data->x[i+1] = coord[3*i];
+        data->y[i+1] = coord[3*i+1];
+        data->z[i+1] = coord[3*i+2];
+    }
+
+    int elem = 0;
+    for(auto& b : blocks){
+        int elemnodes = b.elmertype % 100;
+        for(std::size_t k = 0; k < b.nodes.size(); k += elemnodes){
+            elem++;
+            data->elementtypes[elem] = b.elmertype;
+            data->material[elem] = b.material;
+            for(int j = 0; j < elemnodes; j++){
+                data->topology[elem][j] = revindx[b.nodes[k+j]];
+            }
+        }
+    }
+
+    ElementsToBoundaryConditions(data,bound,FALSE,FALSE);
+
+    /** OCC的tag编号不连续，重新编号 **/
+    RenumberBoundaryTypes(data,bound,TRUE,0,FALSE);
+    RenumberMaterialTypes(data,bound,FALSE);
+}
@@ -0,0 +1,83 @@
+#ifndef PF_GMSHMESHER_H
+#define PF_GMSHMESHER_H
+
+#include "pf_pointhash.h"
+
+#include <QString>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+class PF_Document;
+class PF_Entity;
+struct FemType;
+struct BoundaryType;
+
+/*!
+ \brief 调用Gmsh的API在进程内对PF_Document进行二维网格剖分，
+ 剖分结果直接写入ElmerGrid的FemType，不经过.geo/.msh文件。
+
+ 几何使用OCC内核建立：先以文档的包围盒建立一个矩形区域，
+ 再用文档中的点、线、圆、多段线对其做fragment，得到的每个面
+ 就是一个材料区域（材料编号为面的tag），每条曲线就是一个边界
+ （边界编号为曲线的tag）。
+
+ 构造时复制文档中的几何，之后mesh()不再访问文档，
+ 因此可以在后台线程中调用。
+*/
+class PF_GmshMesher
+{
+public:
+    explicit PF_GmshMesher(PF_Document* doc);
+    ~PF_GmshMesher()=default;
+
+    /** 全局的网格尺寸，小于等于0时由Gmsh自动确定 **/
+    void setMeshSize(double size){
+        meshSize = size;
+    }
+    double getMeshSize() const{
+        return meshSize;
+    }
+
+    /*!
+     \brief 剖分进度的回调，参数为百分比和阶段说明，返回false时取消剖分。
+     Gmsh的generate()本身不能中断，取消只在各阶段之间生效。
+    */
+    typedef std::function<bool(int,const QString&)> ProgressHandler;
+    void setProgressHandler(const ProgressHandler& handler){
+        progressHandler = handler;
+    }
+
+    bool mesh(FemType* data, BoundaryType* bound);
+
+    QString errorString() const{
+        return error;
+    }
+
+private:
+    void collect(PF_Entity* e);
+    bool report(int percent, const QString& stage);
+    void buildModel();
+    int addPoint(const PF_Vector& v);
+    void fetchMesh(FemType* data, BoundaryType* bound);
+
+private:
+    /** 文档几何的副本 **/
+    std::vector<std::pair<PF_Vector,PF_Vector> > lines;
+    std::vector<std::pair<PF_Vector,double> > circles;
+    std::vector<PF_Vector> isolated;
+    PF_Vector minV;
+    PF_Vector maxV;
+
+    double meshSize;
+    QString error;
+    ProgressHandler progressHandler;
+
+    /** 合并重合的端点，pointTags保存每个点在Gmsh中的tag **/
+    PF_PointHash points;
+    std::vector<int> pointTags;
+    std::vector<std::pair<int,int> > tools;
+};
+
+#endif // PF_GMSHMESHER_H
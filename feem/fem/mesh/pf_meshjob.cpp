@@ -0,0 +1,74 @@
+#include "pf_meshjob.h"
+#include "pf_meshscheduler.h"
+#include "pf_gmshmesher.h"
+
+#include "egutils.h"
+#include "egdef.h"
+#include "egtypes.h"
+#include "egmesh.h"
+
+PF_MeshResult::PF_MeshResult()
+    :m_data(new FemType())
+    ,m_bound(new BoundaryType[MAXBOUNDARIES]())
+{
+
+}
+
+PF_MeshResult::~PF_MeshResult()
+{
+    DestroyKnots(m_data);
+    for(int i = 0; i < MAXBOUNDARIES; i++){
+        DestroyBoundary(&m_bound[i]);
+    }
+    delete m_data;
+    delete[] m_bound;
+}
+
+PF_MeshJob::PF_MeshJob()
+    :m_id(0)
+    ,m_canceled(0)
+    ,m_worker(nullptr)
+{
+
+}
+
+/*!
+ \brief 报告进度，在run()中调用。
+
+ \param percent 百分比
+ \param stage 当前阶段的说明
+ \return 任务被取消时返回false
+*/
+bool PF_MeshJob::setProgress(int percent, const QString &stage)
+{
+    if(m_worker){
+        m_worker->reportProgress(this,percent,stage);
+    }
+    return !isCanceled();
+}
+
+PF_GmshMeshJob::PF_GmshMeshJob(PF_Document *doc, double meshSize)
+    :mesher(new PF_GmshMesher(doc))
+{
+    mesher->setMeshSize(meshSize);
+}
+
+PF_GmshMeshJob::~PF_GmshMeshJob()
+{
+    delete mesher;
+}
+
+bool PF_GmshMeshJob::run()
+{
+    mesher->setProgressHandler([this](int percent, const QString& stage){
+        return setProgress(percent,stage);
+    });
+
+    m_result = PF_MeshResultPtr(new PF_MeshResult);
+    if(!mesher->mesh(m_result->data(),m_result->boundaries())){
+        m_error = mesher->errorString();
+        m_result.clear();
+        return false;
+    }
+    return true;
+}
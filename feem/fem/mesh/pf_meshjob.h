@@ -0,0 +1,107 @@
+#ifndef PF_MESHJOB_H
+#define PF_MESHJOB_H
+
+#include <QAtomicInt>
+#include <QMetaType>
+#include <QSharedPointer>
+#include <QString>
+
+class PF_Document;
+class PF_GmshMesher;
+class PF_MeshWorker;
+struct FemType;
+struct BoundaryType;
+
+/*!
+ \brief 剖分得到的网格，包括ElmerGrid的FemType和边界。
+ 析构时释放网格。
+
+*/
+class PF_MeshResult
+{
+public:
+    PF_MeshResult();
+    ~PF_MeshResult();
+
+    FemType* data(){
+        return m_data;
+    }
+    BoundaryType* boundaries(){
+        return m_bound;
+    }
+
+private:
+    Q_DISABLE_COPY(PF_MeshResult)
+    FemType* m_data;
+    BoundaryType* m_bound;
+};
+
+typedef QSharedPointer<PF_MeshResult> PF_MeshResultPtr;
+Q_DECLARE_METATYPE(PF_MeshResultPtr)
+
+/*!
+ \brief 在后台线程中执行的剖分任务，由PF_MeshScheduler调度。
+
+ 子类在run()中完成剖分，期间通过setProgress()报告进度，
+ 当setProgress()返回false时应尽快结束。
+*/
+class PF_MeshJob
+{
+public:
+    PF_MeshJob();
+    virtual ~PF_MeshJob()=default;
+
+    /** 在后台线程中调用，成功时设置result **/
+    virtual bool run()=0;
+
+    int id() const{
+        return m_id;
+    }
+    /** 可以在任意线程调用 **/
+    void cancel(){
+        m_canceled.storeRelease(1);
+    }
+    bool isCanceled() const{
+        return m_canceled.loadAcquire() != 0;
+    }
+
+    PF_MeshResultPtr result() const{
+        return m_result;
+    }
+    QString errorString() const{
+        return m_error;
+    }
+
+protected:
+    bool setProgress(int percent, const QString& stage);
+
+protected:
+    PF_MeshResultPtr m_result;
+    QString m_error;
+
+private:
+    friend class PF_MeshScheduler;
+    friend class PF_MeshWorker;
+    int m_id;
+    QAtomicInt m_canceled;
+    PF_MeshWorker* m_worker;
+};
+
+/*!
+ \brief 调用Gmsh对文档进行二维剖分的任务。
+ 几何在构造时（GUI线程）复制，剖分期间可以继续编辑文档。
+
+*/
+class PF_GmshMeshJob : public PF_MeshJob
+{
+public:
+    explicit PF_GmshMeshJob(PF_Document* doc, double meshSize=0.);
+    ~PF_GmshMeshJob() override;
+
+    bool run() override;
+
+private:
+    PF_GmshMesher* mesher;
+};
+
+#endif // PF_MESHJOB_H
@@ -0,0 +1,117 @@
+#include "pf_meshscheduler.h"
+
+#include "ouptput/messagemanager.h"
+
+#include <QThread>
+
+PF_MeshWorker::PF_MeshWorker(QObject *parent)
+    :QObject(parent)
+{
+
+}
+
+/*!
+ \brief 由任务在工作线程中调用，进度以排队连接的信号发出。
+
+*/
+void PF_MeshWorker::reportProgress(PF_MeshJob *job, int percent, const QString &stage)
+{
+    emit progress(job->id(),percent,stage);
+}
+
+void PF_MeshWorker::runJob(PF_MeshJob *job)
+{
+    if(!job->isCanceled()){
+        job->m_worker = this;
+        job->run();
+        job->m_worker = nullptr;
+    }
+    emit jobDone(job);
+}
+
+PF_MeshScheduler::PF_MeshScheduler(QObject *parent)
+    :QObject(parent)
+    ,thread(new QThread(this))
+    ,worker(new PF_MeshWorker)
+    ,nextId(0)
+{
+    qRegisterMetaType<PF_MeshJob*>("PF_MeshJob*");
+    qRegisterMetaType<PF_MeshResultPtr>("PF_MeshResultPtr");
+
+    worker->moveToThread(thread);
+    connect(thread,&QThread::finished,worker,&QObject::deleteLater);
+    connect(this,&PF_MeshScheduler::jobQueued,
+            worker,&PF_MeshWorker::runJob,Qt::QueuedConnection);
+    connect(worker,&PF_MeshWorker::progress,
+            this,&PF_MeshScheduler::onProgress,Qt::QueuedConnection);
+    connect(worker,&PF_MeshWorker::jobDone,
+            this,&PF_MeshScheduler::onJobDone,Qt::QueuedConnection);
+
+    thread->start();
+}
+
+PF_MeshScheduler::~PF_MeshScheduler()
+{
+    /** 正在执行的任务会在下一个阶段结束 **/
+    cancelAll();
+    thread->quit();
+    thread->wait();
+    qDeleteAll(jobs);
+    jobs.clear();
+}
+
+/*!
+ \brief 提交一个任务，调度器获得任务的所有权。
+
+ \param job 任务
+ \return 任务的编号，用于取消和识别信号
+*/
+int PF_MeshScheduler::submit(PF_MeshJob *job)
+{
+    job->m_id = ++nextId;
+    jobs.insert(job->m_id,job);
+    MessageManager::write(tr("Mesh job %1 queued.").arg(job->m_id));
+    emit jobQueued(job);
+    return job->m_id;
+}
+
+void PF_MeshScheduler::cancel(int id)
+{
+    PF_MeshJob* job = jobs.value(id,nullptr);
+    if(job) job->cancel();
+}
+
+void PF_MeshScheduler::cancelAll()
+{
+    for(auto job : jobs){
+        job->cancel();
+    }
+}
+
+void PF_MeshScheduler::onProgress(int id, int percent, const QString &stage)
+{
+    MessageManager::write(tr("Mesh job %1: %2 (%3%)").arg(id).arg(stage).arg(percent));
+    emit progress(id,percent,stage);
+}
+
+/*!
+ \brief 任务结束，在GUI线程中发出结果信号并删除任务。
+
+*/
+void PF_MeshScheduler::onJobDone(PF_MeshJob *job)
+{
+    const int id = job->id();
+    jobs.remove(id);
+
+    if(job->isCanceled()){
+        MessageManager::write(tr("Mesh job %1 canceled.").arg(id));
+        emit meshCanceled(id);
+    }else if(job->result()){
+        MessageManager::write(tr("Mesh job %1 finished.").arg(id));
+        emit meshFinished(id,job->result());
+    }else{
+        MessageManager::write(tr("Mesh job %1 failed: %2").arg(id).arg(job->errorString()));
+        emit meshFailed(id,job->errorString());
+    }
+    delete job;
+}
@@ -0,0 +1,73 @@
+#ifndef PF_MESHSCHEDULER_H
+#define PF_MESHSCHEDULER_H
+
+#include "pf_meshjob.h"
+
+#include <QHash>
+#include <QObject>
+
+class QThread;
+
+/*!
+ \brief 在后台线程中依次执行剖分任务，不直接使用，由PF_MeshScheduler创建。
+
+*/
+class PF_MeshWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PF_MeshWorker(QObject* parent=nullptr);
+
+    void reportProgress(PF_MeshJob* job, int percent, const QString& stage);
+
+public slots:
+    void runJob(PF_MeshJob* job);
+
+signals:
+    void progress(int id, int percent, const QString& stage);
+    void jobDone(PF_MeshJob* job);
+};
+
+/*!
+ \brief 剖分任务调度器。
+
+ 任务在单独的线程中按提交顺序执行，Gmsh等剖分库不能并发调用，
+ 所以只使用一个线程。进度通过MessageManager输出，结果通过
+ 排队连接的信号回到GUI线程。
+*/
+class PF_MeshScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PF_MeshScheduler(QObject* parent=nullptr);
+    ~PF_MeshScheduler() override;
+
+    int submit(PF_MeshJob* job);
+    void cancel(int id);
+    void cancelAll();
+
+    bool isBusy() const{
+        return !jobs.isEmpty();
+    }
+
+signals:
+    void progress(int id, int percent, const QString& stage);
+    void meshFinished(int id, PF_MeshResultPtr mesh);
+    void meshFailed(int id, const QString& error);
+    void meshCanceled(int id);
+
+    /** 内部使用，将任务交给工作线程 **/
+    void jobQueued(PF_MeshJob* job);
+
+private slots:
+    void onProgress(int id, int percent, const QString& stage);
+    void onJobDone(PF_MeshJob* job);
+
+private:
+    QThread* thread;
+    PF_MeshWorker* worker;
+    QHash<int,PF_MeshJob*> jobs;
+    int nextId;
+};
+
+#endif // PF_MESHSCHEDULER_H
@@ -0,0 +1,70 @@
+#include "pf_pointhash.h"
+
+#include <cmath>
+
+PF_PointHash::PF_PointHash(double tolerance)
+    :tolerance(tolerance)
+{
+
+}
+
+/*!
+ \brief 修改容差，已有的点会被清空。
+
+*/
+void PF_PointHash::setTolerance(double tol)
+{
+    tolerance = tol;
+    clear();
+}
+
+/*!
+ \brief 插入一个点。
+
+ \param v 点的坐标
+ \param isNew 如果不为空，保存该点是否是新加入的
+ \return 点的编号，从0开始，与已有点重合时返回已有点的编号
+*/
+int PF_PointHash::insert(const PF_Vector &v, bool *isNew)
+{
+    int index = find(v);
+    if(isNew) *isNew = (index < 0);
+    if(index >= 0) return index;
+
+    index = int(points.size());
+    points.push_back(v);
+    cells.insert(cellOf(v),index);
+    return index;
+}
+
+/*!
+ \brief 查找与v重合的点，找不到返回-1。
+
+*/
+int PF_PointHash::find(const PF_Vector &v) const
+{
+    const Cell c = cellOf(v);
+    const double tol2 = tolerance*tolerance;
+    for(qint64 i = c.first-1; i <= c.first+1; i++){
+        for(qint64 j = c.second-1; j <= c.second+1; j++){
+            auto it = cells.constFind(Cell(i,j));
+            for(; it != cells.constEnd() && it.key() == Cell(i,j); ++it){
+                if(points[it.value()].squaredTo(v) <= tol2){
+                    return it.value();
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+void PF_PointHash::clear()
+{
+    points.clear();
+    cells.clear();
+}
+
+PF_PointHash::Cell PF_PointHash::cellOf(const PF_Vector &v) const
+{
+    return Cell(qint64(std::floor(v.x/tolerance)),qint64(std::floor(v.y/tolerance)));
+}
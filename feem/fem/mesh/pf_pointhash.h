@@ -0,0 +1,49 @@
+#ifndef PF_POINTHASH_H
+#define PF_POINTHASH_H
+
+#include "pf_vector.h"
+
+#include <QMultiHash>
+#include <QPair>
+
+#include <vector>
+
+/*!
+ \brief 基于均匀网格的空间哈希，用于合并距离小于容差的重合点。
+
+ 每个点按容差大小的格子量化，查找时检查相邻的3x3个格子，
+ 因此落在格子边界两侧的重合点也能被合并。
+*/
+class PF_PointHash
+{
+public:
+    explicit PF_PointHash(double tolerance=PF_TOLERANCE);
+    ~PF_PointHash()=default;
+
+    void setTolerance(double tol);
+    double getTolerance() const{
+        return tolerance;
+    }
+
+    int insert(const PF_Vector& v, bool* isNew=nullptr);
+    int find(const PF_Vector& v) const;
+
+    const PF_Vector& point(int index) const{
+        return points[index];
+    }
+    int size() const{
+        return int(points.size());
+    }
+    void clear();
+
+private:
+    typedef QPair<qint64,qint64> Cell;
+    Cell cellOf(const PF_Vector& v) const;
+
+private:
+    double tolerance;
+    std::vector<PF_Vector> points;
+    QMultiHash<Cell,int> cells;
+};
+
+#endif // PF_POINTHASH_H
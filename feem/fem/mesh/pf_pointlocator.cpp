@@ -0,0 +1,376 @@
+#include "pf_pointlocator.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/** 行走的最大步数，超过后退回到桶网格 **/
+const int MaxWalk = 32;
+/** 点到起点三角形的距离超过三角形尺寸的这个倍数时直接查桶网格 **/
+const double WalkReach = 8.;
+/** 批量查询时每一块的点数 **/
+const int ChunkSize = 1024;
+/** 重心坐标的容差，落在边上的点属于两侧任一个三角形 **/
+const double BaryTolerance = 1e-10;
+
+/*!
+ \brief 批量查询中的一块，在工作线程中执行。
+
+*/
+class LocateJob : public QRunnable
+{
+public:
+    LocateJob(const PF_PointLocator* locator, const double* x, const double* y,
+              int begin, int end, int* elements, double* bary,
+              const double* values, double* out, QSemaphore* done)
+        :locator(locator),x(x),y(y),begin(begin),end(end),elements(elements)
+        ,bary(bary),values(values),out(out),done(done)
+    {
+    }
+
+    void run() override
+    {
+        int hint = -1;
+        double b[3];
+        for(int i=begin;i<end;++i){
+            if(out){
+                out[i] = locator->interpolate(values,x[i],y[i],&hint);
+                continue;
+            }
+            const int e = locator->locate(x[i],y[i],&hint,b);
+            if(elements) elements[i] = e;
+            if(bary){
+                bary[3*i] = b[0];
+                bary[3*i + 1] = b[1];
+                bary[3*i + 2] = b[2];
+            }
+        }
+        if(done) done->release();
+    }
+
+private:
+    const PF_PointLocator* locator;
+    const double* x;
+    const double* y;
+    int begin, end;
+    int* elements;
+    double* bary;
+    const double* values;
+    double* out;
+    QSemaphore* done;
+};
+
+void runChunks(const PF_PointLocator* locator, const double* x, const double* y, int count,
+               int* elements, double* bary, const double* values, double* out)
+{
+    if(count <= ChunkSize){
+        LocateJob job(locator,x,y,0,count,elements,bary,values,out,nullptr);
+        job.run();
+        return;
+    }
+    QThreadPool* pool = QThreadPool::globalInstance();
+    const int chunks = (count + ChunkSize - 1)/ChunkSize;
+    QSemaphore done;
+    for(int i=1;i<chunks;++i){
+        pool->start(new LocateJob(locator,x,y,i*ChunkSize,std::min(count,(i + 1)*ChunkSize),
+                                  elements,bary,values,out,&done));
+    }
+    LocateJob first(locator,x,y,0,ChunkSize,elements,bary,values,out,nullptr);
+    first.run();
+    done.acquire(chunks - 1);
+}
+
+}
+
+PF_PointLocator::PF_PointLocator()
+    :elementCount(0)
+    ,x0(0.)
+    ,y0(0.)
+    ,x1(0.)
+    ,y1(0.)
+    ,cellSize(1.)
+    ,columns(0)
+    ,rows(0)
+{
+
+}
+
+/*!
+ \brief 复制网格并建立相邻关系和桶网格，与三角形数目近似成线性。
+
+*/
+void PF_PointLocator::build(const double *x, const double *y, int nodeCount,
+                            const int *triangles, int triangleCount)
+{
+    clear();
+    if(!x || !y || !triangles || nodeCount <= 0 || triangleCount <= 0) return;
+
+    nx.assign(x,x + nodeCount);
+    ny.assign(y,y + nodeCount);
+    tri.reserve(3*triangleCount);
+    for(int t=0;t<triangleCount;++t){
+        const int* v = triangles + 3*t;
+        if(v[0] < 0 || v[1] < 0 || v[2] < 0
+                || v[0] >= nodeCount || v[1] >= nodeCount || v[2] >= nodeCount){
+            continue;
+        }
+        tri.insert(tri.end(),v,v + 3);
+    }
+    elementCount = int(tri.size())/3;
+    if(elementCount == 0){
+        clear();
+        return;
+    }
+    buildNeighbors();
+    buildGrid();
+}
+
+void PF_PointLocator::clear()
+{
+    nx.clear();
+    ny.clear();
+    tri.clear();
+    neighbor.clear();
+    cellStart.clear();
+    cellItems.clear();
+    elementCount = 0;
+    columns = rows = 0;
+}
+
+int PF_PointLocator::locate(double x, double y, int *hint, double *bary) const
+{
+    if(elementCount == 0) return -1;
+    double b[3];
+    if(!bary) bary = b;
+
+    int e = -1;
+    if(hint && *hint >= 0 && *hint < elementCount && nearby(*hint,x,y))
+        e = walk(*hint,x,y,bary);
+    if(e < 0)
+        e = search(x,y,bary);
+    if(e >= 0 && hint)
+        *hint = e;
+    return e;
+}
+
+bool PF_PointLocator::bounds(double &minX, double &minY, double &maxX, double &maxY) const
+{
+    if(elementCount == 0) return false;
+    minX = x0;
+    minY = y0;
+    maxX = x1;
+    maxY = y1;
+    return true;
+}
+
+bool PF_PointLocator::contains(int element, double x, double y) const
+{
+    if(element < 0 || element >= elementCount) return false;
+    double b[3];
+    return barycentric(element,x,y,b);
+}
+
+double PF_PointLocator::interpolate(const double *values, double x, double y, int *hint) const
+{
+    double b[3];
+    const int e = locate(x,y,hint,b);
+    if(e < 0 || !values) return std::numeric_limits<double>::quiet_NaN();
+    const int* v = tri.data() + 3*e;
+    return b[0]*values[v[0]] + b[1]*values[v[1]] + b[2]*values[v[2]];
+}
+
+bool PF_PointLocator::gradient(const double *values, int element, double &gx, double &gy) const
+{
+    if(!values || element < 0 || element >= elementCount) return false;
+    const int* v = tri.data() + 3*element;
+    const double xa = nx[v[0]], ya = ny[v[0]];
+    const double xb = nx[v[1]] - xa, yb = ny[v[1]] - ya;
+    const double xc = nx[v[2]] - xa, yc = ny[v[2]] - ya;
+    const double det = xb*yc - xc*yb;
+    if(det == 0.) return false;
+    const double db = values[v[1]] - values[v[0]];
+    const double dc = values[v[2]] - values[v[0]];
+    gx = (db*yc - dc*yb)/det;
+    gy = (xb*dc - xc*db)/det;
+    return true;
+}
+
+void PF_PointLocator::locate(const double *x, const double *y, int count, int *elements, double *bary) const
+{
+    if(!x || !y || count <= 0) return;
+    runChunks(this,x,y,count,elements,bary,nullptr,nullptr);
+}
+
+void PF_PointLocator::interpolate(const double *values, const double *x, const double *y, int count, double *out) const
+{
+    if(!values || !x || !y || !out || count <= 0) return;
+    runChunks(this,x,y,count,nullptr,nullptr,values,out);
+}
+
+/*!
+ \brief 计算(x,y)在三角形中的重心坐标，返回点是否在三角形内（包括边上）。
+ 退化的三角形返回false，重心坐标全部为0。
+
+*/
+bool PF_PointLocator::barycentric(int element, double x, double y, double *bary) const
+{
+    const int* v = tri.data() + 3*element;
+    const double xa = nx[v[0]], ya = ny[v[0]];
+    const double xb = nx[v[1]], yb = ny[v[1]];
+    const double xc = nx[v[2]], yc = ny[v[2]];
+    const double det = (xb - xa)*(yc - ya) - (xc - xa)*(yb - ya);
+    if(det == 0.){
+        bary[0] = bary[1] = bary[2] = 0.;
+        return false;
+    }
+    bary[0] = ((xb - x)*(yc - y) - (xc - x)*(yb - y))/det;
+    bary[1] = ((xc - x)*(ya - y) - (xa - x)*(yc - y))/det;
+    bary[2] = 1. - bary[0] - bary[1];
+    return bary[0] >= -BaryTolerance && bary[1] >= -BaryTolerance && bary[2] >= -BaryTolerance;
+}
+
+/*!
+ \brief 判断(x,y)是否离三角形足够近，值得从它开始行走。
+ 远处的点行走的步数多，而且每一步都可能缓存缺失，不如直接查桶网格。
+
+*/
+bool PF_PointLocator::nearby(int element, double x, double y) const
+{
+    const int* v = tri.data() + 3*element;
+    const double xmin = std::min(nx[v[0]],std::min(nx[v[1]],nx[v[2]]));
+    const double ymin = std::min(ny[v[0]],std::min(ny[v[1]],ny[v[2]]));
+    const double xmax = std::max(nx[v[0]],std::max(nx[v[1]],nx[v[2]]));
+    const double ymax = std::max(ny[v[0]],std::max(ny[v[1]],ny[v[2]]));
+    const double reach = WalkReach*std::max(xmax - xmin,ymax - ymin);
+    return x >= xmin - reach && x <= xmax + reach && y >= ymin - reach && y <= ymax + reach;
+}
+
+/*!
+ \brief 从start出发，每次穿过重心坐标最负的节点所对的边，
+ 走出网格、遇到退化三角形或步数过多时返回-1。
+
+*/
+int PF_PointLocator::walk(int start, double x, double y, double *bary) const
+{
+    int e = start;
+    for(int step=0;step<MaxWalk;++step){
+        if(barycentric(e,x,y,bary)) return e;
+        int k = 0;
+        if(bary[1] < bary[k]) k = 1;
+        if(bary[2] < bary[k]) k = 2;
+        if(bary[k] == 0.) return -1;
+        e = neighbor[3*e + k];
+        if(e < 0) return -1;
+    }
+    return -1;
+}
+
+int PF_PointLocator::search(double x, double y, double *bary) const
+{
+    if(columns == 0 || rows == 0) return -1;
+    const double fx = std::floor((x - x0)/cellSize);
+    const double fy = std::floor((y - y0)/cellSize);
+    if(!(fx >= 0. && fx < columns && fy >= 0. && fy < rows)) return -1;
+    const int cell = int(fy)*columns + int(fx);
+    for(int i=cellStart[cell];i<cellStart[cell + 1];++i){
+        if(barycentric(cellItems[i],x,y,bary)) return cellItems[i];
+    }
+    return -1;
+}
+
+/*!
+ \brief 把每条边用两个节点编号排序后配对，共享一条边的两个三角形互为邻居。
+
+*/
+void PF_PointLocator::buildNeighbors()
+{
+    const long long n = static_cast<long long>(nx.size());
+    std::vector<std::pair<long long,int> > edges;
+    edges.reserve(3*elementCount);
+    for(int t=0;t<elementCount;++t){
+        for(int k=0;k<3;++k){
+            const long long a = tri[3*t + (k + 1)%3];
+            const long long b = tri[3*t + (k + 2)%3];
+            edges.push_back(std::make_pair(std::min(a,b)*n + std::max(a,b),3*t + k));
+        }
+    }
+    std::sort(edges.begin(),edges.end());
+
+    neighbor.assign(3*elementCount,-1);
+    for(int i=0;i + 1<int(edges.size());++i){
+        if(edges[i].first != edges[i + 1].first) continue;
+        neighbor[edges[i].second] = edges[i + 1].second/3;
+        neighbor[edges[i + 1].second] = edges[i].second/3;
+        ++i;
+    }
+}
+
+/*!
+ \brief 格子的大小使平均每个格子约有两个三角形，
+ 每个三角形放入它的包围盒覆盖的所有格子。
+
+*/
+void PF_PointLocator::buildGrid()
+{
+    x0 = x1 = nx[tri[0]];
+    y0 = y1 = ny[tri[0]];
+    for(const int v : tri){
+        x0 = std::min(x0,nx[v]);
+        y0 = std::min(y0,ny[v]);
+        x1 = std::max(x1,nx[v]);
+        y1 = std::max(y1,ny[v]);
+    }
+    const double width = x1 - x0;
+    const double height = y1 - y0;
+    const double cells = std::max(1.,elementCount/2.);
+    if(width > 0. && height > 0.)
+        cellSize = std::sqrt(width*height/cells);
+    else
+        cellSize = std::max(width,height)/cells;
+    if(!(cellSize > 0.)) cellSize = 1.;
+    columns = std::max(1,std::min(int(width/cellSize) + 1,int(cells) + 1));
+    rows = std::max(1,std::min(int(height/cellSize) + 1,int(cells) + 1));
+    cellSize = std::max(cellSize,std::max(width/columns,height/rows)*(1. + 1e-12));
+
+    auto range = [&](int t, int& i0, int& j0, int& i1, int& j1){
+        const int* v = tri.data() + 3*t;
+        const double xmin = std::min(nx[v[0]],std::min(nx[v[1]],nx[v[2]]));
+        const double ymin = std::min(ny[v[0]],std::min(ny[v[1]],ny[v[2]]));
+        const double xmax = std::max(nx[v[0]],std::max(nx[v[1]],nx[v[2]]));
+        const double ymax = std::max(ny[v[0]],std::max(ny[v[1]],ny[v[2]]));
+        i0 = std::max(0,int((xmin - x0)/cellSize));
+        j0 = std::max(0,int((ymin - y0)/cellSize));
+        i1 = std::min(columns - 1,int((xmax - x0)/cellSize));
+        j1 = std::min(rows - 1,int((ymax - y0)/cellSize));
+    };
+
+    cellStart.assign(columns*rows + 1,0);
+    int i0, j0, i1, j1;
+    for(int t=0;t<elementCount;++t){
+        range(t,i0,j0,i1,j1);
+        for(int j=j0;j<=j1;++j){
+            for(int i=i0;i<=i1;++i){
+                ++cellStart[j*columns + i + 1];
+            }
+        }
+    }
+    for(int c=0;c<columns*rows;++c){
+        cellStart[c + 1] += cellStart[c];
+    }
+    cellItems.resize(cellStart.back());
+    std::vector<int> fill(cellStart.begin(),cellStart.end() - 1);
+    for(int t=0;t<elementCount;++t){
+        range(t,i0,j0,i1,j1);
+        for(int j=j0;j<=j1;++j){
+            for(int i=i0;i<=i1;++i){
+                cellItems[fill[j*columns + i]++] = t;
+            }
+        }
+    }
+}
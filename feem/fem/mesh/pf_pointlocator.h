@@ -0,0 +1,88 @@
+#ifndef PF_POINTLOCATOR_H
+#define PF_POINTLOCATOR_H
+
+#include <vector>
+
+/*!
+ \brief 三角形网格上的点定位，用于在任意坐标处探测场量（光标读数、
+ 沿线绘图、采样网格）。
+
+ 三角形按包围盒放入均匀的桶网格（CSR存储），平均每个格子约两个三角形。
+ 查询时先从上一次命中的三角形出发，沿重心坐标最负的边走向相邻的三角形，
+ 连续的查询通常只需要几步；走出网格或步数过多时退回到桶网格查找。
+ 查询是只读的，上一次命中的三角形由调用者保存，因此可以在多个线程中同时查询。
+*/
+class PF_PointLocator
+{
+public:
+    PF_PointLocator();
+    ~PF_PointLocator()=default;
+
+    /** 节点坐标和三角形的三个节点编号（从0开始），数据会被复制 **/
+    void build(const double* x, const double* y, int nodeCount,
+               const int* triangles, int triangleCount);
+    void clear();
+
+    bool isEmpty() const{
+        return elementCount == 0;
+    }
+    int nodeCount() const{
+        return int(nx.size());
+    }
+    int triangleCount() const{
+        return elementCount;
+    }
+    /** 所有三角形的包围盒，网格为空时返回false **/
+    bool bounds(double& minX, double& minY, double& maxX, double& maxY) const;
+
+    /*!
+     \brief 查找包含(x,y)的三角形，找不到返回-1。
+
+     \param hint 不为空时作为行走的起点，并保存本次命中的三角形
+     \param bary 不为空时保存三个节点的重心坐标
+    */
+    int locate(double x, double y, int* hint=nullptr, double* bary=nullptr) const;
+
+    /** 判断(x,y)是否在三角形element内（包括边上），用于沿路径判断何时离开一个单元 **/
+    bool contains(int element, double x, double y) const;
+
+    /** 节点值的线性插值，点在网格外时返回NaN **/
+    double interpolate(const double* values, double x, double y, int* hint=nullptr) const;
+    /** 节点值在三角形上的梯度（常数），例如由磁矢位得到B=(dA/dy,-dA/dx) **/
+    bool gradient(const double* values, int element, double& gx, double& gy) const;
+
+    /*!
+     \brief 批量查询，点被分成连续的块在线程池中并行处理，
+     每一块从自己上一次命中的三角形开始行走，所以相邻的点应当连续存放。
+
+     \param elements 保存每个点所在的三角形，可以为空
+     \param bary 保存每个点的三个重心坐标，长度为3*count，可以为空
+    */
+    void locate(const double* x, const double* y, int count, int* elements, double* bary=nullptr) const;
+    /** 批量插值，网格外的点为NaN **/
+    void interpolate(const double* values, const double* x, const double* y, int count, double* out) const;
+
+private:
+    bool barycentric(int element, double x, double y, double* bary) const;
+    bool nearby(int element, double x, double y) const;
+    int walk(int start, double x, double y, double* bary) const;
+    int search(double x, double y, double* bary) const;
+    void buildNeighbors();
+    void buildGrid();
+
+private:
+    std::vector<double> nx, ny;
+    std::vector<int> tri;
+    std::vector<int> neighbor;  /**neighbor[3*t+k]为与节点k对边相邻的三角形，没有为-1**/
+    int elementCount;
+
+    /** 桶网格，(x0,y0)和(x1,y1)为包围盒的两个角 **/
+    double x0, y0;
+    double x1, y1;
+    double cellSize;
+    int columns, rows;
+    std::vector<int> cellStart;
+    std::vector<int> cellItems;
+};
+
+#endif // PF_POINTLOCATOR_H
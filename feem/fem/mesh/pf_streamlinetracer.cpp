@@ -0,0 +1,238 @@
+#include "pf_streamlinetracer.h"
+#include "pf_pointlocator.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+namespace {
+
+/** 并行追踪时每一块的种子点数 **/
+const int SeedChunk = 16;
+/** gridSeeds()最多生成的种子点数 **/
+const double MaxSeeds = 1e6;
+
+long long cellKey(const PF_Vector& p, double distance)
+{
+    const long long i = static_cast<long long>(std::floor(p.x/distance));
+    const long long j = static_cast<long long>(std::floor(p.y/distance));
+    return (i << 32) ^ (j & 0xffffffffLL);
+}
+
+}
+
+/*!
+ \brief 在工作线程中追踪一块连续的种子点。
+
+*/
+class PF_StreamlineTracer::TraceJob : public QRunnable
+{
+public:
+    TraceJob(const PF_StreamlineTracer* tracer, const PF_Vector* seeds, int count,
+             Streamline* out, QSemaphore* done)
+        :tracer(tracer),seeds(seeds),count(count),out(out),done(done)
+    {
+    }
+
+    void run() override
+    {
+        tracer->traceRange(seeds,count,out);
+        done->release();
+    }
+
+private:
+    const PF_StreamlineTracer* tracer;
+    const PF_Vector* seeds;
+    int count;
+    Streamline* out;
+    QSemaphore* done;
+};
+
+PF_StreamlineTracer::PF_StreamlineTracer()
+    :locator(nullptr)
+    ,vx(nullptr)
+    ,vy(nullptr)
+    ,step(1.)
+    ,maxSteps(2000)
+    ,minBound(1.,1.)
+    ,maxBound(-1.,-1.)
+{
+
+}
+
+void PF_StreamlineTracer::setField(const PF_PointLocator *locator, const double *vx, const double *vy)
+{
+    this->locator = locator;
+    this->vx = vx;
+    this->vy = vy;
+}
+
+void PF_StreamlineTracer::setStepSize(double h)
+{
+    if(h > 0.) step = h;
+}
+
+void PF_StreamlineTracer::setMaxSteps(int n)
+{
+    maxSteps = std::max(1,n);
+}
+
+void PF_StreamlineTracer::setBounds(const PF_Vector &minV, const PF_Vector &maxV)
+{
+    minBound = minV;
+    maxBound = maxV;
+}
+
+std::vector<PF_StreamlineTracer::Streamline> PF_StreamlineTracer::trace(const std::vector<PF_Vector> &seeds) const
+{
+    std::vector<Streamline> lines;
+    if(!locator || locator->isEmpty() || !vx || !vy || seeds.empty()) return lines;
+
+    const int count = int(seeds.size());
+    lines.resize(count);
+    const int chunks = (count + SeedChunk - 1)/SeedChunk;
+    QThreadPool* pool = QThreadPool::globalInstance();
+    QSemaphore done;
+    for(int i=1;i<chunks;++i){
+        const int begin = i*SeedChunk;
+        pool->start(new TraceJob(this,seeds.data() + begin,std::min(SeedChunk,count - begin),
+                                 lines.data() + begin,&done));
+    }
+    traceRange(seeds.data(),std::min(SeedChunk,count),lines.data());
+    done.acquire(chunks - 1);
+
+    lines.erase(std::remove_if(lines.begin(),lines.end(),[](const Streamline& l){
+        return l.points.size() < 2;
+    }),lines.end());
+    return lines;
+}
+
+std::vector<PF_Vector> PF_StreamlineTracer::gridSeeds(const PF_Vector &minV, const PF_Vector &maxV, double spacing)
+{
+    std::vector<PF_Vector> seeds;
+    if(!(spacing > 0.) || minV.x > maxV.x || minV.y > maxV.y) return seeds;
+    const double i0 = std::ceil(minV.x/spacing - 0.5), i1 = std::floor(maxV.x/spacing - 0.5);
+    const double j0 = std::ceil(minV.y/spacing - 0.5), j1 = std::floor(maxV.y/spacing - 0.5);
+    if(i1 < i0 || j1 < j0 || (i1 - i0 + 1.)*(j1 - j0 + 1.) > MaxSeeds) return seeds;
+    for(double j=j0;j<=j1;++j){
+        for(double i=i0;i<=i1;++i){
+            seeds.push_back(PF_Vector((i + 0.5)*spacing,(j + 0.5)*spacing));
+        }
+    }
+    return seeds;
+}
+
+void PF_StreamlineTracer::removeOverlaps(std::vector<Streamline> &lines, double distance)
+{
+    if(!(distance > 0.) || lines.size() < 2) return;
+    std::stable_sort(lines.begin(),lines.end(),[](const Streamline& a, const Streamline& b){
+        return a.points.size() > b.points.size();
+    });
+
+    std::unordered_set<long long> occupied;
+    std::vector<Streamline> kept;
+    for(Streamline& line : lines){
+        size_t covered = 0;
+        for(const PF_Vector& p : line.points){
+            if(occupied.count(cellKey(p,distance))) ++covered;
+        }
+        if(2*covered > line.points.size()) continue;
+        for(const PF_Vector& p : line.points){
+            occupied.insert(cellKey(p,distance));
+        }
+        kept.push_back(std::move(line));
+    }
+    lines.swap(kept);
+}
+
+/*!
+ \brief 先向正方向追踪，没有闭合时再向反方向追踪，反方向的点倒序放在前面。
+
+*/
+void PF_StreamlineTracer::traceRange(const PF_Vector *seeds, int count, Streamline *out) const
+{
+    std::vector<PF_Vector> forward, backward;
+    for(int i=0;i<count;++i){
+        Streamline& line = out[i];
+        line.points.clear();
+        line.closed = false;
+
+        const PF_Vector& seed = seeds[i];
+        int hint = -1;
+        PF_Vector d;
+        if(!inBounds(seed) || !direction(seed,1.,hint,d)) continue;
+
+        forward.clear();
+        backward.clear();
+        traceDirection(seed,1.,hint,forward,line.closed);
+        if(!line.closed){
+            bool closed = false;
+            traceDirection(seed,-1.,hint,backward,closed);
+        }
+        line.points.reserve(backward.size() + forward.size() + 1);
+        line.points.insert(line.points.end(),backward.rbegin(),backward.rend());
+        line.points.push_back(seed);
+        line.points.insert(line.points.end(),forward.begin(),forward.end());
+
+        line.minV = line.maxV = seed;
+        for(const PF_Vector& p : line.points){
+            line.minV = PF_Vector::minimum(line.minV,p);
+            line.maxV = PF_Vector::maximum(line.maxV,p);
+        }
+    }
+}
+
+/*!
+ \brief 沿sign*v/|v|积分，中间的某一阶走出网格时用一阶的方向走完这一步后停止。
+
+*/
+void PF_StreamlineTracer::traceDirection(const PF_Vector &seed, double sign, int element,
+                                         std::vector<PF_Vector> &points, bool &closed) const
+{
+    const double h = step;
+    PF_Vector p = seed;
+    int hint = element;
+    double travelled = 0.;
+    for(int i=0;i<maxSteps;++i){
+        PF_Vector k1, k2, k3, k4;
+        if(!direction(p,sign,hint,k1)) break;
+        int h2 = hint;
+        if(!direction(p + k1*(0.5*h),sign,h2,k2)
+                || !direction(p + k2*(0.5*h),sign,h2,k3)
+                || !direction(p + k3*h,sign,h2,k4)){
+            points.push_back(p + k1*h);
+            break;
+        }
+        const PF_Vector next = p + (k1 + k2*2. + k3*2. + k4)*(h/6.);
+        travelled += h;
+        if(travelled > 3.*h && next.distanceTo(seed) < h){
+            points.push_back(seed);
+            closed = true;
+            break;
+        }
+        points.push_back(next);
+        if(!inBounds(next)) break;
+        p = next;
+    }
+}
+
+bool PF_StreamlineTracer::direction(const PF_Vector &p, double sign, int &hint, PF_Vector &d) const
+{
+    const double x = locator->interpolate(vx,p.x,p.y,&hint);
+    if(std::isnan(x)) return false;
+    const double y = locator->interpolate(vy,p.x,p.y,&hint);
+    const double m = std::hypot(x,y);
+    if(!(m > 0.)) return false;
+    d = PF_Vector(x*sign/m,y*sign/m);
+    return true;
+}
+
+bool PF_StreamlineTracer::inBounds(const PF_Vector &p) const
+{
+    if(minBound.x > maxBound.x || minBound.y > maxBound.y) return true;
+    return p.x >= minBound.x && p.x <= maxBound.x && p.y >= minBound.y && p.y <= maxBound.y;
+}
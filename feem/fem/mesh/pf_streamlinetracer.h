@@ -0,0 +1,70 @@
+#ifndef PF_STREAMLINETRACER_H
+#define PF_STREAMLINETRACER_H
+
+#include "pf_vector.h"
+
+#include <vector>
+
+class PF_PointLocator;
+
+/*!
+ \brief 在三角形网格上追踪向量场（例如B）的流线。
+
+ 节点上的向量在单元内线性插值，沿单位方向用四阶Runge-Kutta积分，
+ 步长为弧长，因此点的间距均匀。每一步用上一次所在的单元作为起点行走定位，
+ 通常只需要检查当前单元。每个种子点分别向正、反两个方向追踪，
+ 走出网格或范围、场为零、步数用完或回到起点附近（闭合的磁力线）时停止。
+ 种子点分成若干块在线程池中并行追踪。
+*/
+class PF_StreamlineTracer
+{
+public:
+    struct Streamline{
+        std::vector<PF_Vector> points;
+        bool closed;
+        PF_Vector minV, maxV;
+    };
+
+    PF_StreamlineTracer();
+    ~PF_StreamlineTracer()=default;
+
+    /** 节点上的向量分量，长度为locator的节点数，不复制，追踪期间不能释放 **/
+    void setField(const PF_PointLocator* locator, const double* vx, const double* vy);
+    /** 积分步长（弧长） **/
+    void setStepSize(double h);
+    double stepSize() const{
+        return step;
+    }
+    /** 每个方向的最大步数 **/
+    void setMaxSteps(int n);
+    /** 流线离开这个范围时停止，用于只追踪可见的部分；minV > maxV时不限制 **/
+    void setBounds(const PF_Vector& minV, const PF_Vector& maxV);
+
+    std::vector<Streamline> trace(const std::vector<PF_Vector>& seeds) const;
+
+    /** 按间距spacing在矩形中均匀布置种子点，网格与原点对齐，平移时种子点不动 **/
+    static std::vector<PF_Vector> gridSeeds(const PF_Vector& minV, const PF_Vector& maxV, double spacing);
+    /*!
+     \brief 去掉与前面的流线重合的流线。按长度从长到短，一条流线超过一半的点
+     落在已经被占用的格子（边长为distance）中时被去掉。
+    */
+    static void removeOverlaps(std::vector<Streamline>& lines, double distance);
+
+private:
+    class TraceJob;
+    void traceRange(const PF_Vector* seeds, int count, Streamline* out) const;
+    void traceDirection(const PF_Vector& seed, double sign, int element,
+                        std::vector<PF_Vector>& points, bool& closed) const;
+    bool direction(const PF_Vector& p, double sign, int& hint, PF_Vector& d) const;
+    bool inBounds(const PF_Vector& p) const;
+
+private:
+    const PF_PointLocator* locator;
+    const double* vx;
+    const double* vy;
+    double step;
+    int maxSteps;
+    PF_Vector minBound, maxBound;
+};
+
+#endif // PF_STREAMLINETRACER_H
@@ -0,0 +1,216 @@
+#include "pf_transientresult.h"
+#include "pf.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+/*!
+ \brief 文件头，之后是stepCount个StepEntry，节点值从dataOffset开始。
+
+*/
+struct FileHeader{
+    char magic[8];
+    quint32 version;
+    qint32 nodeCount;
+    qint32 stepCount;
+    quint32 reserved;
+    qint64 dataOffset;
+};
+const qint64 HeaderSize = 64;
+const char Magic[8] = {'F','E','E','M','T','R','N','1'};
+const quint32 Version = 1;
+/** 节点值按页对齐，每一步的数据从页的边界开始时读取的页最少 **/
+const qint64 PageSize = 4096;
+
+}
+
+/*!
+ \brief 时间步表中的一项。
+
+*/
+struct PF_TransientResult::StepEntry{
+    double time;
+    double lower;
+    double upper;
+    quint64 written;
+};
+
+PF_TransientResult::PF_TransientResult()
+    :mapped(nullptr)
+    ,writable(false)
+    ,nodes(0)
+    ,steps(0)
+    ,dataOffset(0)
+{
+
+}
+
+PF_TransientResult::~PF_TransientResult()
+{
+    close();
+}
+
+bool PF_TransientResult::create(const QString &path, int nodeCount, int stepCount)
+{
+    close();
+    if(nodeCount <= 0 || stepCount <= 0){
+        qDebug()<<Q_FUNC_INFO<<"invalid size"<<nodeCount<<stepCount;
+        return false;
+    }
+    file.setFileName(path);
+    if(!file.open(QIODevice::ReadWrite | QIODevice::Truncate)){
+        qDebug()<<Q_FUNC_INFO<<"cannot open"<<path<<file.errorString();
+        return false;
+    }
+    const qint64 table = HeaderSize + qint64(sizeof(StepEntry))*stepCount;
+    const qint64 offset = (table + PageSize - 1)/PageSize*PageSize;
+    const qint64 size = offset + qint64(sizeof(double))*nodeCount*stepCount;
+    if(!file.resize(size)){
+        qDebug()<<Q_FUNC_INFO<<"cannot resize"<<path<<file.errorString();
+        file.close();
+        return false;
+    }
+    writable = true;
+    if(!map(size)) return false;
+
+    FileHeader* header = reinterpret_cast<FileHeader*>(mapped);
+    std::memset(mapped,0,size_t(table));
+    std::memcpy(header->magic,Magic,sizeof(Magic));
+    header->version = Version;
+    header->nodeCount = nodeCount;
+    header->stepCount = stepCount;
+    header->dataOffset = offset;
+    nodes = nodeCount;
+    steps = stepCount;
+    dataOffset = offset;
+    return true;
+}
+
+bool PF_TransientResult::open(const QString &path)
+{
+    close();
+    file.setFileName(path);
+    if(!file.open(QIODevice::ReadOnly)){
+        qDebug()<<Q_FUNC_INFO<<"cannot open"<<path<<file.errorString();
+        return false;
+    }
+    FileHeader header;
+    if(file.read(reinterpret_cast<char*>(&header),sizeof(header)) != qint64(sizeof(header))
+            || std::memcmp(header.magic,Magic,sizeof(Magic)) != 0 || header.version != Version
+            || header.nodeCount <= 0 || header.stepCount <= 0){
+        qDebug()<<Q_FUNC_INFO<<path<<"is not a transient result file";
+        file.close();
+        return false;
+    }
+    const qint64 size = header.dataOffset + qint64(sizeof(double))*header.nodeCount*header.stepCount;
+    if(header.dataOffset < HeaderSize + qint64(sizeof(StepEntry))*header.stepCount || file.size() < size){
+        qDebug()<<Q_FUNC_INFO<<path<<"is truncated";
+        file.close();
+        return false;
+    }
+    writable = false;
+    if(!map(size)) return false;
+    nodes = header.nodeCount;
+    steps = header.stepCount;
+    dataOffset = header.dataOffset;
+    return true;
+}
+
+void PF_TransientResult::close()
+{
+    if(mapped){
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    if(file.isOpen()) file.close();
+    writable = false;
+    nodes = steps = 0;
+    dataOffset = 0;
+}
+
+bool PF_TransientResult::setStep(int step, double time, const double *values)
+{
+    if(!writable || !values || step < 0 || step >= steps) return false;
+    double* data = reinterpret_cast<double*>(mapped + dataOffset) + qint64(step)*nodes;
+    std::memcpy(data,values,sizeof(double)*size_t(nodes));
+
+    double lower = PF_MAXDOUBLE, upper = -PF_MAXDOUBLE;
+    for(int i=0;i<nodes;++i){
+        if(std::isnan(values[i])) continue;
+        lower = std::min(lower,values[i]);
+        upper = std::max(upper,values[i]);
+    }
+    StepEntry* e = const_cast<StepEntry*>(entry(step));
+    e->time = time;
+    e->lower = lower;
+    e->upper = upper;
+    e->written = 1;
+    return true;
+}
+
+bool PF_TransientResult::hasStep(int step) const
+{
+    const StepEntry* e = entry(step);
+    return e && e->written;
+}
+
+double PF_TransientResult::time(int step) const
+{
+    const StepEntry* e = entry(step);
+    return e ? e->time : 0.;
+}
+
+const double *PF_TransientResult::values(int step) const
+{
+    if(!hasStep(step)) return nullptr;
+    return reinterpret_cast<const double*>(mapped + dataOffset) + qint64(step)*nodes;
+}
+
+bool PF_TransientResult::stepRange(int step, double &lower, double &upper) const
+{
+    const StepEntry* e = entry(step);
+    if(!e || !e->written || e->lower > e->upper) return false;
+    lower = e->lower;
+    upper = e->upper;
+    return true;
+}
+
+bool PF_TransientResult::range(double &lower, double &upper) const
+{
+    lower = PF_MAXDOUBLE;
+    upper = -PF_MAXDOUBLE;
+    for(int i=0;i<steps;++i){
+        double l, u;
+        if(!stepRange(i,l,u)) continue;
+        lower = std::min(lower,l);
+        upper = std::max(upper,u);
+    }
+    return lower <= upper;
+}
+
+const PF_TransientResult::StepEntry *PF_TransientResult::entry(int step) const
+{
+    if(!mapped || step < 0 || step >= steps) return nullptr;
+    return reinterpret_cast<const StepEntry*>(mapped + HeaderSize) + step;
+}
+
+/*!
+ \brief 映射整个文件，映射之后文件句柄可以关闭。
+
+*/
+bool PF_TransientResult::map(qint64 size)
+{
+    mapped = file.map(0,size);
+    file.close();
+    if(!mapped){
+        qDebug()<<Q_FUNC_INFO<<"cannot map"<<file.fileName();
+        writable = false;
+        return false;
+    }
+    return true;
+}
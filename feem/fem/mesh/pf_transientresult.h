@@ -0,0 +1,69 @@
+#ifndef PF_TRANSIENTRESULT_H
+#define PF_TRANSIENTRESULT_H
+
+#include <QFile>
+#include <QString>
+
+/*!
+ \brief 瞬态计算结果文件，每个时间步保存一组节点上的值。
+
+ 文件由文件头、时间步表和按时间步连续存放的节点值组成，整个文件映射到
+ 内存中，读取某一步只访问对应的页，由操作系统按需换入换出，不需要把所有
+ 时间步读入内存。求解器用create()建立文件并逐步写入，后处理用open()
+ 只读打开。values()返回的指针可以在多个线程中同时读取。
+*/
+class PF_TransientResult
+{
+public:
+    PF_TransientResult();
+    ~PF_TransientResult();
+
+    /** 建立文件并预留所有时间步的空间，已有的文件会被覆盖 **/
+    bool create(const QString& path, int nodeCount, int stepCount);
+    bool open(const QString& path);
+    void close();
+
+    bool isOpen() const{
+        return mapped != nullptr;
+    }
+    bool isWritable() const{
+        return writable;
+    }
+    QString fileName() const{
+        return file.fileName();
+    }
+    int nodeCount() const{
+        return nodes;
+    }
+    int stepCount() const{
+        return steps;
+    }
+
+    /** 写入第step步的时间和节点值，同时记录该步的最小值和最大值 **/
+    bool setStep(int step, double time, const double* values);
+    /** 第step步是否已经写入 **/
+    bool hasStep(int step) const;
+    double time(int step) const;
+    /** 第step步的节点值，指向映射的内存，没有写入或文件关闭后为空 **/
+    const double* values(int step) const;
+
+    /** 第step步的最小值和最大值，忽略NaN **/
+    bool stepRange(int step, double& lower, double& upper) const;
+    /** 所有已写入的时间步的最小值和最大值，用于动画中固定颜色范围 **/
+    bool range(double& lower, double& upper) const;
+
+private:
+    struct StepEntry;
+    const StepEntry* entry(int step) const;
+    bool map(qint64 size);
+
+private:
+    QFile file;
+    uchar* mapped;
+    bool writable;
+    int nodes;
+    int steps;
+    qint64 dataOffset;
+};
+
+#endif // PF_TRANSIENTRESULT_H
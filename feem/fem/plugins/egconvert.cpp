@@ -975,13 +975,13 @@ int LoadFidapInput(struct FemType *data,struct BoundaryType *boundaries,char *pr
                          elems,nodes,entityname);
 
             for(entity=1;entity<=maxentity;entity++) {
-                k = strcmp(entityname,data->bodyname[entity]);
+                k = strcmp(entityname,BodyName(data,entity));
                 if(k == 0) break;
             }
 
             if(entity > maxentity) {
                 maxentity++;
-                strcpy(data->bodyname[entity],entityname);
+                strcpy(BodyName(data,entity),entityname);
                 if(info) printf("Found new entity: %s\n",entityname);
             }
 
@@ -1464,7 +1464,7 @@ int LoadAnsysInput(struct FemType *data,struct BoundaryType *bound,
             if(strstr(text2,"BODY")) {
                 getline;
                 sscanf(line,"%d%d",&j,&bcind);
-                strcpy(data->bodyname[bcind],text);
+                strcpy(BodyName(data,bcind),text);
             }
             else if(strstr(text2,"BOUNDARY")) {
                 /* Read the boundary groups belonging to a particular name */
@@ -1483,7 +1483,7 @@ int LoadAnsysInput(struct FemType *data,struct BoundaryType *bound,
                 bcind = i;
                 bctypeused[bcind] = TRUE;
                 if(0) printf("First unused boundary is of type %d\n",bcind);
-                strcpy(data->boundaryname[bcind],text);
+                strcpy(BoundaryName(data,bcind),text);
 
                 /* Check which of the BCs have already been named */
                 k = l = 0;
@@ -3613,7 +3613,7 @@ nextline:
                 k = 0;
                 if(allocated) {
                     sscanf(line,"%s",entityname);
-                    strcpy(data->bodyname[group],entityname);
+                    strcpy(BodyName(data,group),entityname);
                     data->bodynamesexist = TRUE;
                     data->boundarynamesexist = TRUE;
 
@@ -68,12 +68,14 @@
 #include "egoutput.h"
 #else
 #include "src/meshtype.h"
+#include "egmain.h"
 #endif
 
 
 static struct GridType *grids;
-static struct FemType data[MAXCASES];
-static struct BoundaryType *boundaries[MAXCASES];
+static struct FemType *data;
+static struct BoundaryType **boundaries;
+static int maxcases;
 static struct ElmergridType eg;
 static char Filename[MAXFILESIZE];
 static int Inmethod;
@@ -799,10 +801,83 @@ static int ExportMeshDefinition(int inmethod,int outmethod,int nofile,char *file
 #else
 
 
+/* Boundary sides of a mesh gathered in one pass over the BoundaryType
+   arrays. The side topology is stored row-wise with stride MAXNODESD1
+   and uses 0-based node indices. */
+struct SideListType {
+    int nosides,
+        *types,      /* side element type */
+        *parent,     /* 0-based primary parent, -1 if none */
+        *parent2,    /* 0-based secondary parent, -1 if none */
+        *bctype,     /* boundary condition index */
+        *topology;   /* side nodes */
+};
+
+
+static void FreeBoundarySides(struct SideListType *sides,int maxsides)
+{
+    if(maxsides <= 0) return;
+    free_Ivector(sides->types,0,maxsides-1);
+    free_Ivector(sides->parent,0,maxsides-1);
+    free_Ivector(sides->parent2,0,maxsides-1);
+    free_Ivector(sides->bctype,0,maxsides-1);
+    free_Ivector(sides->topology,0,MAXNODESD1*maxsides-1);
+    sides->nosides = 0;
+}
+
+
+/* Collects the sides whose element family (type / 100) lies within
+   [minfamily,maxfamily]. The storage is sized from the BoundaryType sizes
+   so that GetElementSide is called only once per side. Returns the size
+   of the allocation, which must be passed to FreeBoundarySides. */
+static int CollectBoundarySides(struct FemType *dat,struct BoundaryType *bound,
+                                int minfamily,int maxfamily,struct SideListType *sides)
+{
+    int i,j,k,l,maxsides,sideelemtype,sidenodes;
+    int ind[MAXNODESD1],*sidetopo;
+
+    maxsides = 0;
+    for(j=0;j<MAXBOUNDARIES;j++)
+        if(bound[j].created) maxsides += bound[j].nosides;
+
+    sides->nosides = 0;
+    if(maxsides == 0) return(0);
+
+    sides->types = Ivector(0,maxsides-1);
+    sides->parent = Ivector(0,maxsides-1);
+    sides->parent2 = Ivector(0,maxsides-1);
+    sides->bctype = Ivector(0,maxsides-1);
+    sides->topology = Ivector(0,MAXNODESD1*maxsides-1);
+
+    for(j=0;j<MAXBOUNDARIES;j++) {
+        if(bound[j].created == FALSE) continue;
+
+        for(i=1;i<=bound[j].nosides;i++) {
+            GetElementSide(bound[j].parent[i],bound[j].side[i],bound[j].normal[i],dat,ind,&sideelemtype);
+
+            if(sideelemtype / 100 < minfamily || sideelemtype / 100 > maxfamily) continue;
+
+            k = sides->nosides++;
+            sides->types[k] = sideelemtype;
+            sides->parent[k] = bound[j].parent[i] ? bound[j].parent[i]-1 : -1;
+            sides->parent2[k] = bound[j].parent2[i] ? bound[j].parent2[i]-1 : -1;
+            sides->bctype[k] = bound[j].types[i];
+
+            sidenodes = MIN(sideelemtype % 100, MAXNODESD1);
+            sidetopo = &sides->topology[k*MAXNODESD1];
+            for(l=0;l<sidenodes;l++)
+                sidetopo[l] = ind[l]-1;
+        }
+    }
+
+    return(maxsides);
+}
+
+
 int ConvertEgTypeToMeshType(struct FemType *dat,struct BoundaryType *bound,mesh_t *mesh)
 {
-    int i,j,k,allocated,surfaces,elemdim;
-    int sideelemtype,ind[MAXNODESD1];
+    int i,j,k,maxsides,elemdim,*elemtopo,*sidetopo;
+    struct SideListType sides;
 
     node_t *n;
     surface_t *b;
@@ -843,74 +918,49 @@ int ConvertEgTypeToMeshType(struct FemType *dat,struct BoundaryType *bound,mesh_
             e->newNodeIndexes(e->getNodes());
             e->setNature(PDE_BULK);
 
+            elemtopo = dat->topology[i+1];
             for(j = 0; j < e->getNodes(); j++)
-                e->setNodeIndex(j, dat->topology[i+1][j]-1);
+                e->setNodeIndex(j, elemtopo[j]-1);
             e->setIndex(dat->material[i+1]);
         }
 
 
         if(eg.saveboundaries) {
-
-            allocated = FALSE;
-do_b:    surfaces = 0;
-
-
-            for(j=0;j<MAXBOUNDARIES;j++) {
-                if(bound[j].created == FALSE) continue;
-
-                for(i=1;i<=bound[j].nosides;i++) {
-                    GetElementSide(bound[j].parent[i],bound[j].side[i],bound[j].normal[i],dat,ind,&sideelemtype);
-
-                    if(sideelemtype / 100 < 3 || sideelemtype / 100 > 4) continue;
-                    surfaces += 1;
-
-                    if(allocated) {
-                        b = mesh->getSurface(surfaces-1);
-                        b->setElements(0);
-                        b->newElementIndexes(2);
-
-                        if(bound[j].parent[i]) {
-                            b->setElements(b->getElements() + 1);
-                            b->setElementIndex(0, bound[j].parent[i]-1);
-                        }
-                        else {
-                            b->setElementIndex(0, -1);
-                        }
-
-                        if(bound[j].parent2[i]) {
-                            b->setElements(b->getElements() + 1);
-                            b->setElementIndex(1, bound[j].parent2[i]-1);
-                        }
-                        else {
-                            b->setElementIndex(1, -1);
-                        }
-
-                        b->setNormal(0, 0.0);
-                        b->setNormal(1, 0.0);
-                        b->setNormal(2, -1.0);
-
-                        b->setNature(PDE_BOUNDARY);
-                        b->setCode(sideelemtype);
-                        b->setNodes(b->getCode() % 100);
-                        b->newNodeIndexes(b->getNodes());
-                        for(k = 0; k < b->getNodes(); k++)
-                            b->setNodeIndex(k, ind[k]-1);
-                        b->setIndex(bound[j].types[i]);
-
-                        b->setEdges(b->getNodes());
-                        b->newEdgeIndexes(b->getEdges());
-                        for(k=0; k < b->getEdges(); k++)
-                            b->setEdgeIndex(k, -1);
-                    }
-                }
+            maxsides = CollectBoundarySides(dat,bound,3,4,&sides);
+
+            mesh->setSurfaces(sides.nosides);
+            mesh->newSurfaceArray(mesh->getSurfaces());
+
+            for(i = 0; i < sides.nosides; i++) {
+                b = mesh->getSurface(i);
+                b->setElements(0);
+                b->newElementIndexes(2);
+
+                b->setElementIndex(0, sides.parent[i]);
+                if(sides.parent[i] >= 0) b->setElements(b->getElements() + 1);
+                b->setElementIndex(1, sides.parent2[i]);
+                if(sides.parent2[i] >= 0) b->setElements(b->getElements() + 1);
+
+                b->setNormal(0, 0.0);
+                b->setNormal(1, 0.0);
+                b->setNormal(2, -1.0);
+
+                b->setNature(PDE_BOUNDARY);
+                b->setCode(sides.types[i]);
+                b->setNodes(b->getCode() % 100);
+                b->newNodeIndexes(b->getNodes());
+                sidetopo = &sides.topology[i*MAXNODESD1];
+                for(k = 0; k < b->getNodes(); k++)
+                    b->setNodeIndex(k, sidetopo[k]);
+                b->setIndex(sides.bctype[i]);
+
+                b->setEdges(b->getNodes());
+                b->newEdgeIndexes(b->getEdges());
+                for(k=0; k < b->getEdges(); k++)
+                    b->setEdgeIndex(k, -1);
             }
 
-            if(!allocated) {
-                mesh->setSurfaces(surfaces);
-                mesh->newSurfaceArray(mesh->getSurfaces());
-                allocated = TRUE;
-                goto do_b;
-            }
+            FreeBoundarySides(&sides,maxsides);
         }
     }
 
@@ -937,8 +987,9 @@ do_b:    surfaces = 0;
             b->newNodeIndexes(b->getNodes());
             b->setNature(PDE_BULK);
 
+            elemtopo = dat->topology[i+1];
             for(j = 0; j < b->getNodes(); j++)
-                b->setNodeIndex(j, dat->topology[i+1][j]-1);
+                b->setNodeIndex(j, elemtopo[j]-1);
             b->setIndex(dat->material[i+1]);
 
             b->setEdges(b->getNodes());
@@ -947,55 +998,33 @@ do_b:    surfaces = 0;
                 b->setEdgeIndex(k, -1);
         }
 
-        allocated = FALSE;
-do_s:    surfaces = 0;
-
-        for(j=0;j<MAXBOUNDARIES;j++) {
-            if(bound[j].created == FALSE) continue;
-
-            for(i=1;i<=bound[j].nosides;i++) {
-                GetElementSide(bound[j].parent[i],bound[j].side[i],bound[j].normal[i],dat,ind,&sideelemtype);
-
-                if(sideelemtype / 100 != 2) continue;
-                surfaces += 1;
-
-                if(allocated) {
-                    s = mesh->getEdge(surfaces-1);
-                    s->setSurfaces(0);
-                    s->newSurfaceIndexes(2);
-
-                    if(bound[j].parent[i]) {
-                        s->setSurfaces(s->getSurfaces() + 1);
-                        s->setSurfaceIndex(0, bound[j].parent[i]-1);
-                    }
-                    else {
-                        s->setSurfaceIndex(0, -1);
-                    }
-                    if(bound[j].parent2[i]) {
-                        s->setSurfaces(s->getSurfaces() + 1);
-                        s->setSurfaceIndex(1, bound[j].parent2[i]-1);
-                    }
-                    else {
-                        s->setSurfaceIndex(1, -1);
-                    }
-                    s->setCode(sideelemtype);
-                    s->setNodes(s->getCode() % 100);
-                    s->newNodeIndexes(s->getNodes());
-                    s->setNature(PDE_BOUNDARY);
-
-                    for(k = 0; k < s->getNodes(); k++)
-                        s->setNodeIndex(k, ind[k]-1);
-                    s->setIndex(bound[j].types[i]);
-                }
-            }
-        }
+        maxsides = CollectBoundarySides(dat,bound,2,2,&sides);
 
-        if(!allocated) {
-            mesh->setEdges(surfaces);
-            mesh->newEdgeArray(mesh->getEdges());
-            allocated = TRUE;
-            goto do_s;
+        mesh->setEdges(sides.nosides);
+        mesh->newEdgeArray(mesh->getEdges());
+
+        for(i = 0; i < sides.nosides; i++) {
+            s = mesh->getEdge(i);
+            s->setSurfaces(0);
+            s->newSurfaceIndexes(2);
+
+            s->setSurfaceIndex(0, sides.parent[i]);
+            if(sides.parent[i] >= 0) s->setSurfaces(s->getSurfaces() + 1);
+            s->setSurfaceIndex(1, sides.parent2[i]);
+            if(sides.parent2[i] >= 0) s->setSurfaces(s->getSurfaces() + 1);
+
+            s->setCode(sides.types[i]);
+            s->setNodes(s->getCode() % 100);
+            s->newNodeIndexes(s->getNodes());
+            s->setNature(PDE_BOUNDARY);
+
+            sidetopo = &sides.topology[i*MAXNODESD1];
+            for(k = 0; k < s->getNodes(); k++)
+                s->setNodeIndex(k, sidetopo[k]);
+            s->setIndex(sides.bctype[i]);
         }
+
+        FreeBoundarySides(&sides,maxsides);
     }
     else {
         printf("Implemented only for element dimensions 2 and 3 (not %d)\n",elemdim);
@@ -1003,6 +1032,118 @@ do_s:    surfaces = 0;
 
     return(0);
 }
+
+
+/* Hands the storage of the FemType over to the caller without copying.
+   The coordinate, element type, material and topology arrays are already
+   contiguous in FemType, so only the index bases are shifted: the topology
+   is renumbered in place to 0-based node indices. The boundary sides of the
+   highest dimension below the bulk elements are gathered in one pass before
+   that, while GetElementSide can still read the 1-based topology. After
+   this call the FemType no longer owns the arrays, and the tables that are
+   not handed over (names, dual graph, inverse topology) are freed. */
+int ConvertEgTypeToMeshBuffers(struct FemType *dat,struct BoundaryType *bound,
+                               struct EgMeshBuffers *buf)
+{
+    int i,elemdim,sidefamily,maxsides,*topo;
+    struct SideListType sides;
+
+    memset(buf,0,sizeof(struct EgMeshBuffers));
+
+    if(!dat->created) {
+        printf("Data is not created!\n");
+        return(1);
+    }
+
+    elemdim = GetMaxElementDimension(dat);
+    if(elemdim < 2 || elemdim > 3) {
+        printf("Implemented only for element dimensions 2 and 3 (not %d)\n",elemdim);
+        return(2);
+    }
+    sidefamily = elemdim;
+
+    buf->dim = MAX(dat->dim, elemdim);
+    buf->noknots = dat->noknots;
+    buf->noelements = dat->noelements;
+    buf->maxnodes = dat->maxnodes;
+
+    buf->x = &dat->x[1];
+    buf->y = &dat->y[1];
+    buf->z = &dat->z[1];
+    buf->elementtypes = &dat->elementtypes[1];
+    buf->material = &dat->material[1];
+
+    /* The sides are read through the 1-based topology rows, so they are
+       collected before the topology is renumbered and its row pointers freed */
+    maxsides = CollectBoundarySides(dat,bound,sidefamily,elemdim == 3 ? 4 : 2,&sides);
+    buf->maxsides = maxsides;
+    buf->nosides = sides.nosides;
+    buf->sidenodes = MAXNODESD1;
+    if(maxsides) {
+        buf->sidetypes = sides.types;
+        buf->sideparent = sides.parent;
+        buf->sideparent2 = sides.parent2;
+        buf->sidebctype = sides.bctype;
+        buf->sidetopology = sides.topology;
+    }
+
+    topo = dat->topology[1];
+    for(i=0;i<dat->noelements*dat->maxnodes;i++)
+        topo[i] -= 1;
+    buf->topology = topo;
+
+    /* Only the row pointers of the matrix are released, the rows move */
+    free((char*) (dat->topology+1-1));
+
+    for(i=0;i<MAXDOFS;i++)
+        if(dat->edofs[i] != 0) {
+            if(dat->edofs[i] > 0)
+                free_Rvector(dat->dofs[i],1,dat->alldofs[i]);
+            dat->edofs[i] = 0;
+        }
+
+    /* The name and connection tables are not handed over, release them
+       while noknots still gives the row lengths */
+    if(dat->dualexists) DestroyDualGraph(dat,FALSE);
+    if(dat->invtopoexists) DestroyInverseTopology(dat,FALSE);
+    DestroyNames(dat);
+
+    dat->x = dat->y = dat->z = NULL;
+    dat->elementtypes = dat->material = NULL;
+    dat->topology = NULL;
+    dat->noknots = 0;
+    dat->noelements = 0;
+    dat->maxnodes = 0;
+    dat->created = FALSE;
+
+    return(0);
+}
+
+
+void eg_freemeshbuffers(struct EgMeshBuffers *buf)
+{
+    struct SideListType sides;
+
+    if(buf->noknots > 0) {
+        free_Rvector(buf->x-1,1,buf->noknots);
+        free_Rvector(buf->y-1,1,buf->noknots);
+        free_Rvector(buf->z-1,1,buf->noknots);
+    }
+    if(buf->noelements > 0) {
+        free_Ivector(buf->elementtypes-1,1,buf->noelements);
+        free_Ivector(buf->material-1,1,buf->noelements);
+        free((char*) (buf->topology-1));
+    }
+    if(buf->maxsides > 0) {
+        sides.types = buf->sidetypes;
+        sides.parent = buf->sideparent;
+        sides.parent2 = buf->sideparent2;
+        sides.bctype = buf->sidebctype;
+        sides.topology = buf->sidetopology;
+        FreeBoundarySides(&sides,buf->maxsides);
+    }
+    memset(buf,0,sizeof(struct EgMeshBuffers));
+}
 #endif
 
 
@@ -1038,24 +1179,39 @@ static int DetermineFileType(const char *filename,int info)
 
 
 
+static void AllocateCases(int cases)
+/* Grows the mesh and boundary tables so that cases meshes may coexist. 
+   The tables are only as large as the number of meshes actually used. */
+{
+    int i,k;
+
+    if(cases <= maxcases) return;
+
+    data = (struct FemType*)realloc(data,(size_t) (cases)*sizeof(struct FemType));
+    boundaries = (struct BoundaryType**)
+            realloc(boundaries,(size_t) (cases)*sizeof(struct BoundaryType*));
+    if(!data || !boundaries) nrerror("allocation failure in AllocateCases()");
+
+    for(k=maxcases;k<cases;k++) {
+        memset(&data[k],0,sizeof(struct FemType));
+        boundaries[k] = (struct BoundaryType*)
+                malloc((size_t) (MAXBOUNDARIES)*sizeof(struct BoundaryType));
+        for(i=0;i<MAXBOUNDARIES;i++) {
+            boundaries[k][i].created = FALSE;
+            boundaries[k][i].nosides = 0;
+        }
+    }
+    maxcases = cases;
+}
+
+
 static int ImportMeshDefinition(int inmethod,int nofile,char *filename,int *nogrids)
 {
     int i,k,errorstat = 0,dim;
-    static int visited = FALSE;
 
 
     *nogrids = 0;
-    if(!visited) {
-        for(k=0;k<MAXCASES;k++) {
-            boundaries[k] = (struct BoundaryType*)
-                    malloc((size_t) (MAXBOUNDARIES)*sizeof(struct BoundaryType));
-            for(i=0;i<MAXBOUNDARIES;i++) {
-                boundaries[k][i].created = FALSE;
-                boundaries[k][i].nosides = 0;
-            }
-        }
-        visited = TRUE;
-    }
+    AllocateCases(nofile+1);
 
     /* Native format of ElmerGrid gets specieal treatment */
     switch (inmethod) {
@@ -1163,7 +1319,7 @@ static int ManipulateMeshDefinition(int inmethod,int outmethod,Real relh)
 
     if(inmethod == 1 && outmethod != 1) {
         if(visited) {
-            for(k=0;k<MAXCASES;k++) {
+            for(k=0;k<maxcases;k++) {
                 if(data[k].created) {
                     DestroyKnots(&data[k]);
                     for(i=0;i<MAXBOUNDARIES;i++)
@@ -1171,6 +1327,7 @@ static int ManipulateMeshDefinition(int inmethod,int outmethod,Real relh)
                 }
             }
         }
+        AllocateCases(nogrids);
         for(k=0;k<nogrids;k++)
             CreateElmerGridMesh(&(grids[k]),&(data[k]),boundaries[k],relh,info);
         nomeshes = nogrids;
@@ -1219,6 +1376,7 @@ static int ManipulateMeshDefinition(int inmethod,int outmethod,Real relh)
 
     if(outmethod != 1 && eg.dim != 2) {
         j = MAX(1,nogrids);
+        AllocateCases(j+1);
         for(k=0;k<j;k++) {
             if(grids[k].dimension == 3 || grids[k].rotate) {
                 CreateKnotsExtruded(&(data[k]),boundaries[k],&(grids[k]),
@@ -1332,10 +1490,11 @@ int eg_loadmesh(const char *filename)
 
 
 
-int eg_transfermesh(mesh_t *mesh,const char *str)
+/* Loads the file given to eg_loadmesh and applies the in-line options.
+   Shared by the mesh_t and the buffer transfers. */
+static int PrepareTransfer(const char *str)
 {
-    int i,k,inmethod,outmethod,errorstat,nofile;
-    info = TRUE;
+    int i,inmethod,outmethod,errorstat,nofile;
     static char arguments[10][10],**argv;
     int argc;
     static int visited = FALSE;
@@ -1379,12 +1538,6 @@ int eg_transfermesh(mesh_t *mesh,const char *str)
 
     if(info) printf("\nElmerGrid manipulating and importing data\n");
 
-    mesh->setNodes(0);
-    mesh->setPoints(0);
-    mesh->setEdges(0);
-    mesh->setSurfaces(0);
-    mesh->setElements(0);
-
     if(nomeshes == 0) {
         printf("No mesh to work with!\n");
         return(1);
@@ -1401,17 +1554,43 @@ int eg_transfermesh(mesh_t *mesh,const char *str)
 
     ManipulateMeshDefinition(inmethod,outmethod,eg.relh);
 
+    return(0);
+}
+
+
+int eg_transfermesh(mesh_t *mesh,const char *str)
+{
+    int errorstat;
+
+    mesh->setNodes(0);
+    mesh->setPoints(0);
+    mesh->setEdges(0);
+    mesh->setSurfaces(0);
+    mesh->setElements(0);
+
+    errorstat = PrepareTransfer(str);
+    if(errorstat) return(errorstat);
+
     errorstat = ConvertEgTypeToMeshType(&data[activemesh],boundaries[activemesh],mesh);
 
     if(info) printf("Done converting mesh\n");
     return(errorstat);
+}
 
-    for(k=0;k<MAXCASES;k++) {
-        DestroyKnots(&data[k]);
-        for(i=0;i<MAXBOUNDARIES;i++)
-            DestroyBoundary(&boundaries[k][i]);
-    }
-    if(info) printf("Done destroying structures\n");
+
+int eg_transfermeshbuffers(struct EgMeshBuffers *buf,const char *str)
+{
+    int errorstat;
+
+    memset(buf,0,sizeof(struct EgMeshBuffers));
+
+    errorstat = PrepareTransfer(str);
+    if(errorstat) return(errorstat);
+
+    errorstat = ConvertEgTypeToMeshBuffers(&data[activemesh],boundaries[activemesh],buf);
+
+    if(info) printf("Done handing over mesh buffers\n");
+    return(errorstat);
 }
 
 
@@ -1,2 +1,35 @@
+#ifndef _EGMAIN_H_
+#define _EGMAIN_H_
+
+/* Contiguous, 0-based views of an ElmerGrid mesh handed over by
+   eg_transfermeshbuffers. The element topology is stored row-wise with
+   stride maxnodes and the side topology with stride sidenodes, both with
+   0-based node indices. The caller owns the arrays and releases them with
+   eg_freemeshbuffers. */
+struct EgMeshBuffers {
+  int dim,
+    noknots,
+    noelements,
+    maxnodes,
+    nosides,        /* number of boundary sides */
+    maxsides,       /* allocated size of the side arrays */
+    sidenodes;      /* stride of the side topology */
+  double *x,
+    *y,
+    *z;
+  int *elementtypes,
+    *material,
+    *topology,
+    *sidetypes,
+    *sideparent,    /* primary parent element, -1 if none */
+    *sideparent2,   /* secondary parent element, -1 if none */
+    *sidebctype,
+    *sidetopology;
+};
+
 int eg_loadmesh(const char *filename);
 int eg_transfermesh(mesh_t *mesh,const char *str);
+int eg_transfermeshbuffers(struct EgMeshBuffers *buf,const char *str);
+void eg_freemeshbuffers(struct EgMeshBuffers *buf);
+
+#endif
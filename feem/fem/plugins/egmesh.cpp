@@ -736,14 +736,98 @@ void InitializeKnots(struct FemType *data)
         strcpy(data->dofname[i],"");
     }
 
-    for(i=0;i<MAXBODIES;i++) {
-        strcpy(data->bodyname[i],"");
-        sprintf(data->bodyname[i],"body%d",i);
-    }
-    for(i=0;i<MAXBCS;i++) {
-        strcpy(data->boundaryname[i],"");
-        sprintf(data->boundaryname[i],"bc%d",i);
-    }
+    data->dualgraph = NULL;
+    data->dualgraphsize = 0;
+    data->partitiontable = NULL;
+    data->partitiontablesize = 0;
+    data->invtopo = NULL;
+    data->invtoposize = 0;
+
+    /* The names get their default values when the tables are grown */
+    data->bodyname = NULL;
+    data->boundaryname = NULL;
+    data->bodynamesize = 0;
+    data->boundarynamesize = 0;
+}
+
+
+static char (*GrowNameTable(char (*names)[MAXNAMESIZE],int *size,int needed,
+                            const char *prefix))[MAXNAMESIZE]
+{
+    int i,newsize;
+
+    if(needed <= *size) return(names);
+
+    newsize = MAX(2*(*size),needed);
+    names = (char (*)[MAXNAMESIZE]) realloc(names,(size_t) newsize*MAXNAMESIZE);
+    if(!names) nrerror("allocation failure in GrowNameTable()");
+
+    for(i=*size;i<newsize;i++)
+        sprintf(names[i],"%s%d",prefix,i);
+    *size = newsize;
+
+    return(names);
+}
+
+
+void AllocateBodyNames(struct FemType *data,int size)
+/* Makes sure that body names 0..size-1 exist. */
+{
+    data->bodyname = GrowNameTable(data->bodyname,&data->bodynamesize,size,"body");
+}
+
+
+void AllocateBoundaryNames(struct FemType *data,int size)
+/* Makes sure that boundary names 0..size-1 exist. */
+{
+    data->boundaryname = GrowNameTable(data->boundaryname,&data->boundarynamesize,size,"bc");
+}
+
+
+char *BodyName(struct FemType *data,int body)
+/* Returns the name of the given body, growing the table if needed. 
+   The pointer is valid until the table grows again. */
+{
+    AllocateBodyNames(data,body+1);
+    return(data->bodyname[body]);
+}
+
+
+char *BoundaryName(struct FemType *data,int bc)
+{
+    AllocateBoundaryNames(data,bc+1);
+    return(data->boundaryname[bc]);
+}
+
+
+void DestroyNames(struct FemType *data)
+{
+    free(data->bodyname);
+    free(data->boundaryname);
+    data->bodyname = NULL;
+    data->boundaryname = NULL;
+    data->bodynamesize = 0;
+    data->boundarynamesize = 0;
+}
+
+
+int **GrowConnectionTable(int **table,int *size,int needed)
+/* Returns the table of row pointers grown so that index needed is valid. 
+   The new rows are set to NULL. */
+{
+    int i,newsize;
+
+    if(needed < *size) return(table);
+
+    newsize = MAX(2*(*size),needed+1);
+    table = (int**) realloc(table,(size_t) newsize*sizeof(int*));
+    if(!table) nrerror("allocation failure in GrowConnectionTable()");
+
+    for(i=*size;i<newsize;i++)
+        table[i] = NULL;
+    *size = newsize;
+
+    return(table);
 }
 
 
@@ -1342,6 +1426,8 @@ void DestroyKnots(struct FemType *data)
     free_Rvector(data->y,1,data->noknots);
     free_Rvector(data->z,1,data->noknots);
 
+    DestroyNames(data);
+
     data->noknots = 0;
     data->noelements = 0;
     data->maxnodes = 0;
@@ -3681,8 +3767,9 @@ void RenumberBoundaryTypes(struct FemType *data,struct BoundaryType *bound,
                     bound[j].types[i] = mapbc[bound[j].types[i]];
                 }
             }
-            if(data->boundarynamesexist) {
-                for(j=minbc;j<=MIN(maxbc,MAXBODIES-1);j++) {
+            if(data->boundarynamesexist && maxbc >= 0) {
+                AllocateBoundaryNames(data,maxbc+1);
+                for(j=MAX(minbc,0);j<=maxbc;j++) {
                     if(mapbc[j])
                         strcpy(data->boundaryname[mapbc[j]],data->boundaryname[j]);
                 }
@@ -3698,8 +3785,10 @@ void RenumberBoundaryTypes(struct FemType *data,struct BoundaryType *bound,
             for(i=1;i<=bound[j].nosides;i++)
                 bound[j].types[i] += bcoffset;
         }
-        if(data->boundarynamesexist) {
-            for(j=MAXBOUNDARIES-bcoffset-1;j>=0;j--) {
+        if(data->boundarynamesexist && bcoffset > 0) {
+            k = data->boundarynamesize;
+            AllocateBoundaryNames(data,k+bcoffset);
+            for(j=k-1;j>=0;j--) {
                 strcpy(data->boundaryname[j+bcoffset],data->boundaryname[j]);
             }
         }
@@ -3747,8 +3836,9 @@ void RenumberMaterialTypes(struct FemType *data,struct BoundaryType *bound,int i
         for(j=1;j<=noelements;j++)
             data->material[j] = mapmat[data->material[j]];
 
-        if(data->bodynamesexist) {
-            for(j=minmat;j<=MIN(maxmat,MAXBODIES-1);j++) {
+        if(data->bodynamesexist && maxmat >= 0) {
+            AllocateBodyNames(data,maxmat+1);
+            for(j=MAX(minmat,0);j<=maxmat;j++) {
                 if(mapmat[j])
                     strcpy(data->bodyname[mapmat[j]],data->bodyname[j]);
             }
@@ -6346,8 +6436,8 @@ void ElementsToBoundaryConditions(struct FemType *data,
                     }
                     if(data->bodynamesexist) {
                         data->boundarynamesexist = TRUE;
-                        if(material < MAXBODIES && material < MAXBOUNDARIES)
-                            strcpy(data->boundaryname[material],data->bodyname[material]);
+                        AllocateBodyNames(data,material+1);
+                        strcpy(BoundaryName(data,material),data->bodyname[material]);
                         if(!strncmp(data->boundaryname[material],"body",4))
                             strncpy(data->boundaryname[material],"bnry",4);
                     }
@@ -8326,6 +8416,7 @@ int CreateDualGraph(struct FemType *data,int full,int info)
                 }
                 if(!hit) {
                     if(l >= maxcon) {
+                        data->dualgraph = GrowConnectionTable(data->dualgraph,&data->dualgraphsize,maxcon);
                         data->dualgraph[maxcon] = Ivector(1,noknots);
                         for(m=1;m<=noknots;m++)
                             data->dualgraph[maxcon][m] = 0;
@@ -8342,6 +8433,7 @@ int CreateDualGraph(struct FemType *data,int full,int info)
                 }
                 if(!hit) {
                     if(l >= maxcon) {
+                        data->dualgraph = GrowConnectionTable(data->dualgraph,&data->dualgraphsize,maxcon);
                         data->dualgraph[maxcon] = Ivector(1,noknots);
                         for(m=1;m<=noknots;m++)
                             data->dualgraph[maxcon][m] = 0;
@@ -8368,6 +8460,7 @@ int CreateDualGraph(struct FemType *data,int full,int info)
                     }
                     if(!hit) {
                         if(l >= maxcon) {
+                            data->dualgraph = GrowConnectionTable(data->dualgraph,&data->dualgraphsize,maxcon);
                             data->dualgraph[maxcon] = Ivector(1,noknots);
                             for(m=1;m<=noknots;m++)
                                 data->dualgraph[maxcon][m] = 0;
@@ -8394,6 +8487,7 @@ int CreateDualGraph(struct FemType *data,int full,int info)
             }
             if(!hit) {
                 if(l >= maxcon) {
+                    data->dualgraph = GrowConnectionTable(data->dualgraph,&data->dualgraphsize,maxcon);
                     data->dualgraph[maxcon] = Ivector(1,noknots);
                     for(m=1;m<=noknots;m++)
                         data->dualgraph[maxcon][m] = 0;
@@ -8431,6 +8525,9 @@ int DestroyDualGraph(struct FemType *data,int info)
 
     for(i=0;i<maxcon;i++)
         free_Ivector(data->dualgraph[i],1,noknots);
+    free(data->dualgraph);
+    data->dualgraph = NULL;
+    data->dualgraphsize = 0;
 
     data->dualmaxconnections = 0;
     data->dualexists = FALSE;
@@ -8473,6 +8570,7 @@ int CreateInverseTopology(struct FemType *data,int info)
 
             if(l > maxcon) {
                 maxcon++;
+                data->invtopo = GrowConnectionTable(data->invtopo,&data->invtoposize,maxcon);
                 data->invtopo[maxcon] = Ivector(1,noknots);
                 for(m=1;m<=noknots;m++)
                     data->invtopo[maxcon][m] = 0;
@@ -8496,6 +8594,29 @@ int CreateInverseTopology(struct FemType *data,int info)
 }
 
 
+int DestroyInverseTopology(struct FemType *data,int info)
+{
+    int i;
+
+    if(!data->invtopoexists) {
+        printf("You tried to destroy a non-existing inverse topology\n");
+        return(1);
+    }
+
+    for(i=1;i<=data->maxinvtopo;i++)
+        free_Ivector(data->invtopo[i],1,data->noknots);
+    free(data->invtopo);
+    data->invtopo = NULL;
+    data->invtoposize = 0;
+
+    data->maxinvtopo = 0;
+    data->invtopoexists = FALSE;
+
+    if(info) printf("The inverse topology was destroyed\n");
+    return(0);
+}
+
+
 
 int MeshTypeStatistics(struct FemType *data,int info)
 {
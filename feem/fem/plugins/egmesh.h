@@ -17,6 +17,12 @@ void NumberVariables(struct FemType *data,int variable);
 int CalculateIndexwidth(struct FemType *data,int indxis,int *indx);
 
 void InitializeKnots(struct FemType *data);
+char *BodyName(struct FemType *data,int body);
+char *BoundaryName(struct FemType *data,int bc);
+void AllocateBodyNames(struct FemType *data,int size);
+void AllocateBoundaryNames(struct FemType *data,int size);
+void DestroyNames(struct FemType *data);
+int **GrowConnectionTable(int **table,int *size,int needed);
 void AllocateKnots(struct FemType *data);
 void CreateKnots(struct GridType *grid,struct CellType *cell,
 		 struct FemType *data,int noknots,int info);
@@ -95,6 +101,7 @@ int RemoveLowerDimensionalBoundaries(struct FemType *data,struct BoundaryType *b
 int CreateDualGraph(struct FemType *data,int full,int info);
 int DestroyDualGraph(struct FemType *data,int info);
 int CreateInverseTopology(struct FemType *data,int info);
+int DestroyInverseTopology(struct FemType *data,int info);
 int MeshTypeStatistics(struct FemType *data,int info);
 int SideAndBulkMappings(struct FemType *data,struct BoundaryType *bound,struct ElmergridType *eg,int info);
 int SideAndBulkBoundaries(struct FemType *data,struct BoundaryType *bound,struct ElmergridType *eg,int info);
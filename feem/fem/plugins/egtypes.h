@@ -5,9 +5,9 @@
 #define DIM 2               /* dimension of the space */
 #define MAXDOFS 20          /* maximum number of variables, e.g. T,P */ 
 #define MAXCELLS 100        /* maximum number of subcells in given direction */
-#define MAXBOUNDARIES 50    /* maximum number of boundaries for BCs */
-#define MAXMATERIALS  50    /* maximum index of materials */
-#define MAXCASES    12      /* maximum number of coexisting cases */ 
+#define MAXBOUNDARIES 50    /* maximum number of boundary groups in a mesh */
+#define MAXMATERIALS  50    /* maximum index of materials in structured grids */
+#define MAXCASES    12      /* maximum number of structured grids in a file */ 
 #define MAXFILESIZE 600      /* maximum filenamesize for i/o files */
 #define MAXLINESIZE 200     /* maximum length of line to be read */
 #define MAXNAMESIZE 30      /* maximum size of the variablename */
@@ -16,9 +16,6 @@
 #define MAXNODESD2 27       /* maximum number of 2D nodes */ 
 #define MAXNODESD1 9        /* maximum number of 1D nodes */
 #define MAXMAPPINGS 10      /* maximum number of geometry mappings */
-#define MAXCONNECTIONS 100  /* maximum number of connections in dual graph */
-#define MAXBCS 1000         /* maximum number of BCs in naming */
-#define MAXBODIES 100       /* maximum number of bodies in naming */
 #define MAXPARTITIONS 512   /* maximum number of partitions */
 #define MAXFORMATS 15
 
@@ -164,16 +161,19 @@ struct FemType {
     maxnodes,      /* maximum number of nodes */
     dim,           /* dimension of space */
     variables,     /* number of variables */
-    *dualgraph[MAXCONNECTIONS],  
+    **dualgraph,   /* grown as connections are found */
+    dualgraphsize, /* allocated size of dualgraph */
     dualmaxconnections,
     indexwidth,
     dualexists,
 
-    *partitiontable[MAXCONNECTIONS],  
+    **partitiontable,
+    partitiontablesize,
     maxpartitiontable,
     partitiontableexists, 
 
-    *invtopo[MAXCONNECTIONS],
+    **invtopo,
+    invtoposize,
     maxinvtopo,
     invtopoexists,
     timesteps,     /* number of timesteps */
@@ -199,8 +199,10 @@ struct FemType {
       *times;
   Real *dofs[MAXDOFS];  /* degrees of freedom in the mesh */
   char dofname[MAXDOFS][MAXNAMESIZE]; 
-  char bodyname[MAXBODIES][MAXNAMESIZE];
-  char boundaryname[MAXBCS][MAXNAMESIZE];
+  char (*bodyname)[MAXNAMESIZE];     /* use BodyName() to grow on demand */
+  char (*boundaryname)[MAXNAMESIZE]; /* use BoundaryName() to grow on demand */
+  int bodynamesize,                  /* allocated number of body names */
+      boundarynamesize;              /* allocated number of boundary names */
   int noboundaries,              /* number of boundaries */
       boundint[MAXBOUNDARIES],   /* internal material in the boundary */
       boundext[MAXBOUNDARIES],   /* external material in the boundary */
@@ -25,6 +25,20 @@ int ElmergridAPI::loadElmerMeshStructure(const char *filename)
 }
 
 
+/* Hands the imported mesh over as contiguous arrays without building a
+   mesh_t. Release the buffers with releaseMeshBuffers. */
+int ElmergridAPI::createMeshBuffers(EgMeshBuffers *buf,const char *options)
+{
+    return eg_transfermeshbuffers(buf,options);
+}
+
+
+void ElmergridAPI::releaseMeshBuffers(EgMeshBuffers *buf)
+{
+    eg_freemeshbuffers(buf);
+}
+
+
 int ElmergridAPI::createElmerMeshStructure(mesh_t *mesh,const char *options)
 {
 #if 1
@@ -3,6 +3,8 @@
 
 #include "src/meshtype.h"
 
+struct EgMeshBuffers;
+
 class ElmergridAPI
 {
  public:
@@ -11,6 +13,8 @@ class ElmergridAPI
   
   int loadElmerMeshStructure(const char*);
   int createElmerMeshStructure(mesh_t *mesh,const char *options);
+  int createMeshBuffers(struct EgMeshBuffers *buf,const char *options);
+  void releaseMeshBuffers(struct EgMeshBuffers *buf);
 };
 
 #endif // #ifndef ELMERGRID_API_H
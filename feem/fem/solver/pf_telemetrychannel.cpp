@@ -0,0 +1,76 @@
+#include "pf_telemetrychannel.h"
+
+PF_TelemetryChannel::PF_TelemetryChannel(const QString &name, int capacity)
+    :channelName(name)
+    ,mask(1)
+    ,lost(0)
+{
+    while(mask < quint32(capacity) && mask < (1u << 30))
+        mask <<= 1;
+    buffer.resize(mask);
+    mask -= 1;
+    tail.index.store(0);
+    tail.cached = 0;
+    head.index.store(0);
+    head.cached = 0;
+}
+
+/*!
+ \brief 只在本地副本显示缓冲区已满时才读取读取线程的位置。数据写入之后
+ 再以release语义更新写位置，读取线程看到新的位置时数据一定已经可见。
+
+*/
+bool PF_TelemetryChannel::publish(int series, double key, double value)
+{
+    const quint32 t = tail.index.load();
+    if(t - tail.cached > mask){
+        tail.cached = head.index.loadAcquire();
+        if(t - tail.cached > mask){
+            lost.fetchAndAddRelaxed(1);
+            return false;
+        }
+    }
+    Sample& s = buffer[t & mask];
+    s.series = series;
+    s.key = key;
+    s.value = value;
+    tail.index.storeRelease(t + 1);
+    return true;
+}
+
+/*!
+ \brief 本地副本中已有足够的数据时不读取发布线程的位置。读出之后再更新读位置，
+ 发布线程看到新的位置时这些位置才会被重新写入。
+
+*/
+int PF_TelemetryChannel::drain(Sample *out, int max)
+{
+    if(!out || max <= 0) return 0;
+    const quint32 h = head.index.load();
+    if(head.cached - h < quint32(max))
+        head.cached = tail.index.loadAcquire();
+    const quint32 count = qMin(head.cached - h,quint32(max));
+    for(quint32 i=0;i<count;++i){
+        out[i] = buffer[(h + i) & mask];
+    }
+    head.index.storeRelease(h + count);
+    return int(count);
+}
+
+/*!
+ \brief 读出当前所有的数据追加到out后面。
+
+*/
+int PF_TelemetryChannel::drain(QVector<Sample> &out)
+{
+    const int start = out.size();
+    out.resize(start + capacity());
+    const int count = drain(out.data() + start,capacity());
+    out.resize(start + count);
+    return count;
+}
+
+quint32 PF_TelemetryChannel::dropped() const
+{
+    return lost.load();
+}
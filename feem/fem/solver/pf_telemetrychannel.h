@@ -0,0 +1,62 @@
+#ifndef PF_TELEMETRYCHANNEL_H
+#define PF_TELEMETRYCHANNEL_H
+
+#include <QAtomicInteger>
+#include <QString>
+#include <QVector>
+
+#include <vector>
+
+/*!
+ \brief 求解过程中向界面发布监视数据（残差、迭代次数等）的通道。
+
+ 一个通道只能有一个发布线程（求解线程）和一个读取线程（GUI线程），
+ 数据放在容量固定的环形缓冲区中，两边只通过原子的读写位置同步，不加锁。
+ 缓冲区满时新的数据被丢弃并计数，发布永远不会等待，监视不会拖慢求解。
+ 每个数据属于一个序列，同一序列的key应当递增，例如迭代序号或时间。
+ 不同的求解阶段各自创建通道，由PF_TelemetryMonitor在GUI线程中读出。
+*/
+class PF_TelemetryChannel
+{
+public:
+    struct Sample{
+        int series;
+        double key;
+        double value;
+    };
+
+    /** 容量向上取为2的幂 **/
+    explicit PF_TelemetryChannel(const QString& name=QString(), int capacity=4096);
+
+    QString name() const{
+        return channelName;
+    }
+    int capacity() const{
+        return int(mask + 1);
+    }
+
+    /** 发布线程调用，缓冲区满时返回false **/
+    bool publish(int series, double key, double value);
+    /** 读取线程调用，最多读出max个数据，返回读出的个数 **/
+    int drain(Sample* out, int max);
+    int drain(QVector<Sample>& out);
+    /** 因缓冲区满被丢弃的数据个数 **/
+    quint32 dropped() const;
+
+private:
+    /** 读写位置放在不同的缓存行中，避免两个线程互相使缓存失效 **/
+    struct Position{
+        QAtomicInteger<quint32> index;
+        quint32 cached;     /**另一方位置的本地副本，只在看起来满或空时重新读取**/
+        char padding[64 - sizeof(QAtomicInteger<quint32>) - sizeof(quint32)];
+    };
+
+    QString channelName;
+    std::vector<Sample> buffer;
+    quint32 mask;
+    Position tail;          /**发布线程写入**/
+    Position head;          /**读取线程写入**/
+    QAtomicInteger<quint32> lost;
+};
+
+#endif // PF_TELEMETRYCHANNEL_H
@@ -76,6 +76,8 @@ public:
         ActionSelectSingle,
         ActionSelectAll,
         ActionDeSelectAll,
+        ActionSelectWindow,
+        ActionSelectLasso,
         ActionDrawPoint,
         ActionDrawCircle,
         ActionDrawRectangle,
@@ -155,7 +157,8 @@ public:
         EntityOverlayBox,    /**< OverlayBox */
         EntityPreview,    /**< Preview Container */
         EntityPattern,
-        EntityOverlayLine
+        EntityOverlayLine,
+        EntityPrimitives    /**< 紧凑存储的直线、圆弧和圆 */
     };
 
     /**